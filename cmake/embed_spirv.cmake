@@ -0,0 +1,53 @@
+# Turns a SPIR-V binary into a C++ header holding its words as a constexpr array
+#
+#   cmake -DINPUT=<file.spv> -DOUTPUT=<file.hpp> -DSYMBOL=<identifier> [-DSTAMP=<file>] -P embed_spirv.cmake
+#
+# OUTPUT keeps its timestamp when its content would not change, STAMP is touched on every run
+# so the build system sees the step as done
+
+if(NOT DEFINED INPUT OR NOT DEFINED OUTPUT OR NOT DEFINED SYMBOL)
+    message(FATAL_ERROR "embed_spirv.cmake needs INPUT, OUTPUT and SYMBOL")
+endif()
+
+file(READ "${INPUT}" spirv_hex HEX)
+string(LENGTH "${spirv_hex}" hex_length)
+math(EXPR byte_count "${hex_length} / 2")
+math(EXPR remainder "${byte_count} % 4")
+if(byte_count EQUAL 0 OR NOT remainder EQUAL 0)
+    message(FATAL_ERROR "${INPUT} is not SPIR-V: ${byte_count} bytes is not a whole number of words")
+endif()
+
+# SPIR-V is stored little endian, swap every word into a readable literal
+string(REGEX REPLACE "(..)(..)(..)(..)" "0x\\4\\3\\2\\1," spirv_words "${spirv_hex}")
+if(NOT spirv_words MATCHES "^0x07230203,")
+    message(FATAL_ERROR "${INPUT} is not SPIR-V: bad magic number")
+endif()
+# eight words a line keeps the generated headers diffable
+string(REGEX REPLACE "(0x[0-9a-f]+,0x[0-9a-f]+,0x[0-9a-f]+,0x[0-9a-f]+,0x[0-9a-f]+,0x[0-9a-f]+,0x[0-9a-f]+,0x[0-9a-f]+,)" "\\1\n        " spirv_words "${spirv_words}")
+
+set(header_content "// generated from ${INPUT} by cmake/embed_spirv.cmake, do not edit
+#pragma once
+
+#include <cstdint>
+
+namespace graph_vulkan::embedded_shaders{
+    inline constexpr uint32_t ${SYMBOL}[] = {
+        ${spirv_words}
+    };
+}
+")
+
+# leave the header untouched when nothing changed, so dependants do not rebuild
+set(header_changed TRUE)
+if(EXISTS "${OUTPUT}")
+    file(READ "${OUTPUT}" old_content)
+    if(old_content STREQUAL header_content)
+        set(header_changed FALSE)
+    endif()
+endif()
+if(header_changed)
+    file(WRITE "${OUTPUT}" "${header_content}")
+endif()
+if(DEFINED STAMP)
+    file(TOUCH "${STAMP}")
+endif()
@@ -0,0 +1,60 @@
+/**
+ *
+ * Pixel_Engine_bench, repeatable timings of the engine's job system, device, upload, pipeline and frame paths
+ *
+ **/
+
+
+#include "./benchmark.hpp"
+#include "./vulkan_benchmarks.hpp"
+#include "./job_benchmarks.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+
+int main(int argc, char **argv){
+    try{
+        // --warmup <n> --repetitions <n> --filter <substring> --json <file>
+        benchmark::Bench_Config config{};
+        std::string json_path;
+        for (int i = 1; i < argc; i++) {
+            bool has_value = i + 1 < argc;
+            if (std::strcmp(argv[i], "--warmup") == 0 && has_value) {
+                config.warmup = static_cast<uint32_t>(std::stoul(argv[++i]));
+            } else if (std::strcmp(argv[i], "--repetitions") == 0 && has_value) {
+                config.repetitions = static_cast<uint32_t>(std::stoul(argv[++i]));
+            } else if (std::strcmp(argv[i], "--filter") == 0 && has_value) {
+                config.filter = argv[++i];
+            } else if (std::strcmp(argv[i], "--json") == 0 && has_value) {
+                json_path = argv[++i];
+            } else {
+                throw std::runtime_error(std::string("Unknown argument: ") + argv[i]);
+            }
+        }
+
+        benchmark::BenchRunner runner{config};
+        {
+            jobs::job_benchmarks benchmarks{runner};
+            benchmarks.run();
+        }
+        graph_vulkan::vulkan_benchmarks::bench_device_creation(runner);
+        {
+            graph_vulkan::vulkan_benchmarks benchmarks{runner};
+            benchmarks.run();
+        }
+
+        runner.print_summary(std::cout);
+        if (!json_path.empty()) {
+            runner.write_json(json_path);
+            std::cout << "Results written to " << json_path << std::endl;
+        }
+    }catch(const std::exception &Exception){
+        std::cerr << Exception.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,183 @@
+
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+
+namespace benchmark{
+    namespace {
+        void write_json_string(std::ostream &out, const std::string &text) {
+            out << '"';
+            for (char character : text) {
+                if (character == '"' || character == '\\') out << '\\';
+                if (static_cast<unsigned char>(character) < 0x20) {
+                    out << ' ';
+                    continue;
+                }
+                out << character;
+            }
+            out << '"';
+        }
+
+        double percentile(const std::vector<double> &sorted, double fraction) {
+            if (sorted.empty()) return 0.0;
+            size_t rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+            return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+        }
+    } // namespace
+
+    void Bench_Result::summarize() {
+        if (samples_ms.empty()) return;
+
+        std::vector<double> sorted = samples_ms;
+        std::sort(sorted.begin(), sorted.end());
+        double total = 0.0;
+        for (double sample : sorted) total += sample;
+        mean_ms = total / static_cast<double>(sorted.size());
+
+        size_t middle = sorted.size() / 2;
+        median_ms = sorted.size() % 2 == 1 ? sorted[middle] : (sorted[middle - 1] + sorted[middle]) / 2.0;
+        min_ms = sorted.front();
+        max_ms = sorted.back();
+        p95_ms = percentile(sorted, 0.95);
+
+        double variance = 0.0;
+        for (double sample : sorted) variance += (sample - mean_ms) * (sample - mean_ms);
+        stddev_ms = sorted.size() > 1 ? std::sqrt(variance / static_cast<double>(sorted.size() - 1)) : 0.0;
+    }
+
+    // from the median, a single slow repetition should not move the throughput
+    double Bench_Result::megabytes_per_second() const {
+        if (bytes <= 0.0 || median_ms <= 0.0) return 0.0;
+        return bytes / (1024.0 * 1024.0) / (median_ms / 1000.0);
+    }
+
+    double Bench_Result::items_per_second() const {
+        if (items <= 0.0 || median_ms <= 0.0) return 0.0;
+        return items / (median_ms / 1000.0);
+    }
+
+    std::vector<uint32_t> thread_counts() {
+        uint32_t hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<uint32_t> counts{1};
+        for (uint32_t threads = 2; threads < hardware_threads; threads *= 2) counts.push_back(threads);
+        if (hardware_threads > 1) counts.push_back(hardware_threads);
+        return counts;
+    }
+
+    BenchRunner::BenchRunner(const Bench_Config &config) : config{config} {
+        if (this->config.repetitions == 0) this->config.repetitions = 1;
+    }
+
+    bool BenchRunner::is_selected(const std::string &name) const {
+        return config.filter.empty() || name.find(config.filter) != std::string::npos;
+    }
+
+    void BenchRunner::set_context(const std::string &key, const std::string &value) {
+        context[key] = value;
+    }
+
+    void BenchRunner::run(const std::string &name, const Bench_Case &bench_case) {
+        if (!is_selected(name)) return;
+
+        Bench_Result result{};
+        result.name = name;
+        result.bytes = bench_case.bytes;
+        result.items = bench_case.items;
+        result.samples_ms.reserve(config.repetitions);
+
+        for (uint32_t i = 0; i < config.warmup + config.repetitions; i++) {
+            if (bench_case.setup) bench_case.setup();
+            auto start = std::chrono::steady_clock::now();
+            bench_case.body();
+            auto end = std::chrono::steady_clock::now();
+            if (bench_case.teardown) bench_case.teardown();
+
+            if (i >= config.warmup) {
+                result.samples_ms.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+            }
+        }
+
+        result.summarize();
+        std::cerr << "bench: " << name << " median " << result.median_ms << " ms" << std::endl;
+        results.push_back(std::move(result));
+    }
+
+    void BenchRunner::run(const std::string &name, const std::function<void()> &body, double bytes, double items) {
+        Bench_Case bench_case{};
+        bench_case.body = body;
+        bench_case.bytes = bytes;
+        bench_case.items = items;
+        run(name, bench_case);
+    }
+
+    void BenchRunner::print_summary(std::ostream &out) const {
+        out << std::left << std::setw(40) << "benchmark" << std::right
+            << std::setw(12) << "median ms" << std::setw(12) << "mean ms"
+            << std::setw(12) << "stddev" << std::setw(12) << "p95 ms"
+            << std::setw(14) << "MB/s" << std::setw(14) << "items/s" << std::endl;
+        out << std::fixed << std::setprecision(3);
+        for (const auto &result : results) {
+            out << std::left << std::setw(40) << result.name << std::right
+                << std::setw(12) << result.median_ms << std::setw(12) << result.mean_ms
+                << std::setw(12) << result.stddev_ms << std::setw(12) << result.p95_ms
+                << std::setw(14) << result.megabytes_per_second()
+                << std::setw(14) << result.items_per_second() << std::endl;
+        }
+        out << std::defaultfloat;
+    }
+
+    void BenchRunner::write_json(const std::string &path) const {
+        std::ofstream file{path, std::ios::trunc};
+        if (!file) {
+            throw std::runtime_error("Failed to open benchmark output: " + path);
+        }
+        file << std::setprecision(9);
+
+        file << "{\n  \"schema\": 1,\n  \"context\": {";
+        bool first = true;
+        for (const auto &entry : context) {
+            file << (first ? "\n    " : ",\n    ");
+            write_json_string(file, entry.first);
+            file << ": ";
+            write_json_string(file, entry.second);
+            first = false;
+        }
+        file << "\n  },\n  \"config\": {\"warmup\": " << config.warmup
+             << ", \"repetitions\": " << config.repetitions << "},\n  \"results\": [";
+
+        first = true;
+        for (const auto &result : results) {
+            file << (first ? "\n    {" : ",\n    {") << "\"name\": ";
+            write_json_string(file, result.name);
+            file << ", \"median_ms\": " << result.median_ms
+                 << ", \"mean_ms\": " << result.mean_ms
+                 << ", \"min_ms\": " << result.min_ms
+                 << ", \"max_ms\": " << result.max_ms
+                 << ", \"stddev_ms\": " << result.stddev_ms
+                 << ", \"p95_ms\": " << result.p95_ms
+                 << ", \"bytes\": " << result.bytes
+                 << ", \"items\": " << result.items
+                 << ", \"mb_per_s\": " << result.megabytes_per_second()
+                 << ", \"items_per_s\": " << result.items_per_second()
+                 << ", \"samples_ms\": [";
+            for (size_t i = 0; i < result.samples_ms.size(); i++) {
+                file << (i == 0 ? "" : ", ") << result.samples_ms[i];
+            }
+            file << "]}";
+            first = false;
+        }
+        file << "\n  ]\n}\n";
+
+        if (!file) {
+            throw std::runtime_error("Failed to write benchmark output: " + path);
+        }
+    }
+} // namespace benchmark
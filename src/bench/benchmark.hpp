@@ -0,0 +1,85 @@
+//
+// Minimal benchmark harness: warmup, timed repetitions, summary statistics and
+// JSON output that can be diffed between releases
+//
+
+#ifndef PIXEL_ENGINE_BENCHMARK_H
+#define PIXEL_ENGINE_BENCHMARK_H
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+namespace benchmark{
+    struct Bench_Config {
+        uint32_t warmup = 2;
+        uint32_t repetitions = 10;
+        // only cases whose name contains this run, empty runs everything
+        std::string filter;
+    };
+
+    struct Bench_Result {
+        std::string name;
+        std::vector<double> samples_ms;
+        // work done by one repetition, turned into MB/s and items/s
+        double bytes = 0.0;
+        double items = 0.0;
+
+        double mean_ms = 0.0;
+        double median_ms = 0.0;
+        double min_ms = 0.0;
+        double max_ms = 0.0;
+        double stddev_ms = 0.0;
+        double p95_ms = 0.0;
+
+        void summarize();
+        double megabytes_per_second() const;
+        double items_per_second() const;
+    };
+
+    // one repetition, setup and teardown run around it without being timed
+    struct Bench_Case {
+        std::function<void()> setup;
+        std::function<void()> body;
+        std::function<void()> teardown;
+        double bytes = 0.0;
+        double items = 0.0;
+    };
+
+    // 1, the powers of two below the hardware thread count and the hardware thread count, for scaling cases
+    std::vector<uint32_t> thread_counts();
+
+    class BenchRunner {
+    private:
+        Bench_Config config;
+        std::vector<Bench_Result> results;
+        // environment the numbers were taken on, device name, driver and so on
+        std::map<std::string, std::string> context;
+
+    public:
+        explicit BenchRunner(const Bench_Config &config);
+
+        BenchRunner(const BenchRunner &) = delete;
+        BenchRunner &operator = (const BenchRunner &) = delete;
+
+        bool is_selected(const std::string &name) const;
+        void set_context(const std::string &key, const std::string &value);
+
+        void run(const std::string &name, const Bench_Case &bench_case);
+        void run(const std::string &name, const std::function<void()> &body, double bytes = 0.0, double items = 0.0);
+
+        const std::vector<Bench_Result> &get_results() const { return results; }
+        void print_summary(std::ostream &out) const;
+        // throws std::runtime_error when the file cannot be written
+        void write_json(const std::string &path) const;
+    };
+} // namespace benchmark
+
+
+#endif //PIXEL_ENGINE_BENCHMARK_H
@@ -0,0 +1,83 @@
+
+#include "job_benchmarks.hpp"
+#include "../library_support/Thread/job_system/job_system.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <string>
+#include <vector>
+
+
+namespace jobs{
+    job_benchmarks::job_benchmarks(benchmark::BenchRunner &runner) : runner{runner} {}
+
+    void job_benchmarks::run() {
+        bench_schedule_overhead();
+        bench_dependency_chain();
+        bench_nested_spawn();
+        bench_parallel_for();
+    }
+
+    void job_benchmarks::bench_schedule_overhead() {
+        // empty jobs, so the time is all scheduling, stealing and completion
+        for (uint32_t threads : benchmark::thread_counts()) {
+            JobSystem job_system{threads - 1};
+            runner.run("job_schedule_empty_x" + std::to_string(JOB_COUNT) + "_" + std::to_string(threads) + "_threads", [&]{
+                Job_Counter counter;
+                for (uint32_t i = 0; i < JOB_COUNT; i++) {
+                    job_system.schedule([]{}, &counter);
+                }
+                job_system.wait(counter);
+            }, 0.0, JOB_COUNT);
+        }
+    }
+
+    void job_benchmarks::bench_dependency_chain() {
+        // every job waits for the one before it, nothing runs in parallel, this is the latency of a release
+        JobSystem job_system;
+        runner.run("job_dependency_chain_x" + std::to_string(JOB_COUNT), [&]{
+            std::vector<Job_Counter> counters(JOB_COUNT);
+            job_system.schedule([]{}, &counters[0]);
+            for (uint32_t i = 1; i < JOB_COUNT; i++) {
+                job_system.schedule_after(counters[i - 1], []{}, &counters[i]);
+            }
+            job_system.wait(counters.back());
+        }, 0.0, JOB_COUNT);
+    }
+
+    void job_benchmarks::bench_nested_spawn() {
+        // jobs that spawn jobs land on the spawning worker's deque, the others have to steal them
+        constexpr uint32_t parents = 64;
+        constexpr uint32_t children = JOB_COUNT / parents;
+        JobSystem job_system;
+        std::atomic<uint32_t> finished{0};
+        runner.run("job_nested_spawn_" + std::to_string(parents) + "x" + std::to_string(children), [&]{
+            Job_Counter counter;
+            for (uint32_t parent = 0; parent < parents; parent++) {
+                job_system.schedule([&]{
+                    Job_Counter child_counter;
+                    for (uint32_t child = 0; child < children; child++) {
+                        job_system.schedule([&]{ finished.fetch_add(1, std::memory_order_relaxed); }, &child_counter);
+                    }
+                    job_system.wait(child_counter);
+                }, &counter);
+            }
+            job_system.wait(counter);
+        }, 0.0, parents * children);
+    }
+
+    void job_benchmarks::bench_parallel_for() {
+        std::vector<float> values(ELEMENT_COUNT, 1.0f);
+        for (uint32_t threads : benchmark::thread_counts()) {
+            JobSystem job_system{threads - 1};
+            runner.run("parallel_for_" + std::to_string(ELEMENT_COUNT) + "_" + std::to_string(threads) + "_threads", [&]{
+                job_system.parallel_for(0, ELEMENT_COUNT, 0, [&](uint32_t first, uint32_t last) {
+                    for (uint32_t i = first; i < last; i++) {
+                        values[i] = std::sqrt(values[i] * values[i] + 1.0f);
+                    }
+                });
+            }, 2.0 * sizeof(float) * ELEMENT_COUNT, ELEMENT_COUNT);
+        }
+    }
+
+} // namespace jobs
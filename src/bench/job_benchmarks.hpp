@@ -0,0 +1,42 @@
+//
+// Job system benchmarks: scheduling overhead per job, dependency chains,
+// nested spawning and parallel_for scaling over the thread count
+//
+
+#ifndef PIXEL_ENGINE_JOB_BENCHMARKS_H
+#define PIXEL_ENGINE_JOB_BENCHMARKS_H
+
+#pragma once
+
+#include "benchmark.hpp"
+
+#include <cstdint>
+
+
+namespace jobs{
+    class job_benchmarks{
+    public:
+        // jobs per repetition of the overhead cases
+        static constexpr uint32_t JOB_COUNT = 10000;
+        // elements per repetition of the parallel_for cases
+        static constexpr uint32_t ELEMENT_COUNT = 1u << 22;
+
+        explicit job_benchmarks(benchmark::BenchRunner &runner);
+
+        job_benchmarks(const job_benchmarks &) = delete;
+        job_benchmarks &operator = (const job_benchmarks &) = delete;
+
+        void run();
+
+    private:
+        void bench_schedule_overhead();
+        void bench_dependency_chain();
+        void bench_nested_spawn();
+        void bench_parallel_for();
+
+        benchmark::BenchRunner &runner;
+    };
+} // namespace jobs
+
+
+#endif //PIXEL_ENGINE_JOB_BENCHMARKS_H
@@ -0,0 +1,824 @@
+
+#include "vulkan_benchmarks.hpp"
+#include "../library_support/File/archive/asset_archive.hpp"
+#include "../library_support/Graphic/vulkan/command/parallel_recorder.hpp"
+#include "../library_support/Graphic/vulkan/descriptor/bindless_descriptors.hpp"
+#include "../library_support/Graphic/vulkan/memory/uniform_ring.hpp"
+#include "../library_support/Graphic/vulkan/mesh/mesh_importer.hpp"
+#include "../library_support/Graphic/vulkan/pipeline/pipeline.hpp"
+#include "../library_support/Graphic/vulkan/render_graph/render_graph.hpp"
+#include "../library_support/Graphic/vulkan/shader/embedded_shaders.hpp"
+#include "../library_support/Graphic/vulkan/texture/texture_streamer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+
+namespace graph_vulkan{
+    namespace {
+        std::string size_label(VkDeviceSize size) {
+            if (size >= 1024 * 1024) return std::to_string(size / (1024 * 1024)) + "MiB";
+            return std::to_string(size / 1024) + "KiB";
+        }
+
+        // a flat grid per object, quads written row by row so the optimizer has something to do
+        void write_grid_obj(const std::string &path, uint32_t object_count, uint32_t grid_size) {
+            std::ofstream file{path, std::ios::binary};
+            if (!file.is_open()) {
+                throw std::runtime_error("failed to open file: " + path);
+            }
+            uint32_t first_vertex = 1;
+            for (uint32_t object = 0; object < object_count; object++) {
+                file << "o grid_" << object << "\n";
+                for (uint32_t y = 0; y <= grid_size; y++) {
+                    for (uint32_t x = 0; x <= grid_size; x++) {
+                        file << "v " << x << " " << object << " " << y << "\n";
+                        file << "vt " << static_cast<float>(x) / grid_size << " " << static_cast<float>(y) / grid_size << "\n";
+                    }
+                }
+                file << "vn 0 1 0\n";
+                for (uint32_t y = 0; y < grid_size; y++) {
+                    for (uint32_t x = 0; x < grid_size; x++) {
+                        uint32_t a = first_vertex + y * (grid_size + 1) + x;
+                        uint32_t b = a + grid_size + 1;
+                        file << "f " << a << "/" << a << "/" << object + 1 << " " << b << "/" << b << "/" << object + 1 << " "
+                             << b + 1 << "/" << b + 1 << "/" << object + 1 << " " << a + 1 << "/" << a + 1 << "/" << object + 1 << "\n";
+                    }
+                }
+                first_vertex += (grid_size + 1) * (grid_size + 1);
+            }
+        }
+
+        void write_u32(std::vector<char> &out, size_t offset, uint32_t value) {
+            std::memcpy(out.data() + offset, &value, sizeof(value));
+        }
+
+        void write_u64(std::vector<char> &out, size_t offset, uint64_t value) {
+            std::memcpy(out.data() + offset, &value, sizeof(value));
+        }
+
+        // a KTX2 file with patterned texels, level_count 0 leaves the mips to the loader
+        void write_ktx2(const std::string &path, VkFormat format, file_io::Texture_Format texture_format,
+                        uint32_t size, uint32_t level_count) {
+            const uint32_t stored_levels = std::max(1u, level_count);
+            constexpr size_t header_size = 80;
+            constexpr size_t level_entry_size = 24;
+            const unsigned char identifier[12] = {0xab, 'K', 'T', 'X', ' ', '2', '0', 0xbb, '\r', '\n', 0x1a, '\n'};
+
+            std::vector<char> out(header_size + stored_levels * level_entry_size);
+            std::memcpy(out.data(), identifier, sizeof(identifier));
+            write_u32(out, 12, static_cast<uint32_t>(format));
+            write_u32(out, 16, 1);
+            write_u32(out, 20, size);
+            write_u32(out, 24, size);
+            write_u32(out, 36, 1);
+            write_u32(out, 40, level_count);
+            // the format stores the smallest level first
+            for (uint32_t level = stored_levels; level-- > 0;) {
+                const uint32_t level_size = std::max(1u, size >> level);
+                const size_t bytes = file_io::texture_level_size(texture_format, level_size, level_size);
+                const size_t offset = (out.size() + 15) & ~size_t{15};
+                const size_t entry = header_size + level * level_entry_size;
+                write_u64(out, entry, offset);
+                write_u64(out, entry + 8, bytes);
+                write_u64(out, entry + 16, bytes);
+                out.resize(offset + bytes);
+                for (size_t b = 0; b < bytes; b++) out[offset + b] = static_cast<char>((b * 13 + level) % 251);
+            }
+            std::ofstream file{path, std::ios::binary};
+            if (!file.is_open()) {
+                throw std::runtime_error("failed to open file: " + path);
+            }
+            file.write(out.data(), static_cast<std::streamsize>(out.size()));
+        }
+    } // namespace
+
+    vulkan_benchmarks::vulkan_benchmarks(benchmark::BenchRunner &runner) : runner{runner} {
+        runner.set_context("device", device.properties.deviceName);
+        runner.set_context("api_version",
+                           std::to_string(VK_API_VERSION_MAJOR(device.properties.apiVersion)) + "." +
+                           std::to_string(VK_API_VERSION_MINOR(device.properties.apiVersion)) + "." +
+                           std::to_string(VK_API_VERSION_PATCH(device.properties.apiVersion)));
+        runner.set_context("driver_version", std::to_string(device.properties.driverVersion));
+
+        target = std::make_unique<OffscreenTarget>(device);
+
+        VkPipelineLayoutCreateInfo pipeline_layout_info{};
+        pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        if (vkCreatePipelineLayout(device.device(), &pipeline_layout_info, nullptr, &pipeline_layout) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create pipeline layout.");
+        }
+
+        command_buffers.resize(target->frames_in_flight());
+        VkCommandBufferAllocateInfo allocate_info{};
+        allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocate_info.commandPool = device.get_command_pool();
+        allocate_info.commandBufferCount = static_cast<uint32_t>(command_buffers.size());
+        if (vkAllocateCommandBuffers(device.device(), &allocate_info, command_buffers.data()) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate command buffers.");
+        }
+    }
+
+    vulkan_benchmarks::~vulkan_benchmarks() {
+        target->wait_idle();
+        vkFreeCommandBuffers(
+                device.device(),
+                device.get_command_pool(),
+                static_cast<uint32_t>(command_buffers.size()),
+                command_buffers.data()
+                );
+        vkDestroyPipelineLayout(device.device(), pipeline_layout, nullptr);
+        target.reset();
+    }
+
+    void vulkan_benchmarks::bench_device_creation(benchmark::BenchRunner &runner) {
+        runner.run("device_create_headless", []{
+            Device device{"Pixel Engine Bench", {0, 0, 1}, Device_Config{"", "", true, ""}};
+        });
+    }
+
+    void vulkan_benchmarks::run() {
+        bench_buffer_creation();
+        bench_image_creation();
+        bench_copy_buffer();
+        bench_shader_modules();
+        bench_pipeline_creation();
+        bench_frame_loop();
+        bench_parallel_recording();
+        bench_uniform_ring();
+        bench_render_graph();
+        bench_descriptors();
+        bench_mesh_import();
+        bench_asset_archive();
+        bench_texture_streaming();
+    }
+
+    void vulkan_benchmarks::bench_buffer_creation() {
+        constexpr uint32_t buffer_count = 1000;
+        std::vector<VkBuffer> buffers(buffer_count);
+        std::vector<Memory_Allocation> memories(buffer_count);
+
+        benchmark::Bench_Case bench_case{};
+        bench_case.items = buffer_count;
+        bench_case.body = [&]{
+            for (uint32_t i = 0; i < buffer_count; i++) {
+                device.create_buffer(
+                        64 * 1024,
+                        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                        buffers[i],
+                        memories[i]
+                        );
+            }
+        };
+        bench_case.teardown = [&]{
+            for (uint32_t i = 0; i < buffer_count; i++) {
+                device.destroy_buffer(buffers[i], memories[i]);
+            }
+        };
+        runner.run("create_buffer_64KiB_x1000", bench_case);
+    }
+
+    void vulkan_benchmarks::bench_image_creation() {
+        constexpr uint32_t image_count = 100;
+        std::vector<VkImage> images(image_count);
+        std::vector<Memory_Allocation> memories(image_count);
+
+        VkImageCreateInfo image_info{};
+        image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        image_info.imageType = VK_IMAGE_TYPE_2D;
+        image_info.extent = {512, 512, 1};
+        image_info.mipLevels = 1;
+        image_info.arrayLayers = 1;
+        image_info.format = VK_FORMAT_R8G8B8A8_UNORM;
+        image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        image_info.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+        image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        benchmark::Bench_Case bench_case{};
+        bench_case.items = image_count;
+        bench_case.body = [&]{
+            for (uint32_t i = 0; i < image_count; i++) {
+                device.create_image_with_info(image_info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, images[i], memories[i]);
+            }
+        };
+        bench_case.teardown = [&]{
+            for (uint32_t i = 0; i < image_count; i++) {
+                device.destroy_image(images[i], memories[i]);
+            }
+        };
+        runner.run("create_image_512x512_rgba8_x100", bench_case);
+    }
+
+    void vulkan_benchmarks::bench_copy_buffer() {
+        const std::array<VkDeviceSize, 4> sizes{64 * 1024, 1024 * 1024, 16 * 1024 * 1024, 64 * 1024 * 1024};
+        const VkDeviceSize max_size = sizes.back();
+
+        VkBuffer staging_buffer;
+        Memory_Allocation staging_memory;
+        device.create_buffer(
+                max_size,
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                staging_buffer,
+                staging_memory
+                );
+        std::memset(staging_memory.mapped, 0x5a, static_cast<size_t>(max_size));
+
+        VkBuffer device_buffer;
+        Memory_Allocation device_memory;
+        device.create_buffer(
+                max_size,
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                device_buffer,
+                device_memory
+                );
+
+        // each copy is a blocking single time submit, so this includes the submit round trip
+        for (VkDeviceSize size : sizes) {
+            runner.run("copy_buffer_" + size_label(size), [&]{
+                device.copy_buffer(staging_buffer, device_buffer, size);
+            }, static_cast<double>(size));
+        }
+
+        device.destroy_buffer(device_buffer, device_memory);
+        device.destroy_buffer(staging_buffer, staging_memory);
+    }
+
+    void vulkan_benchmarks::bench_shader_modules() {
+        std::unique_ptr<ShaderModuleCache> cache;
+
+        // validation, content hashing and vkCreateShaderModule, a fresh cache every time
+        benchmark::Bench_Case bench_case{};
+        bench_case.bytes = static_cast<double>(embedded_shaders::default_vert.size + embedded_shaders::default_frag.size);
+        bench_case.setup = [&]{ cache = std::make_unique<ShaderModuleCache>(device.device()); };
+        bench_case.body = [&]{
+            cache->get(embedded_shaders::default_vert);
+            cache->get(embedded_shaders::default_frag);
+        };
+        bench_case.teardown = [&]{ cache.reset(); };
+        runner.run("shader_module_create_embedded", bench_case);
+    }
+
+    void vulkan_benchmarks::bench_pipeline_creation() {
+        Pipeline_Config_Info config_info{};
+        Pipeline::default_pipeline_config_info(config_info);
+        config_info.pipeline_layout = pipeline_layout;
+        config_info.render_pass = target->get_render_pass();
+        VkShaderModule vert_module = device.shader_modules().get(embedded_shaders::default_vert);
+        VkShaderModule frag_module = device.shader_modules().get(embedded_shaders::default_frag);
+
+        // the device's pipeline cache is warm after the first warmup run, as it is on a second launch
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        benchmark::Bench_Case bench_case{};
+        bench_case.body = [&]{
+            pipeline = Pipeline::create_pipeline_handle(device, vert_module, frag_module, config_info);
+        };
+        bench_case.teardown = [&]{
+            vkDestroyPipeline(device.device(), pipeline, nullptr);
+        };
+        runner.run("pipeline_create_cache_warm", bench_case);
+    }
+
+    void vulkan_benchmarks::bench_frame_loop() {
+        Pipeline_Config_Info config_info{};
+        Pipeline::default_pipeline_config_info(config_info);
+        config_info.pipeline_layout = pipeline_layout;
+        config_info.render_pass = target->get_render_pass();
+        Pipeline pipeline{device, embedded_shaders::default_vert, embedded_shaders::default_frag, config_info};
+
+        runner.run("frame_loop_offscreen_" + std::to_string(target->width()) + "x" + std::to_string(target->height()), [&]{
+            for (uint32_t frame = 0; frame < FRAME_COUNT; frame++) {
+                VkCommandBuffer command_buffer = command_buffers[target->current_frame_index()];
+                uint32_t image_index;
+                target->acquire_next_image(&image_index);
+                record_frame(command_buffer, image_index, pipeline.handle());
+                target->submit_command_buffers(&command_buffer, &image_index);
+            }
+            target->wait_idle();
+        }, 0.0, FRAME_COUNT);
+    }
+
+    void vulkan_benchmarks::bench_parallel_recording() {
+        Pipeline_Config_Info config_info{};
+        Pipeline::default_pipeline_config_info(config_info);
+        config_info.pipeline_layout = pipeline_layout;
+        config_info.render_pass = target->get_render_pass();
+        Pipeline pipeline{device, embedded_shaders::default_vert, embedded_shaders::default_frag, config_info};
+
+        std::array<VkClearValue, 2> clear_values{};
+        clear_values[1].depthStencil = {1.0f, 0};
+        VkRenderPassBeginInfo render_pass_info{};
+        render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        render_pass_info.renderPass = target->get_render_pass();
+        render_pass_info.framebuffer = target->get_frame_buffer(0);
+        render_pass_info.renderArea.extent = target->get_extent();
+        render_pass_info.clearValueCount = static_cast<uint32_t>(clear_values.size());
+        render_pass_info.pClearValues = clear_values.data();
+
+        Slice_Recorder record_slice = [&](VkCommandBuffer command_buffer, uint32_t slice, uint32_t slice_count) {
+            VkViewport viewport{0.0f, 0.0f, static_cast<float>(target->width()), static_cast<float>(target->height()), 0.0f, 1.0f};
+            VkRect2D scissor{{0, 0}, target->get_extent()};
+            vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.handle());
+            vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+            vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+            uint32_t first = DRAW_COUNT * slice / slice_count;
+            uint32_t last = DRAW_COUNT * (slice + 1) / slice_count;
+            for (uint32_t draw = first; draw < last; draw++) {
+                vkCmdDraw(command_buffer, 3, 1, 0, 0);
+            }
+        };
+
+        // recording only, nothing is submitted, so the pools can be reset right away
+        for (uint32_t threads : benchmark::thread_counts()) {
+            // the 1 thread case still goes through secondary buffers, so the difference is only the threading
+            jobs::JobSystem job_system{threads - 1};
+            ParallelRecorder recorder{device, job_system, 1};
+            runner.run("record_" + std::to_string(DRAW_COUNT) + "_draws_" + std::to_string(threads) + "_threads", [&]{
+                recorder.begin_frame(0);
+                VkCommandBuffer primary = recorder.begin_primary();
+                recorder.record_render_pass(primary, render_pass_info, threads * 4, record_slice);
+                vkEndCommandBuffer(primary);
+            }, 0.0, DRAW_COUNT);
+        }
+    }
+
+    void vulkan_benchmarks::bench_uniform_ring() {
+        // a typical per object block: model matrix, tint and a few parameters
+        struct Object_Constants {
+            float model[16];
+            float color[4];
+            float parameters[12];
+        };
+        UniformRing ring{device, target->frames_in_flight(), Uniform_Ring_Config{OBJECT_COUNT * 256ull}};
+        runner.set_context("uniform_ring_device_local", ring.is_device_local() ? "true" : "false");
+
+        Object_Constants constants{};
+        uint32_t frame_index = 0;
+        runner.run("uniform_ring_push_" + std::to_string(sizeof(Object_Constants)) + "B_x" + std::to_string(OBJECT_COUNT), [&]{
+            // nothing is submitted, so the slot is free right away
+            ring.begin_frame(frame_index);
+            frame_index = (frame_index + 1) % target->frames_in_flight();
+            for (uint32_t i = 0; i < OBJECT_COUNT; i++) {
+                constants.parameters[0] = static_cast<float>(i);
+                ring.push(constants);
+            }
+            ring.flush();
+        }, static_cast<double>(OBJECT_COUNT) * sizeof(Object_Constants), OBJECT_COUNT);
+    }
+
+    void vulkan_benchmarks::bench_render_graph() {
+        const VkExtent2D extent = target->get_extent();
+        const Graph_Image_Info color_info{VK_FORMAT_R8G8B8A8_UNORM, extent};
+        const Graph_Image_Info hdr_info{VK_FORMAT_R16G16B16A16_SFLOAT, extent};
+        const Graph_Image_Info half_info{VK_FORMAT_R16G16B16A16_SFLOAT, {extent.width / 2, extent.height / 2}};
+
+        // stands in for the swap chain image
+        VkImageCreateInfo image_info{};
+        image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        image_info.imageType = VK_IMAGE_TYPE_2D;
+        image_info.extent = {extent.width, extent.height, 1};
+        image_info.mipLevels = 1;
+        image_info.arrayLayers = 1;
+        image_info.format = color_info.format;
+        image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        image_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+        image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        VkImage output_image;
+        Memory_Allocation output_memory;
+        device.create_image_with_info(image_info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, output_image, output_memory);
+
+        VkImageViewCreateInfo view_info{};
+        view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        view_info.image = output_image;
+        view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        view_info.format = color_info.format;
+        view_info.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+        VkImageView output_view;
+        if (vkCreateImageView(device.device(), &view_info, nullptr, &output_view) != VK_SUCCESS) {
+            device.destroy_image(output_image, output_memory);
+            throw std::runtime_error("Failed to create texture image view.");
+        }
+        // the graph goes first, its framebuffers point at the view
+        std::unique_ptr<RenderGraph> graph;
+        auto release = [&]{
+            graph.reset();
+            device.deletion_queue().flush();
+            vkDestroyImageView(device.device(), output_view, nullptr);
+            device.destroy_image(output_image, output_memory);
+        };
+
+        try {
+            // deferred shading shaped: gbuffer, lighting, bloom down and up, tonemap, plus a debug view nobody reads;
+            // the passes record nothing themselves, what is measured are the barriers and render passes of the graph
+            Pass_Execute draw = [](const Pass_Context &) {};
+            Pass_Execute dispatch = [](const Pass_Context &) {};
+            graph = std::make_unique<RenderGraph>(device);
+            Graph_Resource albedo = graph->create_image("albedo", color_info);
+            Graph_Resource normal = graph->create_image("normal", hdr_info);
+            Graph_Resource depth = graph->create_image("depth", Graph_Image_Info{device.find_supported_format(
+                    {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
+                    VK_IMAGE_TILING_OPTIMAL,
+                    VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT), extent});
+            Graph_Resource lit = graph->create_image("lit", hdr_info);
+            Graph_Resource bloom_down = graph->create_image("bloom_down", half_info);
+            Graph_Resource bloom_up = graph->create_image("bloom_up", half_info);
+            Graph_Resource debug = graph->create_image("debug", color_info);
+            Graph_Resource output = graph->import_image("output", color_info, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+
+            graph->add_pass("gbuffer", Pass_Type::graphics, [&](Pass_Builder &builder) {
+                builder.write_color(albedo, Attachment_Load::clear);
+                builder.write_color(normal, Attachment_Load::clear);
+                builder.write_depth(depth);
+            }, draw);
+            graph->add_pass("lighting", Pass_Type::graphics, [&](Pass_Builder &builder) {
+                builder.sample(albedo);
+                builder.sample(normal);
+                builder.read_depth(depth);
+                builder.write_color(lit);
+            }, draw);
+            graph->add_pass("debug_normals", Pass_Type::graphics, [&](Pass_Builder &builder) {
+                builder.sample(normal);
+                builder.write_color(debug);
+            }, draw);
+            graph->add_pass("bloom_down", Pass_Type::compute, [&](Pass_Builder &builder) {
+                builder.sample(lit);
+                builder.write_storage(bloom_down);
+            }, dispatch);
+            graph->add_pass("bloom_up", Pass_Type::compute, [&](Pass_Builder &builder) {
+                builder.sample(bloom_down);
+                builder.write_storage(bloom_up);
+            }, dispatch);
+            graph->add_pass("tonemap", Pass_Type::graphics, [&](Pass_Builder &builder) {
+                builder.sample(lit);
+                builder.sample(bloom_up);
+                builder.write_color(output);
+            }, draw);
+            graph->compile();
+            graph->set_imported_image(output, output_image, output_view);
+
+            // recording only, the command buffer is never submitted
+            VkCommandBuffer command_buffer = command_buffers[0];
+            runner.run("render_graph_record_" + std::to_string(graph->get_stats().pass_count) + "_passes", [&]{
+                VkCommandBufferBeginInfo begin_info{};
+                begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+                begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+                vkBeginCommandBuffer(command_buffer, &begin_info);
+                graph->execute(command_buffer);
+                vkEndCommandBuffer(command_buffer);
+            }, 0.0, graph->get_stats().pass_count - graph->get_stats().culled_pass_count);
+
+            const Render_Graph_Stats &stats = graph->get_stats();
+            runner.set_context("render_graph_culled_passes", std::to_string(stats.culled_pass_count));
+            runner.set_context("render_graph_barriers",
+                               std::to_string(stats.image_barriers) + " in " + std::to_string(stats.barrier_batches) +
+                               " batches for " + std::to_string(stats.image_accesses) + " accesses");
+            runner.set_context("render_graph_transient_bytes",
+                               std::to_string(stats.allocated_bytes) + " of " + std::to_string(stats.transient_bytes));
+        } catch (...) {
+            release();
+            throw;
+        }
+        release();
+    }
+
+    void vulkan_benchmarks::bench_descriptors() {
+        // one storage buffer slice per draw, bound the classic way and through the bindless arrays
+        constexpr VkDeviceSize slice_size = 256;
+        VkBuffer buffer;
+        Memory_Allocation buffer_memory;
+        device.create_buffer(
+                slice_size * 64,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                buffer,
+                buffer_memory
+                );
+
+        // recording only, the command buffer is never submitted
+        VkCommandBuffer command_buffer = command_buffers[0];
+        // the draws go into the offscreen pass with a pipeline of the layout being measured
+        auto begin_draws = [&](VkPipeline pipeline) {
+            VkCommandBufferBeginInfo begin_info{};
+            begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            vkBeginCommandBuffer(command_buffer, &begin_info);
+
+            std::array<VkClearValue, 2> clear_values{};
+            clear_values[1].depthStencil = {1.0f, 0};
+            VkRenderPassBeginInfo render_pass_info{};
+            render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            render_pass_info.renderPass = target->get_render_pass();
+            render_pass_info.framebuffer = target->get_frame_buffer(0);
+            render_pass_info.renderArea.extent = target->get_extent();
+            render_pass_info.clearValueCount = static_cast<uint32_t>(clear_values.size());
+            render_pass_info.pClearValues = clear_values.data();
+            vkCmdBeginRenderPass(command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+
+            VkViewport viewport{0.0f, 0.0f, static_cast<float>(target->width()), static_cast<float>(target->height()), 0.0f, 1.0f};
+            VkRect2D scissor{{0, 0}, target->get_extent()};
+            vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+            vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+            vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+        };
+        auto end_draws = [&]{
+            vkCmdEndRenderPass(command_buffer);
+            vkEndCommandBuffer(command_buffer);
+        };
+        Pipeline_Config_Info config_info{};
+        Pipeline::default_pipeline_config_info(config_info);
+        config_info.render_pass = target->get_render_pass();
+
+        {
+            VkDescriptorSetLayout set_layout = device.descriptor_layouts().get({
+                    Descriptor_Binding{0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT}
+            });
+            VkPipelineLayout layout = device.descriptor_layouts().get_pipeline_layout({set_layout});
+            config_info.pipeline_layout = layout;
+            Pipeline pipeline{device, embedded_shaders::default_vert, embedded_shaders::default_frag, config_info};
+            DescriptorAllocator allocator{device.device(), target->frames_in_flight()};
+            Descriptor_Writer writer;
+            uint32_t frame_index = 0;
+            runner.run("descriptors_pooled_" + std::to_string(DRAW_COUNT) + "_draws", [&]{
+                // nothing is submitted, so the slot is free right away
+                allocator.begin_frame(frame_index);
+                frame_index = (frame_index + 1) % target->frames_in_flight();
+                begin_draws(pipeline.handle());
+                for (uint32_t draw = 0; draw < DRAW_COUNT; draw++) {
+                    VkDescriptorSet set = allocator.allocate(set_layout);
+                    writer.write_buffer(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, buffer, (draw % 64) * slice_size, slice_size);
+                    writer.update(device.device(), set);
+                    writer.clear();
+                    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 1, &set, 0, nullptr);
+                    vkCmdDraw(command_buffer, 3, 1, 0, 0);
+                }
+                end_draws();
+            }, 0.0, DRAW_COUNT);
+            runner.set_context("descriptor_pools", std::to_string(allocator.get_pool_count()));
+        }
+
+        if (!device.supports_bindless()) {
+            runner.set_context("descriptors_bindless", "unsupported");
+        } else {
+            struct Draw_Constants {
+                Bindless_Index buffer;
+                uint32_t slice;
+            };
+            BindlessDescriptors bindless{device};
+            Bindless_Index buffer_index = bindless.add_storage_buffer(buffer);
+            bindless.flush_updates();
+            config_info.pipeline_layout = bindless.pipeline_layout();
+            Pipeline pipeline{device, embedded_shaders::default_vert, embedded_shaders::default_frag, config_info};
+            runner.run("descriptors_bindless_" + std::to_string(DRAW_COUNT) + "_draws", [&]{
+                begin_draws(pipeline.handle());
+                bindless.bind(command_buffer);
+                for (uint32_t draw = 0; draw < DRAW_COUNT; draw++) {
+                    bindless.push(command_buffer, Draw_Constants{buffer_index, draw % 64});
+                    vkCmdDraw(command_buffer, 3, 1, 0, 0);
+                }
+                end_draws();
+            }, 0.0, DRAW_COUNT);
+            runner.set_context("descriptors_bindless", "supported");
+        }
+
+        device.deletion_queue().flush();
+        device.destroy_buffer(buffer, buffer_memory);
+    }
+
+    void vulkan_benchmarks::bench_mesh_import() {
+        // several files so the file jobs run side by side, several objects per file for the mesh jobs
+        constexpr uint32_t file_count = 4;
+        constexpr uint32_t objects_per_file = 8;
+        constexpr uint32_t grid_size = 128;
+        const std::filesystem::path directory = std::filesystem::temp_directory_path() / "pixel_engine_bench_meshes";
+        std::filesystem::create_directories(directory);
+        std::vector<std::string> paths;
+        double file_bytes = 0.0;
+        for (uint32_t f = 0; f < file_count; f++) {
+            paths.push_back((directory / ("grid_" + std::to_string(f) + ".obj")).string());
+            write_grid_obj(paths.back(), objects_per_file, grid_size);
+            file_bytes += static_cast<double>(std::filesystem::file_size(paths.back()));
+        }
+
+        {
+            jobs::JobSystem job_system;
+            UploadService upload_service{device};
+            MeshImporter importer{device, job_system, upload_service};
+            Mesh_Set set;
+
+            // parse, optimize and upload until the transfer finished
+            benchmark::Bench_Case bench_case{};
+            bench_case.bytes = file_bytes;
+            bench_case.items = file_count * objects_per_file;
+            bench_case.body = [&]{
+                set = importer.import(paths);
+                upload_service.wait(set.ticket);
+            };
+            bench_case.teardown = [&]{
+                importer.destroy(set);
+                device.deletion_queue().flush();
+            };
+            runner.run("mesh_import_obj_" + std::to_string(file_count) + "_files", bench_case);
+
+            const Mesh_Import_Stats &stats = importer.get_stats();
+            runner.set_context("mesh_import_acmr",
+                               std::to_string(stats.cache_miss_ratio_before) + " -> " + std::to_string(stats.cache_miss_ratio_after));
+        }
+
+        std::error_code error;
+        std::filesystem::remove_all(directory, error);
+    }
+
+    void vulkan_benchmarks::bench_asset_archive() {
+        // the same shader sized assets as loose files and packed, what startup does for each of them
+        constexpr uint32_t asset_count = 256;
+        constexpr size_t asset_size = 16 * 1024;
+        const std::filesystem::path directory = std::filesystem::temp_directory_path() / "pixel_engine_bench_assets";
+        std::filesystem::create_directories(directory);
+        std::vector<std::string> names;
+        file_io::AssetArchiveWriter writer;
+        std::vector<char> contents(asset_size);
+        for (uint32_t i = 0; i < asset_count; i++) {
+            for (size_t b = 0; b < asset_size; b++) contents[b] = static_cast<char>((b * 31 + i) % 61);
+            names.push_back("asset_" + std::to_string(i) + ".bin");
+            std::ofstream{(directory / names.back()).string(), std::ios::binary}.write(contents.data(), asset_size);
+            writer.add(names.back(), contents.data(), asset_size);
+        }
+        const std::string archive_path = (directory / "assets.pxa").string();
+        writer.write(archive_path);
+
+        // the checksum stands in for the consumer touching every byte
+        uint64_t loose_checksum = 0;
+        uint64_t archive_checksum = 0;
+        runner.run("assets_loose_" + std::to_string(asset_count) + "_files", [&]{
+            loose_checksum = 0;
+            for (const auto &name : names) {
+                file_io::MappedFile file{(directory / name).string()};
+                loose_checksum += file_io::AssetArchive::checksum(file.data(), file.size());
+            }
+        }, static_cast<double>(asset_count * asset_size), asset_count);
+        runner.run("assets_archive_" + std::to_string(asset_count) + "_entries", [&]{
+            archive_checksum = 0;
+            file_io::AssetArchive archive{archive_path};
+            for (const auto &name : names) {
+                file_io::Asset_View view = archive.view(name);
+                archive_checksum += file_io::AssetArchive::checksum(view.data, view.size);
+            }
+        }, static_cast<double>(asset_count * asset_size), asset_count);
+
+        std::error_code error;
+        std::filesystem::remove_all(directory, error);
+        // zero when --filter skipped the case
+        if (loose_checksum != 0 && archive_checksum != 0 && loose_checksum != archive_checksum) {
+            throw std::runtime_error("Packed assets differ from the loose files.");
+        }
+    }
+
+    void vulkan_benchmarks::bench_texture_streaming() {
+        // BC7 with full chains, loaded whole against coarse levels first, then RGBA8 without mips for the blit path
+        constexpr uint32_t texture_count = 32;
+        constexpr uint32_t texture_size = 1024;
+        constexpr uint32_t generated_count = 8;
+        try {
+            device.find_supported_format({VK_FORMAT_BC7_UNORM_BLOCK}, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+        } catch (const std::runtime_error &) {
+            runner.set_context("texture_streaming", "BC7 not supported");
+            return;
+        }
+
+        const std::filesystem::path directory = std::filesystem::temp_directory_path() / "pixel_engine_bench_textures";
+        std::filesystem::create_directories(directory);
+        std::vector<std::string> paths;
+        std::vector<std::string> generated_paths;
+        double file_bytes = 0.0;
+        for (uint32_t i = 0; i < texture_count; i++) {
+            paths.push_back((directory / ("bc7_" + std::to_string(i) + ".ktx2")).string());
+            write_ktx2(paths.back(), VK_FORMAT_BC7_UNORM_BLOCK, file_io::Texture_Format::bc7, texture_size,
+                       file_io::TextureFile::full_level_count(texture_size, texture_size));
+            file_bytes += static_cast<double>(std::filesystem::file_size(paths.back()));
+        }
+        for (uint32_t i = 0; i < generated_count; i++) {
+            generated_paths.push_back((directory / ("rgba8_" + std::to_string(i) + ".ktx2")).string());
+            write_ktx2(generated_paths.back(), VK_FORMAT_R8G8B8A8_UNORM, file_io::Texture_Format::rgba8, texture_size, 0);
+        }
+
+        {
+            UploadService upload_service{device};
+            std::unique_ptr<TextureStreamer> streamer;
+            std::vector<Texture_Handle> handles;
+            Texture_Streaming_Stats last_stats{};
+
+            auto wait_ready = [&]{
+                bool ready = false;
+                while (!ready) {
+                    streamer->update();
+                    ready = true;
+                    for (Texture_Handle handle : handles) ready = ready && streamer->is_ready(handle);
+                }
+            };
+            auto make_case = [&](const Texture_Streaming_Config &config, const std::vector<std::string> &files,
+                                 const std::function<void()> &body) {
+                benchmark::Bench_Case bench_case{};
+                bench_case.items = static_cast<double>(files.size());
+                bench_case.setup = [&, config]{
+                    streamer = std::make_unique<TextureStreamer>(device, upload_service, nullptr, config);
+                    handles.clear();
+                };
+                bench_case.body = [&, body]{
+                    for (const auto &file : files) handles.push_back(streamer->load(file));
+                    body();
+                };
+                bench_case.teardown = [&]{
+                    last_stats = streamer->get_stats();
+                    streamer.reset();
+                    device.deletion_queue().flush();
+                };
+                return bench_case;
+            };
+
+            // every level up front, what loading without streaming costs
+            Texture_Streaming_Config full_config{};
+            full_config.resident_size = UINT32_MAX;
+            full_config.memory_budget = UINT64_MAX;
+            benchmark::Bench_Case full_case = make_case(full_config, paths, wait_ready);
+            full_case.bytes = file_bytes;
+            runner.run("textures_full_" + std::to_string(texture_count) + "_bc7", full_case);
+            const VkDeviceSize full_bytes = last_stats.resident_bytes;
+
+            // until every texture can be sampled at its coarse levels
+            runner.run("textures_streamed_" + std::to_string(texture_count) + "_bc7", make_case({}, paths, wait_ready));
+            const VkDeviceSize streamed_bytes = last_stats.resident_bytes;
+            runner.set_context("texture_streaming_resident",
+                               size_label(streamed_bytes) + " streamed, " + size_label(full_bytes) + " full");
+
+            // coarse first, then everything requested until the full levels are in
+            benchmark::Bench_Case promote_case = make_case({}, paths, [&]{
+                wait_ready();
+                bool promoted = false;
+                while (!promoted) {
+                    promoted = true;
+                    for (Texture_Handle handle : handles) {
+                        streamer->request(handle, 0);
+                        promoted = promoted && streamer->resident_level(handle) == 0;
+                    }
+                    streamer->update();
+                }
+            });
+            promote_case.bytes = file_bytes;
+            runner.run("textures_promoted_" + std::to_string(texture_count) + "_bc7", promote_case);
+
+            runner.run("textures_generated_mips_" + std::to_string(generated_count) + "_rgba8",
+                       make_case({}, generated_paths, wait_ready));
+            runner.set_context("texture_generated_mip_chains", std::to_string(last_stats.generated_mip_chains));
+        }
+
+        std::error_code error;
+        std::filesystem::remove_all(directory, error);
+    }
+
+    void vulkan_benchmarks::record_frame(VkCommandBuffer command_buffer, uint32_t image_index, VkPipeline pipeline) {
+        VkCommandBufferBeginInfo begin_info{};
+        begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to begin recording command buffer.");
+        }
+
+        std::array<VkClearValue, 2> clear_values{};
+        clear_values[0].color = {{0.1f, 0.1f, 0.1f, 1.0f}};
+        clear_values[1].depthStencil = {1.0f, 0};
+
+        VkRenderPassBeginInfo render_pass_info{};
+        render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        render_pass_info.renderPass = target->get_render_pass();
+        render_pass_info.framebuffer = target->get_frame_buffer(image_index);
+        render_pass_info.renderArea.offset = {0, 0};
+        render_pass_info.renderArea.extent = target->get_extent();
+        render_pass_info.clearValueCount = static_cast<uint32_t>(clear_values.size());
+        render_pass_info.pClearValues = clear_values.data();
+        vkCmdBeginRenderPass(command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+
+        VkViewport viewport{0.0f, 0.0f, static_cast<float>(target->width()), static_cast<float>(target->height()), 0.0f, 1.0f};
+        VkRect2D scissor{{0, 0}, target->get_extent()};
+        vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+        vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+        vkCmdDraw(command_buffer, 3, 1, 0, 0);
+
+        vkCmdEndRenderPass(command_buffer);
+        if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to record command buffer.");
+        }
+    }
+}
@@ -0,0 +1,67 @@
+//
+// Engine benchmarks on a headless device: device creation, resource creation,
+// upload bandwidth, shader and pipeline creation and offscreen frame loops
+//
+
+#ifndef PIXEL_ENGINE_VULKAN_BENCHMARKS_H
+#define PIXEL_ENGINE_VULKAN_BENCHMARKS_H
+
+#pragma once
+
+#include "benchmark.hpp"
+#include "../library_support/Graphic/vulkan/device/device.hpp"
+#include "../library_support/Graphic/vulkan/offscreen/offscreen_target.hpp"
+
+#include <memory>
+#include <vector>
+
+
+namespace graph_vulkan{
+    class vulkan_benchmarks{
+    public:
+        // frames per repetition of the render loop case
+        static constexpr uint32_t FRAME_COUNT = 100;
+        // draws per repetition of the command recording cases
+        static constexpr uint32_t DRAW_COUNT = 20000;
+        // per object constant blocks per repetition of the uniform ring case
+        static constexpr uint32_t OBJECT_COUNT = 100000;
+
+        explicit vulkan_benchmarks(benchmark::BenchRunner &runner);
+        ~vulkan_benchmarks();
+
+        vulkan_benchmarks(const vulkan_benchmarks &) = delete;
+        vulkan_benchmarks &operator = (const vulkan_benchmarks &) = delete;
+
+        // constructs its own devices, run it before the shared one exists
+        static void bench_device_creation(benchmark::BenchRunner &runner);
+
+        void run();
+
+    private:
+        void bench_buffer_creation();
+        void bench_image_creation();
+        void bench_copy_buffer();
+        void bench_shader_modules();
+        void bench_pipeline_creation();
+        void bench_frame_loop();
+        void bench_parallel_recording();
+        void bench_uniform_ring();
+        void bench_render_graph();
+        void bench_descriptors();
+        void bench_mesh_import();
+        void bench_asset_archive();
+        void bench_texture_streaming();
+
+        void record_frame(VkCommandBuffer command_buffer, uint32_t image_index, VkPipeline pipeline);
+
+        benchmark::BenchRunner &runner;
+        // no pipeline cache file, every run starts from the same state
+        Device device{"Pixel Engine Bench", {0, 0, 1}, Device_Config{"", "", true, ""}};
+        std::unique_ptr<OffscreenTarget> target;
+        VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
+        std::vector<VkCommandBuffer> command_buffers;
+    };
+} // namespace graph_vulkan
+
+
+#endif //PIXEL_ENGINE_VULKAN_BENCHMARKS_H
@@ -0,0 +1,246 @@
+/**
+ * library_support/File/archive
+ *
+ **/
+
+// match hpp file
+#include "asset_archive.hpp"
+#include "block_compression.hpp"
+#include "../hash/fnv1a.hpp"
+//standard libraries
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+
+namespace file_io{
+    static_assert(sizeof(Archive_Header) == 64, "the archive header is part of the file format");
+    static_assert(sizeof(Archive_Entry) == 56, "the archive entry is part of the file format");
+
+    namespace {
+        uint64_t align_up(uint64_t value, uint64_t alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+    } // namespace
+
+    AssetArchive::AssetArchive(const std::string &path) : file{path}, path_{path} {
+        const auto *base = static_cast<const char *>(file.data());
+        const uint64_t file_size = file.size();
+        auto corrupt = [&](const std::string &reason) {
+            return std::runtime_error("Corrupt asset archive " + path + ": " + reason);
+        };
+
+        if (file_size < sizeof(Archive_Header)) throw corrupt("smaller than its header");
+        header = reinterpret_cast<const Archive_Header *>(base);
+        if (header->magic != MAGIC) throw corrupt("bad magic number");
+        if (header->version != VERSION) throw corrupt("unsupported version " + std::to_string(header->version));
+        if (header->file_size != file_size) throw corrupt("truncated");
+
+        const uint64_t toc_size = static_cast<uint64_t>(header->entry_count) * sizeof(Archive_Entry);
+        if (header->toc_offset % alignof(Archive_Entry) != 0 ||
+            header->toc_offset > file_size || toc_size > file_size - header->toc_offset ||
+            header->names_offset > file_size || header->names_size > file_size - header->names_offset) {
+            throw corrupt("table of contents out of range");
+        }
+        entries = reinterpret_cast<const Archive_Entry *>(base + header->toc_offset);
+        names = base + header->names_offset;
+        if (fnv1a(names, header->names_size, fnv1a(entries, toc_size)) != header->toc_checksum) {
+            throw corrupt("table of contents checksum mismatch");
+        }
+
+        // checked once here, so lookups and views can trust the table
+        for (uint32_t i = 0; i < header->entry_count; i++) {
+            const Archive_Entry &entry = entries[i];
+            if (entry.name_offset > header->names_size || entry.name_size > header->names_size - entry.name_offset) {
+                throw corrupt("name of entry " + std::to_string(i) + " out of range");
+            }
+            if (entry.offset % BLOB_ALIGNMENT != 0 || entry.offset > file_size || entry.stored_size > file_size - entry.offset) {
+                throw corrupt("blob of " + std::string(entry_name(entry)) + " out of range");
+            }
+            if (entry.compression == Archive_Compression::none ? entry.stored_size != entry.size
+                                                               : entry.compression != Archive_Compression::lz4_block) {
+                throw corrupt("bad compression of " + std::string(entry_name(entry)));
+            }
+            if (i > 0 && entries[i - 1].name_hash > entry.name_hash) throw corrupt("table of contents not sorted");
+        }
+    }
+
+    std::string_view AssetArchive::entry_name(const Archive_Entry &entry) const {
+        return {names + entry.name_offset, entry.name_size};
+    }
+
+    const Archive_Entry *AssetArchive::find(std::string_view name) const {
+        const uint64_t name_hash = hash_name(name);
+        const Archive_Entry *end = entries + header->entry_count;
+        const Archive_Entry *found = std::lower_bound(entries, end, name_hash, [](const Archive_Entry &entry, uint64_t hash) {
+            return entry.name_hash < hash;
+        });
+        for (; found != end && found->name_hash == name_hash; found++) {
+            if (entry_name(*found) == name) return found;
+        }
+        return nullptr;
+    }
+
+    Asset_View AssetArchive::view(const Archive_Entry &entry) const {
+        if (entry.compression != Archive_Compression::none) {
+            throw std::runtime_error("Asset " + std::string(entry_name(entry)) + " in " + path_ + " is compressed, read() it instead");
+        }
+        return {static_cast<const char *>(file.data()) + entry.offset, static_cast<size_t>(entry.size)};
+    }
+
+    Asset_View AssetArchive::view(std::string_view name) const {
+        const Archive_Entry *entry = find(name);
+        if (entry == nullptr) throw std::runtime_error("Asset not found in " + path_ + ": " + std::string(name));
+        return view(*entry);
+    }
+
+    std::vector<char> AssetArchive::read(const Archive_Entry &entry) const {
+        const char *blob = static_cast<const char *>(file.data()) + entry.offset;
+        std::vector<char> contents(static_cast<size_t>(entry.size));
+        if (entry.compression == Archive_Compression::none) {
+            std::memcpy(contents.data(), blob, contents.size());
+        } else {
+            decompress_block(blob, static_cast<size_t>(entry.stored_size), contents.data(), contents.size());
+        }
+        if (checksum(contents.data(), contents.size()) != entry.checksum) {
+            throw std::runtime_error("Asset " + std::string(entry_name(entry)) + " in " + path_ + " does not match its checksum");
+        }
+        return contents;
+    }
+
+    std::vector<char> AssetArchive::read(std::string_view name) const {
+        const Archive_Entry *entry = find(name);
+        if (entry == nullptr) throw std::runtime_error("Asset not found in " + path_ + ": " + std::string(name));
+        return read(*entry);
+    }
+
+    bool AssetArchive::verify(const Archive_Entry &entry) const {
+        if (entry.compression == Archive_Compression::none) {
+            Asset_View blob = view(entry);
+            return checksum(blob.data, blob.size) == entry.checksum;
+        }
+        try {
+            read(entry);
+            return true;
+        } catch (const std::runtime_error &) {
+            return false;
+        }
+    }
+
+    uint64_t AssetArchive::hash_name(std::string_view name) {
+        return fnv1a(name.data(), name.size());
+    }
+
+    uint64_t AssetArchive::checksum(const void *data, size_t size) {
+        return fnv1a(data, size);
+    }
+
+    void AssetArchiveWriter::add(const std::string &name, const void *data, size_t size, bool compress) {
+        const auto *bytes = static_cast<const char *>(data);
+        assets.push_back(Pending_Asset{name, std::vector<char>(bytes, bytes + size), compress});
+    }
+
+    void AssetArchiveWriter::add_file(const std::string &name, const std::string &path, bool compress) {
+        MappedFile source{path};
+        add(name, source.data(), source.size(), compress);
+    }
+
+    size_t AssetArchiveWriter::write(const std::string &path) const {
+        // the table is ordered by name hash, names break ties so the output does not depend on the add order
+        std::vector<size_t> order(assets.size());
+        std::iota(order.begin(), order.end(), size_t{0});
+        std::vector<uint64_t> name_hashes(assets.size());
+        for (size_t i = 0; i < assets.size(); i++) name_hashes[i] = AssetArchive::hash_name(assets[i].name);
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            if (name_hashes[a] != name_hashes[b]) return name_hashes[a] < name_hashes[b];
+            return assets[a].name < assets[b].name;
+        });
+        for (size_t i = 1; i < order.size(); i++) {
+            if (assets[order[i - 1]].name == assets[order[i]].name) {
+                throw std::runtime_error("Duplicate asset in archive " + path + ": " + assets[order[i]].name);
+            }
+        }
+
+        std::vector<Archive_Entry> entries(assets.size());
+        std::vector<std::vector<unsigned char>> compressed(assets.size());
+        std::string names;
+        for (size_t i = 0; i < order.size(); i++) {
+            const Pending_Asset &asset = assets[order[i]];
+            Archive_Entry &entry = entries[i];
+            entry.name_hash = name_hashes[order[i]];
+            entry.name_offset = static_cast<uint32_t>(names.size());
+            entry.name_size = static_cast<uint32_t>(asset.name.size());
+            entry.size = asset.data.size();
+            entry.checksum = AssetArchive::checksum(asset.data.data(), asset.data.size());
+            entry.compression = Archive_Compression::none;
+            entry.stored_size = asset.data.size();
+            if (asset.compress) {
+                compressed[i] = compress_block(asset.data.data(), asset.data.size());
+                if (!compressed[i].empty()) {
+                    entry.compression = Archive_Compression::lz4_block;
+                    entry.stored_size = compressed[i].size();
+                }
+            }
+            names += asset.name;
+        }
+
+        Archive_Header header{};
+        header.magic = AssetArchive::MAGIC;
+        header.version = AssetArchive::VERSION;
+        header.entry_count = static_cast<uint32_t>(entries.size());
+        header.toc_offset = sizeof(Archive_Header);
+        header.names_offset = header.toc_offset + entries.size() * sizeof(Archive_Entry);
+        header.names_size = names.size();
+        uint64_t offset = align_up(header.names_offset + header.names_size, AssetArchive::BLOB_ALIGNMENT);
+        for (auto &entry : entries) {
+            entry.offset = offset;
+            offset = align_up(offset + entry.stored_size, AssetArchive::BLOB_ALIGNMENT);
+        }
+        header.file_size = offset;
+        header.toc_checksum = fnv1a(names.data(), names.size(),
+                                    fnv1a(entries.data(), entries.size() * sizeof(Archive_Entry)));
+
+        // same as the pipeline cache, a failed write never replaces a good archive
+        const std::string temporary_path = path + ".tmp";
+        {
+            std::ofstream file{temporary_path, std::ios::binary | std::ios::trunc};
+            if (!file.is_open()) {
+                throw std::runtime_error("Failed to open " + temporary_path + " for writing");
+            }
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char *>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(Archive_Entry)));
+            file.write(names.data(), static_cast<std::streamsize>(names.size()));
+
+            static const char padding[AssetArchive::BLOB_ALIGNMENT] = {};
+            uint64_t written = header.names_offset + header.names_size;
+            for (size_t i = 0; i < entries.size(); i++) {
+                file.write(padding, static_cast<std::streamsize>(entries[i].offset - written));
+                if (entries[i].compression == Archive_Compression::none) {
+                    file.write(assets[order[i]].data.data(), static_cast<std::streamsize>(entries[i].stored_size));
+                } else {
+                    file.write(reinterpret_cast<const char *>(compressed[i].data()), static_cast<std::streamsize>(entries[i].stored_size));
+                }
+                written = entries[i].offset + entries[i].stored_size;
+            }
+            file.write(padding, static_cast<std::streamsize>(header.file_size - written));
+            if (!file) {
+                throw std::runtime_error("Failed to write " + temporary_path);
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temporary_path, path, error);
+        if (error) {
+            // rename does not replace existing files everywhere
+            std::filesystem::remove(path, error);
+            std::filesystem::rename(temporary_path, path, error);
+        }
+        if (error) {
+            throw std::runtime_error("Failed to replace " + path + ": " + error.message());
+        }
+        return static_cast<size_t>(header.file_size);
+    }
+
+} // namespace file_io
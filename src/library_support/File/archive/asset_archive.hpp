@@ -0,0 +1,141 @@
+/**
+ * library_support/File/archive
+ *
+ * Packed asset archive, one file and one mapping for every asset
+ *
+ * Layout: header, table of contents sorted by name hash, name strings, then
+ * the blobs, each starting on a 64 byte boundary. Startup maps the archive
+ * once and only touches the pages of the table, a lookup is a binary search
+ * over it. Stored blobs are used straight from the mapping, SPIR-V and vertex
+ * data can go to the driver without a copy; compressed ones (LZ4 block) are
+ * decompressed into a buffer. Every blob has a checksum of its contents.
+ *
+ * The format is little endian, like every platform the engine runs on.
+ * AssetArchiveWriter builds archives offline, see src/tools/asset_packer.cpp.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_FILE_ASSET_ARCHIVE_H
+#define PIXEL_ENGINE_FILE_ASSET_ARCHIVE_H
+
+#pragma once
+
+#include "../mapped_file/mapped_file.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace file_io{
+    enum class Archive_Compression : uint32_t {
+        none = 0,
+        lz4_block = 1,
+    };
+
+    struct Archive_Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t entry_count;
+        uint32_t flags;
+        uint64_t toc_offset;
+        uint64_t names_offset;
+        uint64_t names_size;
+        // FNV-1a of the table and the names
+        uint64_t toc_checksum;
+        uint64_t file_size;
+        uint64_t reserved;
+    };
+
+    struct Archive_Entry {
+        uint64_t name_hash;
+        uint32_t name_offset;
+        uint32_t name_size;
+        // in the archive, 64 byte aligned
+        uint64_t offset;
+        uint64_t stored_size;
+        // after decompression
+        uint64_t size;
+        // FNV-1a of the decompressed contents
+        uint64_t checksum;
+        Archive_Compression compression;
+        uint32_t reserved;
+    };
+
+    // a blob inside the mapping, valid as long as the archive
+    struct Asset_View {
+        const void *data = nullptr;
+        size_t size = 0;
+    };
+
+    class AssetArchive {
+    private:
+        MappedFile file;
+        std::string path_;
+        const Archive_Header *header = nullptr;
+        const Archive_Entry *entries = nullptr;
+        const char *names = nullptr;
+
+    public:
+        static constexpr uint32_t MAGIC = 0x52415850; // "PXAR"
+        static constexpr uint32_t VERSION = 1;
+        static constexpr size_t BLOB_ALIGNMENT = 64;
+
+        // maps the archive and validates the header and the table, not the blobs;
+        // throws std::runtime_error when the file is missing, truncated or corrupt
+        explicit AssetArchive(const std::string &path);
+
+        AssetArchive(const AssetArchive &) = delete;
+        AssetArchive &operator = (const AssetArchive &) = delete;
+
+        const std::string &path() const { return path_; }
+        size_t entry_count() const { return header->entry_count; }
+        const Archive_Entry &entry(size_t index) const { return entries[index]; }
+        std::string_view entry_name(const Archive_Entry &entry) const;
+
+        // null when the archive has no asset of that name
+        const Archive_Entry *find(std::string_view name) const;
+        bool contains(std::string_view name) const { return find(name) != nullptr; }
+
+        // stored entries only, no copy and no checksum test; throws for compressed ones
+        Asset_View view(const Archive_Entry &entry) const;
+        Asset_View view(std::string_view name) const;
+        // decompressed when needed and checked against the checksum, throws on a mismatch
+        std::vector<char> read(const Archive_Entry &entry) const;
+        std::vector<char> read(std::string_view name) const;
+
+        // reads the whole blob, false when the contents do not match the checksum
+        bool verify(const Archive_Entry &entry) const;
+
+        static uint64_t hash_name(std::string_view name);
+        static uint64_t checksum(const void *data, size_t size);
+    };
+
+    // collects assets in memory and writes the archive in one go
+    class AssetArchiveWriter {
+    private:
+        struct Pending_Asset {
+            std::string name;
+            std::vector<char> data;
+            bool compress;
+        };
+
+        std::vector<Pending_Asset> assets;
+
+    public:
+        // compression is dropped for assets it does not make smaller
+        void add(const std::string &name, const void *data, size_t size, bool compress = false);
+        void add_file(const std::string &name, const std::string &path, bool compress = false);
+
+        size_t asset_count() const { return assets.size(); }
+
+        // written next to path first and renamed over it, returns the archive size;
+        // throws std::runtime_error on duplicate names or when the file cannot be written
+        size_t write(const std::string &path) const;
+    };
+
+} // namespace file_io
+
+
+#endif // PIXEL_ENGINE_FILE_ASSET_ARCHIVE_H
@@ -0,0 +1,176 @@
+/**
+ * library_support/File/archive
+ *
+ **/
+
+// match hpp file
+#include "block_compression.hpp"
+//standard libraries
+#include <cstring>
+#include <stdexcept>
+
+namespace file_io{
+    namespace {
+        constexpr size_t MIN_MATCH = 4;
+        // the format wants the last 5 bytes as literals and no match starting in the last 12
+        constexpr size_t LAST_LITERALS = 5;
+        constexpr size_t MATCH_FIND_LIMIT = 12;
+        constexpr size_t MAX_OFFSET = 0xffff;
+        constexpr uint32_t HASH_BITS = 16;
+
+        uint32_t read_32(const unsigned char *p) {
+            uint32_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        uint32_t hash_sequence(uint32_t sequence) {
+            return (sequence * 2654435761u) >> (32 - HASH_BITS);
+        }
+
+        // lengths of 15 and more continue in bytes of 255 and a last smaller one
+        unsigned char *write_length(unsigned char *op, size_t length) {
+            while (length >= 255) {
+                *op++ = 255;
+                length -= 255;
+            }
+            *op++ = static_cast<unsigned char>(length);
+            return op;
+        }
+
+        size_t read_length(const unsigned char *&ip, const unsigned char *ip_end) {
+            size_t length = 0;
+            unsigned char byte;
+            do {
+                if (ip >= ip_end) throw std::runtime_error("Corrupt compressed block: truncated length");
+                byte = *ip++;
+                length += byte;
+            } while (byte == 255);
+            return length;
+        }
+
+        unsigned char *write_literals(unsigned char *op, const unsigned char *literals, size_t literal_count, unsigned char *&token) {
+            token = op++;
+            if (literal_count >= 15) {
+                *token = 15 << 4;
+                op = write_length(op, literal_count - 15);
+            } else {
+                *token = static_cast<unsigned char>(literal_count << 4);
+            }
+            if (literal_count > 0) std::memcpy(op, literals, literal_count);
+            return op + literal_count;
+        }
+    } // namespace
+
+    size_t compress_bound(size_t size) {
+        return size + size / 255 + 16;
+    }
+
+    std::vector<unsigned char> compress_block(const void *data, size_t size) {
+        const auto *in = static_cast<const unsigned char *>(data);
+        std::vector<unsigned char> out(compress_bound(size));
+        unsigned char *op = out.data();
+        unsigned char *token = nullptr;
+        size_t anchor = 0;
+
+        if (size > MATCH_FIND_LIMIT) {
+            // position + 1 of the last occurrence of each hashed 4 byte sequence, 0 is empty
+            std::vector<uint32_t> table(size_t{1} << HASH_BITS, 0);
+            const size_t match_start_limit = size - MATCH_FIND_LIMIT;
+            const size_t match_end_limit = size - LAST_LITERALS;
+            size_t pos = 0;
+            while (pos < match_start_limit) {
+                uint32_t sequence = read_32(in + pos);
+                uint32_t &slot = table[hash_sequence(sequence)];
+                size_t candidate = slot;
+                slot = static_cast<uint32_t>(pos + 1);
+                if (candidate == 0 || pos - (candidate - 1) > MAX_OFFSET || read_32(in + candidate - 1) != sequence) {
+                    // incompressible stretches are skipped faster the longer they get
+                    pos += 1 + ((pos - anchor) >> 6);
+                    continue;
+                }
+
+                size_t ref = candidate - 1;
+                while (pos > anchor && ref > 0 && in[pos - 1] == in[ref - 1]) {
+                    pos--;
+                    ref--;
+                }
+                size_t length = MIN_MATCH;
+                while (pos + length < match_end_limit && in[pos + length] == in[ref + length]) length++;
+
+                op = write_literals(op, in + anchor, pos - anchor, token);
+                const size_t offset = pos - ref;
+                *op++ = static_cast<unsigned char>(offset & 0xff);
+                *op++ = static_cast<unsigned char>(offset >> 8);
+                if (length - MIN_MATCH >= 15) {
+                    *token |= 15;
+                    op = write_length(op, length - MIN_MATCH - 15);
+                } else {
+                    *token |= static_cast<unsigned char>(length - MIN_MATCH);
+                }
+
+                pos += length;
+                anchor = pos;
+                // the end of a match often starts the next one
+                if (pos < match_start_limit) {
+                    table[hash_sequence(read_32(in + pos - 2))] = static_cast<uint32_t>(pos - 2 + 1);
+                }
+            }
+        }
+
+        op = write_literals(op, in + anchor, size - anchor, token);
+        const size_t compressed_size = static_cast<size_t>(op - out.data());
+        if (compressed_size >= size) return {};
+        out.resize(compressed_size);
+        return out;
+    }
+
+    void decompress_block(const void *src, size_t src_size, void *dst, size_t dst_size) {
+        const auto *ip = static_cast<const unsigned char *>(src);
+        const unsigned char *const ip_end = ip + src_size;
+        auto *const out = static_cast<unsigned char *>(dst);
+        unsigned char *op = out;
+        unsigned char *const op_end = out + dst_size;
+
+        while (true) {
+            if (ip >= ip_end) throw std::runtime_error("Corrupt compressed block: missing sequence");
+            const unsigned char token = *ip++;
+
+            size_t literal_count = token >> 4;
+            if (literal_count == 15) literal_count += read_length(ip, ip_end);
+            if (literal_count > static_cast<size_t>(ip_end - ip) || literal_count > static_cast<size_t>(op_end - op)) {
+                throw std::runtime_error("Corrupt compressed block: literals out of range");
+            }
+            if (literal_count > 0) std::memcpy(op, ip, literal_count);
+            ip += literal_count;
+            op += literal_count;
+            // the last sequence has literals only
+            if (ip == ip_end) break;
+
+            if (ip_end - ip < 2) throw std::runtime_error("Corrupt compressed block: truncated offset");
+            const size_t offset = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+            ip += 2;
+            if (offset == 0 || offset > static_cast<size_t>(op - out)) {
+                throw std::runtime_error("Corrupt compressed block: match offset out of range");
+            }
+            size_t length = token & 15;
+            if (length == 15) length += read_length(ip, ip_end);
+            length += MIN_MATCH;
+            if (length > static_cast<size_t>(op_end - op)) {
+                throw std::runtime_error("Corrupt compressed block: match out of range");
+            }
+
+            const unsigned char *match = op - offset;
+            if (offset >= length) {
+                std::memcpy(op, match, length);
+                op += length;
+            } else {
+                // overlapping, a run repeating the last offset bytes
+                for (size_t i = 0; i < length; i++) *op++ = match[i];
+            }
+        }
+
+        if (op != op_end) throw std::runtime_error("Corrupt compressed block: size mismatch");
+    }
+
+} // namespace file_io
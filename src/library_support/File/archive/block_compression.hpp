@@ -0,0 +1,36 @@
+/**
+ * library_support/File/archive
+ *
+ * LZ4 block format compression
+ *
+ * Byte oriented LZ77 without entropy coding: decompression is a loop of
+ * literal and match copies and runs at memory speed, which is what matters
+ * for assets that are packed once and loaded on every start. The output is a
+ * plain LZ4 block, so archives can be inspected with the reference tools.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_FILE_BLOCK_COMPRESSION_H
+#define PIXEL_ENGINE_FILE_BLOCK_COMPRESSION_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace file_io{
+    // largest output compress_block() can produce for size input bytes
+    size_t compress_bound(size_t size);
+
+    // greedy single pass, returns an empty vector when the data did not get smaller
+    std::vector<unsigned char> compress_block(const void *data, size_t size);
+
+    // dst_size is the exact decompressed size; throws std::runtime_error on malformed input
+    // and never reads or writes outside the two ranges
+    void decompress_block(const void *src, size_t src_size, void *dst, size_t dst_size);
+
+} // namespace file_io
+
+
+#endif // PIXEL_ENGINE_FILE_BLOCK_COMPRESSION_H
@@ -0,0 +1,36 @@
+/**
+ * library_support/File/hash
+ *
+ * 64 bit FNV-1a, the one hash for checksums and content keys
+ *
+ * Archive tables of contents, pipeline cache files, shader module keys and
+ * pipeline states all go through here. Not meant to stand up to anybody
+ * crafting collisions, callers that cannot live with one compare the data as
+ * well. Passing the previous result back in hashes several pieces as one.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_FILE_FNV1A_H
+#define PIXEL_ENGINE_FILE_FNV1A_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace file_io{
+    constexpr uint64_t FNV1A_OFFSET_BASIS = 0xcbf29ce484222325ull;
+
+    inline uint64_t fnv1a(const void *data, size_t size, uint64_t hash = FNV1A_OFFSET_BASIS) {
+        const auto *bytes = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+} // namespace file_io
+
+
+#endif // PIXEL_ENGINE_FILE_FNV1A_H
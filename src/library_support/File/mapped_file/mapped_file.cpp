@@ -0,0 +1,124 @@
+/**
+ * library_support/File/mapped_file
+ *
+ **/
+
+// match hpp file
+#include "mapped_file.hpp"
+//standard libraries
+#include <filesystem>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace file_io{
+    static std::runtime_error open_error(const std::string &path) {
+        return std::runtime_error(
+                "Failed to open file: " + path +
+                "\nCurrent Path: " + (std::filesystem::current_path()).string());
+    }
+
+#ifdef _WIN32
+    MappedFile::MappedFile(const std::string &path) {
+        file_handle = CreateFileA(
+                path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file_handle == INVALID_HANDLE_VALUE) {
+            file_handle = nullptr;
+            throw open_error(path);
+        }
+
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file_handle, &file_size)) {
+            close();
+            throw open_error(path);
+        }
+        size_ = static_cast<size_t>(file_size.QuadPart);
+        // an empty file cannot be mapped, it is simply empty
+        if (size_ == 0) return;
+
+        mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_handle != nullptr) {
+            data_ = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+        }
+        if (data_ == nullptr) {
+            close();
+            throw std::runtime_error("Failed to map file: " + path);
+        }
+    }
+
+    void MappedFile::close() {
+        if (data_ != nullptr) UnmapViewOfFile(data_);
+        if (mapping_handle != nullptr) CloseHandle(mapping_handle);
+        if (file_handle != nullptr) CloseHandle(file_handle);
+        data_ = nullptr;
+        mapping_handle = nullptr;
+        file_handle = nullptr;
+        size_ = 0;
+    }
+#else
+    MappedFile::MappedFile(const std::string &path) {
+        int file_descriptor = open(path.c_str(), O_RDONLY);
+        if (file_descriptor < 0) throw open_error(path);
+
+        struct stat file_status{};
+        if (fstat(file_descriptor, &file_status) != 0) {
+            ::close(file_descriptor);
+            throw open_error(path);
+        }
+        size_ = static_cast<size_t>(file_status.st_size);
+        // an empty file cannot be mapped, it is simply empty
+        if (size_ == 0) {
+            ::close(file_descriptor);
+            return;
+        }
+
+        void *mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+        // the mapping keeps the file alive on its own
+        ::close(file_descriptor);
+        if (mapping == MAP_FAILED) {
+            size_ = 0;
+            throw std::runtime_error("Failed to map file: " + path);
+        }
+        data_ = mapping;
+    }
+
+    void MappedFile::close() {
+        if (data_ != nullptr) munmap(const_cast<void *>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+#endif
+
+    MappedFile::~MappedFile() {
+        close();
+    }
+
+    MappedFile::MappedFile(MappedFile &&other) noexcept {
+        *this = std::move(other);
+    }
+
+    MappedFile &MappedFile::operator = (MappedFile &&other) noexcept {
+        if (this != &other) {
+            close();
+            std::swap(data_, other.data_);
+            std::swap(size_, other.size_);
+#ifdef _WIN32
+            std::swap(file_handle, other.file_handle);
+            std::swap(mapping_handle, other.mapping_handle);
+#endif
+        }
+        return *this;
+    }
+
+} // namespace file_io
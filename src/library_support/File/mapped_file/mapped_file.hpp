@@ -0,0 +1,50 @@
+/**
+ * library_support/File/mapped_file
+ *
+ * Read only memory mapped file
+ *
+ * The mapping starts on a page boundary, so the contents can be handed to APIs
+ * that need word aligned data without copying them into a buffer first.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_FILE_MAPPED_FILE_H
+#define PIXEL_ENGINE_FILE_MAPPED_FILE_H
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace file_io{
+    class MappedFile {
+    private:
+        const void *data_ = nullptr;
+        size_t size_ = 0;
+#ifdef _WIN32
+        void *file_handle = nullptr;
+        void *mapping_handle = nullptr;
+#endif
+
+        void close();
+
+    public:
+        MappedFile() = default;
+        // throws std::runtime_error when the file cannot be opened or mapped
+        explicit MappedFile(const std::string &path);
+        ~MappedFile();
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator = (const MappedFile &) = delete;
+        MappedFile(MappedFile &&other) noexcept;
+        MappedFile &operator = (MappedFile &&other) noexcept;
+
+        const void *data() const { return data_; }
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+    };
+
+} // namespace file_io
+
+
+#endif // PIXEL_ENGINE_FILE_MAPPED_FILE_H
@@ -0,0 +1,191 @@
+/**
+ * library_support/File/mesh
+ *
+ **/
+
+// match hpp file
+#include "mesh_optimizer.hpp"
+//standard libraries
+#include <algorithm>
+#include <cmath>
+
+namespace file_io{
+    namespace {
+        // simulated LRU cache, bigger than any real one so the scores still see a bit past it
+        constexpr uint32_t CACHE_SIZE = 32;
+        constexpr uint32_t MAX_VALENCE_SCORE = 32;
+
+        struct Score_Table {
+            float cache[CACHE_SIZE + 3];
+            float valence[MAX_VALENCE_SCORE];
+
+            Score_Table() {
+                constexpr float cache_decay_power = 1.5f;
+                constexpr float last_triangle_score = 0.75f;
+                constexpr float valence_boost_scale = 2.0f;
+                constexpr float valence_boost_power = 0.5f;
+                for (uint32_t i = 0; i < CACHE_SIZE + 3; i++) {
+                    if (i < 3) {
+                        // the triangle just drawn, reusing it right away does not help as much as it seems
+                        cache[i] = last_triangle_score;
+                    } else {
+                        float scaler = 1.0f / static_cast<float>(CACHE_SIZE - 3);
+                        cache[i] = std::pow(std::max(0.0f, 1.0f - static_cast<float>(i - 3) * scaler), cache_decay_power);
+                    }
+                }
+                valence[0] = 0.0f;
+                // vertices with few triangles left get finished first, so they do not become isolated
+                for (uint32_t i = 1; i < MAX_VALENCE_SCORE; i++) {
+                    valence[i] = valence_boost_scale * std::pow(static_cast<float>(i), -valence_boost_power);
+                }
+            }
+        };
+
+        const Score_Table &score_table() {
+            static const Score_Table table;
+            return table;
+        }
+
+        float vertex_score(int32_t cache_position, uint32_t remaining) {
+            if (remaining == 0) return -1.0f;
+            const Score_Table &table = score_table();
+            float score = cache_position >= 0 ? table.cache[cache_position] : 0.0f;
+            return score + table.valence[std::min(remaining, MAX_VALENCE_SCORE - 1)];
+        }
+    } // namespace
+
+    void optimize_vertex_cache(std::vector<uint32_t> &indices, size_t vertex_count) {
+        const size_t triangle_count = indices.size() / 3;
+        if (triangle_count < 2 || vertex_count == 0) return;
+
+        // triangles of every vertex, the live ones at the front of each range
+        std::vector<uint32_t> remaining(vertex_count, 0);
+        for (size_t i = 0; i < triangle_count * 3; i++) remaining[indices[i]]++;
+        std::vector<uint32_t> first_triangle(vertex_count + 1, 0);
+        for (size_t v = 0; v < vertex_count; v++) first_triangle[v + 1] = first_triangle[v] + remaining[v];
+        std::vector<uint32_t> vertex_triangles(triangle_count * 3);
+        {
+            std::vector<uint32_t> fill(first_triangle.begin(), first_triangle.end() - 1);
+            for (size_t t = 0; t < triangle_count; t++) {
+                for (int corner = 0; corner < 3; corner++) {
+                    uint32_t v = indices[t * 3 + corner];
+                    vertex_triangles[fill[v]++] = static_cast<uint32_t>(t);
+                }
+            }
+        }
+
+        std::vector<int32_t> cache_position(vertex_count, -1);
+        std::vector<float> scores(vertex_count);
+        for (size_t v = 0; v < vertex_count; v++) scores[v] = vertex_score(-1, remaining[v]);
+
+        std::vector<bool> emitted(triangle_count, false);
+        uint32_t best_triangle = 0;
+        float best_score = -1.0f;
+        for (size_t t = 0; t < triangle_count; t++) {
+            float score = scores[indices[t * 3]] + scores[indices[t * 3 + 1]] + scores[indices[t * 3 + 2]];
+            if (score > best_score) {
+                best_score = score;
+                best_triangle = static_cast<uint32_t>(t);
+            }
+        }
+
+        std::vector<uint32_t> output;
+        output.reserve(triangle_count * 3);
+        std::vector<uint32_t> cache;
+        std::vector<uint32_t> next_cache;
+        cache.reserve(CACHE_SIZE + 3);
+        next_cache.reserve(CACHE_SIZE + 3);
+        // where the fallback scan continues, everything before it was emitted already
+        size_t scan_cursor = 0;
+
+        for (size_t emitted_count = 0; emitted_count < triangle_count; emitted_count++) {
+            const uint32_t triangle = best_triangle;
+            emitted[triangle] = true;
+            const uint32_t *corners = &indices[triangle * 3];
+            output.insert(output.end(), corners, corners + 3);
+
+            // take the triangle out of its vertices' live ranges
+            for (int corner = 0; corner < 3; corner++) {
+                uint32_t v = corners[corner];
+                uint32_t *begin = &vertex_triangles[first_triangle[v]];
+                uint32_t *end = begin + remaining[v];
+                uint32_t *found = std::find(begin, end, triangle);
+                std::swap(*found, *(end - 1));
+                remaining[v]--;
+            }
+
+            // the triangle's vertices move to the front, the rest shift back and the last ones fall out
+            next_cache.assign(corners, corners + 3);
+            for (uint32_t v : cache) {
+                if (v != corners[0] && v != corners[1] && v != corners[2]) next_cache.push_back(v);
+            }
+            for (size_t i = 0; i < next_cache.size(); i++) {
+                uint32_t v = next_cache[i];
+                cache_position[v] = i < CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+                scores[v] = vertex_score(cache_position[v], remaining[v]);
+            }
+
+            // only triangles around the vertices whose score moved can have changed, evicted ones included
+            best_score = -1.0f;
+            for (uint32_t v : next_cache) {
+                for (uint32_t k = 0; k < remaining[v]; k++) {
+                    uint32_t t = vertex_triangles[first_triangle[v] + k];
+                    float score = scores[indices[t * 3]] + scores[indices[t * 3 + 1]] + scores[indices[t * 3 + 2]];
+                    if (score > best_score) {
+                        best_score = score;
+                        best_triangle = t;
+                    }
+                }
+            }
+            if (next_cache.size() > CACHE_SIZE) next_cache.resize(CACHE_SIZE);
+            std::swap(cache, next_cache);
+
+            if (best_score < 0.0f && emitted_count + 1 < triangle_count) {
+                // nothing in the cache has triangles left, start over at the first one not emitted yet;
+                // searching for the best one here would make meshes with many loose pieces quadratic
+                while (emitted[scan_cursor]) scan_cursor++;
+                best_triangle = static_cast<uint32_t>(scan_cursor);
+            }
+        }
+
+        std::copy(output.begin(), output.end(), indices.begin());
+    }
+
+    void optimize_vertex_fetch(std::vector<Mesh_Vertex> &vertices, std::vector<uint32_t> &indices) {
+        constexpr uint32_t UNUSED = UINT32_MAX;
+        std::vector<uint32_t> remap(vertices.size(), UNUSED);
+        std::vector<Mesh_Vertex> ordered;
+        ordered.reserve(vertices.size());
+        for (uint32_t &index : indices) {
+            if (remap[index] == UNUSED) {
+                remap[index] = static_cast<uint32_t>(ordered.size());
+                ordered.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+        vertices.swap(ordered);
+    }
+
+    void optimize_mesh(Mesh_Data &mesh) {
+        optimize_vertex_cache(mesh.indices, mesh.vertices.size());
+        optimize_vertex_fetch(mesh.vertices, mesh.indices);
+    }
+
+    float average_cache_miss_ratio(const std::vector<uint32_t> &indices, size_t vertex_count, uint32_t cache_size) {
+        const size_t triangle_count = indices.size() / 3;
+        if (triangle_count == 0) return 0.0f;
+
+        // FIFO, a vertex leaves the cache cache_size misses after it entered it
+        std::vector<size_t> entered(vertex_count, 0);
+        size_t misses = 0;
+        for (size_t i = 0; i < triangle_count * 3; i++) {
+            uint32_t v = indices[i];
+            if (entered[v] == 0 || misses - entered[v] + 1 > cache_size) {
+                misses++;
+                entered[v] = misses;
+            }
+        }
+        return static_cast<float>(misses) / static_cast<float>(triangle_count);
+    }
+
+} // namespace file_io
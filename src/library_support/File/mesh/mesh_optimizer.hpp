@@ -0,0 +1,38 @@
+/**
+ * library_support/File/mesh
+ *
+ * Vertex cache and vertex fetch optimization of indexed triangle lists
+ *
+ * optimize_vertex_cache() reorders the triangles so vertices are reused while
+ * they are still in the GPU's post transform cache (Forsyth's linear speed
+ * algorithm), optimize_vertex_fetch() then renumbers the vertices in the order
+ * the triangles first use them, so vertex fetches walk the buffer front to
+ * back. Neither changes what is drawn.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_FILE_MESH_OPTIMIZER_H
+#define PIXEL_ENGINE_FILE_MESH_OPTIMIZER_H
+
+#pragma once
+
+#include "mesh_parser.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace file_io{
+    void optimize_vertex_cache(std::vector<uint32_t> &indices, size_t vertex_count);
+    // drops vertices no triangle uses
+    void optimize_vertex_fetch(std::vector<Mesh_Vertex> &vertices, std::vector<uint32_t> &indices);
+    // both of the above
+    void optimize_mesh(Mesh_Data &mesh);
+
+    // transformed vertices per triangle with a FIFO cache, 3.0 is no reuse at all, 0.5 the best a regular grid gets
+    float average_cache_miss_ratio(const std::vector<uint32_t> &indices, size_t vertex_count, uint32_t cache_size = 16);
+
+} // namespace file_io
+
+
+#endif // PIXEL_ENGINE_FILE_MESH_OPTIMIZER_H
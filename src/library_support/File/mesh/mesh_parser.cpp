@@ -0,0 +1,886 @@
+/**
+ * library_support/File/mesh
+ *
+ **/
+
+// match hpp file
+#include "mesh_parser.hpp"
+//standard libraries
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace file_io{
+    namespace {
+        // ---- numbers ----
+
+        bool is_space(char c) {
+            return c == ' ' || c == '\t' || c == '\r';
+        }
+
+        const char *skip_spaces(const char *p, const char *end) {
+            while (p < end && is_space(*p)) p++;
+            return p;
+        }
+
+        const char *next_line(const char *p, const char *end) {
+            const void *newline = std::memchr(p, '\n', static_cast<size_t>(end - p));
+            return newline ? static_cast<const char *>(newline) + 1 : end;
+        }
+
+        // strtof is locale dependent and needs a terminated string, neither is true of a mapping
+        const char *parse_float(const char *p, const char *end, float &value) {
+            static const double powers_of_ten[] = {
+                    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+                    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+            };
+            const char *start = p;
+            bool negative = false;
+            if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+
+            uint64_t mantissa = 0;
+            int exponent = 0;
+            int digits = 0;
+            for (; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+                if (mantissa < 100000000000000000ull) mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                else exponent++;
+            }
+            if (p < end && *p == '.') {
+                for (p++; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+                    if (mantissa < 100000000000000000ull) {
+                        mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                        exponent--;
+                    }
+                }
+            }
+            if (digits == 0) return start;
+            if (p < end && (*p == 'e' || *p == 'E')) {
+                const char *exponent_start = p++;
+                bool negative_exponent = false;
+                if (p < end && (*p == '-' || *p == '+')) negative_exponent = *p++ == '-';
+                if (p == end || *p < '0' || *p > '9') {
+                    p = exponent_start;
+                } else {
+                    int written = 0;
+                    for (; p < end && *p >= '0' && *p <= '9'; p++) {
+                        if (written < 10000) written = written * 10 + (*p - '0');
+                    }
+                    exponent += negative_exponent ? -written : written;
+                }
+            }
+
+            double result = static_cast<double>(mantissa);
+            int magnitude = std::abs(exponent);
+            double scale = magnitude <= 22 ? powers_of_ten[magnitude] : std::pow(10.0, magnitude);
+            result = exponent < 0 ? result / scale : result * scale;
+            value = static_cast<float>(negative ? -result : result);
+            return p;
+        }
+
+        const char *parse_int(const char *p, const char *end, int64_t &value) {
+            const char *start = p;
+            bool negative = false;
+            if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+            int64_t result = 0;
+            const char *digits = p;
+            for (; p < end && *p >= '0' && *p <= '9'; p++) {
+                // no index or count gets anywhere near INT64_MAX, a longer digit run is rejected
+                if (result > (INT64_MAX - (*p - '0')) / 10) return start;
+                result = result * 10 + (*p - '0');
+            }
+            if (p == digits) return start;
+            value = negative ? -result : result;
+            return p;
+        }
+
+        // ---- JSON, as much as glTF needs ----
+
+        struct Json_Value {
+            enum class Type {null, boolean, number, string, array, object};
+
+            Type type = Type::null;
+            bool boolean = false;
+            double number = 0.0;
+            std::string string;
+            std::vector<Json_Value> array;
+            std::vector<std::pair<std::string, Json_Value>> object;
+
+            const Json_Value *find(const char *key) const {
+                if (type != Type::object) return nullptr;
+                for (const auto &member : object) {
+                    if (member.first == key) return &member.second;
+                }
+                return nullptr;
+            }
+
+            size_t size() const { return type == Type::array ? array.size() : 0; }
+
+            double number_or(const char *key, double fallback) const {
+                const Json_Value *value = find(key);
+                return value && value->type == Type::number ? value->number : fallback;
+            }
+
+            // array indices, UINT32_MAX when missing
+            uint32_t index_or_none(const char *key) const {
+                const Json_Value *value = find(key);
+                if (!value || value->type != Type::number || value->number < 0.0 || value->number >= 4294967295.0) return UINT32_MAX;
+                return static_cast<uint32_t>(value->number);
+            }
+
+            // offsets, lengths and counts: false when present but not a non negative integer up to max,
+            // max has to stay below 2^53 where doubles still hold every integer
+            bool integer_or(const char *key, uint64_t fallback, uint64_t max, uint64_t &result) const {
+                const Json_Value *value = find(key);
+                if (!value) {
+                    result = fallback;
+                    return true;
+                }
+                // written so that NaN fails as well
+                if (value->type != Type::number || !(value->number >= 0.0 && value->number <= static_cast<double>(max)) ||
+                    std::floor(value->number) != value->number) {
+                    return false;
+                }
+                result = static_cast<uint64_t>(value->number);
+                return true;
+            }
+
+            std::string string_or(const char *key, const std::string &fallback) const {
+                const Json_Value *value = find(key);
+                return value && value->type == Type::string ? value->string : fallback;
+            }
+        };
+
+        class Json_Parser {
+        private:
+            const char *p;
+            const char *end;
+            const std::string &name;
+            uint32_t depth = 0;
+
+            [[noreturn]] void fail(const char *what) const {
+                throw std::runtime_error("Invalid JSON in " + name + ": " + what);
+            }
+
+            void skip_whitespace() {
+                while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+            }
+
+            void expect(char c) {
+                skip_whitespace();
+                if (p == end || *p != c) fail("unexpected character");
+                p++;
+            }
+
+            bool match(const char *literal) {
+                size_t length = std::strlen(literal);
+                if (static_cast<size_t>(end - p) < length || std::memcmp(p, literal, length) != 0) return false;
+                p += length;
+                return true;
+            }
+
+            void append_utf8(std::string &out, uint32_t code_point) {
+                if (code_point < 0x80) {
+                    out += static_cast<char>(code_point);
+                } else if (code_point < 0x800) {
+                    out += static_cast<char>(0xc0 | (code_point >> 6));
+                    out += static_cast<char>(0x80 | (code_point & 0x3f));
+                } else {
+                    out += static_cast<char>(0xe0 | (code_point >> 12));
+                    out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3f));
+                    out += static_cast<char>(0x80 | (code_point & 0x3f));
+                }
+            }
+
+            std::string parse_string() {
+                expect('"');
+                std::string result;
+                while (true) {
+                    if (p == end) fail("unterminated string");
+                    char c = *p++;
+                    if (c == '"') return result;
+                    if (c != '\\') {
+                        result += c;
+                        continue;
+                    }
+                    if (p == end) fail("unterminated string");
+                    char escape = *p++;
+                    switch (escape) {
+                        case 'n': result += '\n'; break;
+                        case 't': result += '\t'; break;
+                        case 'r': result += '\r'; break;
+                        case 'b': result += '\b'; break;
+                        case 'f': result += '\f'; break;
+                        case 'u': {
+                            if (end - p < 4) fail("bad unicode escape");
+                            uint32_t code_point = 0;
+                            for (int i = 0; i < 4; i++, p++) {
+                                char h = *p;
+                                code_point <<= 4;
+                                if (h >= '0' && h <= '9') code_point |= static_cast<uint32_t>(h - '0');
+                                else if (h >= 'a' && h <= 'f') code_point |= static_cast<uint32_t>(h - 'a' + 10);
+                                else if (h >= 'A' && h <= 'F') code_point |= static_cast<uint32_t>(h - 'A' + 10);
+                                else fail("bad unicode escape");
+                            }
+                            // names only, a surrogate pair ends up as two replacement sequences
+                            append_utf8(result, code_point);
+                            break;
+                        }
+                        default: result += escape; break;
+                    }
+                }
+            }
+
+        public:
+            Json_Parser(const char *data, size_t size, const std::string &name) : p{data}, end{data + size}, name{name} {}
+
+            Json_Value parse_document() {
+                Json_Value value = parse_value();
+                skip_whitespace();
+                if (p != end) fail("trailing characters");
+                return value;
+            }
+
+            Json_Value parse_value() {
+                if (++depth > 64) fail("nested too deeply");
+                skip_whitespace();
+                if (p == end) fail("unexpected end");
+
+                Json_Value value;
+                if (*p == '{') {
+                    value.type = Json_Value::Type::object;
+                    p++;
+                    skip_whitespace();
+                    if (p < end && *p == '}') {
+                        p++;
+                    } else {
+                        while (true) {
+                            std::string key = parse_string();
+                            expect(':');
+                            value.object.emplace_back(std::move(key), parse_value());
+                            skip_whitespace();
+                            if (p < end && *p == ',') { p++; continue; }
+                            expect('}');
+                            break;
+                        }
+                    }
+                } else if (*p == '[') {
+                    value.type = Json_Value::Type::array;
+                    p++;
+                    skip_whitespace();
+                    if (p < end && *p == ']') {
+                        p++;
+                    } else {
+                        while (true) {
+                            value.array.push_back(parse_value());
+                            skip_whitespace();
+                            if (p < end && *p == ',') { p++; continue; }
+                            expect(']');
+                            break;
+                        }
+                    }
+                } else if (*p == '"') {
+                    value.type = Json_Value::Type::string;
+                    value.string = parse_string();
+                } else if (match("true")) {
+                    value.type = Json_Value::Type::boolean;
+                    value.boolean = true;
+                } else if (match("false")) {
+                    value.type = Json_Value::Type::boolean;
+                } else if (match("null")) {
+                    value.type = Json_Value::Type::null;
+                } else {
+                    float number;
+                    const char *after = parse_float(p, end, number);
+                    if (after == p) fail("unexpected character");
+                    // integers beyond float precision are offsets and counts, parse those exactly
+                    int64_t integer;
+                    const char *integer_end = parse_int(p, end, integer);
+                    value.type = Json_Value::Type::number;
+                    value.number = integer_end == after ? static_cast<double>(integer) : number;
+                    p = after;
+                }
+                depth--;
+                return value;
+            }
+        };
+
+        // ---- OBJ ----
+
+        struct Obj_Corner {
+            uint32_t position;
+            uint32_t uv;
+            uint32_t normal;
+
+            bool operator==(const Obj_Corner &other) const {
+                return position == other.position && uv == other.uv && normal == other.normal;
+            }
+        };
+
+        struct Obj_Corner_Hash {
+            size_t operator()(const Obj_Corner &corner) const {
+                uint64_t h = corner.position * 0x9e3779b97f4a7c15ull;
+                h ^= (corner.uv + 0x632be59bd9b4e019ull) * 0xbf58476d1ce4e5b9ull;
+                h ^= (corner.normal + 0x94d049bb133111ebull) * 0x94d049bb133111ebull;
+                return static_cast<size_t>(h ^ (h >> 31));
+            }
+        };
+
+        constexpr uint32_t NO_OBJ_INDEX = UINT32_MAX;
+
+        // 1 based, negative counts back from the last element read so far
+        uint32_t resolve_obj_index(int64_t index, size_t count) {
+            if (index > 0 && static_cast<size_t>(index) <= count) return static_cast<uint32_t>(index - 1);
+            if (index < 0 && static_cast<size_t>(-index) <= count) return static_cast<uint32_t>(count + index);
+            return NO_OBJ_INDEX;
+        }
+
+        // ---- glTF ----
+
+        constexpr uint32_t GLB_MAGIC = 0x46546c67;        // "glTF"
+        constexpr uint32_t GLB_CHUNK_JSON = 0x4e4f534a;   // "JSON"
+        constexpr uint32_t GLB_CHUNK_BIN = 0x004e4942;    // "BIN\0"
+
+        enum Gltf_Component : uint32_t {
+            gltf_byte = 5120,
+            gltf_unsigned_byte = 5121,
+            gltf_short = 5122,
+            gltf_unsigned_short = 5123,
+            gltf_unsigned_int = 5125,
+            gltf_float = 5126
+        };
+
+        uint32_t component_size(uint32_t component_type) {
+            switch (component_type) {
+                case gltf_byte:
+                case gltf_unsigned_byte: return 1;
+                case gltf_short:
+                case gltf_unsigned_short: return 2;
+                case gltf_unsigned_int:
+                case gltf_float: return 4;
+                default: return 0;
+            }
+        }
+
+        uint32_t component_count(const std::string &type) {
+            if (type == "SCALAR") return 1;
+            if (type == "VEC2") return 2;
+            if (type == "VEC3") return 3;
+            if (type == "VEC4") return 4;
+            // matrices are never vertex attributes or indices
+            return 0;
+        }
+
+        float read_component(const uint8_t *data, uint32_t component_type, bool normalized) {
+            switch (component_type) {
+                case gltf_float: {
+                    float value;
+                    std::memcpy(&value, data, sizeof(value));
+                    return value;
+                }
+                case gltf_unsigned_byte: return normalized ? data[0] / 255.0f : data[0];
+                case gltf_byte: {
+                    auto value = static_cast<int8_t>(data[0]);
+                    return normalized ? std::max(value / 127.0f, -1.0f) : value;
+                }
+                case gltf_unsigned_short: {
+                    uint16_t value;
+                    std::memcpy(&value, data, sizeof(value));
+                    return normalized ? value / 65535.0f : value;
+                }
+                case gltf_short: {
+                    int16_t value;
+                    std::memcpy(&value, data, sizeof(value));
+                    return normalized ? std::max(value / 32767.0f, -1.0f) : value;
+                }
+                default: return 0.0f;
+            }
+        }
+
+        uint32_t read_index(const uint8_t *data, uint32_t component_type) {
+            switch (component_type) {
+                case gltf_unsigned_byte: return data[0];
+                case gltf_unsigned_short: {
+                    uint16_t value;
+                    std::memcpy(&value, data, sizeof(value));
+                    return value;
+                }
+                default: {
+                    uint32_t value;
+                    std::memcpy(&value, data, sizeof(value));
+                    return value;
+                }
+            }
+        }
+
+        uint32_t read_u32(const uint8_t *data) {
+            uint32_t value;
+            std::memcpy(&value, data, sizeof(value));
+            return value;
+        }
+    } // namespace
+
+    void Mesh_Data::compute_bounds() {
+        if (vertices.empty()) return;
+        for (int axis = 0; axis < 3; axis++) {
+            bounds_min[axis] = vertices[0].position[axis];
+            bounds_max[axis] = vertices[0].position[axis];
+        }
+        for (const auto &vertex : vertices) {
+            for (int axis = 0; axis < 3; axis++) {
+                bounds_min[axis] = std::min(bounds_min[axis], vertex.position[axis]);
+                bounds_max[axis] = std::max(bounds_max[axis], vertex.position[axis]);
+            }
+        }
+    }
+
+    void Mesh_Data::generate_normals() {
+        for (auto &vertex : vertices) {
+            vertex.normal[0] = vertex.normal[1] = vertex.normal[2] = 0.0f;
+        }
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            Mesh_Vertex &a = vertices[indices[i]];
+            Mesh_Vertex &b = vertices[indices[i + 1]];
+            Mesh_Vertex &c = vertices[indices[i + 2]];
+            float ab[3], ac[3];
+            for (int axis = 0; axis < 3; axis++) {
+                ab[axis] = b.position[axis] - a.position[axis];
+                ac[axis] = c.position[axis] - a.position[axis];
+            }
+            // unnormalized, its length is twice the area
+            const float normal[3] = {
+                    ab[1] * ac[2] - ab[2] * ac[1],
+                    ab[2] * ac[0] - ab[0] * ac[2],
+                    ab[0] * ac[1] - ab[1] * ac[0]
+            };
+            for (int axis = 0; axis < 3; axis++) {
+                a.normal[axis] += normal[axis];
+                b.normal[axis] += normal[axis];
+                c.normal[axis] += normal[axis];
+            }
+        }
+        for (auto &vertex : vertices) {
+            float length = std::sqrt(vertex.normal[0] * vertex.normal[0] +
+                                     vertex.normal[1] * vertex.normal[1] +
+                                     vertex.normal[2] * vertex.normal[2]);
+            if (length > 0.0f) {
+                for (float &component : vertex.normal) component /= length;
+            } else {
+                vertex.normal[1] = 1.0f;
+            }
+        }
+    }
+
+    Mesh_Format mesh_format_of(const std::string &path) {
+        std::string extension = std::filesystem::path(path).extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) {
+            return static_cast<char>(std::tolower(c));
+        });
+        if (extension == ".obj") return Mesh_Format::obj;
+        if (extension == ".gltf") return Mesh_Format::gltf;
+        if (extension == ".glb") return Mesh_Format::glb;
+        throw std::runtime_error("Unknown mesh format: " + path);
+    }
+
+    static std::vector<Mesh_Data> parse_obj(const void *data, size_t size, const std::string &path) {
+        const char *p = static_cast<const char *>(data);
+        const char *end = p + size;
+
+        std::vector<float> positions;
+        std::vector<float> normals;
+        std::vector<float> uvs;
+
+        std::vector<Mesh_Data> meshes;
+        Mesh_Data mesh;
+        mesh.name = std::filesystem::path(path).stem().string();
+        bool mesh_has_normals = true;
+        std::unordered_map<Obj_Corner, uint32_t, Obj_Corner_Hash> corners;
+        std::vector<uint32_t> face;
+
+        auto finish_mesh = [&](const std::string &next_name) {
+            if (!mesh.indices.empty()) {
+                if (!mesh_has_normals) mesh.generate_normals();
+                mesh.compute_bounds();
+                meshes.push_back(std::move(mesh));
+            }
+            mesh = Mesh_Data{};
+            mesh.name = next_name;
+            mesh_has_normals = true;
+            corners.clear();
+        };
+
+        size_t line_number = 0;
+        while (p < end) {
+            line_number++;
+            const char *line_end = next_line(p, end);
+            const char *q = skip_spaces(p, line_end);
+            const char *line = q;
+            p = line_end;
+            if (q == line_end || *q == '#' || *q == '\n') continue;
+
+            auto fail = [&](const char *what) {
+                throw std::runtime_error("Invalid OBJ " + path + " line " + std::to_string(line_number) + ": " + what);
+            };
+            auto keyword = [&](const char *word) {
+                size_t length = std::strlen(word);
+                if (static_cast<size_t>(line_end - line) <= length || std::memcmp(line, word, length) != 0) return false;
+                if (!is_space(line[length])) return false;
+                q = line + length;
+                return true;
+            };
+            auto read_floats = [&](std::vector<float> &out, int count) {
+                for (int i = 0; i < count; i++) {
+                    float value = 0.0f;
+                    q = skip_spaces(q, line_end);
+                    const char *after = parse_float(q, line_end, value);
+                    if (after == q) fail("expected a number");
+                    q = after;
+                    out.push_back(value);
+                }
+            };
+
+            if (keyword("v")) {
+                read_floats(positions, 3);
+            } else if (keyword("vn")) {
+                read_floats(normals, 3);
+            } else if (keyword("vt")) {
+                read_floats(uvs, 2);
+            } else if (keyword("f")) {
+                face.clear();
+                while (true) {
+                    q = skip_spaces(q, line_end);
+                    if (q == line_end || *q == '\n' || *q == '#') break;
+
+                    int64_t index = 0;
+                    const char *after = parse_int(q, line_end, index);
+                    if (after == q) fail("expected a vertex index");
+                    q = after;
+                    Obj_Corner corner{resolve_obj_index(index, positions.size() / 3), NO_OBJ_INDEX, NO_OBJ_INDEX};
+                    if (corner.position == NO_OBJ_INDEX) fail("vertex index out of range");
+                    if (q < line_end && *q == '/') {
+                        q++;
+                        if (q < line_end && *q != '/') {
+                            after = parse_int(q, line_end, index);
+                            if (after == q) fail("expected a texture coordinate index");
+                            q = after;
+                            corner.uv = resolve_obj_index(index, uvs.size() / 2);
+                            if (corner.uv == NO_OBJ_INDEX) fail("texture coordinate index out of range");
+                        }
+                        if (q < line_end && *q == '/') {
+                            q++;
+                            after = parse_int(q, line_end, index);
+                            if (after == q) fail("expected a normal index");
+                            q = after;
+                            corner.normal = resolve_obj_index(index, normals.size() / 3);
+                            if (corner.normal == NO_OBJ_INDEX) fail("normal index out of range");
+                        }
+                    }
+
+                    auto inserted = corners.emplace(corner, static_cast<uint32_t>(mesh.vertices.size()));
+                    if (inserted.second) {
+                        Mesh_Vertex vertex{};
+                        std::memcpy(vertex.position, &positions[corner.position * 3], sizeof(vertex.position));
+                        if (corner.normal != NO_OBJ_INDEX) {
+                            std::memcpy(vertex.normal, &normals[corner.normal * 3], sizeof(vertex.normal));
+                        } else {
+                            mesh_has_normals = false;
+                        }
+                        if (corner.uv != NO_OBJ_INDEX) {
+                            vertex.uv[0] = uvs[corner.uv * 2];
+                            // OBJ puts the origin bottom left
+                            vertex.uv[1] = 1.0f - uvs[corner.uv * 2 + 1];
+                        }
+                        mesh.vertices.push_back(vertex);
+                    }
+                    face.push_back(inserted.first->second);
+                }
+                if (face.size() < 3) fail("face with less than three vertices");
+                // polygons as a fan, fine for the convex ones exporters write
+                for (size_t i = 1; i + 1 < face.size(); i++) {
+                    mesh.indices.push_back(face[0]);
+                    mesh.indices.push_back(face[i]);
+                    mesh.indices.push_back(face[i + 1]);
+                }
+            } else if (keyword("o") || keyword("g")) {
+                q = skip_spaces(q, line_end);
+                const char *name_end = line_end;
+                while (name_end > q && (name_end[-1] == '\n' || is_space(name_end[-1]))) name_end--;
+                finish_mesh(std::string(q, name_end));
+            }
+            // materials, smoothing groups, lines and points are skipped
+        }
+        finish_mesh({});
+        return meshes;
+    }
+
+    std::vector<Mesh_Data> load_obj(const std::string &path, size_t *bytes_read) {
+        MappedFile file{path};
+        if (bytes_read) *bytes_read = file.size();
+        return parse_obj(file.data(), file.size(), path);
+    }
+
+    std::vector<Mesh_Data> load_obj(const AssetArchive &archive, const std::string &name, size_t *bytes_read) {
+        const Archive_Entry *entry = archive.find(name);
+        if (entry == nullptr) throw std::runtime_error("Asset not found in " + archive.path() + ": " + name);
+        if (bytes_read) *bytes_read = entry->size;
+        if (entry->compression == Archive_Compression::none) {
+            Asset_View contents = archive.view(*entry);
+            return parse_obj(contents.data, contents.size, name);
+        }
+        std::vector<char> contents = archive.read(*entry);
+        return parse_obj(contents.data(), contents.size(), name);
+    }
+
+    GltfFile::GltfFile(const std::string &path) : path{path}, file{path} {
+        open(static_cast<const uint8_t *>(file.data()), file.size());
+    }
+
+    GltfFile::GltfFile(const AssetArchive &archive, const std::string &name) : path{name}, archive{&archive} {
+        const Archive_Entry *entry = archive.find(name);
+        if (entry == nullptr) throw std::runtime_error("Asset not found in " + archive.path() + ": " + name);
+        if (entry->compression == Archive_Compression::none) {
+            Asset_View contents = archive.view(*entry);
+            open(static_cast<const uint8_t *>(contents.data), contents.size);
+        } else {
+            owned_buffers.push_back(archive.read(*entry));
+            open(reinterpret_cast<const uint8_t *>(owned_buffers.back().data()), owned_buffers.back().size());
+        }
+    }
+
+    void GltfFile::open(const uint8_t *data, size_t size) {
+        bytes_read = size;
+
+        if (mesh_format_of(path) != Mesh_Format::glb) {
+            parse(reinterpret_cast<const char *>(data), size, nullptr, 0);
+            return;
+        }
+
+        // 12 byte header, then chunks of length, type and data padded to 4 bytes
+        if (size < 20 || read_u32(data) != GLB_MAGIC || read_u32(data + 4) != 2) {
+            throw std::runtime_error("Invalid GLB header: " + path);
+        }
+        size_t length = std::min<size_t>(read_u32(data + 8), size);
+        const char *json = nullptr;
+        size_t json_size = 0;
+        const uint8_t *binary = nullptr;
+        size_t binary_size = 0;
+        for (size_t offset = 12; offset + 8 <= length;) {
+            size_t chunk_size = read_u32(data + offset);
+            uint32_t chunk_type = read_u32(data + offset + 4);
+            if (chunk_size > length - offset - 8) throw std::runtime_error("Invalid GLB chunk: " + path);
+            if (chunk_type == GLB_CHUNK_JSON && !json) {
+                json = reinterpret_cast<const char *>(data + offset + 8);
+                json_size = chunk_size;
+            } else if (chunk_type == GLB_CHUNK_BIN && !binary) {
+                binary = data + offset + 8;
+                binary_size = chunk_size;
+            }
+            offset += 8 + ((chunk_size + 3) & ~size_t{3});
+        }
+        if (!json) throw std::runtime_error("GLB without JSON chunk: " + path);
+        parse(json, json_size, binary, binary_size);
+    }
+
+    void GltfFile::parse(const char *json, size_t json_size, const uint8_t *binary_chunk, size_t binary_size) {
+        const Json_Value document = Json_Parser{json, json_size, path}.parse_document();
+        auto fail = [&](const std::string &what) {
+            throw std::runtime_error("Invalid glTF " + path + ": " + what);
+        };
+        // checked before the cast, a negative or huge double does not convert to size_t
+        constexpr uint64_t max_size = std::min<uint64_t>(SIZE_MAX, (uint64_t{1} << 53) - 1);
+        auto integer = [&](const Json_Value &object, const char *key, uint64_t fallback, uint64_t max) {
+            uint64_t value = 0;
+            if (!object.integer_or(key, fallback, max, value)) fail(std::string(key) + " is not a valid integer");
+            return value;
+        };
+
+        const Json_Value *asset = document.find("asset");
+        if (!asset || asset->string_or("version", "").compare(0, 1, "2") != 0) fail("only glTF 2.0 is supported");
+
+        const std::filesystem::path directory = std::filesystem::path(path).parent_path();
+        if (const Json_Value *buffer_list = document.find("buffers")) {
+            for (const auto &buffer : buffer_list->array) {
+                const Json_Value *uri = buffer.find("uri");
+                const size_t byte_length = static_cast<size_t>(integer(buffer, "byteLength", 0, max_size));
+                if (!uri) {
+                    if (!binary_chunk || binary_size < byte_length) fail("buffer without uri and no matching GLB chunk");
+                    buffers.push_back(binary_chunk);
+                    buffer_sizes.push_back(byte_length);
+                    continue;
+                }
+                if (uri->string.compare(0, 5, "data:") == 0) fail("embedded data uris are not supported, export with a .bin");
+                const uint8_t *buffer_data;
+                size_t buffer_size;
+                if (archive) {
+                    // packed next to the .gltf, under the name the packer gave it
+                    const std::string name = (directory / uri->string).generic_string();
+                    const Archive_Entry *entry = archive->find(name);
+                    if (entry == nullptr) fail(uri->string + " is not in " + archive->path());
+                    if (entry->compression == Archive_Compression::none) {
+                        Asset_View contents = archive->view(*entry);
+                        buffer_data = static_cast<const uint8_t *>(contents.data);
+                        buffer_size = contents.size;
+                    } else {
+                        owned_buffers.push_back(archive->read(*entry));
+                        buffer_data = reinterpret_cast<const uint8_t *>(owned_buffers.back().data());
+                        buffer_size = owned_buffers.back().size();
+                    }
+                } else {
+                    buffer_files.emplace_back((directory / uri->string).string());
+                    buffer_data = static_cast<const uint8_t *>(buffer_files.back().data());
+                    buffer_size = buffer_files.back().size();
+                }
+                if (buffer_size < byte_length) fail(uri->string + " is shorter than its byteLength");
+                buffers.push_back(buffer_data);
+                buffer_sizes.push_back(byte_length);
+                bytes_read += buffer_size;
+            }
+        }
+
+        if (const Json_Value *view_list = document.find("bufferViews")) {
+            for (const auto &view : view_list->array) {
+                Gltf_Buffer_View buffer_view{};
+                buffer_view.buffer = view.index_or_none("buffer");
+                buffer_view.byte_offset = static_cast<size_t>(integer(view, "byteOffset", 0, max_size));
+                buffer_view.byte_length = static_cast<size_t>(integer(view, "byteLength", 0, max_size));
+                buffer_view.byte_stride = static_cast<size_t>(integer(view, "byteStride", 0, max_size));
+                // checked by parts like validate(), the sum of two hostile values can wrap around
+                if (buffer_view.buffer >= buffers.size() ||
+                    buffer_view.byte_offset > buffer_sizes[buffer_view.buffer] ||
+                    buffer_view.byte_length > buffer_sizes[buffer_view.buffer] - buffer_view.byte_offset) {
+                    fail("buffer view out of range");
+                }
+                buffer_views.push_back(buffer_view);
+            }
+        }
+
+        if (const Json_Value *accessor_list = document.find("accessors")) {
+            for (const auto &accessor_value : accessor_list->array) {
+                Gltf_Accessor accessor{};
+                // accessors without a buffer view are all zeros, left for validate() to reject
+                accessor.buffer_view = accessor_value.index_or_none("bufferView");
+                accessor.byte_offset = static_cast<size_t>(integer(accessor_value, "byteOffset", 0, max_size));
+                accessor.component_type = static_cast<uint32_t>(integer(accessor_value, "componentType", 0, UINT32_MAX));
+                accessor.count = static_cast<size_t>(integer(accessor_value, "count", 0, max_size));
+                accessor.components = component_count(accessor_value.string_or("type", ""));
+                if (const Json_Value *normalized = accessor_value.find("normalized")) accessor.normalized = normalized->boolean;
+                if (accessor_value.find("sparse")) fail("sparse accessors are not supported");
+                accessors.push_back(accessor);
+            }
+        }
+
+        if (const Json_Value *mesh_list = document.find("meshes")) {
+            for (size_t m = 0; m < mesh_list->array.size(); m++) {
+                const Json_Value &mesh = mesh_list->array[m];
+                std::string mesh_name = mesh.string_or("name", "mesh_" + std::to_string(m));
+                const Json_Value *primitive_list = mesh.find("primitives");
+                if (!primitive_list) continue;
+                for (size_t p = 0; p < primitive_list->array.size(); p++) {
+                    const Json_Value &primitive_value = primitive_list->array[p];
+                    // 4 is TRIANGLES and the default, strips, fans, lines and points are skipped
+                    if (primitive_value.number_or("mode", 4) != 4) continue;
+                    const Json_Value *attributes = primitive_value.find("attributes");
+                    if (!attributes || !attributes->find("POSITION")) continue;
+
+                    Gltf_Primitive primitive{};
+                    primitive.name = primitive_list->array.size() > 1 ? mesh_name + "/" + std::to_string(p) : mesh_name;
+                    primitive.position = attributes->index_or_none("POSITION");
+                    primitive.normal = attributes->index_or_none("NORMAL");
+                    primitive.texcoord = attributes->index_or_none("TEXCOORD_0");
+                    primitive.indices = primitive_value.index_or_none("indices");
+
+                    validate(primitive.position, "POSITION");
+                    if (accessors[primitive.position].components != 3) fail("POSITION is not a VEC3");
+                    if (primitive.normal != NO_ACCESSOR) validate(primitive.normal, "NORMAL");
+                    if (primitive.texcoord != NO_ACCESSOR) validate(primitive.texcoord, "TEXCOORD_0");
+                    if (primitive.indices != NO_ACCESSOR) validate(primitive.indices, "indices");
+                    primitives.push_back(std::move(primitive));
+                }
+            }
+        }
+    }
+
+    void GltfFile::validate(uint32_t accessor_index, const char *what) const {
+        auto fail = [&](const std::string &why) {
+            throw std::runtime_error("Invalid glTF " + path + ": " + what + " " + why);
+        };
+        if (accessor_index >= accessors.size()) fail("accessor out of range");
+        const Gltf_Accessor &accessor = accessors[accessor_index];
+        if (accessor.buffer_view >= buffer_views.size()) fail("has no buffer view");
+        if (accessor.components == 0 || component_size(accessor.component_type) == 0) fail("has an unsupported type");
+        if (accessor.count == 0) return;
+
+        const Gltf_Buffer_View &view = buffer_views[accessor.buffer_view];
+        size_t element_size = accessor.components * component_size(accessor.component_type);
+        size_t stride = view.byte_stride != 0 ? view.byte_stride : element_size;
+        // checked by parts, a hostile count or offset must not wrap the sum around
+        if (accessor.byte_offset > view.byte_length || element_size > view.byte_length - accessor.byte_offset) {
+            fail("runs past its buffer view");
+        }
+        size_t room = view.byte_length - accessor.byte_offset - element_size;
+        if (accessor.count - 1 > room / stride) fail("runs past its buffer view");
+    }
+
+    const uint8_t *GltfFile::element(const Gltf_Accessor &accessor, size_t index) const {
+        const Gltf_Buffer_View &view = buffer_views[accessor.buffer_view];
+        size_t element_size = accessor.components * component_size(accessor.component_type);
+        size_t stride = view.byte_stride != 0 ? view.byte_stride : element_size;
+        return buffers[view.buffer] + view.byte_offset + accessor.byte_offset + stride * index;
+    }
+
+    Mesh_Data GltfFile::decode(size_t primitive_index) const {
+        const Gltf_Primitive &primitive = primitives.at(primitive_index);
+        const Gltf_Accessor &positions = accessors[primitive.position];
+
+        Mesh_Data mesh;
+        mesh.name = primitive.name;
+        mesh.vertices.resize(positions.count);
+
+        auto read_attribute = [&](uint32_t accessor_index, size_t offset, uint32_t components) {
+            const Gltf_Accessor &accessor = accessors[accessor_index];
+            uint32_t size = component_size(accessor.component_type);
+            size_t count = std::min(accessor.count, mesh.vertices.size());
+            uint32_t used = std::min(components, accessor.components);
+            for (size_t i = 0; i < count; i++) {
+                const uint8_t *source = element(accessor, i);
+                auto *target = reinterpret_cast<float *>(reinterpret_cast<uint8_t *>(&mesh.vertices[i]) + offset);
+                for (uint32_t c = 0; c < used; c++) {
+                    target[c] = read_component(source + c * size, accessor.component_type, accessor.normalized);
+                }
+            }
+        };
+        read_attribute(primitive.position, offsetof(Mesh_Vertex, position), 3);
+        if (primitive.texcoord != NO_ACCESSOR) read_attribute(primitive.texcoord, offsetof(Mesh_Vertex, uv), 2);
+
+        if (primitive.indices != NO_ACCESSOR) {
+            const Gltf_Accessor &indices = accessors[primitive.indices];
+            mesh.indices.resize(indices.count - indices.count % 3);
+            for (size_t i = 0; i < mesh.indices.size(); i++) {
+                uint32_t index = read_index(element(indices, i), indices.component_type);
+                if (index >= mesh.vertices.size()) {
+                    throw std::runtime_error("Invalid glTF " + path + ": index out of range in " + primitive.name);
+                }
+                mesh.indices[i] = index;
+            }
+        } else {
+            mesh.indices.resize(mesh.vertices.size() - mesh.vertices.size() % 3);
+            for (size_t i = 0; i < mesh.indices.size(); i++) {
+                mesh.indices[i] = static_cast<uint32_t>(i);
+            }
+        }
+
+        if (primitive.normal != NO_ACCESSOR) {
+            read_attribute(primitive.normal, offsetof(Mesh_Vertex, normal), 3);
+        } else {
+            mesh.generate_normals();
+        }
+        mesh.compute_bounds();
+        return mesh;
+    }
+
+} // namespace file_io
@@ -0,0 +1,135 @@
+/**
+ * library_support/File/mesh
+ *
+ * Memory mapped OBJ and glTF 2.0 mesh parsing
+ *
+ * Files are mapped, never read into a buffer, and decoded into one
+ * interleaved vertex layout with 32 bit indices, whatever the source format
+ * stored. OBJ files are parsed in one pass with their own number parser,
+ * identical position/uv/normal triples become one vertex. glTF files (.gltf
+ * with external .bin buffers or a single .glb) are opened first, which parses
+ * the JSON and maps the buffers, every primitive can then be decoded on its
+ * own thread. Both read from an AssetArchive as well, stored assets are then
+ * parsed in place in the archive's mapping.
+ *
+ * Only triangle lists are imported, node transforms, materials, skins and
+ * morph targets are ignored. Missing normals are generated from the faces.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_FILE_MESH_PARSER_H
+#define PIXEL_ENGINE_FILE_MESH_PARSER_H
+
+#pragma once
+
+#include "../archive/asset_archive.hpp"
+#include "../mapped_file/mapped_file.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace file_io{
+    // 32 bytes, binding 0 of every mesh pipeline
+    struct Mesh_Vertex {
+        float position[3];
+        float normal[3];
+        // origin top left, as Vulkan samples
+        float uv[2];
+    };
+
+    struct Mesh_Data {
+        std::string name;
+        std::vector<Mesh_Vertex> vertices;
+        std::vector<uint32_t> indices;
+        float bounds_min[3] = {0.0f, 0.0f, 0.0f};
+        float bounds_max[3] = {0.0f, 0.0f, 0.0f};
+
+        void compute_bounds();
+        // smooth normals, area weighted, for sources that have none
+        void generate_normals();
+    };
+
+    enum class Mesh_Format {obj, gltf, glb};
+
+    // by extension, throws std::runtime_error for anything else
+    Mesh_Format mesh_format_of(const std::string &path);
+
+    // one Mesh_Data per object or group, throws std::runtime_error naming the line on malformed input
+    std::vector<Mesh_Data> load_obj(const std::string &path, size_t *bytes_read = nullptr);
+    // an asset of the archive, parsed straight from its mapping unless it is compressed
+    std::vector<Mesh_Data> load_obj(const AssetArchive &archive, const std::string &name, size_t *bytes_read = nullptr);
+
+    class GltfFile {
+    private:
+        struct Gltf_Buffer_View {
+            uint32_t buffer = 0;
+            size_t byte_offset = 0;
+            size_t byte_length = 0;
+            // 0 for tightly packed
+            size_t byte_stride = 0;
+        };
+
+        struct Gltf_Accessor {
+            uint32_t buffer_view = 0;
+            size_t byte_offset = 0;
+            uint32_t component_type = 0;
+            size_t count = 0;
+            // 1 for SCALAR up to 4 for VEC4
+            uint32_t components = 0;
+            bool normalized = false;
+        };
+
+        static constexpr uint32_t NO_ACCESSOR = UINT32_MAX;
+
+        struct Gltf_Primitive {
+            std::string name;
+            uint32_t position = NO_ACCESSOR;
+            uint32_t normal = NO_ACCESSOR;
+            uint32_t texcoord = NO_ACCESSOR;
+            uint32_t indices = NO_ACCESSOR;
+        };
+
+        // the asset name when opened from an archive
+        std::string path;
+        MappedFile file;
+        // null for loose files, .bin buffers are looked up next to the .gltf in it otherwise
+        const AssetArchive *archive = nullptr;
+        // external .bin files, the .glb binary chunk lives in file
+        std::vector<MappedFile> buffer_files;
+        // compressed archive assets, decompressed
+        std::vector<std::vector<char>> owned_buffers;
+        std::vector<const uint8_t *> buffers;
+        std::vector<size_t> buffer_sizes;
+        std::vector<Gltf_Buffer_View> buffer_views;
+        std::vector<Gltf_Accessor> accessors;
+        std::vector<Gltf_Primitive> primitives;
+        size_t bytes_read = 0;
+
+        void open(const uint8_t *data, size_t size);
+        void parse(const char *json, size_t json_size, const uint8_t *binary_chunk, size_t binary_size);
+        // element i of the accessor, checked against its buffer view
+        const uint8_t *element(const Gltf_Accessor &accessor, size_t index) const;
+        void validate(uint32_t accessor_index, const char *what) const;
+
+    public:
+        // parses the JSON and maps every buffer, throws std::runtime_error on anything malformed
+        explicit GltfFile(const std::string &path);
+        // an asset of an archive that outlives the GltfFile, buffers are other assets named relative to it
+        GltfFile(const AssetArchive &archive, const std::string &name);
+
+        GltfFile(const GltfFile &) = delete;
+        GltfFile &operator = (const GltfFile &) = delete;
+
+        size_t primitive_count() const { return primitives.size(); }
+        // safe from any thread, the file is only read
+        Mesh_Data decode(size_t primitive) const;
+        // the .gltf or .glb and every buffer file
+        size_t get_bytes_read() const { return bytes_read; }
+    };
+
+} // namespace file_io
+
+
+#endif // PIXEL_ENGINE_FILE_MESH_PARSER_H
@@ -0,0 +1,273 @@
+/**
+ * library_support/File/texture
+ *
+ **/
+
+// match hpp file
+#include "texture_file.hpp"
+//standard libraries
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace file_io{
+    namespace {
+        const unsigned char KTX2_IDENTIFIER[12] = {0xab, 'K', 'T', 'X', ' ', '2', '0', 0xbb, '\r', '\n', 0x1a, '\n'};
+        constexpr size_t KTX2_HEADER_SIZE = 80;
+        constexpr size_t KTX2_LEVEL_INDEX_ENTRY_SIZE = 24;
+
+        constexpr uint32_t DDS_MAGIC = 0x20534444; // "DDS "
+        constexpr size_t DDS_HEADER_SIZE = 4 + 124;
+        constexpr size_t DDS_DX10_HEADER_SIZE = 20;
+        constexpr uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+        constexpr uint32_t DDPF_FOURCC = 0x4;
+        constexpr uint32_t DDPF_RGB = 0x40;
+        constexpr uint32_t DDSCAPS2_CUBEMAP = 0x200;
+        constexpr uint32_t DDSCAPS2_VOLUME = 0x200000;
+        constexpr uint32_t D3D10_RESOURCE_DIMENSION_TEXTURE2D = 3;
+        constexpr uint32_t D3D10_RESOURCE_MISC_TEXTURECUBE = 0x4;
+        // above every device's maxImageDimension2D, keeps the level sizes far from overflowing
+        constexpr uint32_t MAX_DIMENSION = 65536;
+
+        constexpr uint32_t four_cc(char a, char b, char c, char d) {
+            return static_cast<uint32_t>(a) | static_cast<uint32_t>(b) << 8 |
+                   static_cast<uint32_t>(c) << 16 | static_cast<uint32_t>(d) << 24;
+        }
+
+        struct Format_Mapping {
+            uint32_t code;
+            Texture_Format format;
+            bool srgb;
+        };
+
+        // VkFormat values, which is what KTX2 stores
+        const Format_Mapping VK_FORMATS[] = {
+                {37, Texture_Format::rgba8, false}, {43, Texture_Format::rgba8, true},
+                {131, Texture_Format::bc1_rgb, false}, {132, Texture_Format::bc1_rgb, true},
+                {133, Texture_Format::bc1_rgba, false}, {134, Texture_Format::bc1_rgba, true},
+                {135, Texture_Format::bc2, false}, {136, Texture_Format::bc2, true},
+                {137, Texture_Format::bc3, false}, {138, Texture_Format::bc3, true},
+                {139, Texture_Format::bc4_unorm, false}, {140, Texture_Format::bc4_snorm, false},
+                {141, Texture_Format::bc5_unorm, false}, {142, Texture_Format::bc5_snorm, false},
+                {143, Texture_Format::bc6h_ufloat, false}, {144, Texture_Format::bc6h_sfloat, false},
+                {145, Texture_Format::bc7, false}, {146, Texture_Format::bc7, true},
+        };
+
+        // DXGI_FORMAT values of the DX10 extended DDS header
+        const Format_Mapping DXGI_FORMATS[] = {
+                {28, Texture_Format::rgba8, false}, {29, Texture_Format::rgba8, true},
+                {71, Texture_Format::bc1_rgba, false}, {72, Texture_Format::bc1_rgba, true},
+                {74, Texture_Format::bc2, false}, {75, Texture_Format::bc2, true},
+                {77, Texture_Format::bc3, false}, {78, Texture_Format::bc3, true},
+                {80, Texture_Format::bc4_unorm, false}, {81, Texture_Format::bc4_snorm, false},
+                {83, Texture_Format::bc5_unorm, false}, {84, Texture_Format::bc5_snorm, false},
+                {95, Texture_Format::bc6h_ufloat, false}, {96, Texture_Format::bc6h_sfloat, false},
+                {98, Texture_Format::bc7, false}, {99, Texture_Format::bc7, true},
+        };
+
+        // the FourCC codes of legacy DDS files
+        const Format_Mapping FOUR_CC_FORMATS[] = {
+                {four_cc('D', 'X', 'T', '1'), Texture_Format::bc1_rgba, false},
+                {four_cc('D', 'X', 'T', '3'), Texture_Format::bc2, false},
+                {four_cc('D', 'X', 'T', '5'), Texture_Format::bc3, false},
+                {four_cc('A', 'T', 'I', '1'), Texture_Format::bc4_unorm, false},
+                {four_cc('B', 'C', '4', 'U'), Texture_Format::bc4_unorm, false},
+                {four_cc('B', 'C', '4', 'S'), Texture_Format::bc4_snorm, false},
+                {four_cc('A', 'T', 'I', '2'), Texture_Format::bc5_unorm, false},
+                {four_cc('B', 'C', '5', 'U'), Texture_Format::bc5_unorm, false},
+                {four_cc('B', 'C', '5', 'S'), Texture_Format::bc5_snorm, false},
+        };
+
+        template<size_t N>
+        const Format_Mapping *find_format(const Format_Mapping (&mappings)[N], uint32_t code) {
+            for (const auto &mapping : mappings) {
+                if (mapping.code == code) return &mapping;
+            }
+            return nullptr;
+        }
+
+        uint32_t read_u32(const unsigned char *data, size_t offset) {
+            uint32_t value;
+            std::memcpy(&value, data + offset, sizeof(value));
+            return value;
+        }
+
+        uint64_t read_u64(const unsigned char *data, size_t offset) {
+            uint64_t value;
+            std::memcpy(&value, data + offset, sizeof(value));
+            return value;
+        }
+    } // namespace
+
+    uint32_t texture_block_bytes(Texture_Format format) {
+        switch (format) {
+            case Texture_Format::rgba8:
+                return 4;
+            case Texture_Format::bc1_rgb:
+            case Texture_Format::bc1_rgba:
+            case Texture_Format::bc4_unorm:
+            case Texture_Format::bc4_snorm:
+                return 8;
+            default:
+                return 16;
+        }
+    }
+
+    bool is_block_compressed(Texture_Format format) {
+        return format != Texture_Format::rgba8;
+    }
+
+    size_t texture_level_size(Texture_Format format, uint32_t width, uint32_t height) {
+        if (!is_block_compressed(format)) return static_cast<size_t>(width) * height * texture_block_bytes(format);
+        // partial blocks at the edges are stored whole
+        size_t blocks_wide = std::max<size_t>(1, (static_cast<size_t>(width) + 3) / 4);
+        size_t blocks_high = std::max<size_t>(1, (static_cast<size_t>(height) + 3) / 4);
+        return blocks_wide * blocks_high * texture_block_bytes(format);
+    }
+
+    uint32_t TextureFile::full_level_count(uint32_t width, uint32_t height) {
+        uint32_t count = 1;
+        for (uint32_t size = std::max(width, height); size > 1; size >>= 1) count++;
+        return count;
+    }
+
+    TextureFile::TextureFile(const std::string &path) : file{path}, name_{path} {
+        data_ = static_cast<const unsigned char *>(file.data());
+        size_ = file.size();
+        parse();
+    }
+
+    TextureFile::TextureFile(const void *data, size_t size, const std::string &name)
+            : data_{static_cast<const unsigned char *>(data)}, size_{size}, name_{name} {
+        parse();
+    }
+
+    TextureFile::TextureFile(std::vector<char> &&contents, const std::string &name)
+            : owned{std::move(contents)}, name_{name} {
+        data_ = reinterpret_cast<const unsigned char *>(owned.data());
+        size_ = owned.size();
+        parse();
+    }
+
+    void TextureFile::check_dimensions(uint32_t width, uint32_t height) const {
+        if (width == 0 || height == 0 || width > MAX_DIMENSION || height > MAX_DIMENSION) {
+            throw std::runtime_error("Bad texture size " + std::to_string(width) + "x" + std::to_string(height) + " in " + name_);
+        }
+    }
+
+    void TextureFile::parse() {
+        if (size_ >= sizeof(KTX2_IDENTIFIER) && std::memcmp(data_, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0) {
+            parse_ktx2();
+        } else if (size_ >= sizeof(uint32_t) && read_u32(data_, 0) == DDS_MAGIC) {
+            parse_dds();
+        } else {
+            throw std::runtime_error("Unknown texture container: " + name_);
+        }
+
+        if (levels_.size() > full_level_count(levels_[0].width, levels_[0].height)) {
+            throw std::runtime_error("More mip levels than the size allows in " + name_);
+        }
+        for (const auto &level : levels_) {
+            if (level.offset > size_ || level.size > size_ - level.offset) {
+                throw std::runtime_error("Truncated texture: " + name_);
+            }
+        }
+    }
+
+    void TextureFile::parse_ktx2() {
+        if (size_ < KTX2_HEADER_SIZE) throw std::runtime_error("Truncated KTX2 header in " + name_);
+        const uint32_t vk_format = read_u32(data_, 12);
+        const uint32_t width = read_u32(data_, 20);
+        const uint32_t height = read_u32(data_, 24);
+        const uint32_t depth = read_u32(data_, 28);
+        const uint32_t layer_count = read_u32(data_, 32);
+        const uint32_t face_count = read_u32(data_, 36);
+        // 0 asks the loader to generate the mips, there is one level in the file then
+        const uint32_t level_count = std::max(1u, read_u32(data_, 40));
+        const uint32_t supercompression = read_u32(data_, 44);
+
+        check_dimensions(width, height);
+        if (supercompression != 0) throw std::runtime_error("Supercompressed KTX2 is not supported: " + name_);
+        if (depth > 1 || layer_count > 1 || face_count != 1) {
+            throw std::runtime_error("Only 2D KTX2 textures with one layer and face are supported: " + name_);
+        }
+        const Format_Mapping *mapping = find_format(VK_FORMATS, vk_format);
+        if (mapping == nullptr) {
+            throw std::runtime_error("Unsupported KTX2 format " + std::to_string(vk_format) + " in " + name_);
+        }
+        format_ = mapping->format;
+        srgb_ = mapping->srgb;
+        if (level_count > 32 || KTX2_HEADER_SIZE + level_count * KTX2_LEVEL_INDEX_ENTRY_SIZE > size_) {
+            throw std::runtime_error("Truncated KTX2 level index in " + name_);
+        }
+
+        for (uint32_t i = 0; i < level_count; i++) {
+            const size_t entry = KTX2_HEADER_SIZE + i * KTX2_LEVEL_INDEX_ENTRY_SIZE;
+            Texture_Level level{};
+            level.width = std::max(1u, width >> i);
+            level.height = std::max(1u, height >> i);
+            level.size = texture_level_size(format_, level.width, level.height);
+            const uint64_t offset = read_u64(data_, entry);
+            const uint64_t length = read_u64(data_, entry + 8);
+            if (length < level.size || offset > size_) {
+                throw std::runtime_error("Bad KTX2 level " + std::to_string(i) + " in " + name_);
+            }
+            level.offset = static_cast<size_t>(offset);
+            levels_.push_back(level);
+        }
+    }
+
+    void TextureFile::parse_dds() {
+        if (size_ < DDS_HEADER_SIZE || read_u32(data_, 4) != 124) throw std::runtime_error("Truncated DDS header in " + name_);
+        const uint32_t flags = read_u32(data_, 8);
+        const uint32_t height = read_u32(data_, 12);
+        const uint32_t width = read_u32(data_, 16);
+        const uint32_t mip_count = read_u32(data_, 28);
+        const uint32_t pixel_flags = read_u32(data_, 80);
+        const uint32_t pixel_four_cc = read_u32(data_, 84);
+        const uint32_t caps2 = read_u32(data_, 112);
+        check_dimensions(width, height);
+        if (caps2 & (DDSCAPS2_CUBEMAP | DDSCAPS2_VOLUME)) {
+            throw std::runtime_error("Only 2D DDS textures are supported: " + name_);
+        }
+
+        size_t data_offset = DDS_HEADER_SIZE;
+        const Format_Mapping *mapping = nullptr;
+        if ((pixel_flags & DDPF_FOURCC) && pixel_four_cc == four_cc('D', 'X', '1', '0')) {
+            if (size_ < DDS_HEADER_SIZE + DDS_DX10_HEADER_SIZE) throw std::runtime_error("Truncated DDS header in " + name_);
+            const uint32_t dxgi_format = read_u32(data_, 128);
+            if (read_u32(data_, 132) != D3D10_RESOURCE_DIMENSION_TEXTURE2D ||
+                (read_u32(data_, 136) & D3D10_RESOURCE_MISC_TEXTURECUBE) || read_u32(data_, 140) > 1) {
+                throw std::runtime_error("Only 2D DDS textures with one layer are supported: " + name_);
+            }
+            mapping = find_format(DXGI_FORMATS, dxgi_format);
+            data_offset += DDS_DX10_HEADER_SIZE;
+        } else if (pixel_flags & DDPF_FOURCC) {
+            mapping = find_format(FOUR_CC_FORMATS, pixel_four_cc);
+        } else if ((pixel_flags & DDPF_RGB) && read_u32(data_, 88) == 32 &&
+                   read_u32(data_, 92) == 0x000000ff && read_u32(data_, 96) == 0x0000ff00 &&
+                   read_u32(data_, 100) == 0x00ff0000) {
+            static const Format_Mapping rgba8{0, Texture_Format::rgba8, false};
+            mapping = &rgba8;
+        }
+        if (mapping == nullptr) throw std::runtime_error("Unsupported DDS pixel format in " + name_);
+        format_ = mapping->format;
+        srgb_ = mapping->srgb;
+
+        // the levels follow the header back to back, largest first
+        const uint32_t level_count = (flags & DDSD_MIPMAPCOUNT) ? std::max(1u, mip_count) : 1;
+        if (level_count > 32) throw std::runtime_error("Bad DDS mip count in " + name_);
+        size_t offset = data_offset;
+        for (uint32_t i = 0; i < level_count; i++) {
+            Texture_Level level{};
+            level.width = std::max(1u, width >> i);
+            level.height = std::max(1u, height >> i);
+            level.size = texture_level_size(format_, level.width, level.height);
+            level.offset = offset;
+            offset += level.size;
+            levels_.push_back(level);
+        }
+    }
+
+} // namespace file_io
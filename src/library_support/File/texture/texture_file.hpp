@@ -0,0 +1,102 @@
+/**
+ * library_support/File/texture
+ *
+ * KTX2 and DDS texture containers
+ *
+ * Only the container is parsed, the texel data stays where it is: every mip
+ * level is a range of the mapped file (or of an asset archive's mapping) and
+ * goes to the staging memory in one copy. Block compressed BC1 to BC7 and
+ * plain RGBA8 are supported, for 2D textures with one layer and one face.
+ * KTX2 supercompression (BasisLZ, zstd) is not.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_FILE_TEXTURE_FILE_H
+#define PIXEL_ENGINE_FILE_TEXTURE_FILE_H
+
+#pragma once
+
+#include "../mapped_file/mapped_file.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace file_io{
+    enum class Texture_Format : uint32_t {
+        rgba8,
+        bc1_rgb,
+        bc1_rgba,
+        bc2,
+        bc3,
+        bc4_unorm,
+        bc4_snorm,
+        bc5_unorm,
+        bc5_snorm,
+        bc6h_ufloat,
+        bc6h_sfloat,
+        bc7,
+    };
+
+    // bytes per 4x4 block, or per texel for rgba8
+    uint32_t texture_block_bytes(Texture_Format format);
+    bool is_block_compressed(Texture_Format format);
+    // tightly packed size of one level
+    size_t texture_level_size(Texture_Format format, uint32_t width, uint32_t height);
+
+    struct Texture_Level {
+        // into the file's data
+        size_t offset = 0;
+        size_t size = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+    };
+
+    class TextureFile {
+    private:
+        MappedFile file;
+        std::vector<char> owned;
+        const unsigned char *data_ = nullptr;
+        size_t size_ = 0;
+        std::string name_;
+
+        Texture_Format format_ = Texture_Format::rgba8;
+        bool srgb_ = false;
+        // largest first, level 0 is the full size
+        std::vector<Texture_Level> levels_;
+
+        void parse();
+        void check_dimensions(uint32_t width, uint32_t height) const;
+        void parse_ktx2();
+        void parse_dds();
+
+    public:
+        // throws std::runtime_error when the file is missing, truncated or in an unsupported format
+        explicit TextureFile(const std::string &path);
+        // contents that outlive the texture file, like a stored asset in an archive
+        TextureFile(const void *data, size_t size, const std::string &name);
+        TextureFile(std::vector<char> &&contents, const std::string &name);
+
+        TextureFile(const TextureFile &) = delete;
+        TextureFile &operator = (const TextureFile &) = delete;
+
+        const std::string &name() const { return name_; }
+        Texture_Format format() const { return format_; }
+        bool is_srgb() const { return srgb_; }
+        uint32_t width() const { return levels_[0].width; }
+        uint32_t height() const { return levels_[0].height; }
+
+        // 1 when the file has no mips below the full size
+        uint32_t level_count() const { return static_cast<uint32_t>(levels_.size()); }
+        const Texture_Level &level(uint32_t index) const { return levels_[index]; }
+        const void *level_data(uint32_t index) const { return data_ + levels_[index].offset; }
+
+        // what a full chain down to 1x1 has
+        static uint32_t full_level_count(uint32_t width, uint32_t height);
+    };
+
+} // namespace file_io
+
+
+#endif // PIXEL_ENGINE_FILE_TEXTURE_FILE_H
@@ -0,0 +1,119 @@
+/**
+ * library_support/Graphic/vulkan/command
+ *
+ **/
+
+// match hpp file
+#include "parallel_recorder.hpp"
+#include "../../../Profiling/profiler/profiler.hpp"
+//standard libraries
+#include <stdexcept>
+#include <vector>
+
+namespace graph_vulkan{
+    namespace {
+        uint32_t current_thread_index(const jobs::JobSystem &job_system) {
+            uint32_t thread_index = job_system.thread_index();
+            if (thread_index == jobs::JobSystem::NOT_A_JOB_THREAD) {
+                throw std::runtime_error("Command recording outside of the job system's threads.");
+            }
+            return thread_index;
+        }
+    } // namespace
+
+    ParallelRecorder::ParallelRecorder(Device &device, jobs::JobSystem &job_system, uint32_t frames_in_flight)
+            : job_system{job_system} {
+        command_pools = std::make_unique<ThreadCommandPools>(
+                device,
+                job_system.thread_count(),
+                frames_in_flight,
+                device.find_physical_queue_families().graphics_Family
+                );
+    }
+
+    void ParallelRecorder::begin_frame(uint32_t frame_index) {
+        command_pools->begin_frame(frame_index);
+    }
+
+    VkCommandBuffer ParallelRecorder::begin_primary() {
+        VkCommandBuffer command_buffer = command_pools->acquire(current_thread_index(job_system), VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+        VkCommandBufferBeginInfo begin_info{};
+        begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to begin recording command buffer.");
+        }
+        return command_buffer;
+    }
+
+    void ParallelRecorder::record_render_pass(
+            VkCommandBuffer primary,
+            const VkRenderPassBeginInfo &begin_info,
+            uint32_t slice_count,
+            const Slice_Recorder &record_slice,
+            uint32_t subpass
+            ) {
+        PIXEL_PROFILE_ZONE("record render pass");
+        vkCmdBeginRenderPass(primary, &begin_info, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        if (slice_count == 0) {
+            vkCmdEndRenderPass(primary);
+            return;
+        }
+
+        VkCommandBufferInheritanceInfo inheritance_info{};
+        inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritance_info.renderPass = begin_info.renderPass;
+        inheritance_info.subpass = subpass;
+        inheritance_info.framebuffer = begin_info.framebuffer;
+
+        std::vector<VkCommandBuffer> slice_buffers(slice_count, VK_NULL_HANDLE);
+        try {
+            if (slice_count == 1) {
+                // a single slice is not worth a job
+                slice_buffers[0] = record_secondary(inheritance_info, record_slice, 0, 1);
+            } else {
+                jobs::Job_Counter counter;
+                for (uint32_t slice = 0; slice < slice_count; slice++) {
+                    job_system.schedule([&, slice]{
+                        slice_buffers[slice] = record_secondary(inheritance_info, record_slice, slice, slice_count);
+                    }, &counter);
+                }
+                job_system.wait(counter);
+            }
+        } catch (...) {
+            vkCmdEndRenderPass(primary);
+            throw;
+        }
+
+        vkCmdExecuteCommands(primary, slice_count, slice_buffers.data());
+        vkCmdEndRenderPass(primary);
+    }
+
+    VkCommandBuffer ParallelRecorder::record_secondary(
+            const VkCommandBufferInheritanceInfo &inheritance_info,
+            const Slice_Recorder &record,
+            uint32_t slice,
+            uint32_t slice_count
+            ) {
+        PIXEL_PROFILE_ZONE("record slice");
+        // the pool of whichever job thread picked the slice up
+        VkCommandBuffer command_buffer = command_pools->acquire(current_thread_index(job_system), VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+
+        VkCommandBufferBeginInfo begin_info{};
+        begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        begin_info.pInheritanceInfo = &inheritance_info;
+        if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to begin recording secondary command buffer.");
+        }
+
+        record(command_buffer, slice, slice_count);
+
+        if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to record secondary command buffer.");
+        }
+        return command_buffer;
+    }
+
+} // namespace graph_vulkan
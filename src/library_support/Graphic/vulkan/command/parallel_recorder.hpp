@@ -0,0 +1,74 @@
+/**
+ * library_support/Graphic/vulkan/command
+ *
+ * Records one render pass from several threads at once
+ *
+ * The pass is split into slices that are scheduled on a jobs::JobSystem, every
+ * slice is recorded into a secondary command buffer from the pool of the job
+ * thread it runs on and the secondaries are executed from the primary in slice
+ * order, so the result does not depend on which thread recorded what. The
+ * calling thread records slices as well while it waits.
+ *
+ * Secondary command buffers inherit nothing but the render pass: every slice
+ * binds its pipeline and sets its dynamic state (viewport, scissor) itself.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_GRAPHIC_VULKAN_PARALLEL_RECORDER_H
+#define PIXEL_ENGINE_GRAPHIC_VULKAN_PARALLEL_RECORDER_H
+
+#pragma once
+
+#include "thread_command_pools.hpp"
+#include "../../../Thread/job_system/job_system.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace graph_vulkan{
+    // records slice_index of slice_count into a secondary command buffer that is already begun
+    using Slice_Recorder = std::function<void(VkCommandBuffer command_buffer, uint32_t slice_index, uint32_t slice_count)>;
+
+    class ParallelRecorder {
+    private:
+        jobs::JobSystem &job_system;
+        // one pool per job thread
+        std::unique_ptr<ThreadCommandPools> command_pools;
+
+        VkCommandBuffer record_secondary(
+                const VkCommandBufferInheritanceInfo &inheritance_info,
+                const Slice_Recorder &record,
+                uint32_t slice,
+                uint32_t slice_count
+                );
+
+    public:
+        ParallelRecorder(Device &device, jobs::JobSystem &job_system, uint32_t frames_in_flight);
+
+        ParallelRecorder(const ParallelRecorder &) = delete;
+        ParallelRecorder &operator = (const ParallelRecorder &) = delete;
+
+        // recording threads, the caller included
+        uint32_t thread_count() const { return command_pools->get_thread_count(); }
+
+        // resets the frame slot's pools, its fence must have signaled
+        void begin_frame(uint32_t frame_index);
+        // a primary buffer of the current frame, already begun for one time submit
+        VkCommandBuffer begin_primary();
+        // begins the render pass on primary, records the slices in parallel, executes them in
+        // order and ends the render pass; rethrows the first exception a slice threw.
+        // Call it from the job system's main thread or from one of its jobs
+        void record_render_pass(
+                VkCommandBuffer primary,
+                const VkRenderPassBeginInfo &begin_info,
+                uint32_t slice_count,
+                const Slice_Recorder &record_slice,
+                uint32_t subpass = 0
+                );
+    };
+
+} // namespace graph_vulkan
+
+
+#endif // PIXEL_ENGINE_GRAPHIC_VULKAN_PARALLEL_RECORDER_H
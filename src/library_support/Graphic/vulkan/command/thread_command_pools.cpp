@@ -0,0 +1,80 @@
+/**
+ * library_support/Graphic/vulkan/command
+ *
+ **/
+
+// match hpp file
+#include "thread_command_pools.hpp"
+//standard libraries
+#include <stdexcept>
+
+namespace graph_vulkan{
+    ThreadCommandPools::ThreadCommandPools(
+            Device &device,
+            uint32_t thread_count,
+            uint32_t frames_in_flight,
+            uint32_t queue_family
+            ) : device{device},
+                thread_count{thread_count > 0 ? thread_count : 1},
+                frame_count{frames_in_flight > 0 ? frames_in_flight : 1} {
+        pools.resize(static_cast<size_t>(this->thread_count) * frame_count);
+        for (auto &pool : pools) {
+            VkCommandPoolCreateInfo pool_info{};
+            pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            pool_info.queueFamilyIndex = queue_family;
+            // no RESET_COMMAND_BUFFER_BIT, the whole pool is reset at once which lets the driver
+            // recycle its memory in one go
+            pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            if (vkCreateCommandPool(device.device(), &pool_info, nullptr, &pool.command_pool) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create thread command pool.");
+            }
+        }
+    }
+
+    ThreadCommandPools::~ThreadCommandPools() {
+        // destroying a pool frees its buffers
+        for (auto &pool : pools) {
+            vkDestroyCommandPool(device.device(), pool.command_pool, nullptr);
+        }
+    }
+
+    void ThreadCommandPools::begin_frame(uint32_t frame_index) {
+        current_frame = frame_index % frame_count;
+        for (uint32_t thread = 0; thread < thread_count; thread++) {
+            Thread_Pool &pool = pools[static_cast<size_t>(current_frame) * thread_count + thread];
+            if (pool.primaries_used == 0 && pool.secondaries_used == 0) continue;
+            vkResetCommandPool(device.device(), pool.command_pool, 0);
+            pool.primaries_used = 0;
+            pool.secondaries_used = 0;
+        }
+    }
+
+    VkCommandBuffer ThreadCommandPools::next_buffer(Thread_Pool &pool, VkCommandBufferLevel level) {
+        bool primary = level == VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        std::vector<VkCommandBuffer> &buffers = primary ? pool.primary_buffers : pool.secondary_buffers;
+        size_t &used = primary ? pool.primaries_used : pool.secondaries_used;
+
+        if (used == buffers.size()) {
+            VkCommandBufferAllocateInfo allocate_info{};
+            allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocate_info.commandPool = pool.command_pool;
+            allocate_info.level = level;
+            allocate_info.commandBufferCount = 1;
+
+            VkCommandBuffer command_buffer;
+            if (vkAllocateCommandBuffers(device.device(), &allocate_info, &command_buffer) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to allocate command buffer.");
+            }
+            buffers.push_back(command_buffer);
+        }
+        return buffers[used++];
+    }
+
+    VkCommandBuffer ThreadCommandPools::acquire(uint32_t thread_index, VkCommandBufferLevel level) {
+        if (thread_index >= thread_count) {
+            throw std::runtime_error("Command pool thread index out of range.");
+        }
+        return next_buffer(pools[static_cast<size_t>(current_frame) * thread_count + thread_index], level);
+    }
+
+} // namespace graph_vulkan
@@ -0,0 +1,62 @@
+/**
+ * library_support/Graphic/vulkan/command
+ *
+ * Command pools per recording thread and per frame in flight
+ *
+ * A VkCommandPool must only be used by one thread at a time, so every thread
+ * that records gets its own pool for every frame in flight. Buffers are never
+ * freed one by one: when a frame slot comes around again all of its pools are
+ * reset in one call and the buffers allocated from them are handed out again.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_GRAPHIC_VULKAN_THREAD_COMMAND_POOLS_H
+#define PIXEL_ENGINE_GRAPHIC_VULKAN_THREAD_COMMAND_POOLS_H
+
+#pragma once
+
+#include "../device/device.hpp"
+
+#include <vector>
+
+namespace graph_vulkan{
+    class ThreadCommandPools {
+    private:
+        struct Thread_Pool {
+            VkCommandPool command_pool = VK_NULL_HANDLE;
+            std::vector<VkCommandBuffer> primary_buffers;
+            std::vector<VkCommandBuffer> secondary_buffers;
+            size_t primaries_used = 0;
+            size_t secondaries_used = 0;
+        };
+
+        Device &device;
+        uint32_t thread_count;
+        uint32_t frame_count;
+        // frame slot major, thread_count pools per frame in flight
+        std::vector<Thread_Pool> pools;
+        uint32_t current_frame = 0;
+
+        VkCommandBuffer next_buffer(Thread_Pool &pool, VkCommandBufferLevel level);
+
+    public:
+        ThreadCommandPools(Device &device, uint32_t thread_count, uint32_t frames_in_flight, uint32_t queue_family);
+        ~ThreadCommandPools();
+
+        ThreadCommandPools(const ThreadCommandPools &) = delete;
+        ThreadCommandPools &operator = (const ThreadCommandPools &) = delete;
+
+        uint32_t get_thread_count() const { return thread_count; }
+        uint32_t get_current_frame() const { return current_frame; }
+
+        // resets every pool of the frame slot, its fence must have signaled
+        void begin_frame(uint32_t frame_index);
+        // a buffer from thread_index's pool of the current frame, valid until that frame slot is reset;
+        // only the thread owning thread_index may call this during a frame
+        VkCommandBuffer acquire(uint32_t thread_index, VkCommandBufferLevel level);
+    };
+
+} // namespace graph_vulkan
+
+
+#endif // PIXEL_ENGINE_GRAPHIC_VULKAN_THREAD_COMMAND_POOLS_H
@@ -0,0 +1,190 @@
+/**
+ * library_support/Graphic/vulkan/descriptor
+ *
+ **/
+
+// match hpp file
+#include "bindless_descriptors.hpp"
+//standard libraries
+#include <algorithm>
+#include <string>
+
+namespace graph_vulkan{
+    namespace {
+        constexpr VkDescriptorType DESCRIPTOR_TYPES[BINDLESS_TYPE_COUNT] = {
+                VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+                VK_DESCRIPTOR_TYPE_SAMPLER,
+                VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+        };
+
+        const char *type_name(Bindless_Type type) {
+            switch (type) {
+                case Bindless_Type::sampled_image: return "texture";
+                case Bindless_Type::sampler: return "sampler";
+                case Bindless_Type::storage_image: return "storage image";
+                case Bindless_Type::storage_buffer: return "storage buffer";
+            }
+            return "descriptor";
+        }
+    } // namespace
+
+    BindlessDescriptors::BindlessDescriptors(Device &device, const Bindless_Config &config)
+            : device{device}, config{config}, slots{std::make_shared<Slot_State>()} {
+        if (!device.supports_bindless()) {
+            throw std::runtime_error("Bindless descriptors need the Vulkan 1.2 descriptor indexing features.");
+        }
+        if (config.push_constant_size > device.properties.limits.maxPushConstantsSize) {
+            throw std::runtime_error("Bindless push constant size exceeds maxPushConstantsSize.");
+        }
+
+        // every stage sees the arrays, so the per stage limits apply to the whole array
+        const VkPhysicalDeviceVulkan12Properties &limits = device.vulkan_12_limits();
+        const uint32_t capacities[BINDLESS_TYPE_COUNT] = {
+                std::min({config.max_sampled_images, limits.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                          limits.maxDescriptorSetUpdateAfterBindSampledImages}),
+                std::min({config.max_samplers, limits.maxPerStageDescriptorUpdateAfterBindSamplers,
+                          limits.maxDescriptorSetUpdateAfterBindSamplers}),
+                std::min({config.max_storage_images, limits.maxPerStageDescriptorUpdateAfterBindStorageImages,
+                          limits.maxDescriptorSetUpdateAfterBindStorageImages}),
+                std::min({config.max_storage_buffers, limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+                          limits.maxDescriptorSetUpdateAfterBindStorageBuffers})
+        };
+        for (uint32_t i = 0; i < BINDLESS_TYPE_COUNT; i++) {
+            slots->arrays[i].capacity = capacities[i];
+        }
+        create_set();
+    }
+
+    BindlessDescriptors::~BindlessDescriptors() {
+        // the set goes with its pool, the layouts belong to the device's cache
+        device.deletion_queue().push_descriptor_pool(pool);
+    }
+
+    void BindlessDescriptors::create_set() {
+        const VkDescriptorBindingFlags binding_flags =
+                VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+        std::vector<Descriptor_Binding> bindings;
+        std::vector<VkDescriptorPoolSize> pool_sizes;
+        for (uint32_t i = 0; i < BINDLESS_TYPE_COUNT; i++) {
+            // a zero sized binding is allowed, but a pool size of zero is not
+            uint32_t count = std::max(1u, slots->arrays[i].capacity);
+            bindings.push_back({i, DESCRIPTOR_TYPES[i], count, VK_SHADER_STAGE_ALL, binding_flags});
+            pool_sizes.push_back({DESCRIPTOR_TYPES[i], count});
+        }
+        set_layout_ = device.descriptor_layouts().get(bindings, VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT);
+        pipeline_layout_ = device.descriptor_layouts().get_pipeline_layout(
+                {set_layout_},
+                {VkPushConstantRange{VK_SHADER_STAGE_ALL, 0, config.push_constant_size}}
+                );
+
+        VkDescriptorPoolCreateInfo pool_info{};
+        pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+        pool_info.maxSets = 1;
+        pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+        pool_info.pPoolSizes = pool_sizes.data();
+        if (vkCreateDescriptorPool(device.device(), &pool_info, nullptr, &pool) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create bindless descriptor pool.");
+        }
+
+        VkDescriptorSetAllocateInfo allocate_info{};
+        allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocate_info.descriptorPool = pool;
+        allocate_info.descriptorSetCount = 1;
+        allocate_info.pSetLayouts = &set_layout_;
+        if (vkAllocateDescriptorSets(device.device(), &allocate_info, &set_) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate bindless descriptor set.");
+        }
+    }
+
+    Bindless_Index BindlessDescriptors::acquire_slot(Bindless_Type type) {
+        std::lock_guard<std::mutex> lock{slots->mutex};
+        Slot_Array &array = slots->arrays[static_cast<uint32_t>(type)];
+        if (!array.free_slots.empty()) {
+            Bindless_Index index = array.free_slots.back();
+            array.free_slots.pop_back();
+            return index;
+        }
+        if (array.next == array.capacity) {
+            throw std::runtime_error(std::string("Bindless ") + type_name(type) + " array is full (" +
+                                     std::to_string(array.capacity) + ").");
+        }
+        return array.next++;
+    }
+
+    Bindless_Index BindlessDescriptors::add_texture(VkImageView view, VkImageLayout layout) {
+        Bindless_Index index = acquire_slot(Bindless_Type::sampled_image);
+        write_texture(index, view, layout);
+        return index;
+    }
+
+    Bindless_Index BindlessDescriptors::replace_texture(Bindless_Index index, VkImageView view, VkImageLayout layout) {
+        Bindless_Index new_index = add_texture(view, layout);
+        remove(Bindless_Type::sampled_image, index);
+        return new_index;
+    }
+
+    void BindlessDescriptors::write_texture(Bindless_Index index, VkImageView view, VkImageLayout layout) {
+        std::lock_guard<std::mutex> lock{writer_mutex};
+        writer.write_image(0, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, view, layout, VK_NULL_HANDLE, index);
+    }
+
+    Bindless_Index BindlessDescriptors::add_sampler(VkSampler sampler) {
+        Bindless_Index index = acquire_slot(Bindless_Type::sampler);
+        std::lock_guard<std::mutex> lock{writer_mutex};
+        writer.write_image(1, VK_DESCRIPTOR_TYPE_SAMPLER, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED, sampler, index);
+        return index;
+    }
+
+    Bindless_Index BindlessDescriptors::add_storage_image(VkImageView view) {
+        Bindless_Index index = acquire_slot(Bindless_Type::storage_image);
+        std::lock_guard<std::mutex> lock{writer_mutex};
+        writer.write_image(2, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, view, VK_IMAGE_LAYOUT_GENERAL, VK_NULL_HANDLE, index);
+        return index;
+    }
+
+    Bindless_Index BindlessDescriptors::add_storage_buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range) {
+        Bindless_Index index = acquire_slot(Bindless_Type::storage_buffer);
+        std::lock_guard<std::mutex> lock{writer_mutex};
+        writer.write_buffer(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, buffer, offset, range, index);
+        return index;
+    }
+
+    void BindlessDescriptors::remove(Bindless_Type type, Bindless_Index index) {
+        if (index == INVALID_BINDLESS_INDEX) return;
+        // nothing is written, a partially bound slot may keep pointing at a dead resource as long as no shader reads it
+        std::weak_ptr<Slot_State> state = slots;
+        device.deletion_queue().push_function([state, type, index]{
+            std::shared_ptr<Slot_State> live = state.lock();
+            if (!live) return;
+            std::lock_guard<std::mutex> lock{live->mutex};
+            live->arrays[static_cast<uint32_t>(type)].free_slots.push_back(index);
+        });
+    }
+
+    void BindlessDescriptors::flush_updates() {
+        std::lock_guard<std::mutex> lock{writer_mutex};
+        if (writer.empty()) return;
+        writer.update(device.device(), set_);
+        writer.clear();
+    }
+
+    void BindlessDescriptors::bind(VkCommandBuffer command_buffer, VkPipelineBindPoint bind_point) const {
+        vkCmdBindDescriptorSets(command_buffer, bind_point, pipeline_layout_, 0, 1, &set_, 0, nullptr);
+    }
+
+    uint32_t BindlessDescriptors::get_capacity(Bindless_Type type) const {
+        return slots->arrays[static_cast<uint32_t>(type)].capacity;
+    }
+
+    uint32_t BindlessDescriptors::get_used_count(Bindless_Type type) {
+        std::lock_guard<std::mutex> lock{slots->mutex};
+        const Slot_Array &array = slots->arrays[static_cast<uint32_t>(type)];
+        return array.next - static_cast<uint32_t>(array.free_slots.size());
+    }
+
+} // namespace graph_vulkan
@@ -0,0 +1,131 @@
+/**
+ * library_support/Graphic/vulkan/descriptor
+ *
+ * Global descriptor arrays addressed by index (descriptor indexing, Vulkan 1.2)
+ *
+ * All textures, samplers, storage images and storage buffers go into one
+ * descriptor set with a large array per type. Adding a resource writes its
+ * descriptor once and returns its index, shaders read the indices of what a
+ * draw uses from push constants. The set is bound once per command buffer, a
+ * draw then costs one vkCmdPushConstants and no descriptor work at all.
+ *
+ * The bindings are update after bind and partially bound, so descriptors can
+ * be added while command buffers using the set are recorded or in flight, as
+ * long as those do not use the slot. A written slot is never rewritten while
+ * it may be in use: replacing a resource takes a new slot, and a removed slot
+ * is handed out again only after the frames that may still use it finished.
+ *
+ * Shader side, set 0:
+ *   binding 0  texture2D textures[]
+ *   binding 1  sampler samplers[]
+ *   binding 2  image2D storage_images[]
+ *   binding 3  buffer storage_buffers[]
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_GRAPHIC_VULKAN_BINDLESS_DESCRIPTORS_H
+#define PIXEL_ENGINE_GRAPHIC_VULKAN_BINDLESS_DESCRIPTORS_H
+
+#pragma once
+
+#include "../device/device.hpp"
+#include "descriptor_allocator.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace graph_vulkan{
+    using Bindless_Index = uint32_t;
+    constexpr Bindless_Index INVALID_BINDLESS_INDEX = UINT32_MAX;
+
+    enum class Bindless_Type : uint32_t {sampled_image, sampler, storage_image, storage_buffer};
+    constexpr uint32_t BINDLESS_TYPE_COUNT = 4;
+
+    struct Bindless_Config {
+        // clamped to the device's update after bind limits
+        uint32_t max_sampled_images = 16384;
+        uint32_t max_samplers = 256;
+        uint32_t max_storage_images = 1024;
+        uint32_t max_storage_buffers = 16384;
+        // 128 bytes is the smallest maxPushConstantsSize a device may have
+        uint32_t push_constant_size = 128;
+    };
+
+    class BindlessDescriptors {
+    private:
+        // shared with the deletion queue, a slot freed after this is gone is dropped
+        struct Slot_Array {
+            uint32_t capacity = 0;
+            uint32_t next = 0;
+            std::vector<uint32_t> free_slots;
+        };
+        struct Slot_State {
+            std::mutex mutex;
+            Slot_Array arrays[BINDLESS_TYPE_COUNT];
+        };
+
+        Device &device;
+        Bindless_Config config;
+
+        VkDescriptorSetLayout set_layout_ = VK_NULL_HANDLE;
+        VkPipelineLayout pipeline_layout_ = VK_NULL_HANDLE;
+        VkDescriptorPool pool = VK_NULL_HANDLE;
+        VkDescriptorSet set_ = VK_NULL_HANDLE;
+
+        std::shared_ptr<Slot_State> slots;
+        std::mutex writer_mutex;
+        Descriptor_Writer writer;
+
+        Bindless_Index acquire_slot(Bindless_Type type);
+        // only for slots no pending frame reads, which are the freshly acquired ones
+        void write_texture(Bindless_Index index, VkImageView view, VkImageLayout layout);
+        void create_set();
+
+    public:
+        BindlessDescriptors(Device &device, const Bindless_Config &config = {});
+        ~BindlessDescriptors();
+
+        BindlessDescriptors(const BindlessDescriptors &) = delete;
+        BindlessDescriptors &operator = (const BindlessDescriptors &) = delete;
+
+        // every add and replace is written by the next flush_updates(), safe from any thread
+        Bindless_Index add_texture(VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        Bindless_Index add_sampler(VkSampler sampler);
+        Bindless_Index add_storage_image(VkImageView view);
+        Bindless_Index add_storage_buffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+        // a new slot for the view and the old one removed, pending frames keep reading the old slot and view,
+        // so the old view must outlive the frames in flight; returns the new index
+        Bindless_Index replace_texture(Bindless_Index index, VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        // the slot is reused once the current frame has finished
+        void remove(Bindless_Type type, Bindless_Index index);
+
+        // one vkUpdateDescriptorSets for everything added since the last call, call before submitting
+        void flush_updates();
+
+        // once per command buffer and bind point, the set stays bound across pipeline changes
+        void bind(VkCommandBuffer command_buffer, VkPipelineBindPoint bind_point = VK_PIPELINE_BIND_POINT_GRAPHICS) const;
+        // the indices of one draw, the pipeline has to be created with pipeline_layout()
+        template<typename T>
+        void push(VkCommandBuffer command_buffer, const T &constants) const {
+            static_assert(std::is_trivially_copyable<T>::value, "Push constants are copied byte by byte.");
+            if (sizeof(T) > config.push_constant_size) {
+                throw std::runtime_error("Bindless push constants are larger than the push constant range.");
+            }
+            vkCmdPushConstants(command_buffer, pipeline_layout_, VK_SHADER_STAGE_ALL, 0, sizeof(T), &constants);
+        }
+
+        VkDescriptorSetLayout set_layout() const { return set_layout_; }
+        VkPipelineLayout pipeline_layout() const { return pipeline_layout_; }
+        VkDescriptorSet set() const { return set_; }
+        uint32_t get_capacity(Bindless_Type type) const;
+        uint32_t get_used_count(Bindless_Type type);
+    };
+
+} // namespace graph_vulkan
+
+
+#endif // PIXEL_ENGINE_GRAPHIC_VULKAN_BINDLESS_DESCRIPTORS_H
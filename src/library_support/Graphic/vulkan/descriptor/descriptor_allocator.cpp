@@ -0,0 +1,168 @@
+/**
+ * library_support/Graphic/vulkan/descriptor
+ *
+ **/
+
+// match hpp file
+#include "descriptor_allocator.hpp"
+#include "../../../Profiling/profiler/profiler.hpp"
+//standard libraries
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace graph_vulkan{
+    DescriptorAllocator::DescriptorAllocator(VkDevice device, uint32_t frames_in_flight, const Descriptor_Allocator_Config &config)
+            : device_{device}, config{config}, frames(frames_in_flight), next_pool_sets{config.initial_sets} {
+        if (frames_in_flight == 0 || config.initial_sets == 0) {
+            throw std::runtime_error("Descriptor allocator needs at least one frame and one set per pool.");
+        }
+    }
+
+    DescriptorAllocator::~DescriptorAllocator() {
+        for (auto &frame : frames) {
+            for (VkDescriptorPool pool : frame.pools) {
+                vkDestroyDescriptorPool(device_, pool, nullptr);
+            }
+        }
+    }
+
+    VkDescriptorPool DescriptorAllocator::create_pool(uint32_t set_count) {
+        PIXEL_PROFILE_ZONE("create descriptor pool");
+        std::vector<VkDescriptorPoolSize> pool_sizes;
+        for (const auto &ratio : config.ratios) {
+            pool_sizes.push_back({ratio.type, std::max(1u, static_cast<uint32_t>(std::ceil(ratio.per_set * set_count)))});
+        }
+
+        VkDescriptorPoolCreateInfo pool_info{};
+        pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        // no FREE_DESCRIPTOR_SET_BIT, the pool is only ever reset as a whole
+        pool_info.flags = 0;
+        pool_info.maxSets = set_count;
+        pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+        pool_info.pPoolSizes = pool_sizes.data();
+
+        VkDescriptorPool pool;
+        if (vkCreateDescriptorPool(device_, &pool_info, nullptr, &pool) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create descriptor pool.");
+        }
+        pool_count++;
+        return pool;
+    }
+
+    void DescriptorAllocator::begin_frame(uint32_t frame_index) {
+        std::lock_guard<std::mutex> lock{mutex};
+        this->frame_index = frame_index % static_cast<uint32_t>(frames.size());
+        Frame_Pools &frame = frames[this->frame_index];
+        // only the pools that were touched have anything to reset
+        for (size_t i = 0; i < frame.pools.size() && i <= frame.current; i++) {
+            vkResetDescriptorPool(device_, frame.pools[i], 0);
+        }
+        frame.current = 0;
+        frame.allocated_sets = 0;
+    }
+
+    VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout layout) {
+        std::lock_guard<std::mutex> lock{mutex};
+        Frame_Pools &frame = frames[frame_index];
+
+        VkDescriptorSetAllocateInfo allocate_info{};
+        allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocate_info.descriptorSetCount = 1;
+        allocate_info.pSetLayouts = &layout;
+
+        // a fresh pool that fails as well means the layout needs more than the ratios give a pool
+        bool fresh_pool = false;
+        while (true) {
+            if (frame.current == frame.pools.size()) {
+                frame.pools.push_back(create_pool(next_pool_sets));
+                next_pool_sets = std::min(next_pool_sets * 2, config.max_sets_per_pool);
+                fresh_pool = true;
+            }
+            allocate_info.descriptorPool = frame.pools[frame.current];
+
+            VkDescriptorSet set;
+            VkResult result = vkAllocateDescriptorSets(device_, &allocate_info, &set);
+            if (result == VK_SUCCESS) {
+                frame.allocated_sets++;
+                peak_sets = std::max(peak_sets, frame.allocated_sets);
+                return set;
+            }
+            if ((result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) || fresh_pool) {
+                throw std::runtime_error("Failed to allocate descriptor set.");
+            }
+            frame.current++;
+        }
+    }
+
+    uint32_t DescriptorAllocator::get_pool_count() {
+        std::lock_guard<std::mutex> lock{mutex};
+        return pool_count;
+    }
+
+    uint32_t DescriptorAllocator::get_allocated_sets() {
+        std::lock_guard<std::mutex> lock{mutex};
+        return frames[frame_index].allocated_sets;
+    }
+
+    uint32_t DescriptorAllocator::get_peak_sets() {
+        std::lock_guard<std::mutex> lock{mutex};
+        return peak_sets;
+    }
+
+    Descriptor_Writer &Descriptor_Writer::write_buffer(
+            uint32_t binding,
+            VkDescriptorType type,
+            VkBuffer buffer,
+            VkDeviceSize offset,
+            VkDeviceSize range,
+            uint32_t array_element
+            ) {
+        buffer_infos.push_back({buffer, offset, range});
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstBinding = binding;
+        write.dstArrayElement = array_element;
+        write.descriptorCount = 1;
+        write.descriptorType = type;
+        write.pBufferInfo = &buffer_infos.back();
+        writes.push_back(write);
+        return *this;
+    }
+
+    Descriptor_Writer &Descriptor_Writer::write_image(
+            uint32_t binding,
+            VkDescriptorType type,
+            VkImageView view,
+            VkImageLayout layout,
+            VkSampler sampler,
+            uint32_t array_element
+            ) {
+        image_infos.push_back({sampler, view, layout});
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstBinding = binding;
+        write.dstArrayElement = array_element;
+        write.descriptorCount = 1;
+        write.descriptorType = type;
+        write.pImageInfo = &image_infos.back();
+        writes.push_back(write);
+        return *this;
+    }
+
+    void Descriptor_Writer::update(VkDevice device, VkDescriptorSet set) {
+        for (auto &write : writes) {
+            write.dstSet = set;
+        }
+        vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+
+    void Descriptor_Writer::clear() {
+        buffer_infos.clear();
+        image_infos.clear();
+        writes.clear();
+    }
+
+} // namespace graph_vulkan
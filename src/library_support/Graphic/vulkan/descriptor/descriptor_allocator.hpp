@@ -0,0 +1,126 @@
+/**
+ * library_support/Graphic/vulkan/descriptor
+ *
+ * Growable per frame descriptor pool allocator
+ *
+ * Every frame in flight owns a list of descriptor pools. Sets are allocated
+ * from the current pool until it runs out, then from the next one, a new pool
+ * is only created when the frame needs more than ever before, each one twice
+ * the size of the last. begin_frame() resets all of a frame's pools with one
+ * vkResetDescriptorPool each, nothing is ever freed set by set, so after the
+ * first few frames allocating a set is a vkAllocateDescriptorSets on a pool
+ * that has room.
+ *
+ * Sets live until their frame slot comes around again. Long lived sets belong
+ * into a pool of their own, bindless resources into BindlessDescriptors.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_GRAPHIC_VULKAN_DESCRIPTOR_ALLOCATOR_H
+#define PIXEL_ENGINE_GRAPHIC_VULKAN_DESCRIPTOR_ALLOCATOR_H
+
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace graph_vulkan{
+    // descriptors of a type a pool holds for every set it can hold
+    struct Descriptor_Pool_Ratio {
+        VkDescriptorType type;
+        float per_set;
+    };
+
+    struct Descriptor_Allocator_Config {
+        uint32_t initial_sets = 256;
+        uint32_t max_sets_per_pool = 4096;
+        std::vector<Descriptor_Pool_Ratio> ratios = {
+                {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f},
+                {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f},
+                {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f},
+                {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1.0f},
+                {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f},
+                {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 2.0f},
+                {VK_DESCRIPTOR_TYPE_SAMPLER, 1.0f},
+                {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f}
+        };
+    };
+
+    class DescriptorAllocator {
+    private:
+        struct Frame_Pools {
+            std::vector<VkDescriptorPool> pools;
+            // pools before this one are full
+            size_t current = 0;
+            uint32_t allocated_sets = 0;
+        };
+
+        VkDevice device_;
+        Descriptor_Allocator_Config config;
+        std::vector<Frame_Pools> frames;
+        uint32_t frame_index = 0;
+        uint32_t next_pool_sets;
+
+        std::mutex mutex;
+        uint32_t pool_count = 0;
+        uint32_t peak_sets = 0;
+
+        VkDescriptorPool create_pool(uint32_t set_count);
+
+    public:
+        DescriptorAllocator(VkDevice device, uint32_t frames_in_flight, const Descriptor_Allocator_Config &config = {});
+        ~DescriptorAllocator();
+
+        DescriptorAllocator(const DescriptorAllocator &) = delete;
+        DescriptorAllocator &operator = (const DescriptorAllocator &) = delete;
+
+        // frees every set of the frame slot, its fence must have signaled
+        void begin_frame(uint32_t frame_index);
+        // safe from any thread during a frame
+        VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+
+        uint32_t get_pool_count();
+        uint32_t get_allocated_sets();
+        // most sets any frame allocated so far, for sizing initial_sets
+        uint32_t get_peak_sets();
+    };
+
+    // collects the writes for a set and issues them with one vkUpdateDescriptorSets
+    class Descriptor_Writer {
+    private:
+        // deques, pointers into them stay valid while more writes are added
+        std::deque<VkDescriptorBufferInfo> buffer_infos;
+        std::deque<VkDescriptorImageInfo> image_infos;
+        std::vector<VkWriteDescriptorSet> writes;
+
+    public:
+        Descriptor_Writer &write_buffer(
+                uint32_t binding,
+                VkDescriptorType type,
+                VkBuffer buffer,
+                VkDeviceSize offset,
+                VkDeviceSize range,
+                uint32_t array_element = 0
+                );
+        Descriptor_Writer &write_image(
+                uint32_t binding,
+                VkDescriptorType type,
+                VkImageView view,
+                VkImageLayout layout,
+                VkSampler sampler = VK_NULL_HANDLE,
+                uint32_t array_element = 0
+                );
+
+        void update(VkDevice device, VkDescriptorSet set);
+        void clear();
+        bool empty() const { return writes.empty(); }
+    };
+
+} // namespace graph_vulkan
+
+
+#endif // PIXEL_ENGINE_GRAPHIC_VULKAN_DESCRIPTOR_ALLOCATOR_H
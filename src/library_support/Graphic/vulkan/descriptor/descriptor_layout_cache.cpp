@@ -0,0 +1,140 @@
+/**
+ * library_support/Graphic/vulkan/descriptor
+ *
+ **/
+
+// match hpp file
+#include "descriptor_layout_cache.hpp"
+//standard libraries
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+
+namespace graph_vulkan{
+    namespace {
+        auto binding_tie(const Descriptor_Binding &binding) {
+            return std::tie(binding.binding, binding.type, binding.count, binding.stages, binding.flags);
+        }
+
+        auto push_constant_tie(const VkPushConstantRange &range) {
+            return std::tie(range.stageFlags, range.offset, range.size);
+        }
+    } // namespace
+
+    bool DescriptorLayoutCache::Set_Layout_Key::operator<(const Set_Layout_Key &other) const {
+        if (flags != other.flags) return flags < other.flags;
+        return std::lexicographical_compare(
+                bindings.begin(), bindings.end(), other.bindings.begin(), other.bindings.end(),
+                [](const Descriptor_Binding &a, const Descriptor_Binding &b) { return binding_tie(a) < binding_tie(b); });
+    }
+
+    bool DescriptorLayoutCache::Pipeline_Layout_Key::operator<(const Pipeline_Layout_Key &other) const {
+        if (set_layouts != other.set_layouts) return set_layouts < other.set_layouts;
+        return std::lexicographical_compare(
+                push_constants.begin(), push_constants.end(), other.push_constants.begin(), other.push_constants.end(),
+                [](const VkPushConstantRange &a, const VkPushConstantRange &b) { return push_constant_tie(a) < push_constant_tie(b); });
+    }
+
+    DescriptorLayoutCache::DescriptorLayoutCache(VkDevice device) : device_{device} {}
+
+    DescriptorLayoutCache::~DescriptorLayoutCache() {
+        for (auto &layout : pipeline_layouts) {
+            vkDestroyPipelineLayout(device_, layout.second, nullptr);
+        }
+        for (auto &layout : set_layouts) {
+            vkDestroyDescriptorSetLayout(device_, layout.second, nullptr);
+        }
+    }
+
+    VkDescriptorSetLayout DescriptorLayoutCache::get(std::vector<Descriptor_Binding> bindings, VkDescriptorSetLayoutCreateFlags flags) {
+        std::sort(bindings.begin(), bindings.end(), [](const Descriptor_Binding &a, const Descriptor_Binding &b) {
+            return a.binding < b.binding;
+        });
+        for (size_t i = 1; i < bindings.size(); i++) {
+            if (bindings[i].binding == bindings[i - 1].binding) {
+                throw std::runtime_error("Descriptor binding " + std::to_string(bindings[i].binding) + " is declared twice.");
+            }
+        }
+
+        Set_Layout_Key key{flags, std::move(bindings)};
+        std::lock_guard<std::mutex> lock{mutex};
+        auto found = set_layouts.find(key);
+        if (found != set_layouts.end()) {
+            hit_count++;
+            return found->second;
+        }
+
+        std::vector<VkDescriptorSetLayoutBinding> layout_bindings;
+        std::vector<VkDescriptorBindingFlags> binding_flags;
+        bool has_binding_flags = false;
+        for (const auto &binding : key.bindings) {
+            VkDescriptorSetLayoutBinding layout_binding{};
+            layout_binding.binding = binding.binding;
+            layout_binding.descriptorType = binding.type;
+            layout_binding.descriptorCount = binding.count;
+            layout_binding.stageFlags = binding.stages;
+            layout_bindings.push_back(layout_binding);
+            binding_flags.push_back(binding.flags);
+            has_binding_flags = has_binding_flags || binding.flags != 0;
+        }
+
+        VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info{};
+        binding_flags_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+        binding_flags_info.bindingCount = static_cast<uint32_t>(binding_flags.size());
+        binding_flags_info.pBindingFlags = binding_flags.data();
+
+        VkDescriptorSetLayoutCreateInfo layout_info{};
+        layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        // the chained struct is a 1.2 one, leave it out when there is nothing in it
+        layout_info.pNext = has_binding_flags ? &binding_flags_info : nullptr;
+        layout_info.flags = flags;
+        layout_info.bindingCount = static_cast<uint32_t>(layout_bindings.size());
+        layout_info.pBindings = layout_bindings.data();
+
+        VkDescriptorSetLayout layout;
+        if (vkCreateDescriptorSetLayout(device_, &layout_info, nullptr, &layout) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create descriptor set layout.");
+        }
+        set_layouts.emplace(std::move(key), layout);
+        return layout;
+    }
+
+    VkPipelineLayout DescriptorLayoutCache::get_pipeline_layout(
+            const std::vector<VkDescriptorSetLayout> &layouts,
+            const std::vector<VkPushConstantRange> &push_constants
+            ) {
+        Pipeline_Layout_Key key{layouts, push_constants};
+        std::lock_guard<std::mutex> lock{mutex};
+        auto found = pipeline_layouts.find(key);
+        if (found != pipeline_layouts.end()) {
+            hit_count++;
+            return found->second;
+        }
+
+        VkPipelineLayoutCreateInfo pipeline_layout_info{};
+        pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipeline_layout_info.setLayoutCount = static_cast<uint32_t>(layouts.size());
+        pipeline_layout_info.pSetLayouts = layouts.data();
+        pipeline_layout_info.pushConstantRangeCount = static_cast<uint32_t>(push_constants.size());
+        pipeline_layout_info.pPushConstantRanges = push_constants.data();
+
+        VkPipelineLayout layout;
+        if (vkCreatePipelineLayout(device_, &pipeline_layout_info, nullptr, &layout) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create pipeline layout.");
+        }
+        pipeline_layouts.emplace(std::move(key), layout);
+        return layout;
+    }
+
+    uint32_t DescriptorLayoutCache::layout_count() {
+        std::lock_guard<std::mutex> lock{mutex};
+        return static_cast<uint32_t>(set_layouts.size() + pipeline_layouts.size());
+    }
+
+    uint32_t DescriptorLayoutCache::get_hit_count() {
+        std::lock_guard<std::mutex> lock{mutex};
+        return hit_count;
+    }
+
+} // namespace graph_vulkan
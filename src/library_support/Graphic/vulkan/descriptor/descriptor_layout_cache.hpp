@@ -0,0 +1,79 @@
+/**
+ * library_support/Graphic/vulkan/descriptor
+ *
+ * VkDescriptorSetLayout and VkPipelineLayout cache keyed by binding signature
+ *
+ * Two pipelines that declare the same bindings get the same set layout handle,
+ * so sets allocated for one are compatible with the other and a set bound once
+ * stays bound across pipeline changes. The bindings are sorted before lookup,
+ * the order they are declared in does not matter.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_GRAPHIC_VULKAN_DESCRIPTOR_LAYOUT_CACHE_H
+#define PIXEL_ENGINE_GRAPHIC_VULKAN_DESCRIPTOR_LAYOUT_CACHE_H
+
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace graph_vulkan{
+    struct Descriptor_Binding {
+        uint32_t binding = 0;
+        VkDescriptorType type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        uint32_t count = 1;
+        VkShaderStageFlags stages = VK_SHADER_STAGE_ALL_GRAPHICS;
+        // VkDescriptorBindingFlags, needs the descriptor indexing features for anything but 0
+        VkDescriptorBindingFlags flags = 0;
+    };
+
+    class DescriptorLayoutCache {
+    private:
+        struct Set_Layout_Key {
+            VkDescriptorSetLayoutCreateFlags flags;
+            std::vector<Descriptor_Binding> bindings;
+
+            bool operator<(const Set_Layout_Key &other) const;
+        };
+
+        struct Pipeline_Layout_Key {
+            std::vector<VkDescriptorSetLayout> set_layouts;
+            std::vector<VkPushConstantRange> push_constants;
+
+            bool operator<(const Pipeline_Layout_Key &other) const;
+        };
+
+        VkDevice device_;
+
+        std::mutex mutex;
+        std::map<Set_Layout_Key, VkDescriptorSetLayout> set_layouts;
+        std::map<Pipeline_Layout_Key, VkPipelineLayout> pipeline_layouts;
+        uint32_t hit_count = 0;
+
+    public:
+        explicit DescriptorLayoutCache(VkDevice device);
+        ~DescriptorLayoutCache();
+
+        DescriptorLayoutCache(const DescriptorLayoutCache &) = delete;
+        DescriptorLayoutCache &operator = (const DescriptorLayoutCache &) = delete;
+
+        // the layouts stay alive as long as the cache, never destroy them
+        VkDescriptorSetLayout get(std::vector<Descriptor_Binding> bindings, VkDescriptorSetLayoutCreateFlags flags = 0);
+        VkPipelineLayout get_pipeline_layout(
+                const std::vector<VkDescriptorSetLayout> &layouts,
+                const std::vector<VkPushConstantRange> &push_constants = {}
+                );
+
+        uint32_t layout_count();
+        uint32_t get_hit_count();
+    };
+
+} // namespace graph_vulkan
+
+
+#endif // PIXEL_ENGINE_GRAPHIC_VULKAN_DESCRIPTOR_LAYOUT_CACHE_H
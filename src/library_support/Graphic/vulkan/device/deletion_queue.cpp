@@ -0,0 +1,242 @@
+/**
+ * library_support/Graphic/vulkan/device
+ *
+ **/
+
+// match hpp file
+#include "deletion_queue.hpp"
+//standard libraries
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace graph_vulkan{
+    DeletionQueue::DeletionQueue(VkDevice device, MemoryAllocator &allocator, QueueSync &queue_sync)
+            : device{device}, allocator{allocator}, queue_sync{queue_sync} {}
+
+    DeletionQueue::~DeletionQueue() {
+        flush();
+    }
+
+    uint64_t DeletionQueue::end_frame() {
+        return current_frame.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    void DeletionQueue::frame_completed(uint64_t serial) {
+        uint64_t completed = completed_frame.load(std::memory_order_relaxed);
+        while (completed < serial &&
+               !completed_frame.compare_exchange_weak(completed, serial, std::memory_order_acq_rel)) {}
+        collect(std::max(completed, serial));
+    }
+
+    void DeletionQueue::push(Deferred_Deletion deletion, uint64_t last_use) {
+        deletion.last_use = last_use == CURRENT_FRAME ? get_current_frame() : last_use;
+        std::lock_guard<std::mutex> lock{mutex};
+        pending.push_back(std::move(deletion));
+    }
+
+    void DeletionQueue::push(Deferred_Deletion deletion, Sync_Point last_use) {
+        // an invalid point waits for nothing, it goes with the next collect
+        deletion.sync_point = last_use;
+        std::lock_guard<std::mutex> lock{mutex};
+        pending.push_back(std::move(deletion));
+    }
+
+    void DeletionQueue::push_buffer(VkBuffer buffer, Memory_Allocation &memory, uint64_t last_use) {
+        Deferred_Deletion deletion;
+        deletion.buffer = buffer;
+        deletion.memory = memory;
+        memory = Memory_Allocation{};
+        push(std::move(deletion), last_use);
+    }
+
+    void DeletionQueue::push_image(VkImage image, Memory_Allocation &memory, uint64_t last_use) {
+        Deferred_Deletion deletion;
+        deletion.image = image;
+        deletion.memory = memory;
+        memory = Memory_Allocation{};
+        push(std::move(deletion), last_use);
+    }
+
+    void DeletionQueue::push_memory(Memory_Allocation &memory, uint64_t last_use) {
+        Deferred_Deletion deletion;
+        deletion.memory = memory;
+        memory = Memory_Allocation{};
+        push(std::move(deletion), last_use);
+    }
+
+    void DeletionQueue::push_image_view(VkImageView image_view, uint64_t last_use) {
+        Deferred_Deletion deletion;
+        deletion.image_view = image_view;
+        push(std::move(deletion), last_use);
+    }
+
+    void DeletionQueue::push_sampler(VkSampler sampler, uint64_t last_use) {
+        Deferred_Deletion deletion;
+        deletion.sampler = sampler;
+        push(std::move(deletion), last_use);
+    }
+
+    void DeletionQueue::push_framebuffer(VkFramebuffer framebuffer, uint64_t last_use) {
+        Deferred_Deletion deletion;
+        deletion.framebuffer = framebuffer;
+        push(std::move(deletion), last_use);
+    }
+
+    void DeletionQueue::push_pipeline(VkPipeline pipeline, uint64_t last_use) {
+        Deferred_Deletion deletion;
+        deletion.pipeline = pipeline;
+        push(std::move(deletion), last_use);
+    }
+
+    void DeletionQueue::push_pipeline_layout(VkPipelineLayout pipeline_layout, uint64_t last_use) {
+        Deferred_Deletion deletion;
+        deletion.pipeline_layout = pipeline_layout;
+        push(std::move(deletion), last_use);
+    }
+
+    void DeletionQueue::push_descriptor_pool(VkDescriptorPool descriptor_pool, uint64_t last_use) {
+        Deferred_Deletion deletion;
+        deletion.descriptor_pool = descriptor_pool;
+        push(std::move(deletion), last_use);
+    }
+
+    void DeletionQueue::push_function(std::function<void()> destroy, uint64_t last_use) {
+        Deferred_Deletion deletion;
+        deletion.destroy = std::move(destroy);
+        push(std::move(deletion), last_use);
+    }
+
+    void DeletionQueue::push_buffer(VkBuffer buffer, Memory_Allocation &memory, Sync_Point last_use) {
+        Deferred_Deletion deletion;
+        deletion.buffer = buffer;
+        deletion.memory = memory;
+        memory = Memory_Allocation{};
+        push(std::move(deletion), last_use);
+    }
+
+    void DeletionQueue::push_image(VkImage image, Memory_Allocation &memory, Sync_Point last_use) {
+        Deferred_Deletion deletion;
+        deletion.image = image;
+        deletion.memory = memory;
+        memory = Memory_Allocation{};
+        push(std::move(deletion), last_use);
+    }
+
+    void DeletionQueue::push_memory(Memory_Allocation &memory, Sync_Point last_use) {
+        Deferred_Deletion deletion;
+        deletion.memory = memory;
+        memory = Memory_Allocation{};
+        push(std::move(deletion), last_use);
+    }
+
+    void DeletionQueue::push_image_view(VkImageView image_view, Sync_Point last_use) {
+        Deferred_Deletion deletion;
+        deletion.image_view = image_view;
+        push(std::move(deletion), last_use);
+    }
+
+    void DeletionQueue::push_sampler(VkSampler sampler, Sync_Point last_use) {
+        Deferred_Deletion deletion;
+        deletion.sampler = sampler;
+        push(std::move(deletion), last_use);
+    }
+
+    void DeletionQueue::push_framebuffer(VkFramebuffer framebuffer, Sync_Point last_use) {
+        Deferred_Deletion deletion;
+        deletion.framebuffer = framebuffer;
+        push(std::move(deletion), last_use);
+    }
+
+    void DeletionQueue::push_pipeline(VkPipeline pipeline, Sync_Point last_use) {
+        Deferred_Deletion deletion;
+        deletion.pipeline = pipeline;
+        push(std::move(deletion), last_use);
+    }
+
+    void DeletionQueue::push_pipeline_layout(VkPipelineLayout pipeline_layout, Sync_Point last_use) {
+        Deferred_Deletion deletion;
+        deletion.pipeline_layout = pipeline_layout;
+        push(std::move(deletion), last_use);
+    }
+
+    void DeletionQueue::push_descriptor_pool(VkDescriptorPool descriptor_pool, Sync_Point last_use) {
+        Deferred_Deletion deletion;
+        deletion.descriptor_pool = descriptor_pool;
+        push(std::move(deletion), last_use);
+    }
+
+    void DeletionQueue::push_function(std::function<void()> destroy, Sync_Point last_use) {
+        Deferred_Deletion deletion;
+        deletion.destroy = std::move(destroy);
+        push(std::move(deletion), last_use);
+    }
+
+    void DeletionQueue::destroy(Deferred_Deletion &deletion) {
+        // views and framebuffers before the images they point at
+        if (deletion.framebuffer != VK_NULL_HANDLE) vkDestroyFramebuffer(device, deletion.framebuffer, nullptr);
+        if (deletion.image_view != VK_NULL_HANDLE) vkDestroyImageView(device, deletion.image_view, nullptr);
+        if (deletion.sampler != VK_NULL_HANDLE) vkDestroySampler(device, deletion.sampler, nullptr);
+        if (deletion.pipeline != VK_NULL_HANDLE) vkDestroyPipeline(device, deletion.pipeline, nullptr);
+        if (deletion.pipeline_layout != VK_NULL_HANDLE) vkDestroyPipelineLayout(device, deletion.pipeline_layout, nullptr);
+        if (deletion.descriptor_pool != VK_NULL_HANDLE) vkDestroyDescriptorPool(device, deletion.descriptor_pool, nullptr);
+        if (deletion.buffer != VK_NULL_HANDLE) vkDestroyBuffer(device, deletion.buffer, nullptr);
+        if (deletion.image != VK_NULL_HANDLE) vkDestroyImage(device, deletion.image, nullptr);
+        if (deletion.memory.is_valid()) allocator.free(deletion.memory);
+        if (deletion.destroy) deletion.destroy();
+    }
+
+    void DeletionQueue::collect(uint64_t completed) {
+        uint64_t completed_values[QUEUE_TYPE_COUNT + 1] = {completed};
+        for (uint32_t queue = 0; queue < QUEUE_TYPE_COUNT; queue++) {
+            completed_values[queue + 1] = queue_sync.get_completed_value(static_cast<Queue_Type>(queue));
+        }
+        collect_retired(completed_values);
+    }
+
+    void DeletionQueue::collect() {
+        collect(get_completed_frame());
+    }
+
+    void DeletionQueue::collect_retired(const uint64_t (&completed)[QUEUE_TYPE_COUNT + 1]) {
+        std::vector<Deferred_Deletion> retired;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            // pushed with older serials out of order now and then, so the whole list is checked
+            auto first_retired = std::stable_partition(pending.begin(), pending.end(), [&completed](const Deferred_Deletion &deletion) {
+                if (deletion.sync_point.is_valid()) {
+                    return deletion.sync_point.value > completed[static_cast<uint32_t>(deletion.sync_point.queue) + 1];
+                }
+                return deletion.last_use > completed[0];
+            });
+            if (first_retired == pending.end()) return;
+            retired.assign(std::make_move_iterator(first_retired), std::make_move_iterator(pending.end()));
+            pending.erase(first_retired, pending.end());
+            destroyed_count += retired.size();
+        }
+        // outside the lock, a destroy function may push again
+        for (auto &deletion : retired) {
+            destroy(deletion);
+        }
+    }
+
+    void DeletionQueue::flush() {
+        // a destroy function may push something new, keep going until nothing is left
+        uint64_t everything[QUEUE_TYPE_COUNT + 1];
+        std::fill(std::begin(everything), std::end(everything), UINT64_MAX - 1);
+        while (get_pending_count() > 0) {
+            collect_retired(everything);
+        }
+    }
+
+    size_t DeletionQueue::get_pending_count() {
+        std::lock_guard<std::mutex> lock{mutex};
+        return pending.size();
+    }
+
+    uint64_t DeletionQueue::get_destroyed_count() {
+        std::lock_guard<std::mutex> lock{mutex};
+        return destroyed_count;
+    }
+
+} // namespace graph_vulkan
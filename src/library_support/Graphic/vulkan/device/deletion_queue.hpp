@@ -0,0 +1,136 @@
+/**
+ * library_support/Graphic/vulkan/device
+ *
+ * Deferred destruction of resources the GPU may still be using
+ *
+ * Every frame submitted by the frame loop gets a serial. A resource is pushed
+ * together with the serial of the last frame that used it, by default the
+ * frame being recorded, and is destroyed once the fence of that frame has been
+ * seen signaled. Nothing waits for the device to go idle, streaming can drop
+ * buffers and images in the middle of a frame.
+ *
+ * The serials assume one frame loop per device, they are handed out by
+ * end_frame() in submit order and completed in the same order.
+ *
+ * Work submitted outside the frame loop, uploads on the transfer queue or
+ * compute dispatches, pushes the Sync_Point of its submit instead. collect()
+ * polls QueueSync for the completed timeline values, so those resources go
+ * as soon as their queue passed them instead of a frame later or too early.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_GRAPHIC_VULKAN_DELETION_QUEUE_H
+#define PIXEL_ENGINE_GRAPHIC_VULKAN_DELETION_QUEUE_H
+
+#pragma once
+
+#include "../memory/memory_allocator.hpp"
+#include "../sync/queue_sync.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace graph_vulkan{
+    class DeletionQueue {
+    public:
+        // last_use of a resource used by the frame being recorded
+        static constexpr uint64_t CURRENT_FRAME = UINT64_MAX;
+
+    private:
+        // only the handles that are set get destroyed, memory is freed after them
+        struct Deferred_Deletion {
+            uint64_t last_use = 0;
+            // set instead of last_use for resources used by a submit outside the frame loop
+            Sync_Point sync_point{};
+            VkBuffer buffer = VK_NULL_HANDLE;
+            VkImage image = VK_NULL_HANDLE;
+            VkImageView image_view = VK_NULL_HANDLE;
+            VkSampler sampler = VK_NULL_HANDLE;
+            VkFramebuffer framebuffer = VK_NULL_HANDLE;
+            VkPipeline pipeline = VK_NULL_HANDLE;
+            VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
+            VkDescriptorPool descriptor_pool = VK_NULL_HANDLE;
+            Memory_Allocation memory{};
+            std::function<void()> destroy;
+        };
+
+        VkDevice device;
+        MemoryAllocator &allocator;
+        QueueSync &queue_sync;
+
+        // serial the frame being recorded is going to get
+        std::atomic<uint64_t> current_frame{1};
+        std::atomic<uint64_t> completed_frame{0};
+
+        std::mutex mutex;
+        std::vector<Deferred_Deletion> pending;
+        uint64_t destroyed_count = 0;
+
+        void push(Deferred_Deletion deletion, uint64_t last_use);
+        void push(Deferred_Deletion deletion, Sync_Point last_use);
+        void destroy(Deferred_Deletion &deletion);
+        // completed holds the frame serial followed by the value of every timeline
+        void collect_retired(const uint64_t (&completed)[QUEUE_TYPE_COUNT + 1]);
+
+    public:
+        DeletionQueue(VkDevice device, MemoryAllocator &allocator, QueueSync &queue_sync);
+        // whatever is still pending is destroyed without waiting, flush() after the device went idle first
+        ~DeletionQueue();
+
+        DeletionQueue(const DeletionQueue &) = delete;
+        DeletionQueue &operator = (const DeletionQueue &) = delete;
+
+        uint64_t get_current_frame() const { return current_frame.load(std::memory_order_acquire); }
+        uint64_t get_completed_frame() const { return completed_frame.load(std::memory_order_acquire); }
+        // called by the frame loop right after the submit, returns the serial of the submitted frame
+        uint64_t end_frame();
+        // called by the frame loop once the fence of frame serial has signaled, destroys what it retires
+        void frame_completed(uint64_t serial);
+
+        // memory is taken over and reset, the caller's handles must not be used any more
+        void push_buffer(VkBuffer buffer, Memory_Allocation &memory, uint64_t last_use = CURRENT_FRAME);
+        void push_image(VkImage image, Memory_Allocation &memory, uint64_t last_use = CURRENT_FRAME);
+        void push_memory(Memory_Allocation &memory, uint64_t last_use = CURRENT_FRAME);
+        void push_image_view(VkImageView image_view, uint64_t last_use = CURRENT_FRAME);
+        void push_sampler(VkSampler sampler, uint64_t last_use = CURRENT_FRAME);
+        void push_framebuffer(VkFramebuffer framebuffer, uint64_t last_use = CURRENT_FRAME);
+        void push_pipeline(VkPipeline pipeline, uint64_t last_use = CURRENT_FRAME);
+        void push_pipeline_layout(VkPipelineLayout pipeline_layout, uint64_t last_use = CURRENT_FRAME);
+        void push_descriptor_pool(VkDescriptorPool descriptor_pool, uint64_t last_use = CURRENT_FRAME);
+        // anything else, runs on the thread that completes the frame
+        void push_function(std::function<void()> destroy, uint64_t last_use = CURRENT_FRAME);
+
+        // the same for resources last used by a submit outside the frame loop, freed once the point is reached
+        void push_buffer(VkBuffer buffer, Memory_Allocation &memory, Sync_Point last_use);
+        void push_image(VkImage image, Memory_Allocation &memory, Sync_Point last_use);
+        void push_memory(Memory_Allocation &memory, Sync_Point last_use);
+        void push_image_view(VkImageView image_view, Sync_Point last_use);
+        void push_sampler(VkSampler sampler, Sync_Point last_use);
+        void push_framebuffer(VkFramebuffer framebuffer, Sync_Point last_use);
+        void push_pipeline(VkPipeline pipeline, Sync_Point last_use);
+        void push_pipeline_layout(VkPipelineLayout pipeline_layout, Sync_Point last_use);
+        void push_descriptor_pool(VkDescriptorPool descriptor_pool, Sync_Point last_use);
+        // runs on the thread that calls collect()
+        void push_function(std::function<void()> destroy, Sync_Point last_use);
+
+        // destroys everything last used by frame serial completed or earlier, and every
+        // sync point QueueSync reports as reached
+        void collect(uint64_t completed);
+        // the same with the last completed frame, for code outside the frame loop like the upload service
+        void collect();
+        // destroys everything, the device has to be idle
+        void flush();
+
+        size_t get_pending_count();
+        uint64_t get_destroyed_count();
+    };
+
+} // namespace graph_vulkan
+
+
+#endif // PIXEL_ENGINE_GRAPHIC_VULKAN_DELETION_QUEUE_H
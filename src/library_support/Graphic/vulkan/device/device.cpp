@@ -3,11 +3,18 @@
 //
 
 #include "device.hpp"
+#include "../../../Profiling/profiler/profiler.hpp"
 
 // std headers
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <map>
 #include <set>
+#include <sstream>
 #include <unordered_set>
 
 namespace graph_vulkan{
@@ -56,29 +63,90 @@ namespace graph_vulkan{
     Device::Device(
             Window &window,
             std::string application_name,
-            std::tuple<int, int, int> application_version
-            ) : window{window} {
+            std::tuple<int, int, int> application_version,
+            const Device_Config &config
+            ) : config{config}, window{&window} {
+        this->config.headless = false;
+        init_instance(application_name, application_version);
+        init_device();
+    }
+
+    Device::Device(
+            std::string application_name,
+            std::tuple<int, int, int> application_version,
+            const Device_Config &config
+            ) : config{config} {
+        this->config.headless = true;
+        init_instance(application_name, application_version);
+        init_device();
+    }
+
+    Device::Device(
+            Deferred_Window,
+            std::string application_name,
+            std::tuple<int, int, int> application_version,
+            const Device_Config &config
+            ) : config{config} {
+        this->config.headless = false;
+        init_instance(application_name, application_version);
+    }
 
+    void Device::attach_window(Window &window) {
+        if (this->window != nullptr || config.headless) {
+            throw std::runtime_error("Device already has its window or is headless.");
+        }
+        this->window = &window;
+        init_device();
+    }
+
+    void Device::init_instance(const std::string &application_name, std::tuple<int, int, int> application_version) {
+        PIXEL_PROFILE_ZONE("create instance");
+        // nothing but disk, overlaps with the loader and the driver below
+        pipeline_cache_file = std::async(std::launch::async, PipelineCache::read_file, config.pipeline_cache_path);
         create_instance(
-                const_cast<char*>(application_name.data()),
+                application_name.c_str(),
                 application_version
                 );
         setup_debug_messenger();
-        create_surface();
+    }
+
+    void Device::init_device() {
+        PIXEL_PROFILE_ZONE("create device");
+        if (!config.headless) create_surface();
         pick_physical_device();
         create_logical_device();
+        create_queue_sync();
+        create_allocator();
+        create_deletion_queue();
+        create_pipeline_cache();
+        create_shader_module_cache();
+        create_descriptor_layout_cache();
         create_command_pool();
     }
 
     Device::~Device() {
-        vkDestroyCommandPool(device_, command_pool, nullptr);
-        vkDestroyDevice(device_, nullptr);
+        // a two step device whose startup failed before attach_window() has an instance only
+        if (device_ != VK_NULL_HANDLE) {
+            // the only idle wait left, whatever the frame loop did not retire yet goes here
+            vkDeviceWaitIdle(device_);
+            deletion_queue_.reset();
+            queue_sync_.reset();
+            vkDestroyCommandPool(device_, command_pool, nullptr);
+            vkDestroyCommandPool(device_, transfer_command_pool, nullptr);
+            vkDestroyCommandPool(device_, compute_command_pool, nullptr);
+            shader_module_cache_.reset();
+            descriptor_layout_cache_.reset();
+            // written back to disk here, every pipeline has to be gone by now
+            pipeline_cache_.reset();
+            allocator_.reset();
+            vkDestroyDevice(device_, nullptr);
+        }
 
         if (enable_validation_layers) {
             destroy_debug_utils_messenger_EXT(instance, debug_messenger, nullptr);
         }
 
-        vkDestroySurfaceKHR(instance, surface_, nullptr);
+        if (surface_ != VK_NULL_HANDLE) vkDestroySurfaceKHR(instance, surface_, nullptr);
         vkDestroyInstance(instance, nullptr);
     }
 
@@ -97,13 +165,20 @@ namespace graph_vulkan{
                 );
         app_info.pEngineName = "No Engine";
         app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-        app_info.apiVersion = VK_API_VERSION_1_0;
+        // 1.2 for timeline semaphores when the loader knows it, a 1.0 loader rejects anything above 1.0
+        auto enumerate_instance_version = reinterpret_cast<PFN_vkEnumerateInstanceVersion>(
+                vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion"));
+        uint32_t loader_version = VK_API_VERSION_1_0;
+        if (enumerate_instance_version) enumerate_instance_version(&loader_version);
+        instance_api_version = loader_version >= VK_API_VERSION_1_2 ? VK_API_VERSION_1_2 : VK_API_VERSION_1_0;
+        app_info.apiVersion = instance_api_version;
 
         VkInstanceCreateInfo create_info = {};
         create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
         create_info.pApplicationInfo = &app_info;
 
         auto extensions = get_required_extensions();
+        has_GflW_required_instance_extensions(extensions);
 
         create_info.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
         create_info.ppEnabledExtensionNames = extensions.data();
@@ -111,7 +186,7 @@ namespace graph_vulkan{
         VkDebugUtilsMessengerCreateInfoEXT debug_create_info;
         if (enable_validation_layers){
             create_info.enabledLayerCount = static_cast<uint32_t>(validation_layers.size());
-            create_info.ppEnabledExtensionNames = validation_layers.data();
+            create_info.ppEnabledLayerNames = validation_layers.data();
 
             populate_debug_messenger_create_info(debug_create_info);
             create_info.pNext = (VkDebugUtilsMessengerCreateInfoEXT *)&debug_create_info;
@@ -124,8 +199,6 @@ namespace graph_vulkan{
             std::string error_message = std::string("Failed to create instance: ").append(application_name);
             throw std::runtime_error(error_message);
         }
-
-        has_GflW_required_instance_extensions();
     }
 
     void Device::pick_physical_device() {
@@ -135,61 +208,197 @@ namespace graph_vulkan{
             throw std::runtime_error("Failed to fin GPUs with Vulkan support.");
         }
 
-        std::cout << "Device count: " << device_count << std::endl;
+        // kept for the startup report, printing here would block the startup on the console
+        std::ostringstream device_list;
+        device_list << "Device count: " << device_count << "\n";
         std::vector<VkPhysicalDevice> devices(device_count);
         vkEnumeratePhysicalDevices(instance, &device_count, devices.data());
 
-        for(const auto &device : devices){
-            if(is_device_suitable(device)){
-                physical_device = device;
-                break;
+        // an explicit choice is either an index into the enumeration or part of the device name
+        std::string preferred = config.preferred_device;
+        if (const char *environment = std::getenv("PIXEL_ENGINE_GPU")) {
+            preferred = environment;
+        }
+        auto to_lower = [](unsigned char c){ return static_cast<char>(std::tolower(c)); };
+        std::transform(preferred.begin(), preferred.end(), preferred.begin(), to_lower);
+        bool preferred_is_index = !preferred.empty() &&
+                std::all_of(preferred.begin(), preferred.end(), [](unsigned char c){ return std::isdigit(c) != 0; });
+        // an index past the devices matches none of them, that is warned about below like a missing name
+        uint64_t preferred_index = UINT64_MAX;
+        if (preferred_is_index) {
+            errno = 0;
+            unsigned long long index = std::strtoull(preferred.c_str(), nullptr, 10);
+            if (errno != ERANGE) preferred_index = index;
+        }
+
+        std::vector<Physical_Device_Info> candidates;
+        int64_t best_score = -1;
+        int64_t best_candidate = -1;
+        int64_t preferred_candidate = -1;
+        for(uint32_t i = 0; i < device_count; i++){
+            Physical_Device_Info info = Physical_Device_Info::query(devices[i], i);
+            int64_t score = is_device_suitable(info) ? rate_device(info) : -1;
+
+            device_list << "\t[" << i << "] " << info.properties.deviceName
+                        << " (" << info.device_type_name() << ", "
+                        << info.device_local_heap_size() / (1024 * 1024) << " MiB) score: ";
+            if (score < 0) device_list << "unsuitable"; else device_list << score;
+            device_list << "\n";
+
+            if (score < 0) continue;
+
+            std::string name = info.properties.deviceName;
+            std::transform(name.begin(), name.end(), name.begin(), to_lower);
+            if (!preferred.empty() && preferred_candidate < 0 &&
+                (preferred_is_index ? preferred_index == i : name.find(preferred) != std::string::npos)){
+                preferred_candidate = static_cast<int64_t>(candidates.size());
+            }
+            if (score > best_score){
+                best_score = score;
+                best_candidate = static_cast<int64_t>(candidates.size());
             }
+            candidates.push_back(std::move(info));
         }
 
-        if(physical_device == VK_NULL_HANDLE){
-            throw std::runtime_error("Failed to find a suitable GPU!");
+        if(candidates.empty()){
+            throw std::runtime_error("Failed to find a suitable GPU!\n" + device_list.str());
+        }
+        if (!preferred.empty() && preferred_candidate < 0){
+            std::cerr << "Requested GPU \"" << preferred << "\" is not available or not suitable, using the best scoring one." << std::endl;
         }
 
-        vkGetPhysicalDeviceProperties(physical_device, &properties);
+        physical_device_info = std::move(candidates[preferred_candidate >= 0 ? preferred_candidate : best_candidate]);
+        physical_device = physical_device_info.handle;
+        properties = physical_device_info.properties;
+        queue_family_indices = find_queue_families(physical_device_info);
 
-        std::cout << "Physical device: " << properties.deviceName << std::endl;
+        device_list << "Physical device: " << properties.deviceName << "\n";
+        device_report += device_list.str();
+    }
+
+    int64_t Device::rate_device(const Physical_Device_Info &device_info) {
+        int64_t score = 0;
+
+        // device type dominates, a software rasterizer only wins when it is the only choice
+        switch (device_info.properties.deviceType) {
+            case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:   score += 100000; break;
+            case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: score +=  50000; break;
+            case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:    score +=  20000; break;
+            case VK_PHYSICAL_DEVICE_TYPE_CPU:            score +=   1000; break;
+            default:                                     score +=   5000; break;
+        }
+
+        // 1 point per 64 MiB of device local memory
+        score += static_cast<int64_t>(device_info.device_local_heap_size() / (64ull * 1024 * 1024));
+
+        Queue_Family_Indices indices = find_queue_families(device_info);
+        if (indices.has_dedicated_transfer()) score += 500;
+        if (indices.has_dedicated_compute()) score += 500;
+
+        const VkPhysicalDeviceLimits &limits = device_info.properties.limits;
+        score += limits.maxImageDimension2D / 1024;
+        score += static_cast<int64_t>(limits.maxMemoryAllocationCount / 65536);
+
+        if (device_info.features.textureCompressionBC) score += 200;
+        if (device_info.properties.apiVersion >= VK_API_VERSION_1_2) score += 200;
+
+        return score;
     }
 
     void Device::create_logical_device() {
-        Queue_Family_Indices indices = find_queue_families(physical_device);
+        Queue_Family_Indices &indices = queue_family_indices;
+        const std::vector<VkQueueFamilyProperties> &queue_families = physical_device_info.queue_families;
+
+        // transfer and compute reuse the graphics queue when they fall back to its family,
+        // when they share a non graphics family they get separate queues if the family has enough
+        uint32_t transfer_queue_index = 0;
+        uint32_t compute_queue_index = 0;
+        if (indices.has_dedicated_compute() && indices.has_dedicated_transfer() &&
+            indices.compute_Family == indices.transfer_Family &&
+            queue_families[indices.compute_Family].queueCount > 1) {
+            compute_queue_index = 1;
+        }
 
-        std::vector<VkDeviceQueueCreateInfo> queue_create_infos;
-        std::set<uint32_t> unique_queue_families = {
-                indices.graphics_Family,
-                indices.present_Family
+        std::map<uint32_t, uint32_t> queue_counts = {
+                {indices.graphics_Family, 1},
+                {indices.present_Family, 1}
         };
+        queue_counts[indices.transfer_Family] = std::max(queue_counts[indices.transfer_Family], transfer_queue_index + 1);
+        queue_counts[indices.compute_Family] = std::max(queue_counts[indices.compute_Family], compute_queue_index + 1);
 
-        float queue_priority = 1.0f;
-        for(uint32_t queue_family : unique_queue_families){
+        std::vector<VkDeviceQueueCreateInfo> queue_create_infos;
+        const float queue_priorities[2] = {1.0f, 1.0f};
+        for(const auto &queue_family : queue_counts){
             VkDeviceQueueCreateInfo queue_create_info = {};
             queue_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-            queue_create_info.queueFamilyIndex = queue_family;
-            queue_create_info.queueCount = 1;
-            queue_create_info.pQueuePriorities = &queue_priority;
+            queue_create_info.queueFamilyIndex = queue_family.first;
+            queue_create_info.queueCount = queue_family.second;
+            queue_create_info.pQueuePriorities = queue_priorities;
             queue_create_infos.push_back(queue_create_info);
         }
 
         VkPhysicalDeviceFeatures device_features = {};
-        device_features.samplerAnisotropy = VK_TRUE;
+        // always there on the windowed path, software implementations may lack it
+        device_features.samplerAnisotropy = physical_device_info.features.samplerAnisotropy;
 
         VkDeviceCreateInfo create_info = {};
         create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 
+        // only what the engine uses out of the 1.2 features, the rest stays off
+        VkPhysicalDeviceVulkan12Features supported_12_features{};
+        supported_12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        vulkan_12_features = VkPhysicalDeviceVulkan12Features{};
+        vulkan_12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        vulkan_12_properties = VkPhysicalDeviceVulkan12Properties{};
+        vulkan_12_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+        if (api_version() >= VK_API_VERSION_1_2) {
+            auto get_features_2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2>(
+                    vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2"));
+            VkPhysicalDeviceFeatures2 features_2{};
+            features_2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            features_2.pNext = &supported_12_features;
+            if (get_features_2) get_features_2(physical_device, &features_2);
+
+            vulkan_12_features.timelineSemaphore = supported_12_features.timelineSemaphore;
+            // bindless descriptors need all of these, a part of them is no use
+            const VkPhysicalDeviceVulkan12Features &s = supported_12_features;
+            if (s.descriptorIndexing && s.runtimeDescriptorArray && s.descriptorBindingPartiallyBound &&
+                s.descriptorBindingUpdateUnusedWhilePending &&
+                s.shaderSampledImageArrayNonUniformIndexing && s.descriptorBindingSampledImageUpdateAfterBind &&
+                s.shaderStorageImageArrayNonUniformIndexing && s.descriptorBindingStorageImageUpdateAfterBind &&
+                s.shaderStorageBufferArrayNonUniformIndexing && s.descriptorBindingStorageBufferUpdateAfterBind) {
+                vulkan_12_features.descriptorIndexing = VK_TRUE;
+                vulkan_12_features.runtimeDescriptorArray = VK_TRUE;
+                vulkan_12_features.descriptorBindingPartiallyBound = VK_TRUE;
+                vulkan_12_features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+                vulkan_12_features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+                vulkan_12_features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+                vulkan_12_features.shaderStorageImageArrayNonUniformIndexing = VK_TRUE;
+                vulkan_12_features.descriptorBindingStorageImageUpdateAfterBind = VK_TRUE;
+                vulkan_12_features.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+                vulkan_12_features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+
+                auto get_properties_2 = reinterpret_cast<PFN_vkGetPhysicalDeviceProperties2>(
+                        vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceProperties2"));
+                VkPhysicalDeviceProperties2 properties_2{};
+                properties_2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+                properties_2.pNext = &vulkan_12_properties;
+                if (get_properties_2) get_properties_2(physical_device, &properties_2);
+            }
+            create_info.pNext = &vulkan_12_features;
+        }
+
         create_info.queueCreateInfoCount = static_cast<uint32_t>(queue_create_infos.size());
         create_info.pQueueCreateInfos = queue_create_infos.data();
 
         create_info.pEnabledFeatures = &device_features;
-        create_info.enabledExtensionCount = static_cast<uint32_t>(device_extensions.size());
-        create_info.ppEnabledExtensionNames = device_extensions.data();
+        auto extensions = get_required_device_extensions();
+        create_info.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+        create_info.ppEnabledExtensionNames = extensions.data();
 
         if(enable_validation_layers){
             create_info.enabledLayerCount = static_cast<uint32_t>(validation_layers.size());
-            create_info.ppEnabledExtensionNames = validation_layers.data();
+            create_info.ppEnabledLayerNames = validation_layers.data();
         } else {
             create_info.enabledLayerCount = 0;
         }
@@ -200,40 +409,118 @@ namespace graph_vulkan{
 
         vkGetDeviceQueue(device_, indices.graphics_Family, 0, &graphics_queue_);
         vkGetDeviceQueue(device_, indices.present_Family,  0, &present_queue_);
+        vkGetDeviceQueue(device_, indices.transfer_Family, transfer_queue_index, &transfer_queue_);
+        vkGetDeviceQueue(device_, indices.compute_Family,  compute_queue_index,  &compute_queue_);
+
+        std::ostringstream queue_report;
+        queue_report << "Queue families: graphics " << indices.graphics_Family
+                     << ", transfer " << indices.transfer_Family << (indices.has_dedicated_transfer() ? " (dedicated)" : "")
+                     << ", compute " << indices.compute_Family << (indices.has_dedicated_compute() ? " (dedicated)" : "")
+                     << ", sync " << (vulkan_12_features.timelineSemaphore ? "timeline semaphores" : "fences")
+                     << ", descriptors " << (supports_bindless() ? "bindless" : "pooled")
+                     << "\n";
+        device_report += queue_report.str();
     }
 
-    void Device::create_command_pool() {
-        Queue_Family_Indices queue_family_indices = find_physical_queue_families();
+    void Device::create_queue_sync() {
+        queue_sync_ = std::make_unique<QueueSync>(
+                device_,
+                vulkan_12_features.timelineSemaphore == VK_TRUE,
+                graphics_queue_,
+                transfer_queue_,
+                compute_queue_,
+                present_queue_
+                );
+    }
 
+    uint32_t Device::api_version() const {
+        return std::min(instance_api_version, properties.apiVersion);
+    }
+
+    bool Device::supports_bindless() const {
+        return vulkan_12_features.descriptorIndexing == VK_TRUE;
+    }
+
+    VkCommandPool Device::create_command_pool_for(uint32_t queue_family) {
         VkCommandPoolCreateInfo pool_info = {};
         pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-        pool_info.queueFamilyIndex = queue_family_indices.graphics_Family;
+        pool_info.queueFamilyIndex = queue_family;
         pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
-        if (vkCreateCommandPool(device_, &pool_info, nullptr, &command_pool) != VK_SUCCESS){
+        VkCommandPool pool;
+        if (vkCreateCommandPool(device_, &pool_info, nullptr, &pool) != VK_SUCCESS){
             throw std::runtime_error("Failed to create command pool. ");
         }
+        return pool;
+    }
+
+    void Device::create_command_pool() {
+        command_pool = create_command_pool_for(queue_family_indices.graphics_Family);
+        transfer_command_pool = create_command_pool_for(queue_family_indices.transfer_Family);
+        compute_command_pool = create_command_pool_for(queue_family_indices.compute_Family);
+    }
+
+    std::vector<uint32_t> Device::get_shared_queue_families() {
+        std::set<uint32_t> families = {
+                queue_family_indices.graphics_Family,
+                queue_family_indices.transfer_Family,
+                queue_family_indices.compute_Family
+        };
+        return {families.begin(), families.end()};
+    }
+
+    void Device::create_allocator() {
+        allocator_ = std::make_unique<MemoryAllocator>(
+                device_,
+                physical_device_info.memory_properties,
+                properties.limits
+                );
+    }
+
+    void Device::create_deletion_queue() {
+        deletion_queue_ = std::make_unique<DeletionQueue>(device_, *allocator_, *queue_sync_);
+    }
+
+    void Device::create_pipeline_cache() {
+        pipeline_cache_ = std::make_unique<PipelineCache>(device_, properties, config.pipeline_cache_path, pipeline_cache_file.get());
+        device_report += pipeline_cache_->load_report();
+    }
+
+    void Device::create_shader_module_cache() {
+        if (!config.asset_archive_path.empty()) {
+            try {
+                asset_archive_ = std::make_unique<file_io::AssetArchive>(config.asset_archive_path);
+            } catch (const std::runtime_error &error) {
+                std::cerr << "Asset archive: " << error.what() << ", loading assets from loose files" << std::endl;
+            }
+        }
+        shader_module_cache_ = std::make_unique<ShaderModuleCache>(device_, asset_archive_.get());
+    }
+
+    void Device::create_descriptor_layout_cache() {
+        descriptor_layout_cache_ = std::make_unique<DescriptorLayoutCache>(device_);
     }
 
     void Device::create_surface() {
-        window.create_window_surface(instance, &surface_);
+        window->create_window_surface(instance, &surface_);
     }
 
-    bool Device::is_device_suitable(VkPhysicalDevice device) {
-        Queue_Family_Indices indices = find_queue_families(device);
+    bool Device::is_device_suitable(const Physical_Device_Info &device_info) {
+        Queue_Family_Indices indices = find_queue_families(device_info);
 
-        bool extensions_supported = check_device_extension_support(device);
+        // nothing is presented, a graphics queue is all offscreen rendering needs
+        if (config.headless) return indices.is_complete();
+
+        bool extensions_supported = check_device_extension_support(device_info);
 
         bool swap_chain_adequate = false;
         if(extensions_supported){
-            Swap_Chain_Support_Details swap_chain_support = query_Swap_Chain_Support(device);
+            Swap_Chain_Support_Details swap_chain_support = query_Swap_Chain_Support(device_info.handle);
 
             swap_chain_adequate = !swap_chain_support.formats.empty() && !swap_chain_support.presentModes.empty();
         }
-        VkPhysicalDeviceFeatures supported_features;
-        vkGetPhysicalDeviceFeatures(device, &supported_features);
 
-        return indices.is_complete() && extensions_supported && swap_chain_adequate && supported_features.samplerAnisotropy;
+        return indices.is_complete() && extensions_supported && swap_chain_adequate && device_info.features.samplerAnisotropy;
     }
 
     void Device::populate_debug_messenger_create_info(VkDebugUtilsMessengerCreateInfoEXT &create_info) {
@@ -281,6 +568,15 @@ namespace graph_vulkan{
     }
 
     std::vector<const char *> Device::get_required_extensions() {
+        if (config.headless) {
+            // GLFW is never initialized without a window
+            std::vector<const char *> extensions;
+            if (enable_validation_layers){
+                extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+            }
+            return extensions;
+        }
+
         uint32_t  glfw_Extension_count = 0;
         const char **glfw_Extensions;
         glfw_Extensions = glfwGetRequiredInstanceExtensions(&glfw_Extension_count);
@@ -293,75 +589,106 @@ namespace graph_vulkan{
         return extensions;
     }
 
-    void Device::has_GflW_required_instance_extensions() {
+    void Device::has_GflW_required_instance_extensions(const std::vector<const char *> &required_extensions) {
         uint32_t extension_count = 0;
         vkEnumerateInstanceExtensionProperties(nullptr, &extension_count, nullptr);
         std::vector<VkExtensionProperties> extensions(extension_count);
         vkEnumerateInstanceExtensionProperties(nullptr, &extension_count, extensions.data());
 
-        std::cout << "Available extensions: " << std::endl;
+        // only what is missing is worth printing, listing every extension cost more than creating the instance
         std::unordered_set<std::string> available;
         for (const auto &extension : extensions){
-            std::cout << "\t" << extension.extensionName << std::endl;
             available.insert(extension.extensionName);
         }
+        for (const char *required : required_extensions){
+            if (available.count(required) == 0){
+                throw std::runtime_error(std::string("Missing required instance extension: ") + required);
+            }
+        }
     }
 
-    bool Device::check_device_extension_support(VkPhysicalDevice device) {
-        uint32_t extension_count;
-        vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, nullptr);
-
-        std::vector<VkExtensionProperties> available_extensions(extension_count);
-        vkEnumerateDeviceExtensionProperties(
-                device,
-                nullptr,
-                &extension_count,
-                available_extensions.data()
-                );
-
-        std::set<std::string> required_extensions(device_extensions.begin(), device_extensions.end());
+    std::vector<const char *> Device::get_required_device_extensions() {
+        if (config.headless) return {};
+        return device_extensions;
+    }
 
-        for(const auto &extension : available_extensions){
-            required_extensions.erase(extension.extensionName);
+    bool Device::check_device_extension_support(const Physical_Device_Info &device_info) {
+        for(const char *extension : get_required_device_extensions()){
+            if (!device_info.supports_extension(extension)) return false;
         }
-
-        return required_extensions.empty();
+        return true;
     }
 
-    Queue_Family_Indices Device::find_queue_families(VkPhysicalDevice device) {
+    Queue_Family_Indices Device::find_queue_families(const Physical_Device_Info &device_info) {
         Queue_Family_Indices indices;
 
-        uint32_t queue_family_count = 0;
-        vkGetPhysicalDeviceQueueFamilyProperties(
-                device,
-                &queue_family_count,
-                nullptr
-                );
+        VkPhysicalDevice device = device_info.handle;
+        const std::vector<VkQueueFamilyProperties> &queue_families = device_info.queue_families;
+        uint32_t queue_family_count = static_cast<uint32_t>(queue_families.size());
+
+        // every family has to be looked at, the dedicated ones are usually listed last
+        for(uint32_t _i = 0; _i < queue_family_count; _i++){
+            const auto &queue_family = queue_families[_i];
+            if (queue_family.queueCount == 0) continue;
+
+            bool graphics = queue_family.queueFlags & VK_QUEUE_GRAPHICS_BIT;
+            bool compute = queue_family.queueFlags & VK_QUEUE_COMPUTE_BIT;
+            bool transfer = queue_family.queueFlags & VK_QUEUE_TRANSFER_BIT;
 
-        std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
-        vkGetPhysicalDeviceQueueFamilyProperties(device, &queue_family_count, queue_families.data());
+            VkBool32 presentSupport = false;
+            if (surface_ != VK_NULL_HANDLE) {
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, _i, surface_, &presentSupport);
+            }
 
-        int _i = 0;
-        for(const auto &queue_family : queue_families){
-            if (queue_family.queueCount > 0 && queue_family.queueFlags & VK_QUEUE_GRAPHICS_BIT){
+            // prefer one family doing both graphics and present
+            if (graphics && (!indices.graphics_Family_has_Value ||
+                             (presentSupport && !(indices.present_Family_has_Value && indices.present_Family == indices.graphics_Family)))){
                 indices.graphics_Family = _i;
                 indices.graphics_Family_has_Value = true;
             }
-            VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, _i, surface_, &presentSupport);
-            if (queue_family.queueCount > 0 && presentSupport){
+            if (presentSupport && (!indices.present_Family_has_Value || (graphics && indices.graphics_Family == _i))){
                 indices.present_Family = _i;
                 indices.present_Family_has_Value = true;
             }
-            if (indices.is_complete()){
-                break;
+
+            // a transfer only family is the DMA engine, a compute family without graphics is async compute
+            if (transfer && !graphics && !compute && !indices.transfer_Family_has_Value){
+                indices.transfer_Family = _i;
+                indices.transfer_Family_has_Value = true;
+            }
+            if (compute && !graphics && !indices.compute_Family_has_Value){
+                indices.compute_Family = _i;
+                indices.compute_Family_has_Value = true;
+            }
+        }
+
+        if (!indices.transfer_Family_has_Value && indices.compute_Family_has_Value){
+            // compute families can always transfer, still better than the graphics queue
+            indices.transfer_Family = indices.compute_Family;
+            indices.transfer_Family_has_Value = true;
+        }
+        if (indices.graphics_Family_has_Value){
+            if (config.headless){
+                // nothing is presented, the present queue is just the graphics queue
+                indices.present_Family = indices.graphics_Family;
+                indices.present_Family_has_Value = true;
+            }
+            if (!indices.transfer_Family_has_Value){
+                indices.transfer_Family = indices.graphics_Family;
+                indices.transfer_Family_has_Value = true;
+            }
+            if (!indices.compute_Family_has_Value){
+                indices.compute_Family = indices.graphics_Family;
+                indices.compute_Family_has_Value = true;
             }
-            _i++;
         }
         return indices;
     }
 
     Swap_Chain_Support_Details Device::query_Swap_Chain_Support(VkPhysicalDevice device) {
+        if (surface_ == VK_NULL_HANDLE) {
+            throw std::runtime_error("Headless device has no surface, render to an OffscreenTarget instead.");
+        }
         Swap_Chain_Support_Details details;
         vkGetPhysicalDeviceSurfaceCapabilitiesKHR(
                 device,
@@ -407,8 +734,7 @@ namespace graph_vulkan{
             VkImageTiling tiling,
             VkFormatFeatureFlags features) {
         for (VkFormat format : candidates) {
-            VkFormatProperties props;
-            vkGetPhysicalDeviceFormatProperties(physical_device, format, &props);
+            VkFormatProperties props = physical_device_info.get_format_properties(format);
 
             if (tiling == VK_IMAGE_TILING_LINEAR && (props.linearTilingFeatures & features) == features){
                 return format;
@@ -423,26 +749,27 @@ namespace graph_vulkan{
     }
 
     uint32_t Device::find_Memory_type(uint32_t type_filter, VkMemoryPropertyFlags property_flags) {
-        VkPhysicalDeviceMemoryProperties memory_properties;
-        vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties);
-        for (uint32_t i = 0; i < memory_properties.memoryTypeCount; i++) {
-            if ((type_filter & (1 << i)) &&
-                (memory_properties.memoryTypes[i].propertyFlags & property_flags) == property_flags) {
-                return i;
-            }
-        }
-
-        throw std::runtime_error("failed to find suitable memory type!");
+        return allocator_->find_memory_type(type_filter, property_flags);
     }
 
     void Device::create_buffer(VkDeviceSize size, VkBufferUsageFlags usage,
                                VkMemoryPropertyFlags property_flags,
-                               VkBuffer &buffer, VkDeviceMemory &buffer_memory) {
+                               VkBuffer &buffer, Memory_Allocation &buffer_memory) {
             VkBufferCreateInfo bufferInfo{};
             bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
             bufferInfo.size = size;
             bufferInfo.usage = usage;
-            bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+            // buffers are filled on the transfer queue and read on graphics/compute,
+            // concurrent sharing spares every upload a queue ownership transfer
+            std::vector<uint32_t> shared_families = get_shared_queue_families();
+            if (shared_families.size() > 1) {
+                bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+                bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(shared_families.size());
+                bufferInfo.pQueueFamilyIndices = shared_families.data();
+            } else {
+                bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            }
 
             if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
                 throw std::runtime_error("Failed to create vertex buffer!");
@@ -451,16 +778,16 @@ namespace graph_vulkan{
             VkMemoryRequirements memory_requirements;
             vkGetBufferMemoryRequirements(device_, buffer, &memory_requirements);
 
-            VkMemoryAllocateInfo allocInfo{};
-            allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-            allocInfo.allocationSize = memory_requirements.size;
-            allocInfo.memoryTypeIndex = find_Memory_type(memory_requirements.memoryTypeBits, property_flags);
+            buffer_memory = allocator_->allocate(memory_requirements, property_flags, Allocation_Kind::linear);
 
-            if (vkAllocateMemory(device_, &allocInfo, nullptr, &buffer_memory) != VK_SUCCESS) {
-                throw std::runtime_error("Failed to allocate vertex buffer memory!");
+            if (vkBindBufferMemory(device_, buffer, buffer_memory.memory, buffer_memory.offset) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to bind vertex buffer memory!");
             }
+    }
 
-            vkBindBufferMemory(device_, buffer, buffer_memory, 0);
+    void Device::destroy_buffer(VkBuffer buffer, Memory_Allocation &buffer_memory) {
+        vkDestroyBuffer(device_, buffer, nullptr);
+        allocator_->free(buffer_memory);
     }
 
     VkCommandBuffer Device::begin_single_time_commands(){
@@ -484,13 +811,12 @@ namespace graph_vulkan{
     void Device::end_single_time_commands(VkCommandBuffer command_buffer){
         vkEndCommandBuffer(command_buffer);
 
-        VkSubmitInfo submit_info{};
-        submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        submit_info.commandBufferCount = 1;
-        submit_info.pCommandBuffers = &command_buffer;
+        Queue_Submit_Info submit_info{};
+        submit_info.command_buffers = {command_buffer};
 
-        vkQueueSubmit(graphics_queue_, 1, &submit_info, VK_NULL_HANDLE);
-        vkQueueWaitIdle(graphics_queue_);
+        // only wait for this submission instead of draining the whole graphics queue,
+        // bulk transfers should go through UploadService and not block at all
+        queue_sync_->wait(queue_sync_->submit(Queue_Type::graphics, submit_info));
 
         vkFreeCommandBuffers(device_, command_pool, 1, &command_buffer);
     }
@@ -545,25 +871,42 @@ namespace graph_vulkan{
             const VkImageCreateInfo &image_info,
             VkMemoryPropertyFlags property_flags,
             VkImage &image,
-            VkDeviceMemory &image_memory ){
-        if (vkCreateImage(device_, &image_info, nullptr, &image) != VK_SUCCESS) {
+            Memory_Allocation &image_memory ){
+        // sampled images uploaded through the transfer queue are shared the same way as buffers,
+        // attachments stay exclusive so the driver can keep its compression
+        VkImageCreateInfo shared_info = image_info;
+        std::vector<uint32_t> shared_families = get_shared_queue_families();
+        constexpr VkImageUsageFlags attachment_usage =
+                VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+        if (shared_families.size() > 1 &&
+            image_info.sharingMode == VK_SHARING_MODE_EXCLUSIVE &&
+            (image_info.usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT) &&
+            !(image_info.usage & attachment_usage)) {
+            shared_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            shared_info.queueFamilyIndexCount = static_cast<uint32_t>(shared_families.size());
+            shared_info.pQueueFamilyIndices = shared_families.data();
+        }
+
+        if (vkCreateImage(device_, &shared_info, nullptr, &image) != VK_SUCCESS) {
             throw std::runtime_error("failed to create image!");
         }
 
         VkMemoryRequirements memory_requirements;
         vkGetImageMemoryRequirements(device_, image, &memory_requirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memory_requirements.size;
-        allocInfo.memoryTypeIndex = find_Memory_type(memory_requirements.memoryTypeBits, property_flags);
-
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &image_memory) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate image memory!");
-        }
+        image_memory = allocator_->allocate(
+                memory_requirements,
+                property_flags,
+                image_info.tiling == VK_IMAGE_TILING_OPTIMAL ? Allocation_Kind::optimal : Allocation_Kind::linear
+                );
 
-        if (vkBindImageMemory(device_, image, image_memory, 0) != VK_SUCCESS) {
+        if (vkBindImageMemory(device_, image, image_memory.memory, image_memory.offset) != VK_SUCCESS) {
             throw std::runtime_error("failed to bind image memory!");
         }
     }
-} // namespace graph_vulkan
+
+    void Device::destroy_image(VkImage image, Memory_Allocation &image_memory) {
+        vkDestroyImage(device_, image, nullptr);
+        allocator_->free(image_memory);
+    }
+} // namespace graph_vulkan
\ No newline at end of file
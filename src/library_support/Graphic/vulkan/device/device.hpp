@@ -8,7 +8,17 @@
 #pragma once
 
 #include "../window/window.hpp"
+#include "../descriptor/descriptor_layout_cache.hpp"
+#include "../memory/memory_allocator.hpp"
+#include "../pipeline/pipeline_cache.hpp"
+#include "../shader/shader_module_cache.hpp"
+#include "../sync/queue_sync.hpp"
+#include "deletion_queue.hpp"
+#include "physical_device_info.hpp"
 
+#include <future>
+#include <memory>
+#include <ostream>
 #include <string>
 #include <vector>
 
@@ -22,44 +32,110 @@ namespace graph_vulkan{
     struct Queue_Family_Indices {
         uint32_t graphics_Family;
         uint32_t  present_Family;
+        // fall back to graphics_Family when the device has no dedicated family
+        uint32_t transfer_Family;
+        uint32_t  compute_Family;
         bool graphics_Family_has_Value = false;
         bool  present_Family_has_Value = false;
+        bool transfer_Family_has_Value = false;
+        bool  compute_Family_has_Value = false;
         bool is_complete() {
             return ( graphics_Family_has_Value && present_Family_has_Value );
         }
+        bool has_dedicated_transfer() const {
+            return transfer_Family_has_Value && graphics_Family_has_Value && transfer_Family != graphics_Family;
+        }
+        bool has_dedicated_compute() const {
+            return compute_Family_has_Value && graphics_Family_has_Value && compute_Family != graphics_Family;
+        }
+    };
+
+    struct Device_Config {
+        // index or part of the name of the GPU to use, empty picks the best scoring device,
+        // the PIXEL_ENGINE_GPU environment variable takes precedence over this
+        std::string preferred_device;
+        // where the VkPipelineCache is kept between runs, empty keeps it in memory only
+        std::string pipeline_cache_path = "pixel_engine_pipeline_cache.bin";
+        // no window, no surface and no swap chain, rendering goes to offscreen images,
+        // works on render servers and with software implementations like lavapipe
+        bool headless = false;
+        // packed assets (see File/archive), empty, missing or corrupt loads every asset from its own file
+        std::string asset_archive_path;
     };
 
+    // selects the two step constructor of a windowed Device
+    struct Deferred_Window {};
+
     class Device{
     private:
         VkInstance instance;
+        // 1.2 when the loader supports it, the device may still be 1.0, see api_version()
+        uint32_t instance_api_version = VK_API_VERSION_1_0;
         VkDebugUtilsMessengerEXT debug_messenger;
         VkPhysicalDevice physical_device = VK_NULL_HANDLE;
-        Window &window;
-        VkCommandPool command_pool;
+        Physical_Device_Info physical_device_info;
+        Device_Config config;
+        // null when headless
+        Window *window = nullptr;
+        VkCommandPool command_pool = VK_NULL_HANDLE;
+        VkCommandPool transfer_command_pool = VK_NULL_HANDLE;
+        VkCommandPool compute_command_pool = VK_NULL_HANDLE;
+        Queue_Family_Indices queue_family_indices;
 
-        VkDevice device_;
-        VkSurfaceKHR surface_;
+        // null until attach_window() when created in two steps
+        VkDevice device_ = VK_NULL_HANDLE;
+        VkSurfaceKHR surface_ = VK_NULL_HANDLE;
         VkQueue graphics_queue_;
         VkQueue present_queue_;
+        VkQueue transfer_queue_;
+        VkQueue compute_queue_;
+        // the 1.2 features that were enabled, all off on older devices
+        VkPhysicalDeviceVulkan12Features vulkan_12_features{};
+        // only queried when the descriptor indexing features are enabled
+        VkPhysicalDeviceVulkan12Properties vulkan_12_properties{};
+
+        std::unique_ptr<MemoryAllocator> allocator_;
+        std::unique_ptr<DeletionQueue> deletion_queue_;
+        std::unique_ptr<QueueSync> queue_sync_;
+        std::unique_ptr<PipelineCache> pipeline_cache_;
+        std::unique_ptr<ShaderModuleCache> shader_module_cache_;
+        std::unique_ptr<DescriptorLayoutCache> descriptor_layout_cache_;
+        // null without an archive, one open and one mapping for every packed asset
+        std::unique_ptr<file_io::AssetArchive> asset_archive_;
+        // read while the instance and device come up, it only needs the device to be validated
+        std::future<std::vector<char>> pipeline_cache_file;
+        // device list, choice, queue families and pipeline cache state, kept for print_device_report() instead of printed during startup
+        std::string device_report;
 
         const std::vector<const char *> validation_layers = {"VK_LAYER_KHRONOS_validation"};
         const std::vector<const char *> device_extensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 
+        void init_instance(const std::string &application_name, std::tuple<int, int, int> application_version);
+        void init_device();
         void create_instance(const char* application_name, std::tuple<int, int, int>application_version);
         void setup_debug_messenger();
         void create_surface();
         void pick_physical_device();
         void create_logical_device();
+        void create_queue_sync();
         void create_command_pool();
+        VkCommandPool create_command_pool_for(uint32_t queue_family);
+        void create_allocator();
+        void create_deletion_queue();
+        void create_pipeline_cache();
+        void create_shader_module_cache();
+        void create_descriptor_layout_cache();
 
         // helper functions
-        bool is_device_suitable(VkPhysicalDevice device);
+        bool is_device_suitable(const Physical_Device_Info &device_info);
+        int64_t rate_device(const Physical_Device_Info &device_info);
         std::vector<const char *> get_required_extensions();
+        std::vector<const char *> get_required_device_extensions();
         bool check_validation_layer_support();
-        Queue_Family_Indices find_queue_families(VkPhysicalDevice device);
+        Queue_Family_Indices find_queue_families(const Physical_Device_Info &device_info);
         void populate_debug_messenger_create_info(VkDebugUtilsMessengerCreateInfoEXT &create_info);
-        void has_GflW_required_instance_extensions();
-        bool check_device_extension_support(VkPhysicalDevice device);
+        void has_GflW_required_instance_extensions(const std::vector<const char *> &required_extensions);
+        bool check_device_extension_support(const Physical_Device_Info &device_info);
         Swap_Chain_Support_Details query_Swap_Chain_Support(VkPhysicalDevice device);
 
     public:
@@ -71,10 +147,28 @@ namespace graph_vulkan{
         Device(
             Window &window,
             std::string application_name,
-            std::tuple<int, int, int> application_version
+            std::tuple<int, int, int> application_version,
+            const Device_Config &config = Device_Config{}
+            );
+        // headless, config.headless is implied
+        Device(
+            std::string application_name,
+            std::tuple<int, int, int> application_version,
+            const Device_Config &config = Device_Config{}
+            );
+        // windowed in two steps: the instance is created here and the rest by attach_window(), so the
+        // window can be created on the main thread meanwhile; glfwInit must have been called already
+        Device(
+            Deferred_Window,
+            std::string application_name,
+            std::tuple<int, int, int> application_version,
+            const Device_Config &config = Device_Config{}
             );
         ~Device();
 
+        // surface, physical and logical device and everything after, nothing else may be used before
+        void attach_window(Window &window);
+
         Device(const Device &) = delete;
         Device &operator = (const Device &) = delete;
         Device(Device &&) = delete;
@@ -82,16 +176,46 @@ namespace graph_vulkan{
 
         // helper functions
         VkCommandPool get_command_pool(){ return command_pool; }
+        VkCommandPool get_transfer_command_pool(){ return transfer_command_pool; }
+        VkCommandPool get_compute_command_pool(){ return compute_command_pool; }
         VkDevice device(){ return device_; }
         VkSurfaceKHR surface(){ return surface_; }
+        bool is_headless(){ return config.headless; }
         VkQueue graphics_queue(){ return graphics_queue_; }
         VkQueue present_queue(){ return present_queue_; }
+        VkQueue transfer_queue(){ return transfer_queue_; }
+        VkQueue compute_queue(){ return compute_queue_; }
+        // every submit and present goes through here
+        QueueSync &sync(){ return *queue_sync_; }
+        // version both the instance and the physical device support
+        uint32_t api_version() const;
+        const VkPhysicalDeviceVulkan12Features &enabled_vulkan_12_features() const { return vulkan_12_features; }
+        const VkPhysicalDeviceVulkan12Properties &vulkan_12_limits() const { return vulkan_12_properties; }
+        // descriptor indexing with update after bind, what BindlessDescriptors needs
+        bool supports_bindless() const;
+        MemoryAllocator &allocator(){ return *allocator_; }
+        // resources still in use by frames in flight go here instead of being destroyed right away
+        DeletionQueue &deletion_queue(){ return *deletion_queue_; }
+        // shared by every pipeline creation
+        VkPipelineCache pipeline_cache(){ return pipeline_cache_->handle(); }
+        PipelineCache &pipeline_cache_store(){ return *pipeline_cache_; }
+        // one VkShaderModule per distinct SPIR-V code
+        ShaderModuleCache &shader_modules(){ return *shader_module_cache_; }
+        // one VkDescriptorSetLayout per distinct binding signature
+        DescriptorLayoutCache &descriptor_layouts(){ return *descriptor_layout_cache_; }
+        // null when the config names no archive or it could not be opened
+        const file_io::AssetArchive *asset_archive() const { return asset_archive_.get(); }
+        const Physical_Device_Info &physical_info(){ return physical_device_info; }
+        // for the startup report, once startup is done
+        void print_device_report(std::ostream &out) const { out << device_report << std::flush; }
 
         Swap_Chain_Support_Details get_Swap_Chain_Support(){ return query_Swap_Chain_Support(physical_device); }
 
         uint32_t find_Memory_type(uint32_t type_filter, VkMemoryPropertyFlags property_flags);
 
-        Queue_Family_Indices find_physical_queue_families(){  return find_queue_families(physical_device); }
+        Queue_Family_Indices find_physical_queue_families(){  return queue_family_indices; }
+        // distinct families among graphics, transfer and compute, used for concurrent sharing
+        std::vector<uint32_t> get_shared_queue_families();
 
         VkFormat find_supported_format(
                 const std::vector<VkFormat> &candidates,
@@ -105,8 +229,9 @@ namespace graph_vulkan{
                 VkBufferUsageFlags usage,
                 VkMemoryPropertyFlags property_flags,
                 VkBuffer &buffer,
-                VkDeviceMemory &buffer_memory
+                Memory_Allocation &buffer_memory
                 );
+        void destroy_buffer(VkBuffer buffer, Memory_Allocation &buffer_memory);
 
         VkCommandBuffer begin_single_time_commands();
         void end_single_time_commands(VkCommandBuffer command_buffer);
@@ -126,8 +251,9 @@ namespace graph_vulkan{
                 const VkImageCreateInfo &image_info,
                 VkMemoryPropertyFlags property_flags,
                 VkImage &image,
-                VkDeviceMemory &image_memory
+                Memory_Allocation &image_memory
                 );
+        void destroy_image(VkImage image, Memory_Allocation &image_memory);
 
         VkPhysicalDeviceProperties properties{};
     };
@@ -0,0 +1,79 @@
+/**
+ * library_support/Graphic/vulkan/device
+ *
+ **/
+
+// match hpp file
+#include "physical_device_info.hpp"
+//standard libraries
+#include <algorithm>
+#include <cstring>
+
+namespace graph_vulkan{
+    // the last format of the core specification, extension formats are looked up on demand
+    static constexpr uint32_t LAST_CORE_FORMAT = VK_FORMAT_ASTC_12x12_SRGB_BLOCK;
+
+    Physical_Device_Info Physical_Device_Info::query(VkPhysicalDevice device, uint32_t index) {
+        Physical_Device_Info info;
+        info.handle = device;
+        info.index = index;
+
+        vkGetPhysicalDeviceProperties(device, &info.properties);
+        vkGetPhysicalDeviceMemoryProperties(device, &info.memory_properties);
+        vkGetPhysicalDeviceFeatures(device, &info.features);
+
+        uint32_t queue_family_count = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &queue_family_count, nullptr);
+        info.queue_families.resize(queue_family_count);
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &queue_family_count, info.queue_families.data());
+
+        uint32_t extension_count = 0;
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, nullptr);
+        info.extensions.resize(extension_count);
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, info.extensions.data());
+
+        info.format_properties.resize(LAST_CORE_FORMAT + 1);
+        for (uint32_t format = 0; format <= LAST_CORE_FORMAT; format++) {
+            vkGetPhysicalDeviceFormatProperties(device, static_cast<VkFormat>(format), &info.format_properties[format]);
+        }
+
+        return info;
+    }
+
+    VkFormatProperties Physical_Device_Info::get_format_properties(VkFormat format) const {
+        if (static_cast<uint32_t>(format) < format_properties.size()) {
+            return format_properties[format];
+        }
+
+        VkFormatProperties props;
+        vkGetPhysicalDeviceFormatProperties(handle, format, &props);
+        return props;
+    }
+
+    bool Physical_Device_Info::supports_extension(const char *extension_name) const {
+        return std::any_of(extensions.begin(), extensions.end(), [extension_name](const VkExtensionProperties &extension){
+            return strcmp(extension.extensionName, extension_name) == 0;
+        });
+    }
+
+    VkDeviceSize Physical_Device_Info::device_local_heap_size() const {
+        VkDeviceSize largest = 0;
+        for (uint32_t i = 0; i < memory_properties.memoryHeapCount; i++) {
+            if (memory_properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+                largest = std::max(largest, memory_properties.memoryHeaps[i].size);
+            }
+        }
+        return largest;
+    }
+
+    std::string Physical_Device_Info::device_type_name() const {
+        switch (properties.deviceType) {
+            case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:   return "discrete";
+            case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return "integrated";
+            case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:    return "virtual";
+            case VK_PHYSICAL_DEVICE_TYPE_CPU:            return "cpu";
+            default:                                     return "other";
+        }
+    }
+
+} // namespace graph_vulkan
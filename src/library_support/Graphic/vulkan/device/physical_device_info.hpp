@@ -0,0 +1,47 @@
+/**
+ * library_support/Graphic/vulkan/device
+ *
+ * Snapshot of everything the engine asks a physical device about
+ *
+ * Queried once when the device is enumerated, afterwards memory type, format
+ * and extension lookups are answered from here without calling into the driver.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_GRAPHIC_VULKAN_PHYSICAL_DEVICE_INFO_H
+#define PIXEL_ENGINE_GRAPHIC_VULKAN_PHYSICAL_DEVICE_INFO_H
+
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <string>
+#include <vector>
+
+namespace graph_vulkan{
+    struct Physical_Device_Info {
+        VkPhysicalDevice handle = VK_NULL_HANDLE;
+        // position in vkEnumeratePhysicalDevices, used for selecting a device by index
+        uint32_t index = 0;
+
+        VkPhysicalDeviceProperties properties{};
+        VkPhysicalDeviceMemoryProperties memory_properties{};
+        VkPhysicalDeviceFeatures features{};
+        std::vector<VkQueueFamilyProperties> queue_families;
+        std::vector<VkExtensionProperties> extensions;
+        // properties of every core format, indexed by VkFormat
+        std::vector<VkFormatProperties> format_properties;
+
+        static Physical_Device_Info query(VkPhysicalDevice device, uint32_t index);
+
+        VkFormatProperties get_format_properties(VkFormat format) const;
+        bool supports_extension(const char *extension_name) const;
+        // size of the biggest device local heap, the VRAM on discrete GPUs
+        VkDeviceSize device_local_heap_size() const;
+        std::string device_type_name() const;
+    };
+
+} // namespace graph_vulkan
+
+
+#endif // PIXEL_ENGINE_GRAPHIC_VULKAN_PHYSICAL_DEVICE_INFO_H
@@ -0,0 +1,318 @@
+/**
+ * library_support/Graphic/vulkan/memory
+ *
+ **/
+
+// match hpp file
+#include "memory_allocator.hpp"
+//standard libraries
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+namespace graph_vulkan{
+    struct Memory_Block {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+        uint32_t memory_type = 0;
+        void *mapped = nullptr;
+        Allocation_Kind kind = Allocation_Kind::linear;
+        bool dedicated = false;
+
+        // offset -> size of every free range, neighbours are merged on free
+        std::map<VkDeviceSize, VkDeviceSize> free_ranges;
+        VkDeviceSize used = 0;
+        uint32_t allocation_count = 0;
+    };
+
+    static VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment){
+        return alignment <= 1 ? value : (value + alignment - 1) / alignment * alignment;
+    }
+
+    MemoryAllocator::MemoryAllocator(
+            VkDevice device,
+            const VkPhysicalDeviceMemoryProperties &memory_properties,
+            const VkPhysicalDeviceLimits &limits
+            ) : device_{device},
+                memory_properties_{memory_properties},
+                buffer_image_granularity_{limits.bufferImageGranularity},
+                non_coherent_atom_size_{limits.nonCoherentAtomSize},
+                max_memory_allocation_count_{limits.maxMemoryAllocationCount} {
+        for (uint32_t i = 0; i < memory_properties_.memoryTypeCount; i++) {
+            // small heaps (integrated GPUs, BAR memory) get proportionally smaller blocks
+            VkDeviceSize heap_size = memory_properties_.memoryHeaps[memory_properties_.memoryTypes[i].heapIndex].size;
+            pools_[i].block_size = std::min(DEFAULT_BLOCK_SIZE, std::max<VkDeviceSize>(heap_size / 8, 1024 * 1024));
+        }
+    }
+
+    MemoryAllocator::~MemoryAllocator() {
+        uint32_t leaked = 0;
+        for (auto &pool : pools_) {
+            for (auto &block : pool.blocks) {
+                leaked += block->allocation_count;
+                if (block->mapped != nullptr) vkUnmapMemory(device_, block->memory);
+                vkFreeMemory(device_, block->memory, nullptr);
+            }
+            pool.blocks.clear();
+        }
+        if (leaked != 0) {
+            std::cerr << "Memory allocator destroyed with " << leaked << " live allocations." << std::endl;
+        }
+    }
+
+    uint32_t MemoryAllocator::find_memory_type(uint32_t type_filter, VkMemoryPropertyFlags property_flags) const {
+        for (uint32_t i = 0; i < memory_properties_.memoryTypeCount; i++) {
+            if ((type_filter & (1 << i)) &&
+                (memory_properties_.memoryTypes[i].propertyFlags & property_flags) == property_flags) {
+                return i;
+            }
+        }
+
+        throw std::runtime_error("failed to find suitable memory type!");
+    }
+
+    Memory_Block *MemoryAllocator::create_block(uint32_t memory_type, VkDeviceSize size, Allocation_Kind kind, bool dedicated) {
+        if (device_memory_count_ >= max_memory_allocation_count_) {
+            throw std::runtime_error("Exceeded maxMemoryAllocationCount of the device.");
+        }
+
+        VkMemoryAllocateInfo alloc_info{};
+        alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        alloc_info.allocationSize = size;
+        alloc_info.memoryTypeIndex = memory_type;
+
+        auto block = std::make_unique<Memory_Block>();
+        if (vkAllocateMemory(device_, &alloc_info, nullptr, &block->memory) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate device memory block!");
+        }
+        device_memory_count_++;
+
+        block->size = size;
+        block->memory_type = memory_type;
+        block->kind = kind;
+        block->dedicated = dedicated;
+        block->free_ranges.emplace(0, size);
+
+        // host visible blocks stay mapped for their whole lifetime
+        if (memory_properties_.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+            if (vkMapMemory(device_, block->memory, 0, VK_WHOLE_SIZE, 0, &block->mapped) != VK_SUCCESS) {
+                vkFreeMemory(device_, block->memory, nullptr);
+                device_memory_count_--;
+                throw std::runtime_error("Failed to map device memory block!");
+            }
+        }
+
+        pools_[memory_type].blocks.push_back(std::move(block));
+        return pools_[memory_type].blocks.back().get();
+    }
+
+    void MemoryAllocator::destroy_block(Memory_Block *block) {
+        auto &blocks = pools_[block->memory_type].blocks;
+        auto found = std::find_if(blocks.begin(), blocks.end(), [block](const auto &each){ return each.get() == block; });
+        if (found == blocks.end()) return;
+
+        if (block->mapped != nullptr) vkUnmapMemory(device_, block->memory);
+        vkFreeMemory(device_, block->memory, nullptr);
+        device_memory_count_--;
+        blocks.erase(found);
+    }
+
+    bool MemoryAllocator::allocate_from_block(
+            Memory_Block &block,
+            VkDeviceSize size,
+            VkDeviceSize alignment,
+            Memory_Allocation &allocation ){
+        for (auto range = block.free_ranges.begin(); range != block.free_ranges.end(); ++range) {
+            VkDeviceSize range_begin = range->first;
+            VkDeviceSize range_end = range->first + range->second;
+            VkDeviceSize aligned = align_up(range_begin, alignment);
+            if (aligned + size > range_end) continue;
+
+            // split the free range into the padding before and the tail after the allocation
+            block.free_ranges.erase(range);
+            if (aligned > range_begin) block.free_ranges.emplace(range_begin, aligned - range_begin);
+            if (aligned + size < range_end) block.free_ranges.emplace(aligned + size, range_end - (aligned + size));
+
+            block.used += size;
+            block.allocation_count++;
+
+            allocation.memory = block.memory;
+            allocation.offset = aligned;
+            allocation.size = size;
+            allocation.memory_type = block.memory_type;
+            allocation.mapped = block.mapped == nullptr ? nullptr : static_cast<char *>(block.mapped) + aligned;
+            allocation.block = &block;
+            return true;
+        }
+        return false;
+    }
+
+    Memory_Allocation MemoryAllocator::allocate(
+            const VkMemoryRequirements &requirements,
+            VkMemoryPropertyFlags property_flags,
+            Allocation_Kind kind ){
+        uint32_t memory_type = find_memory_type(requirements.memoryTypeBits, property_flags);
+        VkMemoryPropertyFlags type_flags = memory_properties_.memoryTypes[memory_type].propertyFlags;
+
+        VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+        VkDeviceSize size = requirements.size;
+        // keep flush/invalidate ranges of neighbours from overlapping
+        if ((type_flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(type_flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+            alignment = std::max(alignment, non_coherent_atom_size_);
+            size = align_up(size, non_coherent_atom_size_);
+        }
+
+        // linear and optimal resources only share a block when the device has no granularity restriction
+        bool separate_kinds = buffer_image_granularity_ > 1;
+
+        std::lock_guard<std::mutex> lock{mutex_};
+        Memory_Type_Pool &pool = pools_[memory_type];
+        Memory_Allocation allocation{};
+
+        // big resources get their own allocation rather than eating a whole block
+        if (size > pool.block_size / 2) {
+            Memory_Block *block = create_block(memory_type, size, kind, true);
+            allocate_from_block(*block, size, 1, allocation);
+            return allocation;
+        }
+
+        for (auto &block : pool.blocks) {
+            if (block->dedicated) continue;
+            if (separate_kinds && block->kind != kind) continue;
+            if (block->size - block->used < size) continue;
+            if (allocate_from_block(*block, size, alignment, allocation)) return allocation;
+        }
+
+        Memory_Block *block = create_block(memory_type, pool.block_size, kind, false);
+        if (!allocate_from_block(*block, size, alignment, allocation)) {
+            throw std::runtime_error("Failed to sub-allocate from a fresh memory block!");
+        }
+        return allocation;
+    }
+
+    void MemoryAllocator::free(Memory_Allocation &allocation) {
+        if (!allocation.is_valid()) return;
+
+        std::lock_guard<std::mutex> lock{mutex_};
+        Memory_Block *block = allocation.block;
+
+        block->used -= allocation.size;
+        block->allocation_count--;
+
+        // insert the range back and merge it with the free neighbours on both sides
+        VkDeviceSize begin = allocation.offset;
+        VkDeviceSize end = allocation.offset + allocation.size;
+        auto next = block->free_ranges.lower_bound(begin);
+        if (next != block->free_ranges.end() && next->first == end) {
+            end += next->second;
+            next = block->free_ranges.erase(next);
+        }
+        if (next != block->free_ranges.begin()) {
+            auto previous = std::prev(next);
+            if (previous->first + previous->second == begin) {
+                begin = previous->first;
+                block->free_ranges.erase(previous);
+            }
+        }
+        block->free_ranges.emplace(begin, end - begin);
+
+        if (block->allocation_count == 0) {
+            // keep one empty block per memory type around to avoid allocate/free churn
+            bool keep = false;
+            if (!block->dedicated) {
+                auto &blocks = pools_[block->memory_type].blocks;
+                keep = std::none_of(blocks.begin(), blocks.end(), [block](const auto &each){
+                    return each.get() != block && !each->dedicated && each->allocation_count == 0;
+                });
+            }
+            if (!keep) destroy_block(block);
+        }
+
+        allocation = Memory_Allocation{};
+    }
+
+    VkMappedMemoryRange MemoryAllocator::mapped_range(const Memory_Allocation &allocation, VkDeviceSize offset, VkDeviceSize size) const {
+        if (size == VK_WHOLE_SIZE) size = allocation.size - offset;
+
+        // non-coherent ranges have to start and end on nonCoherentAtomSize
+        VkDeviceSize begin = allocation.offset + offset;
+        VkDeviceSize end = align_up(begin + size, non_coherent_atom_size_);
+        begin -= begin % non_coherent_atom_size_;
+
+        VkMappedMemoryRange range{};
+        range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        range.memory = allocation.memory;
+        range.offset = begin;
+        range.size = std::min(end, allocation.block->size) - begin;
+        return range;
+    }
+
+    void MemoryAllocator::flush(const Memory_Allocation &allocation, VkDeviceSize offset, VkDeviceSize size) {
+        VkMemoryPropertyFlags type_flags = memory_properties_.memoryTypes[allocation.memory_type].propertyFlags;
+        if (type_flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) return;
+
+        VkMappedMemoryRange range = mapped_range(allocation, offset, size);
+        vkFlushMappedMemoryRanges(device_, 1, &range);
+    }
+
+    void MemoryAllocator::invalidate(const Memory_Allocation &allocation, VkDeviceSize offset, VkDeviceSize size) {
+        VkMemoryPropertyFlags type_flags = memory_properties_.memoryTypes[allocation.memory_type].propertyFlags;
+        if (type_flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) return;
+
+        VkMappedMemoryRange range = mapped_range(allocation, offset, size);
+        vkInvalidateMappedMemoryRanges(device_, 1, &range);
+    }
+
+    std::vector<Memory_Heap_Stats> MemoryAllocator::get_heap_stats() const {
+        std::vector<Memory_Heap_Stats> stats(memory_properties_.memoryHeapCount);
+        for (uint32_t i = 0; i < memory_properties_.memoryHeapCount; i++) {
+            stats[i].heap_index = i;
+            stats[i].heap_size = memory_properties_.memoryHeaps[i].size;
+            stats[i].device_local = memory_properties_.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+        }
+
+        std::lock_guard<std::mutex> lock{mutex_};
+        for (uint32_t type = 0; type < memory_properties_.memoryTypeCount; type++) {
+            Memory_Heap_Stats &heap = stats[memory_properties_.memoryTypes[type].heapIndex];
+            for (const auto &block : pools_[type].blocks) {
+                if (block->dedicated) heap.dedicated_count++; else heap.block_count++;
+                heap.allocation_count += block->allocation_count;
+                heap.reserved_bytes += block->size;
+                heap.used_bytes += block->used;
+                for (const auto &range : block->free_ranges) {
+                    heap.free_bytes += range.second;
+                    heap.largest_free_range = std::max(heap.largest_free_range, range.second);
+                }
+            }
+        }
+
+        for (auto &heap : stats) {
+            heap.fragmentation = heap.free_bytes == 0 ? 0.0f :
+                    1.0f - static_cast<float>(heap.largest_free_range) / static_cast<float>(heap.free_bytes);
+        }
+        return stats;
+    }
+
+    uint32_t MemoryAllocator::device_memory_count() const {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return device_memory_count_;
+    }
+
+    void MemoryAllocator::print_stats(std::ostream &out) const {
+        constexpr double MiB = 1024.0 * 1024.0;
+        out << "Device memory: " << device_memory_count() << " / " << max_memory_allocation_count_
+            << " vkAllocateMemory calls in use" << std::endl;
+        for (const auto &heap : get_heap_stats()) {
+            out << "\theap " << heap.heap_index << (heap.device_local ? " (device local)" : " (host)")
+                << std::fixed << std::setprecision(2)
+                << ": used " << heap.used_bytes / MiB << " MiB"
+                << " / reserved " << heap.reserved_bytes / MiB << " MiB"
+                << " / heap " << heap.heap_size / MiB << " MiB"
+                << ", blocks " << heap.block_count << " + " << heap.dedicated_count << " dedicated"
+                << ", allocations " << heap.allocation_count
+                << ", fragmentation " << heap.fragmentation * 100.0f << "%" << std::endl;
+        }
+    }
+
+} // namespace graph_vulkan
@@ -0,0 +1,127 @@
+/**
+ * library_support/Graphic/vulkan/memory
+ *
+ * Block based sub-allocator for vulkan device memory
+ *
+ * Every memory type owns a list of large VkDeviceMemory blocks, resources are
+ * placed inside them through a first-fit free list, so the driver only sees one
+ * vkAllocateMemory per block instead of one per buffer or image.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_GRAPHIC_VULKAN_MEMORY_ALLOCATOR_H
+#define PIXEL_ENGINE_GRAPHIC_VULKAN_MEMORY_ALLOCATOR_H
+
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace graph_vulkan{
+    struct Memory_Block;
+
+    // what is going to be bound to the memory, used to honour bufferImageGranularity
+    enum class Allocation_Kind {
+        linear,     // buffers and linear tiled images
+        optimal     // optimal tiled images
+    };
+
+    // handle to a sub-range of a device memory block, replaces raw VkDeviceMemory
+    struct Memory_Allocation {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        uint32_t memory_type = 0;
+        // host address of `offset`, only set when the memory type is host visible
+        void *mapped = nullptr;
+
+        Memory_Block *block = nullptr;
+
+        bool is_valid() const { return memory != VK_NULL_HANDLE; }
+    };
+
+    struct Memory_Heap_Stats {
+        uint32_t heap_index = 0;
+        VkDeviceSize heap_size = 0;
+        bool device_local = false;
+
+        uint32_t block_count = 0;
+        uint32_t dedicated_count = 0;
+        uint32_t allocation_count = 0;
+
+        VkDeviceSize reserved_bytes = 0;    // bytes requested from the driver
+        VkDeviceSize used_bytes = 0;        // bytes handed out to resources
+        VkDeviceSize free_bytes = 0;
+        VkDeviceSize largest_free_range = 0;
+
+        // 0 when all free space is one range, close to 1 when it is scattered
+        float fragmentation = 0.0f;
+    };
+
+    class MemoryAllocator {
+    private:
+        struct Memory_Type_Pool {
+            std::vector<std::unique_ptr<Memory_Block>> blocks;
+            VkDeviceSize block_size = 0;
+        };
+
+        VkDevice device_;
+        VkPhysicalDeviceMemoryProperties memory_properties_;
+        VkDeviceSize buffer_image_granularity_;
+        VkDeviceSize non_coherent_atom_size_;
+        uint32_t max_memory_allocation_count_;
+
+        Memory_Type_Pool pools_[VK_MAX_MEMORY_TYPES];
+        uint32_t device_memory_count_ = 0;
+        mutable std::mutex mutex_;
+
+        Memory_Block *create_block(uint32_t memory_type, VkDeviceSize size, Allocation_Kind kind, bool dedicated);
+        void destroy_block(Memory_Block *block);
+        bool allocate_from_block(
+                Memory_Block &block,
+                VkDeviceSize size,
+                VkDeviceSize alignment,
+                Memory_Allocation &allocation
+                );
+        VkMappedMemoryRange mapped_range(const Memory_Allocation &allocation, VkDeviceSize offset, VkDeviceSize size) const;
+
+    public:
+        static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+        MemoryAllocator(
+                VkDevice device,
+                const VkPhysicalDeviceMemoryProperties &memory_properties,
+                const VkPhysicalDeviceLimits &limits
+                );
+        ~MemoryAllocator();
+
+        MemoryAllocator(const MemoryAllocator &) = delete;
+        MemoryAllocator &operator = (const MemoryAllocator &) = delete;
+
+        uint32_t find_memory_type(uint32_t type_filter, VkMemoryPropertyFlags property_flags) const;
+
+        Memory_Allocation allocate(
+                const VkMemoryRequirements &requirements,
+                VkMemoryPropertyFlags property_flags,
+                Allocation_Kind kind
+                );
+        void free(Memory_Allocation &allocation);
+
+        // only needed for host visible memory without VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        void flush(const Memory_Allocation &allocation, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+        void invalidate(const Memory_Allocation &allocation, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+
+        std::vector<Memory_Heap_Stats> get_heap_stats() const;
+        uint32_t device_memory_count() const;
+        void print_stats(std::ostream &out) const;
+    };
+
+} // namespace graph_vulkan
+
+
+#endif // PIXEL_ENGINE_GRAPHIC_VULKAN_MEMORY_ALLOCATOR_H
@@ -0,0 +1,117 @@
+/**
+ * library_support/Graphic/vulkan/memory
+ *
+ **/
+
+// match hpp file
+#include "uniform_ring.hpp"
+//standard libraries
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace graph_vulkan{
+    namespace {
+        VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+    } // namespace
+
+    UniformRing::UniformRing(Device &device, uint32_t frames_in_flight, const Uniform_Ring_Config &config)
+            : device{device}, config{config}, frame_count{frames_in_flight} {
+        if (frame_count == 0) {
+            throw std::runtime_error("Uniform ring needs at least one frame in flight.");
+        }
+        const VkPhysicalDeviceLimits &limits = device.physical_info().properties.limits;
+        alignment = std::max<VkDeviceSize>({
+            limits.minUniformBufferOffsetAlignment,
+            limits.minStorageBufferOffsetAlignment,
+            1
+        });
+        region_size = align_up(config.frame_size, alignment);
+        // dynamic offsets are 32 bit
+        if (region_size * frame_count > UINT32_MAX) {
+            throw std::runtime_error("Uniform ring of " + std::to_string(region_size * frame_count) + " bytes is too large for dynamic offsets.");
+        }
+        create_buffer();
+    }
+
+    UniformRing::~UniformRing() {
+        device.destroy_buffer(buffer_, memory);
+    }
+
+    void UniformRing::create_buffer() {
+        const VkPhysicalDeviceMemoryProperties &memory_properties = device.physical_info().memory_properties;
+        // coherent first, so flush() has nothing to do
+        const VkMemoryPropertyFlags host_visible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+        const VkMemoryPropertyFlags candidates[] = {
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | host_visible | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | host_visible,
+            host_visible | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            host_visible
+        };
+
+        VkMemoryPropertyFlags property_flags = 0;
+        for (VkMemoryPropertyFlags candidate : candidates) {
+            if (!config.prefer_device_local && (candidate & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) continue;
+            for (uint32_t i = 0; i < memory_properties.memoryTypeCount; i++) {
+                if ((memory_properties.memoryTypes[i].propertyFlags & candidate) == candidate) {
+                    property_flags = candidate;
+                    break;
+                }
+            }
+            if (property_flags) break;
+        }
+        if (!property_flags) {
+            throw std::runtime_error("No host visible memory for the uniform ring.");
+        }
+
+        device.create_buffer(region_size * frame_count, config.usage, property_flags, buffer_, memory);
+        if (!memory.mapped) {
+            device.destroy_buffer(buffer_, memory);
+            throw std::runtime_error("Uniform ring buffer is not host mapped.");
+        }
+
+        VkMemoryPropertyFlags type_flags = memory_properties.memoryTypes[memory.memory_type].propertyFlags;
+        device_local = type_flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        host_coherent = type_flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    }
+
+    void UniformRing::begin_frame(uint32_t frame_index) {
+        if (frame_index >= frame_count) {
+            throw std::runtime_error("Uniform ring frame index out of range.");
+        }
+        peak_bytes = std::max(peak_bytes, get_used_bytes());
+        current_frame = frame_index;
+        head.store(0, std::memory_order_relaxed);
+    }
+
+    Uniform_Allocation UniformRing::allocate(VkDeviceSize size) {
+        // every size is rounded up, so every offset stays aligned
+        VkDeviceSize aligned_size = align_up(std::max<VkDeviceSize>(size, 1), alignment);
+        VkDeviceSize offset = head.fetch_add(aligned_size, std::memory_order_relaxed);
+        if (offset + aligned_size > region_size) {
+            throw std::runtime_error("Uniform ring frame of " + std::to_string(region_size) + " bytes is full, raise frame_size.");
+        }
+
+        VkDeviceSize buffer_offset = region_size * current_frame + offset;
+        Uniform_Allocation allocation;
+        allocation.buffer = buffer_;
+        allocation.offset = static_cast<uint32_t>(buffer_offset);
+        allocation.size = size;
+        allocation.data = static_cast<char *>(memory.mapped) + buffer_offset;
+        return allocation;
+    }
+
+    void UniformRing::flush() {
+        if (host_coherent) return;
+        VkDeviceSize used = get_used_bytes();
+        if (used == 0) return;
+        device.allocator().flush(memory, region_size * current_frame, used);
+    }
+
+    VkDeviceSize UniformRing::get_used_bytes() const {
+        return std::min(head.load(std::memory_order_relaxed), region_size);
+    }
+
+} // namespace graph_vulkan
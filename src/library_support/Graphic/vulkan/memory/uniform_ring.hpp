@@ -0,0 +1,106 @@
+/**
+ * library_support/Graphic/vulkan/memory
+ *
+ * Per frame linear allocator for uniform and dynamic data
+ *
+ * One large buffer is created up front, persistently mapped and split into one
+ * region per frame in flight. Every allocation bumps the head of the current
+ * region, so a per object constant block costs an atomic add and a memcpy and
+ * is bound with a dynamic offset into the same descriptor. A region is reset
+ * as a whole by begin_frame() once the fence of the frame that used it last
+ * has signaled, which acquiring the frame already waits for.
+ *
+ * The buffer goes into device local, host visible memory when the device has
+ * it (resizable BAR or unified memory), the shaders then read straight from
+ * VRAM, otherwise into plain host visible memory.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_GRAPHIC_VULKAN_UNIFORM_RING_H
+#define PIXEL_ENGINE_GRAPHIC_VULKAN_UNIFORM_RING_H
+
+#pragma once
+
+#include "../device/device.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace graph_vulkan{
+    struct Uniform_Ring_Config {
+        // bytes every frame in flight may allocate
+        VkDeviceSize frame_size = 4ull * 1024 * 1024;
+        VkBufferUsageFlags usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+        bool prefer_device_local = true;
+    };
+
+    // valid until the frame slot it came from is reset
+    struct Uniform_Allocation {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        // from the start of buffer, aligned for dynamic uniform and storage offsets
+        uint32_t offset = 0;
+        VkDeviceSize size = 0;
+        // write only, the memory may be write combined
+        void *data = nullptr;
+    };
+
+    class UniformRing {
+    private:
+        Device &device;
+        Uniform_Ring_Config config;
+        uint32_t frame_count;
+        VkDeviceSize alignment;
+        VkDeviceSize region_size;
+
+        VkBuffer buffer_ = VK_NULL_HANDLE;
+        Memory_Allocation memory{};
+        bool device_local = false;
+        bool host_coherent = false;
+
+        uint32_t current_frame = 0;
+        // bytes taken from the current frame's region, may run past region_size on overflow
+        std::atomic<VkDeviceSize> head{0};
+        VkDeviceSize peak_bytes = 0;
+
+        void create_buffer();
+
+    public:
+        UniformRing(Device &device, uint32_t frames_in_flight, const Uniform_Ring_Config &config = {});
+        ~UniformRing();
+
+        UniformRing(const UniformRing &) = delete;
+        UniformRing &operator = (const UniformRing &) = delete;
+
+        // throws away every allocation of the frame slot, its fence must have signaled
+        void begin_frame(uint32_t frame_index);
+        // safe from any thread during a frame, throws once the frame's region is used up
+        Uniform_Allocation allocate(VkDeviceSize size);
+        // makes this frame's writes visible to the device, call before submitting; nothing to do on coherent memory
+        void flush();
+
+        template<typename T>
+        Uniform_Allocation push(const T &value) {
+            static_assert(std::is_trivially_copyable<T>::value, "Uniform data is copied byte by byte.");
+            Uniform_Allocation allocation = allocate(sizeof(T));
+            std::memcpy(allocation.data, &value, sizeof(T));
+            return allocation;
+        }
+
+        // for a VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC binding, the offset then comes from each allocation
+        VkDescriptorBufferInfo descriptor_info(VkDeviceSize range) const { return {buffer_, 0, range}; }
+
+        VkBuffer buffer() const { return buffer_; }
+        VkDeviceSize get_alignment() const { return alignment; }
+        VkDeviceSize get_frame_size() const { return region_size; }
+        VkDeviceSize get_used_bytes() const;
+        // most bytes any frame allocated so far, for sizing frame_size
+        VkDeviceSize get_peak_bytes() const { return peak_bytes; }
+        bool is_device_local() const { return device_local; }
+    };
+
+} // namespace graph_vulkan
+
+
+#endif // PIXEL_ENGINE_GRAPHIC_VULKAN_UNIFORM_RING_H
@@ -0,0 +1,225 @@
+/**
+ * library_support/Graphic/vulkan/mesh
+ *
+ **/
+
+// match hpp file
+#include "mesh_importer.hpp"
+#include "../../../File/mesh/mesh_optimizer.hpp"
+#include "../../../Profiling/profiler/profiler.hpp"
+//standard libraries
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+
+namespace graph_vulkan{
+    namespace {
+        // the largest index a 16 bit index buffer can address, 0xffff is the primitive restart value
+        constexpr size_t MAX_UINT16_VERTICES = 0xffff;
+
+        double seconds_since(std::chrono::steady_clock::time_point start) {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+    } // namespace
+
+    void Mesh_Set::bind(VkCommandBuffer command_buffer) const {
+        VkDeviceSize offset = 0;
+        vkCmdBindVertexBuffers(command_buffer, 0, 1, &vertex_buffer, &offset);
+    }
+
+    void Mesh_Set::draw(VkCommandBuffer command_buffer, size_t mesh, uint32_t instance_count) const {
+        const Gpu_Mesh &gpu_mesh = meshes[mesh];
+        vkCmdBindIndexBuffer(command_buffer, index_buffer, gpu_mesh.index_offset, gpu_mesh.index_type);
+        vkCmdDrawIndexed(command_buffer, gpu_mesh.index_count, instance_count, 0, gpu_mesh.vertex_offset, 0);
+    }
+
+    MeshImporter::MeshImporter(Device &device, jobs::JobSystem &job_system, UploadService &upload_service)
+            : device{device}, job_system{job_system}, upload_service{upload_service} {}
+
+    std::vector<file_io::Mesh_Data> MeshImporter::load_files(
+            const std::vector<std::string> &paths,
+            const file_io::AssetArchive *archive
+            ) {
+        PIXEL_PROFILE_ZONE("load meshes");
+        const auto start = std::chrono::steady_clock::now();
+
+        std::vector<std::vector<file_io::Mesh_Data>> file_meshes(paths.size());
+        std::vector<std::unique_ptr<file_io::GltfFile>> gltf_files(paths.size());
+        std::vector<size_t> file_bytes(paths.size(), 0);
+
+        std::mutex stats_mutex;
+        double weighted_before = 0.0;
+        double weighted_after = 0.0;
+        uint64_t triangle_count = 0;
+        auto optimize = [&](file_io::Mesh_Data &mesh) {
+            PIXEL_PROFILE_ZONE("optimize mesh");
+            double before = file_io::average_cache_miss_ratio(mesh.indices, mesh.vertices.size());
+            file_io::optimize_mesh(mesh);
+            double after = file_io::average_cache_miss_ratio(mesh.indices, mesh.vertices.size());
+            uint64_t triangles = mesh.indices.size() / 3;
+            std::lock_guard<std::mutex> lock{stats_mutex};
+            weighted_before += before * static_cast<double>(triangles);
+            weighted_after += after * static_cast<double>(triangles);
+            triangle_count += triangles;
+        };
+
+        // the file jobs schedule the mesh jobs against the same counter, before they finish themselves
+        jobs::Job_Counter counter;
+        for (size_t f = 0; f < paths.size(); f++) {
+            job_system.schedule([&, f]{
+                PIXEL_PROFILE_ZONE("parse mesh file");
+                if (file_io::mesh_format_of(paths[f]) == file_io::Mesh_Format::obj) {
+                    file_meshes[f] = archive
+                            ? file_io::load_obj(*archive, paths[f], &file_bytes[f])
+                            : file_io::load_obj(paths[f], &file_bytes[f]);
+                    for (size_t m = 0; m < file_meshes[f].size(); m++) {
+                        job_system.schedule([&, f, m]{ optimize(file_meshes[f][m]); }, &counter);
+                    }
+                } else {
+                    gltf_files[f] = archive
+                            ? std::make_unique<file_io::GltfFile>(*archive, paths[f])
+                            : std::make_unique<file_io::GltfFile>(paths[f]);
+                    file_bytes[f] = gltf_files[f]->get_bytes_read();
+                    file_meshes[f].resize(gltf_files[f]->primitive_count());
+                    for (size_t m = 0; m < file_meshes[f].size(); m++) {
+                        job_system.schedule([&, f, m]{
+                            PIXEL_PROFILE_ZONE("decode gltf primitive");
+                            file_meshes[f][m] = gltf_files[f]->decode(m);
+                            optimize(file_meshes[f][m]);
+                        }, &counter);
+                    }
+                }
+            }, &counter);
+        }
+        job_system.wait(counter);
+
+        std::vector<file_io::Mesh_Data> meshes;
+        stats = Mesh_Import_Stats{};
+        stats.file_count = static_cast<uint32_t>(paths.size());
+        for (size_t f = 0; f < paths.size(); f++) {
+            stats.bytes_read += file_bytes[f];
+            for (auto &mesh : file_meshes[f]) {
+                // a primitive or group without triangles has nothing to draw
+                if (mesh.indices.empty()) continue;
+                stats.vertex_count += mesh.vertices.size();
+                stats.index_count += mesh.indices.size();
+                meshes.push_back(std::move(mesh));
+            }
+        }
+        stats.mesh_count = static_cast<uint32_t>(meshes.size());
+        if (triangle_count > 0) {
+            stats.cache_miss_ratio_before = weighted_before / static_cast<double>(triangle_count);
+            stats.cache_miss_ratio_after = weighted_after / static_cast<double>(triangle_count);
+        }
+        stats.load_seconds = seconds_since(start);
+        return meshes;
+    }
+
+    Mesh_Set MeshImporter::upload(const std::vector<file_io::Mesh_Data> &meshes) {
+        PIXEL_PROFILE_ZONE("upload meshes");
+        const auto start = std::chrono::steady_clock::now();
+
+        Mesh_Set set;
+        VkDeviceSize vertex_bytes = 0;
+        VkDeviceSize index_bytes = 0;
+        for (const auto &mesh : meshes) {
+            Gpu_Mesh gpu_mesh{};
+            gpu_mesh.name = mesh.name;
+            gpu_mesh.vertex_offset = static_cast<int32_t>(vertex_bytes / sizeof(file_io::Mesh_Vertex));
+            gpu_mesh.vertex_count = static_cast<uint32_t>(mesh.vertices.size());
+            gpu_mesh.index_count = static_cast<uint32_t>(mesh.indices.size());
+            gpu_mesh.index_type = mesh.vertices.size() <= MAX_UINT16_VERTICES ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+            // the offset has to be a multiple of the index size, 4 covers both
+            gpu_mesh.index_offset = (index_bytes + 3) & ~VkDeviceSize{3};
+            for (int axis = 0; axis < 3; axis++) {
+                gpu_mesh.bounds_min[axis] = mesh.bounds_min[axis];
+                gpu_mesh.bounds_max[axis] = mesh.bounds_max[axis];
+            }
+
+            vertex_bytes += mesh.vertices.size() * sizeof(file_io::Mesh_Vertex);
+            index_bytes = gpu_mesh.index_offset + mesh.indices.size() *
+                    (gpu_mesh.index_type == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t));
+            set.meshes.push_back(std::move(gpu_mesh));
+        }
+        if (set.meshes.empty()) {
+            stats.upload_seconds = seconds_since(start);
+            return set;
+        }
+
+        device.create_buffer(
+                vertex_bytes,
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                set.vertex_buffer,
+                set.vertex_memory
+                );
+        device.create_buffer(
+                index_bytes,
+                VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                set.index_buffer,
+                set.index_memory
+                );
+
+        // the staging copy is the only one, the 16 bit indices are narrowed on the way
+        std::vector<uint16_t> narrow_indices;
+        for (size_t i = 0; i < meshes.size(); i++) {
+            const file_io::Mesh_Data &mesh = meshes[i];
+            const Gpu_Mesh &gpu_mesh = set.meshes[i];
+            upload_service.upload_buffer(
+                    set.vertex_buffer,
+                    static_cast<VkDeviceSize>(gpu_mesh.vertex_offset) * sizeof(file_io::Mesh_Vertex),
+                    mesh.vertices.data(),
+                    mesh.vertices.size() * sizeof(file_io::Mesh_Vertex)
+                    );
+            if (gpu_mesh.index_type == VK_INDEX_TYPE_UINT16) {
+                narrow_indices.assign(mesh.indices.begin(), mesh.indices.end());
+                upload_service.upload_buffer(
+                        set.index_buffer, gpu_mesh.index_offset, narrow_indices.data(), narrow_indices.size() * sizeof(uint16_t));
+            } else {
+                upload_service.upload_buffer(
+                        set.index_buffer, gpu_mesh.index_offset, mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+            }
+        }
+        set.ticket = upload_service.flush();
+
+        stats.bytes_uploaded = vertex_bytes + index_bytes;
+        stats.upload_seconds = seconds_since(start);
+        return set;
+    }
+
+    void MeshImporter::destroy(Mesh_Set &set) {
+        if (set.vertex_buffer != VK_NULL_HANDLE) device.deletion_queue().push_buffer(set.vertex_buffer, set.vertex_memory);
+        if (set.index_buffer != VK_NULL_HANDLE) device.deletion_queue().push_buffer(set.index_buffer, set.index_memory);
+        set = Mesh_Set{};
+    }
+
+    std::vector<VkVertexInputBindingDescription> MeshImporter::binding_descriptions() {
+        return {{0, sizeof(file_io::Mesh_Vertex), VK_VERTEX_INPUT_RATE_VERTEX}};
+    }
+
+    std::vector<VkVertexInputAttributeDescription> MeshImporter::attribute_descriptions() {
+        return {
+                {0, 0, VK_FORMAT_R32G32B32_SFLOAT, static_cast<uint32_t>(offsetof(file_io::Mesh_Vertex, position))},
+                {1, 0, VK_FORMAT_R32G32B32_SFLOAT, static_cast<uint32_t>(offsetof(file_io::Mesh_Vertex, normal))},
+                {2, 0, VK_FORMAT_R32G32_SFLOAT, static_cast<uint32_t>(offsetof(file_io::Mesh_Vertex, uv))}
+        };
+    }
+
+    void MeshImporter::print_stats(std::ostream &out) const {
+        const double megabytes = static_cast<double>(stats.bytes_read) / (1024.0 * 1024.0);
+        out << "Mesh import: " << stats.mesh_count << " meshes from " << stats.file_count << " files, "
+            << stats.vertex_count << " vertices, " << stats.index_count << " indices" << std::endl;
+        out << std::fixed << std::setprecision(2)
+            << "    load " << stats.load_seconds * 1000.0 << " ms ("
+            << (stats.load_seconds > 0.0 ? megabytes / stats.load_seconds : 0.0) << " MB/s, "
+            << (stats.load_seconds > 0.0 ? stats.mesh_count / stats.load_seconds : 0.0) << " meshes/s), upload "
+            << stats.upload_seconds * 1000.0 << " ms for "
+            << static_cast<double>(stats.bytes_uploaded) / (1024.0 * 1024.0) << " MB" << std::endl;
+        out << "    vertex cache misses per triangle " << stats.cache_miss_ratio_before << " -> "
+            << stats.cache_miss_ratio_after << std::defaultfloat << std::endl;
+    }
+
+} // namespace graph_vulkan
@@ -0,0 +1,121 @@
+/**
+ * library_support/Graphic/vulkan/mesh
+ *
+ * Parallel OBJ/glTF import into device local vertex and index buffers
+ *
+ * load() parses the files on the job system, one job per file and then one
+ * per mesh for decoding (glTF) and vertex cache optimization. upload() packs
+ * every mesh of an import into one vertex buffer and one index buffer and
+ * streams them through the UploadService. A mesh gets 16 bit indices when it
+ * has few enough vertices, the index buffer mixes both widths, every draw
+ * binds it at the mesh's offset with the mesh's index type.
+ *
+ * A single large OBJ file is parsed by one thread, the parallelism is across
+ * files and meshes.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_GRAPHIC_VULKAN_MESH_IMPORTER_H
+#define PIXEL_ENGINE_GRAPHIC_VULKAN_MESH_IMPORTER_H
+
+#pragma once
+
+#include "../device/device.hpp"
+#include "../upload/upload_service.hpp"
+#include "../../../File/mesh/mesh_parser.hpp"
+#include "../../../Thread/job_system/job_system.hpp"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace graph_vulkan{
+    struct Gpu_Mesh {
+        std::string name;
+        // in vertices from the start of the set's vertex buffer, the indices are relative to it
+        int32_t vertex_offset = 0;
+        uint32_t vertex_count = 0;
+        // in bytes from the start of the set's index buffer
+        VkDeviceSize index_offset = 0;
+        uint32_t index_count = 0;
+        VkIndexType index_type = VK_INDEX_TYPE_UINT32;
+        float bounds_min[3] = {0.0f, 0.0f, 0.0f};
+        float bounds_max[3] = {0.0f, 0.0f, 0.0f};
+    };
+
+    struct Mesh_Set {
+        VkBuffer vertex_buffer = VK_NULL_HANDLE;
+        Memory_Allocation vertex_memory{};
+        VkBuffer index_buffer = VK_NULL_HANDLE;
+        Memory_Allocation index_memory{};
+        std::vector<Gpu_Mesh> meshes;
+        // the buffers are written on the transfer queue, wait on this before drawing
+        Upload_Ticket ticket{};
+
+        // once per command buffer for all meshes of the set
+        void bind(VkCommandBuffer command_buffer) const;
+        void draw(VkCommandBuffer command_buffer, size_t mesh, uint32_t instance_count = 1) const;
+    };
+
+    struct Mesh_Import_Stats {
+        uint32_t file_count = 0;
+        uint32_t mesh_count = 0;
+        uint64_t vertex_count = 0;
+        uint64_t index_count = 0;
+        // mapped from disk and written to the device
+        uint64_t bytes_read = 0;
+        uint64_t bytes_uploaded = 0;
+        // wall clock of load() and of upload() up to the flush, not the transfer itself
+        double load_seconds = 0.0;
+        double upload_seconds = 0.0;
+        // transformed vertices per triangle before and after the optimization, 16 entry FIFO
+        double cache_miss_ratio_before = 0.0;
+        double cache_miss_ratio_after = 0.0;
+    };
+
+    class MeshImporter {
+    private:
+        Device &device;
+        jobs::JobSystem &job_system;
+        UploadService &upload_service;
+        Mesh_Import_Stats stats;
+
+        // loose files when archive is null, assets of it otherwise
+        std::vector<file_io::Mesh_Data> load_files(const std::vector<std::string> &paths, const file_io::AssetArchive *archive);
+
+    public:
+        MeshImporter(Device &device, jobs::JobSystem &job_system, UploadService &upload_service);
+
+        MeshImporter(const MeshImporter &) = delete;
+        MeshImporter &operator = (const MeshImporter &) = delete;
+
+        // parsed, decoded and optimized, in file order; throws the first error any file ran into
+        std::vector<file_io::Mesh_Data> load(const std::vector<std::string> &paths) { return load_files(paths, nullptr); }
+        // assets of an archive, by name, stored ones are parsed in the archive's mapping
+        std::vector<file_io::Mesh_Data> load(const file_io::AssetArchive &archive, const std::vector<std::string> &names) {
+            return load_files(names, &archive);
+        }
+        // creates the buffers and queues the copies, the meshes are usable once the set's ticket completes
+        Mesh_Set upload(const std::vector<file_io::Mesh_Data> &meshes);
+        Mesh_Set import(const std::vector<std::string> &paths) { return upload(load(paths)); }
+        Mesh_Set import(const file_io::AssetArchive &archive, const std::vector<std::string> &names) {
+            return upload(load(archive, names));
+        }
+
+        // through the deletion queue, frames in flight may still draw the set
+        void destroy(Mesh_Set &set);
+
+        // binding 0 with file_io::Mesh_Vertex, for Pipeline_Config_Info
+        static std::vector<VkVertexInputBindingDescription> binding_descriptions();
+        static std::vector<VkVertexInputAttributeDescription> attribute_descriptions();
+
+        // of the last load() and upload()
+        const Mesh_Import_Stats &get_stats() const { return stats; }
+        void print_stats(std::ostream &out) const;
+    };
+
+} // namespace graph_vulkan
+
+
+#endif // PIXEL_ENGINE_GRAPHIC_VULKAN_MESH_IMPORTER_H
@@ -0,0 +1,258 @@
+/**
+ * library_support/Graphic/vulkan/offscreen
+ *
+ **/
+
+// match hpp file
+#include "offscreen_target.hpp"
+#include "../../../Profiling/profiler/profiler.hpp"
+//standard libraries
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <stdexcept>
+
+namespace graph_vulkan{
+    OffscreenTarget::OffscreenTarget(Device &device, const Offscreen_Target_Config &config)
+            : device{device}, config{config} {
+        if (this->config.frames_in_flight == 0) this->config.frames_in_flight = 1;
+        depth_format = device.find_supported_format(
+                {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
+                VK_IMAGE_TILING_OPTIMAL,
+                VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
+                );
+
+        create_render_pass();
+        create_images();
+        create_framebuffers();
+        create_sync_objects();
+    }
+
+    OffscreenTarget::~OffscreenTarget() {
+        wait_idle();
+
+        for (auto framebuffer : framebuffers) {
+            vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
+        }
+        for (size_t i = 0; i < color_images.size(); i++) {
+            vkDestroyImageView(device.device(), color_image_views[i], nullptr);
+            device.destroy_image(color_images[i], color_image_memories[i]);
+            vkDestroyImageView(device.device(), depth_image_views[i], nullptr);
+            device.destroy_image(depth_images[i], depth_image_memories[i]);
+        }
+        vkDestroyRenderPass(device.device(), render_pass, nullptr);
+
+        for (auto fence : in_flight_fences) {
+            vkDestroyFence(device.device(), fence, nullptr);
+        }
+    }
+
+    VkResult OffscreenTarget::acquire_next_image(uint32_t *image_index) {
+        PIXEL_PROFILE_ZONE("wait for frame slot");
+        vkWaitForFences(
+                device.device(),
+                1,
+                &in_flight_fences[current_frame],
+                VK_TRUE,
+                std::numeric_limits<uint64_t>::max()
+                );
+        if (frame_serials[current_frame] != 0) {
+            device.deletion_queue().frame_completed(frame_serials[current_frame]);
+        }
+        *image_index = current_frame;
+        return VK_SUCCESS;
+    }
+
+    VkResult OffscreenTarget::submit_command_buffers(const VkCommandBuffer *buffers, uint32_t *image_index, const std::vector<Sync_Wait> &waits) {
+        PIXEL_PROFILE_ZONE("submit");
+        Queue_Submit_Info submit_info{};
+        submit_info.command_buffers = {buffers[0]};
+        submit_info.waits = waits;
+        submit_info.fence = in_flight_fences[*image_index];
+
+        vkResetFences(device.device(), 1, &in_flight_fences[*image_index]);
+        last_submit = device.sync().submit(Queue_Type::graphics, submit_info);
+        frame_serials[*image_index] = device.deletion_queue().end_frame();
+
+        current_frame = (current_frame + 1) % config.frames_in_flight;
+        return VK_SUCCESS;
+    }
+
+    void OffscreenTarget::wait_idle() {
+        if (in_flight_fences.empty()) return;
+        vkWaitForFences(
+                device.device(),
+                static_cast<uint32_t>(in_flight_fences.size()),
+                in_flight_fences.data(),
+                VK_TRUE,
+                std::numeric_limits<uint64_t>::max()
+                );
+        device.deletion_queue().frame_completed(*std::max_element(frame_serials.begin(), frame_serials.end()));
+    }
+
+    void OffscreenTarget::create_render_pass() {
+        VkAttachmentDescription color_attachment{};
+        color_attachment.format = config.color_format;
+        color_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        // ready to be copied out once the pass ends
+        color_attachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+        VkAttachmentDescription depth_attachment{};
+        depth_attachment.format = depth_format;
+        depth_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        depth_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depth_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        depth_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depth_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        depth_attachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        VkAttachmentReference color_attachment_ref{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+        VkAttachmentReference depth_attachment_ref{1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+
+        VkSubpassDescription subpass{};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 1;
+        subpass.pColorAttachments = &color_attachment_ref;
+        subpass.pDepthStencilAttachment = &depth_attachment_ref;
+
+        std::array<VkSubpassDependency, 2> dependencies{};
+        // the previous use of the image in this frame slot, usually a readback copy
+        dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[0].dstSubpass = 0;
+        dependencies[0].srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        dependencies[0].srcAccessMask = 0;
+        dependencies[0].dstStageMask =
+                VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        dependencies[0].dstAccessMask =
+                VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        // copies recorded after the pass see the finished image
+        dependencies[1].srcSubpass = 0;
+        dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+        std::array<VkAttachmentDescription, 2> attachments = {color_attachment, depth_attachment};
+        VkRenderPassCreateInfo render_pass_info{};
+        render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        render_pass_info.attachmentCount = static_cast<uint32_t>(attachments.size());
+        render_pass_info.pAttachments = attachments.data();
+        render_pass_info.subpassCount = 1;
+        render_pass_info.pSubpasses = &subpass;
+        render_pass_info.dependencyCount = static_cast<uint32_t>(dependencies.size());
+        render_pass_info.pDependencies = dependencies.data();
+
+        if (vkCreateRenderPass(device.device(), &render_pass_info, nullptr, &render_pass) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create render pass.");
+        }
+    }
+
+    void OffscreenTarget::create_image(
+            VkFormat format,
+            VkImageUsageFlags usage,
+            VkImageAspectFlags aspect,
+            VkImage &image,
+            Memory_Allocation &memory,
+            VkImageView &view
+            ) {
+        VkImageCreateInfo image_info{};
+        image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        image_info.imageType = VK_IMAGE_TYPE_2D;
+        image_info.extent.width = config.extent.width;
+        image_info.extent.height = config.extent.height;
+        image_info.extent.depth = 1;
+        image_info.mipLevels = 1;
+        image_info.arrayLayers = 1;
+        image_info.format = format;
+        image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        image_info.usage = usage;
+        image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+        image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        device.create_image_with_info(image_info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, memory);
+
+        VkImageViewCreateInfo view_info{};
+        view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        view_info.image = image;
+        view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        view_info.format = format;
+        view_info.subresourceRange.aspectMask = aspect;
+        view_info.subresourceRange.baseMipLevel = 0;
+        view_info.subresourceRange.levelCount = 1;
+        view_info.subresourceRange.baseArrayLayer = 0;
+        view_info.subresourceRange.layerCount = 1;
+
+        if (vkCreateImageView(device.device(), &view_info, nullptr, &view) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create texture image view.");
+        }
+    }
+
+    void OffscreenTarget::create_images() {
+        uint32_t count = config.frames_in_flight;
+        color_images.resize(count);
+        color_image_memories.resize(count);
+        color_image_views.resize(count);
+        depth_images.resize(count);
+        depth_image_memories.resize(count);
+        depth_image_views.resize(count);
+
+        for (uint32_t i = 0; i < count; i++) {
+            create_image(
+                    config.color_format,
+                    VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                    VK_IMAGE_ASPECT_COLOR_BIT,
+                    color_images[i], color_image_memories[i], color_image_views[i]
+                    );
+            create_image(
+                    depth_format,
+                    VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+                    VK_IMAGE_ASPECT_DEPTH_BIT,
+                    depth_images[i], depth_image_memories[i], depth_image_views[i]
+                    );
+        }
+    }
+
+    void OffscreenTarget::create_framebuffers() {
+        framebuffers.resize(config.frames_in_flight);
+        for (uint32_t i = 0; i < config.frames_in_flight; i++) {
+            std::array<VkImageView, 2> attachments = {color_image_views[i], depth_image_views[i]};
+
+            VkFramebufferCreateInfo framebuffer_info{};
+            framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            framebuffer_info.renderPass = render_pass;
+            framebuffer_info.attachmentCount = static_cast<uint32_t>(attachments.size());
+            framebuffer_info.pAttachments = attachments.data();
+            framebuffer_info.width = config.extent.width;
+            framebuffer_info.height = config.extent.height;
+            framebuffer_info.layers = 1;
+
+            if (vkCreateFramebuffer(device.device(), &framebuffer_info, nullptr, &framebuffers[i]) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create framebuffer.");
+            }
+        }
+    }
+
+    void OffscreenTarget::create_sync_objects() {
+        in_flight_fences.resize(config.frames_in_flight);
+        frame_serials.assign(config.frames_in_flight, 0);
+
+        VkFenceCreateInfo fence_info{};
+        fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+        for (auto &fence : in_flight_fences) {
+            if (vkCreateFence(device.device(), &fence_info, nullptr, &fence) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create synchronization objects for a frame.");
+            }
+        }
+    }
+
+} // namespace graph_vulkan
@@ -0,0 +1,88 @@
+/**
+ * library_support/Graphic/vulkan/offscreen
+ *
+ * Render target for headless rendering, the SwapChain counterpart without a surface
+ *
+ * Every frame in flight owns a color image, a depth image, a framebuffer and a
+ * fence. The render pass leaves the color image in TRANSFER_SRC_OPTIMAL so the
+ * finished frame can be copied out right away.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_GRAPHIC_VULKAN_OFFSCREEN_TARGET_H
+#define PIXEL_ENGINE_GRAPHIC_VULKAN_OFFSCREEN_TARGET_H
+
+#pragma once
+
+#include "../device/device.hpp"
+
+#include <vector>
+
+namespace graph_vulkan{
+    struct Offscreen_Target_Config {
+        VkExtent2D extent{1600, 900};
+        VkFormat color_format = VK_FORMAT_R8G8B8A8_UNORM;
+        uint32_t frames_in_flight = 2;
+    };
+
+    class OffscreenTarget {
+    private:
+        Device &device;
+        Offscreen_Target_Config config;
+        VkFormat depth_format;
+
+        std::vector<VkImage> color_images;
+        std::vector<Memory_Allocation> color_image_memories;
+        std::vector<VkImageView> color_image_views;
+        std::vector<VkImage> depth_images;
+        std::vector<Memory_Allocation> depth_image_memories;
+        std::vector<VkImageView> depth_image_views;
+        std::vector<VkFramebuffer> framebuffers;
+        VkRenderPass render_pass = VK_NULL_HANDLE;
+
+        std::vector<VkFence> in_flight_fences;
+        // deletion queue serial of the frame last submitted in the slot, 0 before the first
+        std::vector<uint64_t> frame_serials;
+        uint32_t current_frame = 0;
+        Sync_Point last_submit{};
+
+        void create_render_pass();
+        void create_images();
+        void create_framebuffers();
+        void create_sync_objects();
+
+        void create_image(VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect,
+                          VkImage &image, Memory_Allocation &memory, VkImageView &view);
+
+    public:
+        OffscreenTarget(Device &device, const Offscreen_Target_Config &config = Offscreen_Target_Config{});
+        ~OffscreenTarget();
+
+        OffscreenTarget(const OffscreenTarget &) = delete;
+        OffscreenTarget &operator = (const OffscreenTarget &) = delete;
+
+        VkFramebuffer get_frame_buffer(uint32_t index) { return framebuffers[index]; }
+        VkRenderPass get_render_pass() { return render_pass; }
+        VkImage get_color_image(uint32_t index) { return color_images[index]; }
+        VkFormat get_color_format() { return config.color_format; }
+        VkExtent2D get_extent() { return config.extent; }
+        uint32_t width() { return config.extent.width; }
+        uint32_t height() { return config.extent.height; }
+        uint32_t frames_in_flight() { return config.frames_in_flight; }
+        uint32_t current_frame_index() { return current_frame; }
+        VkFence get_frame_fence(uint32_t index) { return in_flight_fences[index]; }
+
+        // waits until the next frame slot is free, its index doubles as the image index
+        VkResult acquire_next_image(uint32_t *image_index);
+        // waits holds sync points of other queues the frame needs, like the upload of a texture it samples
+        VkResult submit_command_buffers(const VkCommandBuffer *buffers, uint32_t *image_index, const std::vector<Sync_Wait> &waits = {});
+        // graphics queue point of the last submitted frame
+        Sync_Point get_last_submit() { return last_submit; }
+        // blocks until everything submitted so far has finished
+        void wait_idle();
+    };
+
+} // namespace graph_vulkan
+
+
+#endif // PIXEL_ENGINE_GRAPHIC_VULKAN_OFFSCREEN_TARGET_H
@@ -1,64 +1,167 @@
 /**
- * library_support/Graphic/vulkan/window
+ * library_support/Graphic/vulkan/pipeline
  *
  **/
 
 // match hpp file
 #include "pipeline.hpp"
+#include "../../../Profiling/profiler/profiler.hpp"
 //standard libraries
-#include <fstream>
+#include <cassert>
 #include <stdexcept>
-#include <iostream>
-
-#include <filesystem>
 
 namespace graph_vulkan{
-    Pipeline::Pipeline(const std::string& vert_path, const std::string& frag_path){
-        create_graphics_pipeline(vert_path, frag_path);
+    Pipeline::Pipeline(
+            Device& device,
+            const std::string& vert_path,
+            const std::string& frag_path,
+            const Pipeline_Config_Info& config_info
+            ) : device{device} {
+        vert_shader_module = device.shader_modules().load(vert_path);
+        frag_shader_module = device.shader_modules().load(frag_path);
+        create_graphics_pipeline(config_info);
     }
 
+    Pipeline::Pipeline(
+            Device& device,
+            const Spirv_Blob& vert_code,
+            const Spirv_Blob& frag_code,
+            const Pipeline_Config_Info& config_info
+            ) : device{device} {
+        vert_shader_module = device.shader_modules().get(vert_code);
+        frag_shader_module = device.shader_modules().get(frag_code);
+        create_graphics_pipeline(config_info);
+    }
 
-    std::vector<char> Pipeline::read_file(const std::string& target_file_path){
-        std::ifstream target_file{
-            target_file_path,
-            std::ios::ate | std::ios::binary
-                /**
-                 *  Explain for std::ios::ate
-                 *  while file been open, cursor locate the tail of the file to get the size of the file
-                 *
-                 *  Explain for std::ios::binary
-                 *  Read the file by binary mode, to avoid any changes to the file while in reading
-                 **/
-        };
-
-        // check if the file can be open, or throw an error
-        if (!target_file.is_open())
-            throw std::runtime_error(
-                    "Failed to open file: " + target_file_path +
-                    "\nCurrent Path: " + (std::filesystem::current_path()).string());
-
-
-        // get the size of target file
-        size_t target_file_size = static_cast<size_t>(target_file.tellg());
-        // Create a cache for the file
-        std::vector<char> buffer(target_file_size);
-
-        target_file.seekg(0);   // move the cursor to the start of the file
-        target_file.read(buffer.data(), target_file_size);
-        target_file.close();    //close the file
-
-        return buffer;
+    Pipeline::~Pipeline() {
+        // frames in flight may still draw with it
+        device.deletion_queue().push_pipeline(graphics_pipeline);
     }
-    void Pipeline::create_graphics_pipeline(
-            const std::string& vert_path,
-            const std::string& frag_path
+
+
+    void Pipeline::create_graphics_pipeline(const Pipeline_Config_Info& config_info){
+        PIXEL_PROFILE_ZONE("create graphics pipeline");
+        graphics_pipeline = create_pipeline_handle(device, vert_shader_module, frag_shader_module, config_info);
+    }
+
+    VkPipeline Pipeline::create_pipeline_handle(
+            Device& device,
+            VkShaderModule vert_shader_module,
+            VkShaderModule frag_shader_module,
+            const Pipeline_Config_Info& config_info
             ){
-        auto vert_code = read_file(vert_path);
-        auto frag_code = read_file(frag_path);
+        assert(config_info.pipeline_layout != VK_NULL_HANDLE && "Cannot create graphics pipeline: no pipeline layout provided");
+        assert(config_info.render_pass != VK_NULL_HANDLE && "Cannot create graphics pipeline: no render pass provided");
+
+        VkPipelineShaderStageCreateInfo shader_stages[2]{};
+        shader_stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        shader_stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+        shader_stages[0].module = vert_shader_module;
+        shader_stages[0].pName = "main";
+        shader_stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        shader_stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+        shader_stages[1].module = frag_shader_module;
+        shader_stages[1].pName = "main";
+
+        VkPipelineVertexInputStateCreateInfo vertex_input_info{};
+        vertex_input_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+        vertex_input_info.vertexBindingDescriptionCount = static_cast<uint32_t>(config_info.binding_descriptions.size());
+        vertex_input_info.pVertexBindingDescriptions = config_info.binding_descriptions.data();
+        vertex_input_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(config_info.attribute_descriptions.size());
+        vertex_input_info.pVertexAttributeDescriptions = config_info.attribute_descriptions.data();
+
+        // point the config at its own members, the copy we got may have moved
+        VkPipelineColorBlendStateCreateInfo color_blend_info = config_info.color_blend_info;
+        color_blend_info.attachmentCount = 1;
+        color_blend_info.pAttachments = &config_info.color_blend_attachment;
+        VkPipelineDynamicStateCreateInfo dynamic_state_info = config_info.dynamic_state_info;
+        dynamic_state_info.dynamicStateCount = static_cast<uint32_t>(config_info.dynamic_state_enables.size());
+        dynamic_state_info.pDynamicStates = config_info.dynamic_state_enables.data();
+
+        VkGraphicsPipelineCreateInfo pipeline_info{};
+        pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipeline_info.stageCount = 2;
+        pipeline_info.pStages = shader_stages;
+        pipeline_info.pVertexInputState = &vertex_input_info;
+        pipeline_info.pInputAssemblyState = &config_info.input_assembly_info;
+        pipeline_info.pViewportState = &config_info.viewport_info;
+        pipeline_info.pRasterizationState = &config_info.rasterization_info;
+        pipeline_info.pMultisampleState = &config_info.multisample_info;
+        pipeline_info.pColorBlendState = &color_blend_info;
+        pipeline_info.pDepthStencilState = &config_info.depth_stencil_info;
+        pipeline_info.pDynamicState = config_info.dynamic_state_enables.empty() ? nullptr : &dynamic_state_info;
+
+        pipeline_info.layout = config_info.pipeline_layout;
+        pipeline_info.renderPass = config_info.render_pass;
+        pipeline_info.subpass = config_info.subpass;
+
+        pipeline_info.basePipelineIndex = -1;
+        pipeline_info.basePipelineHandle = VK_NULL_HANDLE;
+
+        // every pipeline goes through the device's cache, warm starts skip the driver compile,
+        // the cache is internally synchronized so worker threads can share it
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        if (vkCreateGraphicsPipelines(
+                device.device(),
+                device.pipeline_cache(),
+                1,
+                &pipeline_info,
+                nullptr,
+                &pipeline) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create graphics pipeline.");
+        }
+        return pipeline;
+    }
+
+    void Pipeline::bind(VkCommandBuffer command_buffer) {
+        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphics_pipeline);
+    }
+
+    void Pipeline::default_pipeline_config_info(Pipeline_Config_Info& config_info) {
+        config_info.input_assembly_info.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+        config_info.input_assembly_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        config_info.input_assembly_info.primitiveRestartEnable = VK_FALSE;
+
+        config_info.viewport_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+        config_info.viewport_info.viewportCount = 1;
+        config_info.viewport_info.pViewports = nullptr;
+        config_info.viewport_info.scissorCount = 1;
+        config_info.viewport_info.pScissors = nullptr;
+
+        config_info.rasterization_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+        config_info.rasterization_info.depthClampEnable = VK_FALSE;
+        config_info.rasterization_info.rasterizerDiscardEnable = VK_FALSE;
+        config_info.rasterization_info.polygonMode = VK_POLYGON_MODE_FILL;
+        config_info.rasterization_info.lineWidth = 1.0f;
+        config_info.rasterization_info.cullMode = VK_CULL_MODE_NONE;
+        config_info.rasterization_info.frontFace = VK_FRONT_FACE_CLOCKWISE;
+        config_info.rasterization_info.depthBiasEnable = VK_FALSE;
+
+        config_info.multisample_info.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+        config_info.multisample_info.sampleShadingEnable = VK_FALSE;
+        config_info.multisample_info.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+        config_info.multisample_info.minSampleShading = 1.0f;
+
+        config_info.color_blend_attachment.colorWriteMask =
+                VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+        config_info.color_blend_attachment.blendEnable = VK_FALSE;
+
+        config_info.color_blend_info.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+        config_info.color_blend_info.logicOpEnable = VK_FALSE;
+        config_info.color_blend_info.logicOp = VK_LOGIC_OP_COPY;
 
+        config_info.depth_stencil_info.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+        config_info.depth_stencil_info.depthTestEnable = VK_TRUE;
+        config_info.depth_stencil_info.depthWriteEnable = VK_TRUE;
+        config_info.depth_stencil_info.depthCompareOp = VK_COMPARE_OP_LESS;
+        config_info.depth_stencil_info.depthBoundsTestEnable = VK_FALSE;
+        config_info.depth_stencil_info.minDepthBounds = 0.0f;
+        config_info.depth_stencil_info.maxDepthBounds = 1.0f;
+        config_info.depth_stencil_info.stencilTestEnable = VK_FALSE;
 
-        // Test if files are readed correctly.
-        std::cout << "Vertex Shader Code Size: " << vert_code.size() <<std::endl;
-        std::cout << "Fragment Shader Code Size: " << frag_code.size() << std::endl;
+        config_info.dynamic_state_enables = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+        config_info.dynamic_state_info.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+        config_info.dynamic_state_info.flags = 0;
     }
 }
@@ -11,16 +11,74 @@
 
 #pragma once
 
+#include "../device/device.hpp"
+
 #include <string>
 #include <vector>
 
 namespace graph_vulkan{
+    struct Pipeline_Config_Info {
+        VkPipelineViewportStateCreateInfo viewport_info{};
+        VkPipelineInputAssemblyStateCreateInfo input_assembly_info{};
+        VkPipelineRasterizationStateCreateInfo rasterization_info{};
+        VkPipelineMultisampleStateCreateInfo multisample_info{};
+        VkPipelineColorBlendAttachmentState color_blend_attachment{};
+        VkPipelineColorBlendStateCreateInfo color_blend_info{};
+        VkPipelineDepthStencilStateCreateInfo depth_stencil_info{};
+        std::vector<VkDynamicState> dynamic_state_enables;
+        VkPipelineDynamicStateCreateInfo dynamic_state_info{};
+        // empty when the vertices are generated in the shader
+        std::vector<VkVertexInputBindingDescription> binding_descriptions;
+        std::vector<VkVertexInputAttributeDescription> attribute_descriptions;
+        // pointers inside the create infos are pointed at the members above when the pipeline
+        // is created, so the config can be copied around freely
+        VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
+        VkRenderPass render_pass = VK_NULL_HANDLE;
+        uint32_t subpass = 0;
+    };
+
     class Pipeline {
         private:
-            static std::vector<char> read_file(const std::string& target_file_path);
-            void create_graphics_pipeline(const std::string& vert_path, const std::string& frag_path);
+            Device &device;
+            VkPipeline graphics_pipeline = VK_NULL_HANDLE;
+            // owned by the device's shader module cache
+            VkShaderModule vert_shader_module = VK_NULL_HANDLE;
+            VkShaderModule frag_shader_module = VK_NULL_HANDLE;
+
+            void create_graphics_pipeline(const Pipeline_Config_Info& config_info);
         public:
-            Pipeline(const std::string& vert_path, const std::string& frag_path);
+            // loads .spv files through the device's shader module cache
+            Pipeline(
+                    Device& device,
+                    const std::string& vert_path,
+                    const std::string& frag_path,
+                    const Pipeline_Config_Info& config_info
+                    );
+            // shaders embedded into the executable, see shader/embedded_shaders.hpp
+            Pipeline(
+                    Device& device,
+                    const Spirv_Blob& vert_code,
+                    const Spirv_Blob& frag_code,
+                    const Pipeline_Config_Info& config_info
+                    );
+            ~Pipeline();
+
+            Pipeline(const Pipeline &) = delete;
+            Pipeline &operator = (const Pipeline &) = delete;
+
+            void bind(VkCommandBuffer command_buffer);
+            VkPipeline handle() const { return graphics_pipeline; }
+
+            // shared with PipelineLibrary, which compiles the same way in its jobs
+            static VkPipeline create_pipeline_handle(
+                    Device& device,
+                    VkShaderModule vert_shader_module,
+                    VkShaderModule frag_shader_module,
+                    const Pipeline_Config_Info& config_info
+                    );
+
+            // triangle list, no culling, no blending, viewport and scissor left dynamic
+            static void default_pipeline_config_info(Pipeline_Config_Info& config_info);
     };
 
 }
@@ -0,0 +1,196 @@
+/**
+ * library_support/Graphic/vulkan/pipeline
+ *
+ **/
+
+// match hpp file
+#include "pipeline_cache.hpp"
+#include "../../../File/hash/fnv1a.hpp"
+//standard libraries
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+namespace graph_vulkan{
+    PipelineCache::PipelineCache(
+            VkDevice device,
+            const VkPhysicalDeviceProperties &properties,
+            std::string path
+            ) : PipelineCache(device, properties, path, read_file(path)) {}
+
+    PipelineCache::PipelineCache(
+            VkDevice device,
+            const VkPhysicalDeviceProperties &properties,
+            std::string path,
+            const std::vector<char> &file_contents
+            ) : device_{device}, properties_{properties}, path_{std::move(path)} {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<char> initial_data = validate_file_contents(file_contents);
+
+        VkPipelineCacheCreateInfo create_info{};
+        create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        create_info.initialDataSize = initial_data.size();
+        create_info.pInitialData = initial_data.empty() ? nullptr : initial_data.data();
+
+        if (vkCreatePipelineCache(device_, &create_info, nullptr, &cache_) != VK_SUCCESS) {
+            // the driver may still reject data it does not like, retry empty before giving up
+            create_info.initialDataSize = 0;
+            create_info.pInitialData = nullptr;
+            loaded_from_disk_ = false;
+            loaded_hash_ = 0;
+            if (vkCreatePipelineCache(device_, &create_info, nullptr, &cache_) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create pipeline cache.");
+            }
+        }
+
+        auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::ostringstream report;
+        if (loaded_from_disk_) {
+            report << "Pipeline cache: loaded " << initial_data.size() << " bytes from " << path_
+                   << " in " << elapsed << " ms\n";
+        } else {
+            report << "Pipeline cache: started empty\n";
+        }
+        load_report_ += report.str();
+    }
+
+    PipelineCache::~PipelineCache() {
+        save();
+        vkDestroyPipelineCache(device_, cache_, nullptr);
+    }
+
+    uint64_t PipelineCache::hash_data(const void *data, size_t size) {
+        // good enough to detect truncated or corrupted files
+        return file_io::fnv1a(data, size);
+    }
+
+    std::vector<char> PipelineCache::read_file(const std::string &path) {
+        if (path.empty()) return {};
+        std::ifstream file{path, std::ios::ate | std::ios::binary};
+        if (!file.is_open()) return {};
+
+        std::vector<char> contents(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(contents.data(), static_cast<std::streamsize>(contents.size()));
+        if (!file) return {};
+        return contents;
+    }
+
+    std::vector<char> PipelineCache::validate_file_contents(const std::vector<char> &file_contents) {
+        size_t file_size = file_contents.size();
+        if (file_size < sizeof(Pipeline_Cache_File_Header)) return {};
+
+        Pipeline_Cache_File_Header header{};
+        std::memcpy(&header, file_contents.data(), sizeof(header));
+
+        const char *reject_reason = nullptr;
+        if (header.magic != FILE_MAGIC || header.header_version != FILE_VERSION) {
+            reject_reason = "unknown file format";
+        } else if (header.vendor_id != properties_.vendorID || header.device_id != properties_.deviceID) {
+            reject_reason = "written by another GPU";
+        } else if (header.driver_version != properties_.driverVersion) {
+            reject_reason = "written by another driver version";
+        } else if (std::memcmp(header.pipeline_cache_uuid, properties_.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+            reject_reason = "pipelineCacheUUID changed";
+        } else if (header.data_size != file_size - sizeof(header)) {
+            reject_reason = "truncated";
+        }
+
+        std::vector<char> data;
+        if (reject_reason == nullptr) {
+            data.assign(file_contents.begin() + sizeof(header), file_contents.end());
+            if (hash_data(data.data(), data.size()) != header.data_hash) {
+                reject_reason = "checksum mismatch";
+            }
+        }
+
+        // the driver's own header has to agree as well
+        if (reject_reason == nullptr) {
+            VkPipelineCacheHeaderVersionOne driver_header{};
+            if (data.size() < sizeof(driver_header)) {
+                reject_reason = "missing driver header";
+            } else {
+                std::memcpy(&driver_header, data.data(), sizeof(driver_header));
+                if (driver_header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+                    driver_header.vendorID != properties_.vendorID ||
+                    driver_header.deviceID != properties_.deviceID ||
+                    std::memcmp(driver_header.pipelineCacheUUID, properties_.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+                    reject_reason = "driver header mismatch";
+                }
+            }
+        }
+
+        if (reject_reason != nullptr) {
+            load_report_ += "Pipeline cache: ignoring " + path_ + " (" + reject_reason + ")\n";
+            return {};
+        }
+
+        loaded_from_disk_ = true;
+        loaded_hash_ = header.data_hash;
+        return data;
+    }
+
+    bool PipelineCache::save() {
+        if (path_.empty()) return false;
+        size_t data_size = 0;
+        if (vkGetPipelineCacheData(device_, cache_, &data_size, nullptr) != VK_SUCCESS || data_size == 0) {
+            return false;
+        }
+        std::vector<char> data(data_size);
+        if (vkGetPipelineCacheData(device_, cache_, &data_size, data.data()) != VK_SUCCESS) {
+            return false;
+        }
+        data.resize(data_size);
+
+        uint64_t data_hash = hash_data(data.data(), data.size());
+        if (loaded_from_disk_ && data_hash == loaded_hash_) return true;
+
+        Pipeline_Cache_File_Header header{};
+        header.magic = FILE_MAGIC;
+        header.header_version = FILE_VERSION;
+        header.vendor_id = properties_.vendorID;
+        header.device_id = properties_.deviceID;
+        header.driver_version = properties_.driverVersion;
+        std::memcpy(header.pipeline_cache_uuid, properties_.pipelineCacheUUID, VK_UUID_SIZE);
+        header.data_size = data.size();
+        header.data_hash = data_hash;
+
+        // a crash in the middle of writing must never leave a half written cache behind
+        const std::string temporary_path = path_ + ".tmp";
+        {
+            std::ofstream file{temporary_path, std::ios::binary | std::ios::trunc};
+            if (!file.is_open()) {
+                std::cerr << "Pipeline cache: failed to open " << temporary_path << " for writing" << std::endl;
+                return false;
+            }
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(data.data(), static_cast<std::streamsize>(data.size()));
+            if (!file) {
+                std::cerr << "Pipeline cache: failed to write " << temporary_path << std::endl;
+                return false;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temporary_path, path_, error);
+        if (error) {
+            // rename does not replace existing files everywhere
+            std::filesystem::remove(path_, error);
+            std::filesystem::rename(temporary_path, path_, error);
+        }
+        if (error) {
+            std::cerr << "Pipeline cache: failed to replace " << path_ << ": " << error.message() << std::endl;
+            return false;
+        }
+
+        loaded_from_disk_ = true;
+        loaded_hash_ = data_hash;
+        return true;
+    }
+
+} // namespace graph_vulkan
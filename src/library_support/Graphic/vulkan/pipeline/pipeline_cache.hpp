@@ -0,0 +1,83 @@
+/**
+ * library_support/Graphic/vulkan/pipeline
+ *
+ * VkPipelineCache persisted on disk between runs
+ *
+ * The blob is prefixed with our own header holding vendor, device, driver
+ * version, pipelineCacheUUID and a checksum of the data, a cache written by
+ * another GPU or driver is thrown away instead of being handed to the driver.
+ * Reading the file needs no device, read_file() lets startup do it early.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_GRAPHIC_VULKAN_PIPELINE_CACHE_H
+#define PIXEL_ENGINE_GRAPHIC_VULKAN_PIPELINE_CACHE_H
+
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace graph_vulkan{
+    struct Pipeline_Cache_File_Header {
+        uint32_t magic;
+        uint32_t header_version;
+        uint32_t vendor_id;
+        uint32_t device_id;
+        uint32_t driver_version;
+        uint8_t  pipeline_cache_uuid[VK_UUID_SIZE];
+        uint64_t data_size;
+        uint64_t data_hash;
+    };
+
+    class PipelineCache {
+    private:
+        VkDevice device_;
+        VkPhysicalDeviceProperties properties_;
+        std::string path_;
+        VkPipelineCache cache_ = VK_NULL_HANDLE;
+
+        // hash of what is on disk, saving is skipped when nothing was added
+        uint64_t loaded_hash_ = 0;
+        bool loaded_from_disk_ = false;
+        // what happened to the file on disk, the device adds it to its report instead of printing during startup
+        std::string load_report_;
+
+        std::vector<char> validate_file_contents(const std::vector<char> &file_contents);
+
+    public:
+        static constexpr uint32_t FILE_MAGIC = 0x43505850; // "PXPC"
+        static constexpr uint32_t FILE_VERSION = 1;
+
+        PipelineCache(VkDevice device, const VkPhysicalDeviceProperties &properties, std::string path);
+        // file_contents is what read_file(path) returned, path is still where the cache is saved to
+        PipelineCache(
+                VkDevice device,
+                const VkPhysicalDeviceProperties &properties,
+                std::string path,
+                const std::vector<char> &file_contents
+                );
+        ~PipelineCache();
+
+        PipelineCache(const PipelineCache &) = delete;
+        PipelineCache &operator = (const PipelineCache &) = delete;
+
+        VkPipelineCache handle() const { return cache_; }
+        bool was_loaded_from_disk() const { return loaded_from_disk_; }
+        const std::string &load_report() const { return load_report_; }
+
+        // writes to a temporary file first and renames it over the old one
+        bool save();
+
+        static uint64_t hash_data(const void *data, size_t size);
+        // the whole file, header included, empty when there is none
+        static std::vector<char> read_file(const std::string &path);
+    };
+
+} // namespace graph_vulkan
+
+
+#endif // PIXEL_ENGINE_GRAPHIC_VULKAN_PIPELINE_CACHE_H
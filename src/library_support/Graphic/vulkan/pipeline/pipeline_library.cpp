@@ -0,0 +1,328 @@
+/**
+ * library_support/Graphic/vulkan/pipeline
+ *
+ **/
+
+// match hpp file
+#include "pipeline_library.hpp"
+#include "../../../File/hash/fnv1a.hpp"
+#include "../../../Profiling/profiler/profiler.hpp"
+//standard libraries
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace graph_vulkan{
+    namespace {
+        // the bytes of one field at a time, structs are never written whole since
+        // their padding and pNext pointers are not part of the state
+        class State_Writer {
+        private:
+            std::string bytes;
+
+        public:
+            template<typename T>
+            void add(const T &value) {
+                static_assert(std::is_trivially_copyable<T>::value, "only plain values can be written");
+                bytes.append(reinterpret_cast<const char *>(&value), sizeof(T));
+            }
+
+            void add_stencil(const VkStencilOpState &stencil) {
+                add(stencil.failOp);
+                add(stencil.passOp);
+                add(stencil.depthFailOp);
+                add(stencil.compareOp);
+                add(stencil.compareMask);
+                add(stencil.writeMask);
+                add(stencil.reference);
+            }
+
+            std::string take() { return std::move(bytes); }
+        };
+    } // namespace
+
+    VkPipeline Pipeline_Handle::wait() const {
+        if (!entry) return VK_NULL_HANDLE;
+
+        std::unique_lock<std::mutex> lock{entry->mutex};
+        entry->finished.wait(lock, [this]{
+            return entry->state.load(std::memory_order_acquire) != Pipeline_State::pending;
+        });
+        if (entry->error) std::rethrow_exception(entry->error);
+        return entry->pipeline;
+    }
+
+    bool Pipeline_Handle::bind(VkCommandBuffer command_buffer, VkPipeline fallback) const {
+        VkPipeline pipeline = try_get();
+        if (pipeline == VK_NULL_HANDLE) pipeline = fallback;
+        if (pipeline == VK_NULL_HANDLE) return false;
+
+        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+        return true;
+    }
+
+    PipelineLibrary::PipelineLibrary(Device &device, jobs::JobSystem &job_system) : device{device}, job_system{job_system} {}
+
+    PipelineLibrary::~PipelineLibrary() {
+        // what has not started yet fails right away, what is compiling finishes
+        stopping.store(true, std::memory_order_release);
+        job_system.wait(compiling);
+
+        // a frame in flight may still draw with them
+        for (auto &pipeline : pipelines) {
+            if (pipeline.second->pipeline != VK_NULL_HANDLE) device.deletion_queue().push_pipeline(pipeline.second->pipeline);
+        }
+        for (auto &entry : evicted) {
+            if (entry->pipeline != VK_NULL_HANDLE) device.deletion_queue().push_pipeline(entry->pipeline);
+        }
+    }
+
+    size_t PipelineLibrary::State_Key_Hash::operator()(const std::string &state) const {
+        return static_cast<size_t>(file_io::fnv1a(state.data(), state.size()));
+    }
+
+    std::string PipelineLibrary::state_key(
+            VkShaderModule vert_module,
+            VkShaderModule frag_module,
+            const Pipeline_Config_Info &config_info
+            ) {
+        State_Writer writer;
+        writer.add(vert_module);
+        writer.add(frag_module);
+
+        writer.add(config_info.binding_descriptions.size());
+        for (const auto &binding : config_info.binding_descriptions) {
+            writer.add(binding.binding);
+            writer.add(binding.stride);
+            writer.add(binding.inputRate);
+        }
+        writer.add(config_info.attribute_descriptions.size());
+        for (const auto &attribute : config_info.attribute_descriptions) {
+            writer.add(attribute.location);
+            writer.add(attribute.binding);
+            writer.add(attribute.format);
+            writer.add(attribute.offset);
+        }
+
+        writer.add(config_info.input_assembly_info.topology);
+        writer.add(config_info.input_assembly_info.primitiveRestartEnable);
+
+        writer.add(config_info.viewport_info.viewportCount);
+        writer.add(config_info.viewport_info.scissorCount);
+
+        const auto &raster = config_info.rasterization_info;
+        writer.add(raster.depthClampEnable);
+        writer.add(raster.rasterizerDiscardEnable);
+        writer.add(raster.polygonMode);
+        writer.add(raster.cullMode);
+        writer.add(raster.frontFace);
+        writer.add(raster.depthBiasEnable);
+        writer.add(raster.depthBiasConstantFactor);
+        writer.add(raster.depthBiasClamp);
+        writer.add(raster.depthBiasSlopeFactor);
+        writer.add(raster.lineWidth);
+
+        const auto &multisample = config_info.multisample_info;
+        writer.add(multisample.rasterizationSamples);
+        writer.add(multisample.sampleShadingEnable);
+        writer.add(multisample.minSampleShading);
+        writer.add(multisample.alphaToCoverageEnable);
+        writer.add(multisample.alphaToOneEnable);
+
+        const auto &blend = config_info.color_blend_attachment;
+        writer.add(blend.blendEnable);
+        writer.add(blend.srcColorBlendFactor);
+        writer.add(blend.dstColorBlendFactor);
+        writer.add(blend.colorBlendOp);
+        writer.add(blend.srcAlphaBlendFactor);
+        writer.add(blend.dstAlphaBlendFactor);
+        writer.add(blend.alphaBlendOp);
+        writer.add(blend.colorWriteMask);
+        writer.add(config_info.color_blend_info.logicOpEnable);
+        writer.add(config_info.color_blend_info.logicOp);
+        writer.add(config_info.color_blend_info.blendConstants);
+
+        const auto &depth = config_info.depth_stencil_info;
+        writer.add(depth.depthTestEnable);
+        writer.add(depth.depthWriteEnable);
+        writer.add(depth.depthCompareOp);
+        writer.add(depth.depthBoundsTestEnable);
+        writer.add(depth.stencilTestEnable);
+        writer.add_stencil(depth.front);
+        writer.add_stencil(depth.back);
+        writer.add(depth.minDepthBounds);
+        writer.add(depth.maxDepthBounds);
+
+        writer.add(config_info.dynamic_state_enables.size());
+        for (VkDynamicState dynamic_state : config_info.dynamic_state_enables) {
+            writer.add(dynamic_state);
+        }
+
+        writer.add(config_info.pipeline_layout);
+        writer.add(config_info.render_pass);
+        writer.add(config_info.subpass);
+        return writer.take();
+    }
+
+    Pipeline_Handle PipelineLibrary::request(const Pipeline_Desc &desc) {
+        request_count.fetch_add(1, std::memory_order_relaxed);
+
+        ShaderModuleCache &shader_modules = device.shader_modules();
+        VkShaderModule vert_module = desc.vert_code.empty() ? shader_modules.load(desc.vert_path) : shader_modules.get(desc.vert_code);
+        VkShaderModule frag_module = desc.frag_code.empty() ? shader_modules.load(desc.frag_path) : shader_modules.get(desc.frag_code);
+        std::string state = state_key(vert_module, frag_module, desc.config_info);
+
+        std::shared_ptr<Pipeline_Entry> entry;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            // the map compares the whole state, two states with the same hash stay two pipelines
+            auto found = pipelines.find(state);
+            if (found != pipelines.end()) {
+                dedup_hit_count.fetch_add(1, std::memory_order_relaxed);
+                return Pipeline_Handle{found->second};
+            }
+
+            entry = std::make_shared<Pipeline_Entry>();
+            entry->key = file_io::fnv1a(state.data(), state.size());
+            entry->vert_shader_module = vert_module;
+            entry->frag_shader_module = frag_module;
+            entry->config_info = desc.config_info;
+            pipelines.emplace(std::move(state), entry);
+        }
+
+        // without workers nothing runs the job until somebody waits for it, and a frame never does
+        if (job_system.thread_count() <= 1) {
+            compile(*entry);
+            return Pipeline_Handle{entry};
+        }
+        outstanding.fetch_add(1, std::memory_order_relaxed);
+        job_system.schedule([this, entry]{
+            compile(*entry);
+            outstanding.fetch_sub(1, std::memory_order_relaxed);
+        }, &compiling);
+        return Pipeline_Handle{entry};
+    }
+
+    void PipelineLibrary::compile(Pipeline_Entry &entry) {
+        PIXEL_PROFILE_ZONE("compile pipeline");
+        auto start = std::chrono::steady_clock::now();
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        std::exception_ptr error;
+        try {
+            {
+                std::lock_guard<std::mutex> lock{entry.mutex};
+                // nobody is going to wait for it
+                if (stopping.load(std::memory_order_acquire)) {
+                    throw std::runtime_error("Pipeline library destroyed before compiling.");
+                }
+                // its render pass or layout may be gone already
+                if (entry.evicted) {
+                    throw std::runtime_error("Pipeline evicted before compiling.");
+                }
+                entry.compiling = true;
+            }
+            pipeline = Pipeline::create_pipeline_handle(
+                    device,
+                    entry.vert_shader_module,
+                    entry.frag_shader_module,
+                    entry.config_info
+                    );
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{entry.mutex};
+            entry.compiling = false;
+            entry.pipeline = pipeline;
+            entry.error = error;
+            entry.compile_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            entry.state.store(error ? Pipeline_State::failed : Pipeline_State::ready, std::memory_order_release);
+        }
+        entry.finished.notify_all();
+        if (!error) compiled_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void PipelineLibrary::wait_idle() {
+        job_system.wait(compiling);
+    }
+
+    void PipelineLibrary::evict_render_pass(VkRenderPass render_pass) {
+        evict(render_pass, VK_NULL_HANDLE);
+    }
+
+    void PipelineLibrary::evict_pipeline_layout(VkPipelineLayout pipeline_layout) {
+        evict(VK_NULL_HANDLE, pipeline_layout);
+    }
+
+    void PipelineLibrary::evict(VkRenderPass render_pass, VkPipelineLayout pipeline_layout) {
+        std::vector<std::shared_ptr<Pipeline_Entry>> removed;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            for (auto pipeline = pipelines.begin(); pipeline != pipelines.end();) {
+                const Pipeline_Config_Info &config_info = pipeline->second->config_info;
+                if ((render_pass != VK_NULL_HANDLE && config_info.render_pass == render_pass) ||
+                    (pipeline_layout != VK_NULL_HANDLE && config_info.pipeline_layout == pipeline_layout)) {
+                    removed.push_back(std::move(pipeline->second));
+                    pipeline = pipelines.erase(pipeline);
+                } else {
+                    ++pipeline;
+                }
+            }
+        }
+
+        // a compile using the handle right now has to be done before the caller destroys it
+        for (auto &entry : removed) {
+            std::unique_lock<std::mutex> lock{entry->mutex};
+            entry->evicted = true;
+            entry->finished.wait(lock, [&entry]{ return !entry->compiling; });
+        }
+
+        std::lock_guard<std::mutex> lock{mutex};
+        evicted_count.fetch_add(static_cast<uint32_t>(removed.size()), std::memory_order_relaxed);
+        evicted.insert(evicted.end(), std::make_move_iterator(removed.begin()), std::make_move_iterator(removed.end()));
+        release_evicted();
+    }
+
+    void PipelineLibrary::release_evicted() {
+        // the library's reference is the last one, and no compile job holds one either
+        auto unused = std::partition(evicted.begin(), evicted.end(), [](const std::shared_ptr<Pipeline_Entry> &entry) {
+            return entry.use_count() > 1 || entry->state.load(std::memory_order_acquire) == Pipeline_State::pending;
+        });
+        for (auto entry = unused; entry != evicted.end(); ++entry) {
+            // a frame in flight may still draw with it
+            if ((*entry)->pipeline != VK_NULL_HANDLE) device.deletion_queue().push_pipeline((*entry)->pipeline);
+        }
+        evicted.erase(unused, evicted.end());
+    }
+
+    uint32_t PipelineLibrary::pending_count() {
+        return outstanding.load(std::memory_order_relaxed);
+    }
+
+    uint32_t PipelineLibrary::pipeline_count() {
+        std::lock_guard<std::mutex> lock{mutex};
+        return static_cast<uint32_t>(pipelines.size());
+    }
+
+    void PipelineLibrary::print_stats(std::ostream &out) {
+        std::lock_guard<std::mutex> lock{mutex};
+        double total_compile_ms = 0.0;
+        double slowest_compile_ms = 0.0;
+        for (auto &pipeline : pipelines) {
+            if (pipeline.second->state.load(std::memory_order_acquire) == Pipeline_State::pending) continue;
+            total_compile_ms += pipeline.second->compile_ms;
+            slowest_compile_ms = std::max(slowest_compile_ms, pipeline.second->compile_ms);
+        }
+        out << "Pipeline library: " << request_count.load() << " requests, "
+            << dedup_hit_count.load() << " deduplicated, "
+            << compiled_count.load() << " compiled on " << job_system.thread_count() << " job threads, "
+            << outstanding.load() << " pending, "
+            << evicted_count.load() << " evicted, "
+            << total_compile_ms << " ms compile time (slowest " << slowest_compile_ms << " ms)" << std::endl;
+    }
+
+} // namespace graph_vulkan
@@ -0,0 +1,151 @@
+/**
+ * library_support/Graphic/vulkan/pipeline
+ *
+ * Deduplicating, asynchronous graphics pipeline cache
+ *
+ * Pipelines are keyed by their complete state, shader modules, vertex layout,
+ * fixed function state and render pass, so identical requests share one
+ * VkPipeline. The hash only picks the bucket, a hit compares the whole state.
+ * Compilation runs as jobs on the engine's jobs::JobSystem, a request returns a
+ * handle right away and draws using a pipeline that is not ready yet are
+ * skipped or drawn with a fallback instead of stalling the frame. Without
+ * worker threads the request compiles right away.
+ *
+ * The key holds raw render pass and layout handles. Evict them before they are
+ * destroyed, a new object may get the same handle value and must not be handed
+ * a pipeline built for the old one.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_GRAPHIC_VULKAN_PIPELINE_LIBRARY_H
+#define PIXEL_ENGINE_GRAPHIC_VULKAN_PIPELINE_LIBRARY_H
+
+#pragma once
+
+#include "pipeline.hpp"
+#include "../../../Thread/job_system/job_system.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace graph_vulkan{
+    struct Pipeline_Desc {
+        // embedded code is used when set, the paths otherwise
+        std::string vert_path;
+        std::string frag_path;
+        Pipeline_Config_Info config_info;
+        Spirv_Blob vert_code{};
+        Spirv_Blob frag_code{};
+    };
+
+    enum class Pipeline_State {pending, ready, failed};
+
+    struct Pipeline_Entry {
+        uint64_t key = 0;
+        VkShaderModule vert_shader_module = VK_NULL_HANDLE;
+        VkShaderModule frag_shader_module = VK_NULL_HANDLE;
+        Pipeline_Config_Info config_info;
+
+        std::atomic<Pipeline_State> state{Pipeline_State::pending};
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        std::exception_ptr error;
+        double compile_ms = 0.0;
+
+        std::mutex mutex;
+        std::condition_variable finished;
+        // guarded by mutex, an evicted entry that has not started compiling never does
+        bool compiling = false;
+        bool evicted = false;
+    };
+
+    class Pipeline_Handle {
+    private:
+        std::shared_ptr<Pipeline_Entry> entry;
+
+    public:
+        Pipeline_Handle() = default;
+        explicit Pipeline_Handle(std::shared_ptr<Pipeline_Entry> entry) : entry{std::move(entry)} {}
+
+        bool valid() const { return entry != nullptr; }
+        bool is_ready() const { return entry && entry->state.load(std::memory_order_acquire) == Pipeline_State::ready; }
+        bool has_failed() const { return entry && entry->state.load(std::memory_order_acquire) == Pipeline_State::failed; }
+        uint64_t key() const { return entry ? entry->key : 0; }
+
+        // VK_NULL_HANDLE until compiled, never blocks
+        VkPipeline try_get() const { return is_ready() ? entry->pipeline : VK_NULL_HANDLE; }
+        // blocks until compiled, rethrows the compile error
+        VkPipeline wait() const;
+        // binds the pipeline, or the fallback when given, returns false when the draw should be skipped
+        bool bind(VkCommandBuffer command_buffer, VkPipeline fallback = VK_NULL_HANDLE) const;
+    };
+
+    class PipelineLibrary {
+    private:
+        Device &device;
+        jobs::JobSystem &job_system;
+
+        struct State_Key_Hash {
+            size_t operator()(const std::string &state) const;
+        };
+
+        std::mutex mutex;
+        // keyed by the state's bytes, see state_key()
+        std::unordered_map<std::string, std::shared_ptr<Pipeline_Entry>, State_Key_Hash> pipelines;
+        // no longer handed out, freed once no handle refers to them
+        std::vector<std::shared_ptr<Pipeline_Entry>> evicted;
+
+        // one per compile job, queued plus currently compiling
+        jobs::Job_Counter compiling;
+        std::atomic<uint32_t> outstanding{0};
+        // compile jobs that have not started yet fail their entry instead
+        std::atomic<bool> stopping{false};
+
+        std::atomic<uint32_t> request_count{0};
+        std::atomic<uint32_t> dedup_hit_count{0};
+        std::atomic<uint32_t> compiled_count{0};
+        std::atomic<uint32_t> evicted_count{0};
+
+        void compile(Pipeline_Entry &entry);
+        // drops every entry built against render_pass or pipeline_layout, a null handle matches nothing
+        void evict(VkRenderPass render_pass, VkPipelineLayout pipeline_layout);
+        // mutex held, the evicted entries nobody holds a handle to any more
+        void release_evicted();
+
+    public:
+        // the job system has to outlive the library
+        PipelineLibrary(Device &device, jobs::JobSystem &job_system);
+        ~PipelineLibrary();
+
+        PipelineLibrary(const PipelineLibrary &) = delete;
+        PipelineLibrary &operator = (const PipelineLibrary &) = delete;
+
+        // returns right away, an identical earlier request returns the same pipeline
+        Pipeline_Handle request(const Pipeline_Desc &desc);
+        // waits for everything queued so far, runs other jobs meanwhile on a job thread
+        void wait_idle();
+        // before destroying a render pass or layout pipelines were requested with; handles given out keep
+        // their pipeline, a compile still running against it finishes first, one not started yet fails
+        void evict_render_pass(VkRenderPass render_pass);
+        void evict_pipeline_layout(VkPipelineLayout pipeline_layout);
+
+        uint32_t pending_count();
+        uint32_t pipeline_count();
+        void print_stats(std::ostream &out);
+
+        // every field that ends up in the VkPipeline, one after the other; modules come from the
+        // device's content keyed cache, equal handles mean equal code
+        static std::string state_key(VkShaderModule vert_module, VkShaderModule frag_module, const Pipeline_Config_Info &config_info);
+    };
+
+} // namespace graph_vulkan
+
+
+#endif // PIXEL_ENGINE_GRAPHIC_VULKAN_PIPELINE_LIBRARY_H
@@ -0,0 +1,116 @@
+/**
+ * library_support/Graphic/vulkan/profiler
+ *
+ **/
+
+// match hpp file
+#include "gpu_profiler.hpp"
+//standard libraries
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace graph_vulkan{
+    GpuProfiler::GpuProfiler(Device &device, uint32_t frames_in_flight, uint32_t max_zones_per_frame)
+            : device{device}, max_zones{max_zones_per_frame} {
+        if (!profiling::compiled_in || max_zones == 0) return;
+
+        const Physical_Device_Info &info = device.physical_info();
+        uint32_t graphics_family = device.find_physical_queue_families().graphics_Family;
+        uint32_t valid_bits = info.queue_families[graphics_family].timestampValidBits;
+        if (valid_bits == 0 || info.properties.limits.timestampPeriod <= 0.0f) return;
+
+        supported = true;
+        timestamp_period = info.properties.limits.timestampPeriod;
+        timestamp_mask = valid_bits >= 64 ? std::numeric_limits<uint64_t>::max() : (1ull << valid_bits) - 1;
+
+        frames.resize(frames_in_flight > 0 ? frames_in_flight : 1);
+        for (auto &frame : frames) {
+            VkQueryPoolCreateInfo pool_info{};
+            pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+            // a begin and an end timestamp per zone
+            pool_info.queryCount = max_zones * 2;
+            if (vkCreateQueryPool(device.device(), &pool_info, nullptr, &frame.query_pool) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create timestamp query pool.");
+            }
+            frame.zone_names.reserve(max_zones);
+        }
+        results.resize(static_cast<size_t>(max_zones) * 2);
+    }
+
+    GpuProfiler::~GpuProfiler() {
+        for (auto &frame : frames) {
+            vkDestroyQueryPool(device.device(), frame.query_pool, nullptr);
+        }
+    }
+
+    void GpuProfiler::collect(Frame_Queries &frame) {
+        frame.pending = false;
+        uint32_t query_count = static_cast<uint32_t>(frame.zone_names.size()) * 2;
+        if (query_count == 0) return;
+
+        // no WAIT bit, the fence of the frame has signaled so the results are there already
+        VkResult result = vkGetQueryPoolResults(
+                device.device(),
+                frame.query_pool,
+                0,
+                query_count,
+                query_count * sizeof(uint64_t),
+                results.data(),
+                sizeof(uint64_t),
+                VK_QUERY_RESULT_64_BIT
+                );
+        if (result != VK_SUCCESS) return;
+
+        uint64_t first_tick = std::numeric_limits<uint64_t>::max();
+        uint64_t last_tick = 0;
+        for (uint32_t i = 0; i < query_count; i++) {
+            results[i] &= timestamp_mask;
+            if (i % 2 == 0) first_tick = std::min(first_tick, results[i]);
+            else last_tick = std::max(last_tick, results[i]);
+        }
+
+        profiling::Profiler &profiler = profiling::Profiler::instance();
+        auto to_cpu_ns = [&](uint64_t tick) {
+            return frame.recorded_ns + static_cast<int64_t>(static_cast<double>(tick - first_tick) * timestamp_period);
+        };
+        for (size_t zone = 0; zone < frame.zone_names.size(); zone++) {
+            uint64_t begin = results[zone * 2];
+            uint64_t end = results[zone * 2 + 1];
+            if (end < begin) continue;
+            profiler.add_gpu_zone(frame.zone_names[zone], to_cpu_ns(begin), to_cpu_ns(end));
+        }
+        if (last_tick >= first_tick) {
+            profiler.add_gpu_frame_time(static_cast<double>(last_tick - first_tick) * timestamp_period / 1.0e6);
+        }
+    }
+
+    void GpuProfiler::begin_frame(VkCommandBuffer command_buffer, uint32_t frame_index) {
+        if (!supported) return;
+
+        current = &frames[frame_index % frames.size()];
+        if (current->pending) collect(*current);
+
+        current->zone_names.clear();
+        current->recorded_ns = profiling::Profiler::instance().now_ns();
+        current->pending = true;
+        vkCmdResetQueryPool(command_buffer, current->query_pool, 0, max_zones * 2);
+    }
+
+    uint32_t GpuProfiler::begin_zone(VkCommandBuffer command_buffer, const char *name) {
+        if (!current || current->zone_names.size() >= max_zones) return std::numeric_limits<uint32_t>::max();
+
+        uint32_t zone = static_cast<uint32_t>(current->zone_names.size());
+        current->zone_names.push_back(name);
+        vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, current->query_pool, zone * 2);
+        return zone;
+    }
+
+    void GpuProfiler::end_zone(VkCommandBuffer command_buffer, uint32_t zone) {
+        if (!current || zone >= current->zone_names.size()) return;
+
+        vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, current->query_pool, zone * 2 + 1);
+    }
+
+} // namespace graph_vulkan
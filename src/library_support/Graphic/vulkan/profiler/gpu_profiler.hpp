@@ -0,0 +1,90 @@
+/**
+ * library_support/Graphic/vulkan/profiler
+ *
+ * GPU timestamp zones, fed into the CPU profiler's trace and frame statistics
+ *
+ * Every frame in flight has its own query pool. Its results are read back when
+ * the frame slot comes around again, after its fence has been waited for, so
+ * reading them never stalls. Timestamps are converted with timestampPeriod and
+ * placed on the CPU clock at the time the frame was recorded, close enough to
+ * line both timelines up in the trace.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_GRAPHIC_VULKAN_GPU_PROFILER_H
+#define PIXEL_ENGINE_GRAPHIC_VULKAN_GPU_PROFILER_H
+
+#pragma once
+
+#include "../device/device.hpp"
+#include "../../../Profiling/profiler/profiler.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace graph_vulkan{
+    class GpuProfiler {
+    private:
+        struct Frame_Queries {
+            VkQueryPool query_pool = VK_NULL_HANDLE;
+            std::vector<const char *> zone_names;
+            int64_t recorded_ns = 0;
+            bool pending = false;
+        };
+
+        Device &device;
+        uint32_t max_zones;
+        double timestamp_period = 1.0;
+        uint64_t timestamp_mask = 0;
+        bool supported = false;
+
+        std::vector<Frame_Queries> frames;
+        Frame_Queries *current = nullptr;
+        std::vector<uint64_t> results;
+
+        void collect(Frame_Queries &frame);
+
+    public:
+        // does nothing when PIXEL_ENGINE_PROFILING is off or the graphics queue has no timestamps
+        GpuProfiler(Device &device, uint32_t frames_in_flight, uint32_t max_zones_per_frame = 64);
+        ~GpuProfiler();
+
+        GpuProfiler(const GpuProfiler &) = delete;
+        GpuProfiler &operator = (const GpuProfiler &) = delete;
+
+        bool is_supported() const { return supported; }
+
+        // right after vkBeginCommandBuffer, once the frame slot's fence has signaled
+        void begin_frame(VkCommandBuffer command_buffer, uint32_t frame_index);
+        // name must be a string literal, returns the zone for end_zone
+        uint32_t begin_zone(VkCommandBuffer command_buffer, const char *name);
+        void end_zone(VkCommandBuffer command_buffer, uint32_t zone);
+    };
+
+    class Gpu_Zone {
+    private:
+        GpuProfiler &profiler;
+        VkCommandBuffer command_buffer;
+        uint32_t zone;
+
+    public:
+        Gpu_Zone(GpuProfiler &profiler, VkCommandBuffer command_buffer, const char *name)
+                : profiler{profiler}, command_buffer{command_buffer}, zone{profiler.begin_zone(command_buffer, name)} {}
+        ~Gpu_Zone() { profiler.end_zone(command_buffer, zone); }
+
+        Gpu_Zone(const Gpu_Zone &) = delete;
+        Gpu_Zone &operator = (const Gpu_Zone &) = delete;
+    };
+
+} // namespace graph_vulkan
+
+#ifdef PIXEL_ENGINE_PROFILING
+// times the commands recorded in the enclosing scope
+#define PIXEL_PROFILE_GPU_ZONE(profiler, command_buffer, name) \
+    ::graph_vulkan::Gpu_Zone PIXEL_PROFILE_CONCAT(profile_gpu_zone_, __LINE__){profiler, command_buffer, name}
+#else
+#define PIXEL_PROFILE_GPU_ZONE(profiler, command_buffer, name) ((void)0)
+#endif
+
+
+#endif // PIXEL_ENGINE_GRAPHIC_VULKAN_GPU_PROFILER_H
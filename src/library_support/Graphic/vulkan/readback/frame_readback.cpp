@@ -0,0 +1,274 @@
+/**
+ * library_support/Graphic/vulkan/readback
+ *
+ **/
+
+// match hpp file
+#include "frame_readback.hpp"
+#include "../../../Profiling/profiler/profiler.hpp"
+//standard libraries
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+namespace graph_vulkan{
+    FrameReadback::FrameReadback(Device &device, VkExtent2D extent, VkFormat format, const Frame_Readback_Config &config)
+            : device{device}, extent{extent}, format{format} {
+        uint32_t bytes_per_pixel = readback_bytes_per_pixel(format);
+        if (bytes_per_pixel == 0) {
+            throw std::runtime_error("Frame readback does not support this image format.");
+        }
+        frame_size = static_cast<VkDeviceSize>(extent.width) * extent.height * bytes_per_pixel;
+
+        create_buffers(config.ring_size > 0 ? config.ring_size : 1);
+        worker = std::thread(&FrameReadback::worker_loop, this);
+    }
+
+    FrameReadback::~FrameReadback() {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            stopping = true;
+        }
+        work_ready.notify_all();
+        // the worker drains what was handed over before leaving
+        worker.join();
+
+        for (auto &sink : sinks) {
+            try {
+                sink->finish();
+            } catch (const std::exception &exception) {
+                std::cerr << exception.what() << std::endl;
+            }
+        }
+        for (auto &slot : slots) {
+            device.destroy_buffer(slot.buffer, slot.memory);
+        }
+    }
+
+    void FrameReadback::create_buffers(uint32_t ring_size) {
+        // the CPU reads every byte, uncached (write combined) memory makes that several times slower
+        const VkPhysicalDeviceMemoryProperties &memory_properties = device.physical_info().memory_properties;
+        const VkMemoryPropertyFlags cached_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+        for (uint32_t i = 0; i < memory_properties.memoryTypeCount; i++) {
+            if ((memory_properties.memoryTypes[i].propertyFlags & cached_flags) == cached_flags) {
+                host_cached = true;
+                break;
+            }
+        }
+        VkMemoryPropertyFlags property_flags = host_cached
+                ? cached_flags
+                : VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+        slots.resize(ring_size);
+        for (auto &slot : slots) {
+            device.create_buffer(frame_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, property_flags, slot.buffer, slot.memory);
+            if (!slot.memory.mapped) {
+                throw std::runtime_error("Frame readback buffer is not host mapped.");
+            }
+        }
+    }
+
+    void FrameReadback::add_sink(std::unique_ptr<FrameSink> sink) {
+        std::lock_guard<std::mutex> lock{mutex};
+        sinks.push_back(std::move(sink));
+    }
+
+    uint32_t FrameReadback::record_copy(VkCommandBuffer command_buffer, VkImage image, uint64_t frame_number) {
+        rethrow_worker_error();
+
+        uint32_t slot_index = next_slot;
+        Readback_Slot &slot = slots[slot_index];
+        Slot_State state;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            state = slot.state;
+            if (state != Slot_State::free) stall_count++;
+        }
+        if (state == Slot_State::recorded) {
+            throw std::runtime_error("Frame readback copy was recorded but never submitted.");
+        }
+        // the ring went all the way around, the oldest frame has to reach the sinks first
+        if (state == Slot_State::submitted || state == Slot_State::copied) {
+            hand_over_finished(true);
+        }
+        {
+            std::unique_lock<std::mutex> lock{mutex};
+            slot_released.wait(lock, [&]{ return slot.state == Slot_State::free || error; });
+            if (error) std::rethrow_exception(error);
+            slot.state = Slot_State::recorded;
+            slot.frame_number = frame_number;
+        }
+        next_slot = (next_slot + 1) % static_cast<uint32_t>(slots.size());
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = 0;
+        // tightly packed
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {extent.width, extent.height, 1};
+        vkCmdCopyImageToBuffer(command_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer, 1, &region);
+
+        // the fence alone does not make the copy visible to host reads
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = slot.buffer;
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+        vkCmdPipelineBarrier(
+                command_buffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_HOST_BIT,
+                0,
+                0, nullptr,
+                1, &barrier,
+                0, nullptr
+                );
+        return slot_index;
+    }
+
+    void FrameReadback::submitted(uint32_t slot, VkFence fence) {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            if (slots[slot].state != Slot_State::recorded) {
+                throw std::runtime_error("Frame readback slot was not recorded.");
+            }
+            slots[slot].fence = fence;
+            slots[slot].state = Slot_State::submitted;
+        }
+        in_flight.push_back(slot);
+    }
+
+    void FrameReadback::poll() {
+        rethrow_worker_error();
+        hand_over_finished(false);
+    }
+
+    void FrameReadback::flush() {
+        hand_over_finished(true);
+        std::unique_lock<std::mutex> lock{mutex};
+        slot_released.wait(lock, [this]{
+            if (error) return true;
+            for (auto &slot : slots) {
+                if (slot.state == Slot_State::writing) return false;
+            }
+            return true;
+        });
+        if (error) std::rethrow_exception(error);
+    }
+
+    void FrameReadback::hand_over_finished(bool wait) {
+        // fences are read here only, on the thread that submits, so none is reset while being checked
+        std::vector<uint32_t> finished;
+        for (uint32_t slot_index : in_flight) {
+            Readback_Slot &slot = slots[slot_index];
+            if (slot.state != Slot_State::submitted) continue;
+            VkResult result = wait
+                    ? vkWaitForFences(device.device(), 1, &slot.fence, VK_TRUE, std::numeric_limits<uint64_t>::max())
+                    : vkGetFenceStatus(device.device(), slot.fence);
+            if (result == VK_SUCCESS) finished.push_back(slot_index);
+        }
+
+        bool handed_over = false;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            for (uint32_t slot_index : finished) {
+                slots[slot_index].state = Slot_State::copied;
+            }
+            while (!in_flight.empty() && slots[in_flight.front()].state == Slot_State::copied) {
+                uint32_t slot_index = in_flight.front();
+                in_flight.pop_front();
+                slots[slot_index].state = Slot_State::writing;
+                slots[slot_index].fence = VK_NULL_HANDLE;
+                write_queue.push_back(slot_index);
+                if (first_handover == std::chrono::steady_clock::time_point{}) {
+                    first_handover = std::chrono::steady_clock::now();
+                }
+                handed_over = true;
+            }
+        }
+        if (handed_over) work_ready.notify_one();
+    }
+
+    void FrameReadback::worker_loop() {
+        PIXEL_PROFILE_THREAD("frame readback");
+        while (true) {
+            uint32_t slot_index;
+            {
+                std::unique_lock<std::mutex> lock{mutex};
+                work_ready.wait(lock, [this]{ return stopping || !write_queue.empty(); });
+                if (write_queue.empty()) return;
+                slot_index = write_queue.front();
+                write_queue.pop_front();
+            }
+
+            Readback_Slot &slot = slots[slot_index];
+            std::exception_ptr write_error;
+            try {
+                PIXEL_PROFILE_ZONE("write frame");
+                device.allocator().invalidate(slot.memory);
+
+                Readback_Frame frame{};
+                frame.frame_number = slot.frame_number;
+                frame.width = extent.width;
+                frame.height = extent.height;
+                frame.format = format;
+                frame.pixels = static_cast<const unsigned char *>(slot.memory.mapped);
+                frame.size = static_cast<size_t>(frame_size);
+                for (auto &sink : sinks) {
+                    sink->write(frame);
+                }
+            } catch (...) {
+                write_error = std::current_exception();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                slot.state = Slot_State::free;
+                if (write_error && !error) error = write_error;
+                if (!write_error) {
+                    frames_written++;
+                    last_write = std::chrono::steady_clock::now();
+                }
+            }
+            slot_released.notify_all();
+        }
+    }
+
+    void FrameReadback::rethrow_worker_error() {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (error) std::rethrow_exception(error);
+    }
+
+    uint64_t FrameReadback::frame_count() {
+        std::lock_guard<std::mutex> lock{mutex};
+        return frames_written;
+    }
+
+    void FrameReadback::print_stats(std::ostream &out) {
+        std::lock_guard<std::mutex> lock{mutex};
+        double elapsed_s = frames_written > 0
+                ? std::chrono::duration<double>(last_write - first_handover).count()
+                : 0.0;
+        double megabytes = static_cast<double>(frames_written * frame_size) / (1024.0 * 1024.0);
+
+        out << "Readback: " << frames_written << " frames " << extent.width << "x" << extent.height
+            << " written in " << elapsed_s * 1000.0 << " ms, "
+            << (elapsed_s > 0.0 ? frames_written / elapsed_s : 0.0) << " fps, "
+            << (elapsed_s > 0.0 ? megabytes / elapsed_s : 0.0) << " MB/s, "
+            << stall_count << " stalls on a full ring of " << slots.size() << " "
+            << (host_cached ? "cached" : "uncached") << " buffers" << std::endl;
+        for (auto &sink : sinks) {
+            out << "  -> " << sink->name() << std::endl;
+        }
+    }
+
+} // namespace graph_vulkan
@@ -0,0 +1,114 @@
+/**
+ * library_support/Graphic/vulkan/readback
+ *
+ * Asynchronous readback of rendered frames to host memory
+ *
+ * A ring of host visible, persistently mapped buffers receives one image copy
+ * each, recorded at the end of the frame's own command buffer. Once the fence of
+ * that submit has signaled the buffer goes to a worker thread which hands the
+ * pixels to the sinks, while the GPU already renders the following frames. The
+ * ring only blocks when every buffer is still waiting on the GPU or the sinks.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_GRAPHIC_VULKAN_FRAME_READBACK_H
+#define PIXEL_ENGINE_GRAPHIC_VULKAN_FRAME_READBACK_H
+
+#pragma once
+
+#include "../device/device.hpp"
+#include "frame_sink.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+namespace graph_vulkan{
+    struct Frame_Readback_Config {
+        // frames in flight plus one keeps the GPU from waiting on the sinks, more absorbs slow writes
+        uint32_t ring_size = 4;
+    };
+
+    class FrameReadback {
+    private:
+        // copied: the GPU is done, waiting for older frames so the sinks see them in order
+        enum class Slot_State {free, recorded, submitted, copied, writing};
+
+        struct Readback_Slot {
+            VkBuffer buffer = VK_NULL_HANDLE;
+            Memory_Allocation memory{};
+            Slot_State state = Slot_State::free;
+            uint64_t frame_number = 0;
+            VkFence fence = VK_NULL_HANDLE;
+        };
+
+        Device &device;
+        VkExtent2D extent;
+        VkFormat format;
+        VkDeviceSize frame_size;
+        bool host_cached = false;
+
+        // state is guarded by mutex, buffers and fences are only touched by the recording thread
+        std::vector<Readback_Slot> slots;
+        uint32_t next_slot = 0;
+        // submitted slots in submit order, so frames reach the sinks in order
+        std::deque<uint32_t> in_flight;
+
+        std::vector<std::unique_ptr<FrameSink>> sinks;
+
+        std::mutex mutex;
+        std::condition_variable work_ready;
+        std::condition_variable slot_released;
+        std::deque<uint32_t> write_queue;
+        std::thread worker;
+        bool stopping = false;
+        std::exception_ptr error;
+
+        uint64_t frames_written = 0;
+        uint64_t stall_count = 0;
+        std::chrono::steady_clock::time_point first_handover{};
+        std::chrono::steady_clock::time_point last_write{};
+
+        void create_buffers(uint32_t ring_size);
+        void worker_loop();
+        // checks every submitted fence, then moves the finished frames at the front to the worker
+        void hand_over_finished(bool wait);
+        void rethrow_worker_error();
+
+    public:
+        // format has to be one the sinks understand, see readback_bytes_per_pixel
+        FrameReadback(Device &device, VkExtent2D extent, VkFormat format, const Frame_Readback_Config &config = Frame_Readback_Config{});
+        // the GPU must be done with every recorded copy
+        ~FrameReadback();
+
+        FrameReadback(const FrameReadback &) = delete;
+        FrameReadback &operator = (const FrameReadback &) = delete;
+
+        // before the first frame, sinks are called in the order they were added
+        void add_sink(std::unique_ptr<FrameSink> sink);
+
+        // records the copy of an image in TRANSFER_SRC_OPTIMAL into the next ring buffer, returns
+        // the slot for submitted(), blocks only when the whole ring is busy
+        uint32_t record_copy(VkCommandBuffer command_buffer, VkImage image, uint64_t frame_number);
+        // the fence of the submit holding the copy, poll() has to see it signaled before it is reset
+        void submitted(uint32_t slot, VkFence fence);
+        // never blocks, call it once a frame after waiting for the frame slot's fence
+        void poll();
+        // waits until every submitted frame has reached the sinks
+        void flush();
+
+        uint64_t frame_count();
+        void print_stats(std::ostream &out);
+    };
+
+} // namespace graph_vulkan
+
+
+#endif // PIXEL_ENGINE_GRAPHIC_VULKAN_FRAME_READBACK_H
@@ -0,0 +1,256 @@
+/**
+ * library_support/Graphic/vulkan/readback
+ *
+ **/
+
+// match hpp file
+#include "frame_sink.hpp"
+//standard libraries
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+namespace graph_vulkan{
+    namespace {
+        const std::array<uint32_t, 256> &crc_table() {
+            static const std::array<uint32_t, 256> table = []{
+                std::array<uint32_t, 256> result{};
+                for (uint32_t i = 0; i < 256; i++) {
+                    uint32_t crc = i;
+                    for (int bit = 0; bit < 8; bit++) {
+                        crc = (crc & 1) ? 0xedb88320u ^ (crc >> 1) : crc >> 1;
+                    }
+                    result[i] = crc;
+                }
+                return result;
+            }();
+            return table;
+        }
+
+        uint32_t crc32(uint32_t crc, const unsigned char *data, size_t size) {
+            const auto &table = crc_table();
+            crc = ~crc;
+            for (size_t i = 0; i < size; i++) {
+                crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+            }
+            return ~crc;
+        }
+
+        void put_u32_be(std::vector<unsigned char> &out, uint32_t value) {
+            out.push_back(static_cast<unsigned char>(value >> 24));
+            out.push_back(static_cast<unsigned char>(value >> 16));
+            out.push_back(static_cast<unsigned char>(value >> 8));
+            out.push_back(static_cast<unsigned char>(value));
+        }
+
+        // reserves the length, appends the type, returns where the chunk data starts
+        size_t begin_chunk(std::vector<unsigned char> &out, const char *type) {
+            put_u32_be(out, 0);
+            out.insert(out.end(), type, type + 4);
+            return out.size();
+        }
+
+        void end_chunk(std::vector<unsigned char> &out, size_t data_start) {
+            uint32_t length = static_cast<uint32_t>(out.size() - data_start);
+            out[data_start - 8] = static_cast<unsigned char>(length >> 24);
+            out[data_start - 7] = static_cast<unsigned char>(length >> 16);
+            out[data_start - 6] = static_cast<unsigned char>(length >> 8);
+            out[data_start - 5] = static_cast<unsigned char>(length);
+            // the crc covers the type and the data
+            put_u32_be(out, crc32(0, out.data() + data_start - 4, length + 4));
+        }
+
+        bool is_bgra(VkFormat format) {
+            return format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB;
+        }
+
+        std::string replace_all(std::string text, const std::string &from, const std::string &to) {
+            size_t position = 0;
+            while ((position = text.find(from, position)) != std::string::npos) {
+                text.replace(position, from.size(), to);
+                position += to.size();
+            }
+            return text;
+        }
+    } // namespace
+
+    uint32_t readback_bytes_per_pixel(VkFormat format) {
+        switch (format) {
+            case VK_FORMAT_R8G8B8A8_UNORM:
+            case VK_FORMAT_R8G8B8A8_SRGB:
+            case VK_FORMAT_B8G8R8A8_UNORM:
+            case VK_FORMAT_B8G8R8A8_SRGB:
+                return 4;
+            default:
+                return 0;
+        }
+    }
+
+    std::unique_ptr<FrameSink> create_frame_sink(const std::string &spec) {
+        size_t separator = spec.find(':');
+        if (separator == std::string::npos || separator + 1 == spec.size()) {
+            throw std::runtime_error("Frame output must look like raw:<file>, png:<directory> or pipe:<command>, got: " + spec);
+        }
+        std::string kind = spec.substr(0, separator);
+        std::string target = spec.substr(separator + 1);
+
+        if (kind == "raw") return std::make_unique<RawFileSink>(target);
+        if (kind == "png") return std::make_unique<PngSink>(target);
+        if (kind == "pipe") return std::make_unique<PipeSink>(target);
+        throw std::runtime_error("Unknown frame output: " + kind);
+    }
+
+    RawFileSink::RawFileSink(std::string path) : path{std::move(path)} {
+        file.open(this->path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("Failed to open frame output file: " + this->path);
+        }
+    }
+
+    void RawFileSink::write(const Readback_Frame &frame) {
+        file.write(reinterpret_cast<const char *>(frame.pixels), static_cast<std::streamsize>(frame.size));
+        if (!file) {
+            throw std::runtime_error("Failed to write frame to: " + path);
+        }
+    }
+
+    void RawFileSink::finish() {
+        file.flush();
+    }
+
+    PngSink::PngSink(std::string directory) : directory{std::move(directory)} {
+        std::error_code error;
+        std::filesystem::create_directories(this->directory, error);
+        if (error) {
+            throw std::runtime_error("Failed to create frame output directory: " + this->directory);
+        }
+    }
+
+    void PngSink::encode(const Readback_Frame &frame) {
+        uint32_t bytes_per_pixel = readback_bytes_per_pixel(frame.format);
+        if (bytes_per_pixel != 4) {
+            throw std::runtime_error("PNG output only supports 8 bit RGBA and BGRA frames.");
+        }
+        size_t row_size = static_cast<size_t>(frame.width) * bytes_per_pixel;
+        // one filter byte in front of every row
+        size_t raw_size = (row_size + 1) * frame.height;
+        size_t block_count = raw_size / 0xffff + 1;
+
+        encoded.clear();
+        encoded.reserve(raw_size + block_count * 5 + 128);
+        static const unsigned char signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+        encoded.insert(encoded.end(), signature, signature + sizeof(signature));
+
+        size_t chunk = begin_chunk(encoded, "IHDR");
+        put_u32_be(encoded, frame.width);
+        put_u32_be(encoded, frame.height);
+        // 8 bit, RGBA, deflate, adaptive filtering, no interlace
+        encoded.insert(encoded.end(), {8, 6, 0, 0, 0});
+        end_chunk(encoded, chunk);
+
+        chunk = begin_chunk(encoded, "IDAT");
+        // zlib header, 32k window, no compression
+        encoded.push_back(0x78);
+        encoded.push_back(0x01);
+
+        // filtered rows first, then cut into stored blocks, which are at most 64k each
+        bool swizzle = is_bgra(frame.format);
+        scanlines.resize(raw_size);
+        for (uint32_t y = 0; y < frame.height; y++) {
+            unsigned char *out = scanlines.data() + y * (row_size + 1);
+            const unsigned char *row = frame.pixels + y * row_size;
+            *out++ = 0;
+            if (!swizzle) {
+                std::memcpy(out, row, row_size);
+                continue;
+            }
+            for (uint32_t x = 0; x < frame.width; x++, out += 4, row += 4) {
+                out[0] = row[2];
+                out[1] = row[1];
+                out[2] = row[0];
+                out[3] = row[3];
+            }
+        }
+
+        for (size_t offset = 0; offset < raw_size; offset += 0xffff) {
+            uint16_t length = static_cast<uint16_t>(std::min<size_t>(raw_size - offset, 0xffff));
+            // final flag, then length and its complement, little endian
+            encoded.push_back(offset + length >= raw_size ? 1 : 0);
+            encoded.push_back(static_cast<unsigned char>(length));
+            encoded.push_back(static_cast<unsigned char>(length >> 8));
+            encoded.push_back(static_cast<unsigned char>(~length));
+            encoded.push_back(static_cast<unsigned char>(~length >> 8));
+            encoded.insert(encoded.end(), scanlines.begin() + offset, scanlines.begin() + offset + length);
+        }
+
+        // adler32, the modulo is only needed every 5552 bytes before the sums can overflow
+        uint32_t adler_a = 1;
+        uint32_t adler_b = 0;
+        for (size_t offset = 0; offset < raw_size; offset += 5552) {
+            size_t end = std::min<size_t>(raw_size, offset + 5552);
+            for (size_t i = offset; i < end; i++) {
+                adler_a += scanlines[i];
+                adler_b += adler_a;
+            }
+            adler_a %= 65521;
+            adler_b %= 65521;
+        }
+        put_u32_be(encoded, (adler_b << 16) | adler_a);
+        end_chunk(encoded, chunk);
+
+        chunk = begin_chunk(encoded, "IEND");
+        end_chunk(encoded, chunk);
+    }
+
+    void PngSink::write(const Readback_Frame &frame) {
+        encode(frame);
+
+        std::string number = std::to_string(frame.frame_number);
+        if (number.size() < 6) number.insert(0, 6 - number.size(), '0');
+        std::string path = (std::filesystem::path(directory) / ("frame_" + number + ".png")).string();
+
+        std::ofstream file{path, std::ios::binary | std::ios::trunc};
+        file.write(reinterpret_cast<const char *>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+        if (!file) {
+            throw std::runtime_error("Failed to write frame to: " + path);
+        }
+    }
+
+    PipeSink::PipeSink(std::string command) : command{std::move(command)} {}
+
+    PipeSink::~PipeSink() {
+        finish();
+    }
+
+    void PipeSink::write(const Readback_Frame &frame) {
+        if (!pipe) {
+            std::string expanded = replace_all(command, "{width}", std::to_string(frame.width));
+            expanded = replace_all(expanded, "{height}", std::to_string(frame.height));
+#ifdef _WIN32
+            pipe = _popen(expanded.c_str(), "wb");
+#else
+            pipe = popen(expanded.c_str(), "w");
+#endif
+            if (!pipe) {
+                throw std::runtime_error("Failed to start frame encoder: " + expanded);
+            }
+        }
+
+        if (std::fwrite(frame.pixels, 1, frame.size, pipe) != frame.size) {
+            throw std::runtime_error("Frame encoder stopped reading: " + command);
+        }
+    }
+
+    void PipeSink::finish() {
+        if (!pipe) return;
+#ifdef _WIN32
+        _pclose(pipe);
+#else
+        pclose(pipe);
+#endif
+        pipe = nullptr;
+    }
+
+} // namespace graph_vulkan
@@ -0,0 +1,108 @@
+/**
+ * library_support/Graphic/vulkan/readback
+ *
+ * Destinations for frames copied back from the GPU
+ *
+ * Sinks are called on the readback worker thread, one frame at a time and in
+ * frame order, so they need no locking of their own. The pixels are only valid
+ * during the call, a sink that keeps them has to copy.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_GRAPHIC_VULKAN_FRAME_SINK_H
+#define PIXEL_ENGINE_GRAPHIC_VULKAN_FRAME_SINK_H
+
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace graph_vulkan{
+    struct Readback_Frame {
+        uint64_t frame_number = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        // tightly packed rows, width * bytes per pixel
+        const unsigned char *pixels = nullptr;
+        size_t size = 0;
+    };
+
+    class FrameSink {
+    public:
+        virtual ~FrameSink() = default;
+
+        virtual void write(const Readback_Frame &frame) = 0;
+        // called once after the last frame
+        virtual void finish() {}
+        virtual std::string name() const = 0;
+    };
+
+    // every frame appended to one file as it is in memory
+    class RawFileSink : public FrameSink {
+    private:
+        std::string path;
+        std::ofstream file;
+
+    public:
+        explicit RawFileSink(std::string path);
+
+        void write(const Readback_Frame &frame) override;
+        void finish() override;
+        std::string name() const override { return "raw " + path; }
+    };
+
+    // one png per frame, <directory>/frame_<number>.png, deflate is stored only since the
+    // point is getting frames out fast, not small
+    class PngSink : public FrameSink {
+    private:
+        std::string directory;
+        // kept between frames so every frame after the first reuses the memory
+        std::vector<unsigned char> scanlines;
+        std::vector<unsigned char> encoded;
+
+        void encode(const Readback_Frame &frame);
+
+    public:
+        explicit PngSink(std::string directory);
+
+        void write(const Readback_Frame &frame) override;
+        std::string name() const override { return "png " + directory; }
+    };
+
+    // raw frames written to the stdin of an external encoder, {width} and {height} in the
+    // command are replaced once the first frame arrives, e.g.
+    // ffmpeg -f rawvideo -pix_fmt rgba -s {width}x{height} -i - out.mp4
+    class PipeSink : public FrameSink {
+    private:
+        std::string command;
+        FILE *pipe = nullptr;
+
+    public:
+        explicit PipeSink(std::string command);
+        ~PipeSink() override;
+
+        PipeSink(const PipeSink &) = delete;
+        PipeSink &operator = (const PipeSink &) = delete;
+
+        void write(const Readback_Frame &frame) override;
+        void finish() override;
+        std::string name() const override { return "pipe " + command; }
+    };
+
+    // raw:<file>, png:<directory> or pipe:<command>
+    std::unique_ptr<FrameSink> create_frame_sink(const std::string &spec);
+
+    // 0 for formats the sinks do not understand
+    uint32_t readback_bytes_per_pixel(VkFormat format);
+
+} // namespace graph_vulkan
+
+
+#endif // PIXEL_ENGINE_GRAPHIC_VULKAN_FRAME_SINK_H
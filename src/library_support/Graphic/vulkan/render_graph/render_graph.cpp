@@ -0,0 +1,713 @@
+/**
+ * library_support/Graphic/vulkan/render_graph
+ *
+ **/
+
+// match hpp file
+#include "render_graph.hpp"
+//standard libraries
+#include <algorithm>
+#include <iomanip>
+#include <numeric>
+#include <stdexcept>
+
+namespace graph_vulkan{
+    namespace {
+        constexpr VkAccessFlags WRITE_ACCESS =
+                VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                VK_ACCESS_SHADER_WRITE_BIT |
+                VK_ACCESS_TRANSFER_WRITE_BIT;
+
+        struct Access_Info {
+            VkPipelineStageFlags stages;
+            VkAccessFlags access;
+            VkImageLayout layout;
+            VkImageUsageFlags usage;
+            bool write;
+        };
+
+        Access_Info access_info(Image_Access access, Pass_Type type) {
+            const VkPipelineStageFlags shader_stages = type == Pass_Type::compute
+                    ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+                    : VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            const VkPipelineStageFlags depth_stages =
+                    VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+            switch (access) {
+                case Image_Access::color_attachment:
+                    return {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                            VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                            VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, true};
+                case Image_Access::depth_attachment:
+                    return {depth_stages,
+                            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, true};
+                case Image_Access::depth_read:
+                    return {depth_stages, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+                            VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, false};
+                case Image_Access::sampled:
+                    return {shader_stages, VK_ACCESS_SHADER_READ_BIT,
+                            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT, false};
+                case Image_Access::storage_read:
+                    return {shader_stages, VK_ACCESS_SHADER_READ_BIT,
+                            VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, false};
+                case Image_Access::storage_write:
+                    return {shader_stages, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                            VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, true};
+                case Image_Access::transfer_src:
+                    return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+                            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, false};
+                case Image_Access::transfer_dst:
+                    return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT, true};
+            }
+            throw std::runtime_error("Unknown image access.");
+        }
+
+        bool is_attachment(Image_Access access) {
+            return access == Image_Access::color_attachment ||
+                   access == Image_Access::depth_attachment ||
+                   access == Image_Access::depth_read;
+        }
+
+        // the old contents are thrown away, whatever wrote them before is dead
+        bool discards(Image_Access access, Attachment_Load load) {
+            return (access == Image_Access::color_attachment || access == Image_Access::depth_attachment) &&
+                   load != Attachment_Load::load;
+        }
+
+        bool reads(Image_Access access, Attachment_Load load) {
+            return !access_info(access, Pass_Type::graphics).write ||
+                   access == Image_Access::storage_write ||
+                   (is_attachment(access) && load == Attachment_Load::load);
+        }
+
+        VkImageAspectFlags aspect_of(VkFormat format) {
+            switch (format) {
+                case VK_FORMAT_D16_UNORM:
+                case VK_FORMAT_X8_D24_UNORM_PACK32:
+                case VK_FORMAT_D32_SFLOAT:
+                    return VK_IMAGE_ASPECT_DEPTH_BIT;
+                case VK_FORMAT_D16_UNORM_S8_UINT:
+                case VK_FORMAT_D24_UNORM_S8_UINT:
+                case VK_FORMAT_D32_SFLOAT_S8_UINT:
+                    return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+                default:
+                    return VK_IMAGE_ASPECT_COLOR_BIT;
+            }
+        }
+
+        double to_mib(VkDeviceSize bytes) {
+            return static_cast<double>(bytes) / (1024.0 * 1024.0);
+        }
+    } // namespace
+
+    void Pass_Builder::use(Graph_Resource image, Image_Access access, Attachment_Load load, VkClearValue clear) {
+        if (image >= graph.images.size()) {
+            throw std::runtime_error("Render graph pass " + graph.passes[pass].name + " uses an unknown image.");
+        }
+        graph.passes[pass].uses.push_back({image, access, load, clear});
+    }
+
+    void Pass_Builder::write_color(Graph_Resource image, Attachment_Load load, VkClearColorValue clear) {
+        VkClearValue value{};
+        value.color = clear;
+        use(image, Image_Access::color_attachment, load, value);
+    }
+
+    void Pass_Builder::write_depth(Graph_Resource image, Attachment_Load load, VkClearDepthStencilValue clear) {
+        VkClearValue value{};
+        value.depthStencil = clear;
+        use(image, Image_Access::depth_attachment, load, value);
+    }
+
+    void Pass_Builder::read_depth(Graph_Resource image) { use(image, Image_Access::depth_read); }
+    void Pass_Builder::sample(Graph_Resource image) { use(image, Image_Access::sampled); }
+    void Pass_Builder::read_storage(Graph_Resource image) { use(image, Image_Access::storage_read); }
+    void Pass_Builder::write_storage(Graph_Resource image) { use(image, Image_Access::storage_write); }
+    void Pass_Builder::copy_from(Graph_Resource image) { use(image, Image_Access::transfer_src); }
+    void Pass_Builder::copy_to(Graph_Resource image) { use(image, Image_Access::transfer_dst); }
+    void Pass_Builder::set_side_effect() { graph.passes[pass].side_effect = true; }
+
+    RenderGraph::RenderGraph(Device &device) : device{device} {}
+
+    RenderGraph::~RenderGraph() {
+        DeletionQueue &deletion_queue = device.deletion_queue();
+        for (auto &pass : passes) {
+            for (auto &framebuffer : pass.framebuffers) {
+                deletion_queue.push_framebuffer(framebuffer.second);
+            }
+            if (pass.render_pass != VK_NULL_HANDLE) {
+                VkDevice vk_device = device.device();
+                VkRenderPass render_pass = pass.render_pass;
+                deletion_queue.push_function([vk_device, render_pass]{
+                    vkDestroyRenderPass(vk_device, render_pass, nullptr);
+                });
+            }
+        }
+        for (auto &image : images) {
+            if (image.imported || image.image == VK_NULL_HANDLE) continue;
+            deletion_queue.push_image_view(image.view);
+            // the memory belongs to the alias group
+            Memory_Allocation no_memory{};
+            deletion_queue.push_image(image.image, no_memory);
+        }
+        for (auto &group : alias_groups) {
+            deletion_queue.push_memory(group.memory);
+        }
+    }
+
+    Graph_Resource RenderGraph::create_image(const std::string &name, const Graph_Image_Info &info) {
+        if (compiled) {
+            throw std::runtime_error("Render graph images cannot be added once it is compiled.");
+        }
+        Graph_Image image{};
+        image.name = name;
+        image.info = info;
+        image.aspect = aspect_of(info.format);
+        images.push_back(image);
+        return static_cast<Graph_Resource>(images.size() - 1);
+    }
+
+    Graph_Resource RenderGraph::import_image(
+            const std::string &name,
+            const Graph_Image_Info &info,
+            VkImageLayout initial_layout,
+            VkImageLayout final_layout,
+            VkPipelineStageFlags initial_stages
+            ) {
+        Graph_Resource id = create_image(name, info);
+        Graph_Image &image = images[id];
+        image.imported = true;
+        image.initial_layout = initial_layout;
+        image.final_layout = final_layout;
+        image.initial_stages = initial_stages;
+        return id;
+    }
+
+    void RenderGraph::add_pass(
+            const std::string &name,
+            Pass_Type type,
+            const std::function<void(Pass_Builder &builder)> &setup,
+            Pass_Execute execute
+            ) {
+        if (compiled) {
+            throw std::runtime_error("Render graph passes cannot be added once it is compiled.");
+        }
+        Graph_Pass pass{};
+        pass.name = name;
+        pass.type = type;
+        pass.execute = std::move(execute);
+        passes.push_back(std::move(pass));
+
+        Pass_Builder builder{*this, static_cast<uint32_t>(passes.size() - 1)};
+        setup(builder);
+    }
+
+    void RenderGraph::set_imported_image(Graph_Resource image, VkImage handle, VkImageView view) {
+        if (!images.at(image).imported) {
+            throw std::runtime_error("Render graph image " + images[image].name + " is not imported.");
+        }
+        images[image].image = handle;
+        images[image].view = view;
+    }
+
+    void RenderGraph::cull_passes() {
+        // walk backwards, a pass lives when a live pass after it reads what it writes
+        std::vector<bool> needed(images.size(), false);
+        for (uint32_t i = static_cast<uint32_t>(passes.size()); i-- > 0;) {
+            Graph_Pass &pass = passes[i];
+            bool live = pass.side_effect;
+            for (const auto &use : pass.uses) {
+                if (!access_info(use.access, pass.type).write) continue;
+                if (images[use.image].imported || needed[use.image]) live = true;
+            }
+            pass.culled = !live;
+            if (!live) continue;
+
+            for (const auto &use : pass.uses) {
+                if (discards(use.access, use.load)) needed[use.image] = false;
+            }
+            for (const auto &use : pass.uses) {
+                if (reads(use.access, use.load)) needed[use.image] = true;
+            }
+        }
+    }
+
+    bool RenderGraph::used_after(Graph_Resource image, uint32_t pass_index) const {
+        if (images[image].imported) return true;
+        for (uint32_t i = pass_index + 1; i < passes.size(); i++) {
+            if (passes[i].culled) continue;
+            for (const auto &use : passes[i].uses) {
+                if (use.image == image) return true;
+            }
+        }
+        return false;
+    }
+
+    void RenderGraph::compile() {
+        if (compiled) {
+            throw std::runtime_error("Render graph is already compiled.");
+        }
+
+        for (auto &pass : passes) {
+            for (size_t a = 0; a < pass.uses.size(); a++) {
+                const Image_Use &use = pass.uses[a];
+                if (is_attachment(use.access) && pass.type != Pass_Type::graphics) {
+                    throw std::runtime_error("Render graph pass " + pass.name + " is not a graphics pass but has attachments.");
+                }
+                for (size_t b = a + 1; b < pass.uses.size(); b++) {
+                    if (pass.uses[b].image == use.image &&
+                        access_info(pass.uses[b].access, pass.type).layout != access_info(use.access, pass.type).layout) {
+                        throw std::runtime_error("Render graph pass " + pass.name + " uses " + images[use.image].name +
+                                                 " in two layouts.");
+                    }
+                }
+            }
+        }
+
+        cull_passes();
+
+        for (uint32_t i = 0; i < passes.size(); i++) {
+            if (passes[i].culled) continue;
+            for (const auto &use : passes[i].uses) {
+                Graph_Image &image = images[use.image];
+                image.info.usage |= access_info(use.access, passes[i].type).usage;
+                if (image.imported) continue;
+                // a first storage write starts from undefined contents like a cleared attachment,
+                // that is how compute passes produce transients
+                if (image.first_pass == UINT32_MAX && reads(use.access, use.load) &&
+                    use.access != Image_Access::storage_write) {
+                    // aliased memory holds whatever the previous image left there
+                    throw std::runtime_error("Render graph image " + image.name + " is read before anything writes it.");
+                }
+                image.first_pass = std::min(image.first_pass, i);
+                image.last_pass = std::max(image.last_pass, i);
+            }
+        }
+
+        allocate_transients();
+        for (uint32_t i = 0; i < passes.size(); i++) {
+            if (!passes[i].culled && passes[i].type == Pass_Type::graphics) create_render_pass(i);
+        }
+
+        stats.pass_count = static_cast<uint32_t>(passes.size());
+        stats.culled_pass_count = static_cast<uint32_t>(std::count_if(passes.begin(), passes.end(), [](const Graph_Pass &pass) {
+            return pass.culled;
+        }));
+        compiled = true;
+    }
+
+    void RenderGraph::allocate_transients() {
+        std::vector<Graph_Resource> transients;
+        for (Graph_Resource id = 0; id < images.size(); id++) {
+            Graph_Image &image = images[id];
+            if (image.imported || image.first_pass == UINT32_MAX) continue;
+
+            VkImageUsageFlags usage = image.info.usage;
+            // attachments only, a tiler can keep them in tile memory
+            constexpr VkImageUsageFlags attachment_usage =
+                    VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+            if ((usage & ~attachment_usage) == 0) usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+
+            VkImageCreateInfo image_info{};
+            image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            image_info.imageType = VK_IMAGE_TYPE_2D;
+            image_info.format = image.info.format;
+            image_info.extent = {image.info.extent.width, image.info.extent.height, 1};
+            image_info.mipLevels = 1;
+            image_info.arrayLayers = 1;
+            image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+            image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+            image_info.usage = usage;
+            image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            if (vkCreateImage(device.device(), &image_info, nullptr, &image.image) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create render graph image " + image.name + ".");
+            }
+            vkGetImageMemoryRequirements(device.device(), image.image, &image.requirements);
+            transients.push_back(id);
+        }
+
+        // biggest first, the smaller ones then fit into the gaps of the big ones
+        std::stable_sort(transients.begin(), transients.end(), [this](Graph_Resource a, Graph_Resource b) {
+            return images[a].requirements.size > images[b].requirements.size;
+        });
+        for (Graph_Resource id : transients) {
+            Graph_Image &image = images[id];
+            for (uint32_t g = 0; g < alias_groups.size() && image.alias_group == NO_GROUP; g++) {
+                Alias_Group &group = alias_groups[g];
+                if ((group.requirements.memoryTypeBits & image.requirements.memoryTypeBits) == 0) continue;
+                bool overlaps = std::any_of(group.images.begin(), group.images.end(), [&](Graph_Resource other) {
+                    return images[other].first_pass <= image.last_pass && image.first_pass <= images[other].last_pass;
+                });
+                if (!overlaps) image.alias_group = g;
+            }
+            if (image.alias_group == NO_GROUP) {
+                alias_groups.emplace_back();
+                alias_groups.back().requirements.memoryTypeBits = image.requirements.memoryTypeBits;
+                image.alias_group = static_cast<uint32_t>(alias_groups.size() - 1);
+            }
+
+            Alias_Group &group = alias_groups[image.alias_group];
+            group.images.push_back(id);
+            group.requirements.size = std::max(group.requirements.size, image.requirements.size);
+            group.requirements.alignment = std::max(group.requirements.alignment, image.requirements.alignment);
+            group.requirements.memoryTypeBits &= image.requirements.memoryTypeBits;
+            stats.transient_bytes += image.requirements.size;
+        }
+
+        for (auto &group : alias_groups) {
+            group.memory = device.allocator().allocate(group.requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, Allocation_Kind::optimal);
+            stats.allocated_bytes += group.requirements.size;
+            for (Graph_Resource id : group.images) {
+                Graph_Image &image = images[id];
+                if (vkBindImageMemory(device.device(), image.image, group.memory.memory, group.memory.offset) != VK_SUCCESS) {
+                    throw std::runtime_error("Failed to bind render graph image " + image.name + ".");
+                }
+
+                VkImageViewCreateInfo view_info{};
+                view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+                view_info.image = image.image;
+                view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+                view_info.format = image.info.format;
+                view_info.subresourceRange.aspectMask = image.aspect;
+                view_info.subresourceRange.levelCount = 1;
+                view_info.subresourceRange.layerCount = 1;
+                if (vkCreateImageView(device.device(), &view_info, nullptr, &image.view) != VK_SUCCESS) {
+                    throw std::runtime_error("Failed to create render graph image view " + image.name + ".");
+                }
+            }
+        }
+        stats.transient_image_count = static_cast<uint32_t>(transients.size());
+        stats.alias_group_count = static_cast<uint32_t>(alias_groups.size());
+    }
+
+    void RenderGraph::create_render_pass(uint32_t pass_index) {
+        Graph_Pass &pass = passes[pass_index];
+        std::vector<VkAttachmentDescription> attachments;
+        std::vector<VkAttachmentReference> color_references;
+        VkAttachmentReference depth_reference{};
+        bool has_depth = false;
+
+        for (const auto &use : pass.uses) {
+            if (!is_attachment(use.access)) continue;
+            const Graph_Image &image = images[use.image];
+            if (pass.attachments.empty()) {
+                pass.extent = image.info.extent;
+            } else if (image.info.extent.width != pass.extent.width || image.info.extent.height != pass.extent.height) {
+                throw std::runtime_error("Render graph pass " + pass.name + " has attachments of different sizes.");
+            }
+
+            VkImageLayout layout = access_info(use.access, pass.type).layout;
+            VkAttachmentDescription attachment{};
+            attachment.format = image.info.format;
+            attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+            attachment.loadOp = use.load == Attachment_Load::clear ? VK_ATTACHMENT_LOAD_OP_CLEAR
+                    : use.load == Attachment_Load::load ? VK_ATTACHMENT_LOAD_OP_LOAD
+                    : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            // nobody reads it afterwards, a tiler does not have to write it out
+            attachment.storeOp = used_after(use.image, pass_index) ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachment.stencilLoadOp = (image.aspect & VK_IMAGE_ASPECT_STENCIL_BIT) ? attachment.loadOp : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachment.stencilStoreOp = (image.aspect & VK_IMAGE_ASPECT_STENCIL_BIT) ? attachment.storeOp : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            // the graph transitions before the pass, the render pass itself never changes a layout
+            attachment.initialLayout = layout;
+            attachment.finalLayout = layout;
+
+            VkAttachmentReference reference{static_cast<uint32_t>(attachments.size()), layout};
+            if (use.access == Image_Access::color_attachment) {
+                color_references.push_back(reference);
+            } else {
+                if (has_depth) {
+                    throw std::runtime_error("Render graph pass " + pass.name + " has two depth attachments.");
+                }
+                depth_reference = reference;
+                has_depth = true;
+            }
+            attachments.push_back(attachment);
+            pass.attachments.push_back(use.image);
+            pass.clear_values.push_back(use.clear);
+        }
+        if (attachments.empty()) return;
+
+        VkSubpassDescription subpass{};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = static_cast<uint32_t>(color_references.size());
+        subpass.pColorAttachments = color_references.data();
+        subpass.pDepthStencilAttachment = has_depth ? &depth_reference : nullptr;
+
+        VkRenderPassCreateInfo render_pass_info{};
+        render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        render_pass_info.attachmentCount = static_cast<uint32_t>(attachments.size());
+        render_pass_info.pAttachments = attachments.data();
+        render_pass_info.subpassCount = 1;
+        render_pass_info.pSubpasses = &subpass;
+        if (vkCreateRenderPass(device.device(), &render_pass_info, nullptr, &pass.render_pass) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create render pass for render graph pass " + pass.name + ".");
+        }
+    }
+
+    VkFramebuffer RenderGraph::get_framebuffer(Graph_Pass &pass) {
+        std::vector<VkImageView> views;
+        views.reserve(pass.attachments.size());
+        for (Graph_Resource id : pass.attachments) {
+            if (images[id].view == VK_NULL_HANDLE) {
+                throw std::runtime_error("Render graph image " + images[id].name + " has no image set.");
+            }
+            views.push_back(images[id].view);
+        }
+
+        // one per swap chain image at most, imported views come around again
+        auto found = pass.framebuffers.find(views);
+        if (found != pass.framebuffers.end()) return found->second;
+
+        VkFramebufferCreateInfo framebuffer_info{};
+        framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebuffer_info.renderPass = pass.render_pass;
+        framebuffer_info.attachmentCount = static_cast<uint32_t>(views.size());
+        framebuffer_info.pAttachments = views.data();
+        framebuffer_info.width = pass.extent.width;
+        framebuffer_info.height = pass.extent.height;
+        framebuffer_info.layers = 1;
+
+        VkFramebuffer framebuffer;
+        if (vkCreateFramebuffer(device.device(), &framebuffer_info, nullptr, &framebuffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create framebuffer for render graph pass " + pass.name + ".");
+        }
+        pass.framebuffers.emplace(std::move(views), framebuffer);
+        return framebuffer;
+    }
+
+    void RenderGraph::record_barriers(VkCommandBuffer command_buffer, const Graph_Pass &pass) {
+        std::vector<VkImageMemoryBarrier> barriers;
+        VkPipelineStageFlags src_stages = 0;
+        VkPipelineStageFlags dst_stages = 0;
+        bool dependency = false;
+
+        for (const auto &use : pass.uses) {
+            Graph_Image &image = images[use.image];
+            Image_State &state = image.state;
+            const Access_Info next = access_info(use.access, pass.type);
+            stats.image_accesses++;
+
+            bool layout_change = state.layout != next.layout;
+            VkPipelineStageFlags wait_stages = 0;
+            VkAccessFlags src_access = 0;
+            bool memory_barrier = false;
+            if (layout_change || next.write) {
+                // everything since the last write has to be done, a transition or write would race it
+                wait_stages = state.write_stages | state.read_stages;
+                src_access = state.write_access;
+                memory_barrier = layout_change || (state.write_access != 0 && state.read_stages == 0);
+            } else if ((next.stages & ~state.visible_stages) != 0) {
+                // first read in these stages, chain on to where the data is visible already
+                wait_stages = state.write_stages | state.visible_stages;
+                src_access = state.write_access;
+                memory_barrier = true;
+            } else {
+                // read after read
+                state.read_stages |= next.stages;
+                continue;
+            }
+
+            if (memory_barrier) {
+                VkImageMemoryBarrier barrier{};
+                barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                barrier.oldLayout = discards(use.access, use.load) ? VK_IMAGE_LAYOUT_UNDEFINED : state.layout;
+                barrier.newLayout = next.layout;
+                barrier.srcAccessMask = src_access;
+                barrier.dstAccessMask = next.access;
+                barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.image = image.image;
+                barrier.subresourceRange.aspectMask = image.aspect;
+                barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+                barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+                barriers.push_back(barrier);
+                stats.image_barriers++;
+                if (layout_change) stats.layout_transitions++;
+            }
+            src_stages |= wait_stages;
+            dst_stages |= next.stages;
+            dependency = true;
+
+            if (next.write) {
+                state = Image_State{next.layout, next.stages, next.access & WRITE_ACCESS, 0, next.stages};
+            } else if (layout_change) {
+                // the transition is the last write now, visible to this read
+                state = Image_State{next.layout, 0, 0, next.stages, next.stages};
+            } else {
+                state.read_stages |= next.stages;
+                state.visible_stages |= next.stages;
+            }
+            if (image.alias_group != NO_GROUP) {
+                alias_groups[image.alias_group].stages = state.write_stages | state.read_stages;
+                alias_groups[image.alias_group].write_access = state.write_access;
+            }
+        }
+        // the read stages of read after read are only tracked, carry them over to the memory as well
+        for (const auto &use : pass.uses) {
+            const Graph_Image &image = images[use.image];
+            if (image.alias_group == NO_GROUP) continue;
+            alias_groups[image.alias_group].stages |= image.state.read_stages;
+        }
+
+        if (!dependency) return;
+        vkCmdPipelineBarrier(
+                command_buffer,
+                src_stages != 0 ? src_stages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                dst_stages,
+                0,
+                0, nullptr,
+                0, nullptr,
+                static_cast<uint32_t>(barriers.size()), barriers.data()
+                );
+        stats.barrier_batches++;
+    }
+
+    void RenderGraph::record_final_transitions(VkCommandBuffer command_buffer) {
+        std::vector<VkImageMemoryBarrier> barriers;
+        VkPipelineStageFlags src_stages = 0;
+        VkPipelineStageFlags dst_stages = 0;
+        for (auto &image : images) {
+            if (!image.imported || image.final_layout == VK_IMAGE_LAYOUT_UNDEFINED) continue;
+            if (image.state.layout == image.final_layout) continue;
+
+            VkPipelineStageFlags next_stages;
+            VkAccessFlags next_access;
+            switch (image.final_layout) {
+                case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:
+                    // the present waits on a semaphore, that is all the ordering it needs
+                    next_stages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+                    next_access = 0;
+                    break;
+                case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+                    next_stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+                    next_access = VK_ACCESS_TRANSFER_READ_BIT;
+                    break;
+                case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+                    next_stages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+                    next_access = VK_ACCESS_SHADER_READ_BIT;
+                    break;
+                default:
+                    next_stages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+                    next_access = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+                    break;
+            }
+
+            VkImageMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.oldLayout = image.state.layout;
+            barrier.newLayout = image.final_layout;
+            barrier.srcAccessMask = image.state.write_access;
+            barrier.dstAccessMask = next_access;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = image.image;
+            barrier.subresourceRange.aspectMask = image.aspect;
+            barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+            barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+            barriers.push_back(barrier);
+            src_stages |= image.state.write_stages | image.state.read_stages;
+            dst_stages |= next_stages;
+            stats.image_barriers++;
+            stats.layout_transitions++;
+        }
+        if (barriers.empty()) return;
+
+        vkCmdPipelineBarrier(
+                command_buffer,
+                src_stages != 0 ? src_stages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                dst_stages,
+                0,
+                0, nullptr,
+                0, nullptr,
+                static_cast<uint32_t>(barriers.size()), barriers.data()
+                );
+        stats.barrier_batches++;
+    }
+
+    void RenderGraph::execute(VkCommandBuffer command_buffer) {
+        if (!compiled) {
+            throw std::runtime_error("Render graph has to be compiled before it is executed.");
+        }
+        stats.image_accesses = 0;
+        stats.image_barriers = 0;
+        stats.layout_transitions = 0;
+        stats.barrier_batches = 0;
+
+        for (auto &image : images) {
+            if (image.imported) {
+                if (image.image == VK_NULL_HANDLE) {
+                    throw std::runtime_error("Render graph image " + image.name + " has no image set.");
+                }
+                image.state = Image_State{image.initial_layout, image.initial_stages, 0, 0, 0};
+            } else if (image.alias_group != NO_GROUP) {
+                // undefined contents, but whoever had the memory last, in this frame or the one before, has to be done
+                const Alias_Group &group = alias_groups[image.alias_group];
+                image.state = Image_State{VK_IMAGE_LAYOUT_UNDEFINED, group.stages, group.write_access, 0, 0};
+            }
+        }
+
+        for (uint32_t i = 0; i < passes.size(); i++) {
+            Graph_Pass &pass = passes[i];
+            if (pass.culled) continue;
+
+            // the image that used the memory before this one is done with it by now
+            for (const auto &use : pass.uses) {
+                Graph_Image &image = images[use.image];
+                if (image.alias_group == NO_GROUP || image.first_pass != i || image.state.layout != VK_IMAGE_LAYOUT_UNDEFINED) continue;
+                const Alias_Group &group = alias_groups[image.alias_group];
+                image.state.write_stages = group.stages;
+                image.state.write_access = group.write_access;
+            }
+            record_barriers(command_buffer, pass);
+
+            Pass_Context context{command_buffer, pass.render_pass, pass.extent, *this};
+            if (pass.render_pass == VK_NULL_HANDLE) {
+                if (pass.execute) pass.execute(context);
+                continue;
+            }
+
+            VkRenderPassBeginInfo begin_info{};
+            begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            begin_info.renderPass = pass.render_pass;
+            begin_info.framebuffer = get_framebuffer(pass);
+            begin_info.renderArea.extent = pass.extent;
+            begin_info.clearValueCount = static_cast<uint32_t>(pass.clear_values.size());
+            begin_info.pClearValues = pass.clear_values.data();
+            vkCmdBeginRenderPass(command_buffer, &begin_info, VK_SUBPASS_CONTENTS_INLINE);
+            if (pass.execute) pass.execute(context);
+            vkCmdEndRenderPass(command_buffer);
+        }
+
+        record_final_transitions(command_buffer);
+    }
+
+    VkRenderPass RenderGraph::get_render_pass(const std::string &pass_name) const {
+        for (const auto &pass : passes) {
+            if (pass.name == pass_name) return pass.render_pass;
+        }
+        throw std::runtime_error("Render graph has no pass " + pass_name + ".");
+    }
+
+    bool RenderGraph::is_culled(const std::string &pass_name) const {
+        for (const auto &pass : passes) {
+            if (pass.name == pass_name) return pass.culled;
+        }
+        throw std::runtime_error("Render graph has no pass " + pass_name + ".");
+    }
+
+    void RenderGraph::print_stats(std::ostream &out) const {
+        out << "Render graph: " << stats.pass_count << " passes, " << stats.culled_pass_count << " culled" << std::endl;
+        out << "    barriers: " << stats.image_barriers << " image barriers (" << stats.layout_transitions
+            << " layout transitions) in " << stats.barrier_batches << " batches for "
+            << stats.image_accesses << " image accesses" << std::endl;
+        out << "    transient images: " << stats.transient_image_count << " in " << stats.alias_group_count
+            << " memory blocks, " << std::fixed << std::setprecision(1)
+            << to_mib(stats.transient_bytes) << " MiB -> " << to_mib(stats.allocated_bytes) << " MiB, saved "
+            << to_mib(stats.transient_bytes - stats.allocated_bytes) << " MiB" << std::defaultfloat << std::endl;
+    }
+
+} // namespace graph_vulkan
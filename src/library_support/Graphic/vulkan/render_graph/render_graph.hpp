@@ -0,0 +1,237 @@
+/**
+ * library_support/Graphic/vulkan/render_graph
+ *
+ * Frame render graph with automatic barriers and aliased transient images
+ *
+ * Passes are added in execution order and declare which images they read and
+ * write. compile() culls every pass whose results nobody uses, creates a
+ * render pass per graphics pass and allocates the transient images: images
+ * whose lifetimes do not overlap share the same memory. execute() records the
+ * passes, in front of each pass one vkCmdPipelineBarrier with exactly the
+ * layout transitions and dependencies the pass needs, read after read needs
+ * nothing.
+ *
+ * Imported images (the swap chain image, a readback target) are owned by
+ * somebody else, they can change every frame through set_imported_image() and
+ * are transitioned to their final layout at the end of the graph. The graph is
+ * compiled once and executed every frame, rebuild it when the extent changes.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_GRAPHIC_VULKAN_RENDER_GRAPH_H
+#define PIXEL_ENGINE_GRAPHIC_VULKAN_RENDER_GRAPH_H
+
+#pragma once
+
+#include "../device/device.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace graph_vulkan{
+    using Graph_Resource = uint32_t;
+
+    enum class Pass_Type {graphics, compute, transfer};
+    enum class Image_Access {
+        color_attachment,
+        depth_attachment,
+        depth_read,         // depth test without writes
+        sampled,
+        storage_read,
+        storage_write,
+        transfer_src,
+        transfer_dst
+    };
+    // what an attachment write starts from, anything but load lets the graph discard the old contents
+    enum class Attachment_Load {load, clear, dont_care};
+
+    struct Graph_Image_Info {
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkExtent2D extent{};
+        // on top of the usage the passes imply
+        VkImageUsageFlags usage = 0;
+    };
+
+    class RenderGraph;
+
+    struct Pass_Context {
+        VkCommandBuffer command_buffer;
+        // begun by the graph for graphics passes, null otherwise
+        VkRenderPass render_pass;
+        VkExtent2D extent;
+        const RenderGraph &graph;
+    };
+    using Pass_Execute = std::function<void(const Pass_Context &context)>;
+
+    struct Render_Graph_Stats {
+        uint32_t pass_count = 0;
+        uint32_t culled_pass_count = 0;
+        uint32_t transient_image_count = 0;
+        uint32_t alias_group_count = 0;
+        // what the transient images would take on their own and what they take aliased
+        VkDeviceSize transient_bytes = 0;
+        VkDeviceSize allocated_bytes = 0;
+
+        // last execute(): image accesses of the live passes, what a barrier per access would issue
+        uint32_t image_accesses = 0;
+        uint32_t image_barriers = 0;
+        uint32_t layout_transitions = 0;
+        // vkCmdPipelineBarrier calls
+        uint32_t barrier_batches = 0;
+    };
+
+    class Pass_Builder {
+    private:
+        RenderGraph &graph;
+        uint32_t pass;
+
+        void use(Graph_Resource image, Image_Access access, Attachment_Load load = Attachment_Load::load, VkClearValue clear = {});
+
+    public:
+        Pass_Builder(RenderGraph &graph, uint32_t pass) : graph{graph}, pass{pass} {}
+
+        // attachments are bound in the order they are written
+        void write_color(Graph_Resource image, Attachment_Load load = Attachment_Load::dont_care, VkClearColorValue clear = {});
+        void write_depth(Graph_Resource image, Attachment_Load load = Attachment_Load::clear, VkClearDepthStencilValue clear = {1.0f, 0});
+        void read_depth(Graph_Resource image);
+        void sample(Graph_Resource image);
+        void read_storage(Graph_Resource image);
+        // the first write of a transient image discards whatever the memory held before
+        void write_storage(Graph_Resource image);
+        void copy_from(Graph_Resource image);
+        void copy_to(Graph_Resource image);
+        // keeps the pass even when nothing reads what it writes
+        void set_side_effect();
+    };
+
+    class RenderGraph {
+    private:
+        friend class Pass_Builder;
+
+        static constexpr uint32_t NO_GROUP = UINT32_MAX;
+
+        struct Image_State {
+            VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            // the last write and the reads since, what the next write or transition waits for
+            VkPipelineStageFlags write_stages = 0;
+            VkAccessFlags write_access = 0;
+            VkPipelineStageFlags read_stages = 0;
+            // stages the last write or transition is visible to already
+            VkPipelineStageFlags visible_stages = 0;
+        };
+
+        struct Graph_Image {
+            std::string name;
+            Graph_Image_Info info;
+            VkImageAspectFlags aspect = 0;
+            VkImage image = VK_NULL_HANDLE;
+            VkImageView view = VK_NULL_HANDLE;
+
+            bool imported = false;
+            VkImageLayout initial_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            VkImageLayout final_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            VkPipelineStageFlags initial_stages = 0;
+
+            // transient images only, lifetime in live passes
+            uint32_t first_pass = UINT32_MAX;
+            uint32_t last_pass = 0;
+            VkMemoryRequirements requirements{};
+            uint32_t alias_group = NO_GROUP;
+
+            Image_State state;
+        };
+
+        struct Image_Use {
+            Graph_Resource image;
+            Image_Access access;
+            Attachment_Load load;
+            VkClearValue clear;
+        };
+
+        struct Graph_Pass {
+            std::string name;
+            Pass_Type type;
+            Pass_Execute execute;
+            std::vector<Image_Use> uses;
+            bool side_effect = false;
+            bool culled = false;
+
+            // graphics passes with attachments
+            VkRenderPass render_pass = VK_NULL_HANDLE;
+            VkExtent2D extent{};
+            std::vector<Graph_Resource> attachments;
+            std::vector<VkClearValue> clear_values;
+            std::map<std::vector<VkImageView>, VkFramebuffer> framebuffers;
+        };
+
+        struct Alias_Group {
+            std::vector<Graph_Resource> images;
+            VkMemoryRequirements requirements{};
+            Memory_Allocation memory{};
+            // accesses of whichever image used the memory last, carried over into the next frame
+            VkPipelineStageFlags stages = 0;
+            VkAccessFlags write_access = 0;
+        };
+
+        Device &device;
+        std::vector<Graph_Image> images;
+        std::vector<Graph_Pass> passes;
+        std::vector<Alias_Group> alias_groups;
+        bool compiled = false;
+        Render_Graph_Stats stats;
+
+        void cull_passes();
+        void allocate_transients();
+        void create_render_pass(uint32_t pass_index);
+        VkFramebuffer get_framebuffer(Graph_Pass &pass);
+        void record_barriers(VkCommandBuffer command_buffer, const Graph_Pass &pass);
+        bool used_after(Graph_Resource image, uint32_t pass_index) const;
+        void record_final_transitions(VkCommandBuffer command_buffer);
+
+    public:
+        explicit RenderGraph(Device &device);
+        // frames in flight may still use the images, everything goes through the deletion queue
+        ~RenderGraph();
+
+        RenderGraph(const RenderGraph &) = delete;
+        RenderGraph &operator = (const RenderGraph &) = delete;
+
+        Graph_Resource create_image(const std::string &name, const Graph_Image_Info &info);
+        // initial_stages is where the image was last used before the graph, the swap chain's acquire waits at color output
+        Graph_Resource import_image(
+                const std::string &name,
+                const Graph_Image_Info &info,
+                VkImageLayout initial_layout,
+                VkImageLayout final_layout,
+                VkPipelineStageFlags initial_stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
+                );
+        void add_pass(
+                const std::string &name,
+                Pass_Type type,
+                const std::function<void(Pass_Builder &builder)> &setup,
+                Pass_Execute execute
+                );
+
+        void compile();
+        // the image and view the imported image stands for in the next execute()
+        void set_imported_image(Graph_Resource image, VkImage handle, VkImageView view);
+        void execute(VkCommandBuffer command_buffer);
+
+        VkImage get_image(Graph_Resource image) const { return images[image].image; }
+        VkImageView get_view(Graph_Resource image) const { return images[image].view; }
+        // for creating the pipelines of a pass, valid after compile()
+        VkRenderPass get_render_pass(const std::string &pass_name) const;
+        bool is_culled(const std::string &pass_name) const;
+
+        const Render_Graph_Stats &get_stats() const { return stats; }
+        void print_stats(std::ostream &out) const;
+    };
+
+} // namespace graph_vulkan
+
+
+#endif // PIXEL_ENGINE_GRAPHIC_VULKAN_RENDER_GRAPH_H
@@ -0,0 +1,29 @@
+/**
+ * library_support/Graphic/vulkan/shader
+ *
+ * Shaders compiled into the executable
+ *
+ * The headers included here are generated at build time from the GLSL sources
+ * in shaders/ (see cmake/embed_spirv.cmake), using them needs no file I/O and
+ * does not depend on the working directory.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_GRAPHIC_VULKAN_EMBEDDED_SHADERS_H
+#define PIXEL_ENGINE_GRAPHIC_VULKAN_EMBEDDED_SHADERS_H
+
+#pragma once
+
+#include "shader_module_cache.hpp"
+
+#include "shaders/shader_v0_0_0.vert.hpp"
+#include "shaders/shader_v0_0_0.frag.hpp"
+
+namespace graph_vulkan::embedded_shaders{
+    inline constexpr Spirv_Blob default_vert{shader_v0_0_0_vert, sizeof(shader_v0_0_0_vert)};
+    inline constexpr Spirv_Blob default_frag{shader_v0_0_0_frag, sizeof(shader_v0_0_0_frag)};
+
+} // namespace graph_vulkan::embedded_shaders
+
+
+#endif // PIXEL_ENGINE_GRAPHIC_VULKAN_EMBEDDED_SHADERS_H
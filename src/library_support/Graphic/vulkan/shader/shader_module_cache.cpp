@@ -0,0 +1,131 @@
+/**
+ * library_support/Graphic/vulkan/shader
+ *
+ **/
+
+// match hpp file
+#include "shader_module_cache.hpp"
+#include "../pipeline/pipeline_cache.hpp"
+#include "../../../File/mapped_file/mapped_file.hpp"
+#include "../../../Profiling/profiler/profiler.hpp"
+//standard libraries
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace graph_vulkan{
+    // magic number, version, generator, bound and schema
+    static constexpr size_t SPIRV_HEADER_SIZE = 5 * sizeof(uint32_t);
+
+    ShaderModuleCache::ShaderModuleCache(VkDevice device, const file_io::AssetArchive *archive)
+            : device_{device}, archive_{archive} {}
+
+    ShaderModuleCache::~ShaderModuleCache() {
+        for (auto &module : modules_by_hash) {
+            vkDestroyShaderModule(device_, module.second, nullptr);
+        }
+    }
+
+    void ShaderModuleCache::validate_spirv(const void *code, size_t size, const std::string &name) {
+        if (code == nullptr || size < SPIRV_HEADER_SIZE || size % sizeof(uint32_t) != 0) {
+            throw std::runtime_error("Invalid SPIR-V in " + name + ": size " + std::to_string(size) + " is not a whole number of words");
+        }
+        if (reinterpret_cast<uintptr_t>(code) % alignof(uint32_t) != 0) {
+            throw std::runtime_error("Invalid SPIR-V in " + name + ": code is not 4 byte aligned");
+        }
+        uint32_t magic;
+        std::memcpy(&magic, code, sizeof(magic));
+        if (magic != SPIRV_MAGIC) {
+            throw std::runtime_error("Invalid SPIR-V in " + name + ": bad magic number");
+        }
+    }
+
+    VkShaderModule ShaderModuleCache::find_or_create(uint64_t code_hash, const uint32_t *code, size_t size) {
+        auto found = modules_by_hash.find(code_hash);
+        if (found != modules_by_hash.end()) {
+            hit_count++;
+            return found->second;
+        }
+
+        VkShaderModuleCreateInfo create_info{};
+        create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        create_info.codeSize = size;
+        create_info.pCode = code;
+
+        VkShaderModule module;
+        if (vkCreateShaderModule(device_, &create_info, nullptr, &module) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create shader module.");
+        }
+        modules_by_hash.emplace(code_hash, module);
+        return module;
+    }
+
+    VkShaderModule ShaderModuleCache::load(const std::string &path) {
+        PIXEL_PROFILE_ZONE("load shader module");
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            auto found = modules_by_path.find(path);
+            if (found != modules_by_path.end()) {
+                hit_count++;
+                return found->second.module;
+            }
+        }
+
+        // packed blobs are 64 byte aligned, stored ones go to the driver straight from the archive's mapping
+        const file_io::Archive_Entry *entry = archive_ != nullptr ? archive_->find(path) : nullptr;
+        if (entry != nullptr) {
+            std::vector<char> decompressed;
+            file_io::Asset_View code;
+            if (entry->compression == file_io::Archive_Compression::none) {
+                code = archive_->view(*entry);
+            } else {
+                decompressed = archive_->read(*entry);
+                code = {decompressed.data(), decompressed.size()};
+            }
+            validate_spirv(code.data, code.size, archive_->path() + ":" + path);
+            uint64_t code_hash = PipelineCache::hash_data(code.data, code.size);
+
+            std::lock_guard<std::mutex> lock{mutex};
+            archive_count++;
+            archive_bytes += code.size;
+            VkShaderModule module = find_or_create(code_hash, static_cast<const uint32_t *>(code.data), code.size);
+            modules_by_path.emplace(path, Shader_Module_Entry{code_hash, module});
+            return module;
+        }
+
+        // mapping and hashing happen outside the lock so several threads can load at once,
+        // the mapping is page aligned and only needed until the driver has consumed the code
+        file_io::MappedFile file{path};
+        validate_spirv(file.data(), file.size(), path);
+        uint64_t code_hash = PipelineCache::hash_data(file.data(), file.size());
+
+        std::lock_guard<std::mutex> lock{mutex};
+        file_count++;
+        file_bytes += file.size();
+        VkShaderModule module = find_or_create(code_hash, static_cast<const uint32_t *>(file.data()), file.size());
+        modules_by_path.emplace(path, Shader_Module_Entry{code_hash, module});
+        return module;
+    }
+
+    VkShaderModule ShaderModuleCache::get(const Spirv_Blob &blob) {
+        validate_spirv(blob.code, blob.size, "embedded shader");
+        uint64_t code_hash = PipelineCache::hash_data(blob.code, blob.size);
+
+        std::lock_guard<std::mutex> lock{mutex};
+        return find_or_create(code_hash, blob.code, blob.size);
+    }
+
+    uint32_t ShaderModuleCache::module_count() {
+        std::lock_guard<std::mutex> lock{mutex};
+        return static_cast<uint32_t>(modules_by_hash.size());
+    }
+
+    void ShaderModuleCache::print_stats(std::ostream &out) {
+        std::lock_guard<std::mutex> lock{mutex};
+        out << "Shader modules: " << modules_by_hash.size() << " modules from "
+            << file_count << " mapped files (" << file_bytes << " bytes) and "
+            << archive_count << " archive assets (" << archive_bytes << " bytes), "
+            << hit_count << " cache hits" << std::endl;
+    }
+
+} // namespace graph_vulkan
@@ -0,0 +1,90 @@
+/**
+ * library_support/Graphic/vulkan/shader
+ *
+ * VkShaderModule cache keyed by the hash of the SPIR-V code
+ *
+ * .spv files are memory mapped and handed to the driver straight from the
+ * mapping, each distinct piece of code becomes one module per device no matter
+ * how many pipelines or file names refer to it. With an asset archive, paths
+ * that are packed into it are served from the archive's mapping instead.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_GRAPHIC_VULKAN_SHADER_MODULE_CACHE_H
+#define PIXEL_ENGINE_GRAPHIC_VULKAN_SHADER_MODULE_CACHE_H
+
+#pragma once
+
+#include "../../../File/archive/asset_archive.hpp"
+
+#include <vulkan/vulkan.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+namespace graph_vulkan{
+    // SPIR-V already in memory, usually one of the embedded shaders
+    struct Spirv_Blob {
+        const uint32_t *code = nullptr;
+        // in bytes
+        size_t size = 0;
+
+        bool empty() const { return code == nullptr || size == 0; }
+    };
+
+    class ShaderModuleCache {
+    private:
+        struct Shader_Module_Entry {
+            uint64_t code_hash;
+            VkShaderModule module;
+        };
+
+        VkDevice device_;
+        // may be null, looked up before the file system
+        const file_io::AssetArchive *archive_;
+
+        std::mutex mutex;
+        std::unordered_map<uint64_t, VkShaderModule> modules_by_hash;
+        // repeated loads of the same path skip mapping and hashing the file
+        std::unordered_map<std::string, Shader_Module_Entry> modules_by_path;
+
+        uint32_t file_count = 0;
+        uint64_t file_bytes = 0;
+        uint32_t archive_count = 0;
+        uint64_t archive_bytes = 0;
+        uint32_t hit_count = 0;
+
+        // caller holds the mutex
+        VkShaderModule find_or_create(uint64_t code_hash, const uint32_t *code, size_t size);
+
+    public:
+        static constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+
+        // the archive has to outlive the cache
+        explicit ShaderModuleCache(VkDevice device, const file_io::AssetArchive *archive = nullptr);
+        ~ShaderModuleCache();
+
+        ShaderModuleCache(const ShaderModuleCache &) = delete;
+        ShaderModuleCache &operator = (const ShaderModuleCache &) = delete;
+
+        // the asset of that name in the archive or else a mapped .spv file,
+        // the module stays alive as long as the cache
+        VkShaderModule load(const std::string &path);
+        // code already in memory, nothing is copied or read from disk
+        VkShaderModule get(const Spirv_Blob &blob);
+
+        uint32_t module_count();
+        void print_stats(std::ostream &out);
+
+        // throws std::runtime_error naming the source when the code is not SPIR-V
+        static void validate_spirv(const void *code, size_t size, const std::string &name);
+    };
+
+} // namespace graph_vulkan
+
+
+#endif // PIXEL_ENGINE_GRAPHIC_VULKAN_SHADER_MODULE_CACHE_H
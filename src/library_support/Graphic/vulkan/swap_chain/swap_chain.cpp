@@ -0,0 +1,500 @@
+/**
+ * library_support/Graphic/vulkan/swap_chain
+ *
+ **/
+
+// match hpp file
+#include "swap_chain.hpp"
+#include "../../../Profiling/profiler/profiler.hpp"
+//standard libraries
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+namespace graph_vulkan{
+    SwapChain::SwapChain(Device &device, VkExtent2D window_extent, const Swap_Chain_Config &config)
+            : device{device}, window_extent{window_extent}, config{config} {
+        init();
+    }
+
+    SwapChain::SwapChain(
+            Device &device,
+            VkExtent2D window_extent,
+            std::shared_ptr<SwapChain> previous,
+            const Swap_Chain_Config &config
+            ) : device{device}, window_extent{window_extent}, config{config}, old_swap_chain{std::move(previous)} {
+        init();
+    }
+
+    void SwapChain::init() {
+        if (config.frames_in_flight == 0) config.frames_in_flight = 1;
+
+        create_swap_chain();
+        create_image_views();
+        create_render_pass();
+        create_depth_resources();
+        create_framebuffers();
+        create_sync_objects();
+    }
+
+    SwapChain::~SwapChain() {
+        for (auto image_view : swap_chain_image_views) {
+            vkDestroyImageView(device.device(), image_view, nullptr);
+        }
+        swap_chain_image_views.clear();
+
+        if (swap_chain != VK_NULL_HANDLE) {
+            vkDestroySwapchainKHR(device.device(), swap_chain, nullptr);
+            swap_chain = VK_NULL_HANDLE;
+        }
+
+        for (size_t i = 0; i < depth_images.size(); i++) {
+            vkDestroyImageView(device.device(), depth_image_views[i], nullptr);
+            device.destroy_image(depth_images[i], depth_image_memories[i]);
+        }
+
+        for (auto framebuffer : swap_chain_framebuffers) {
+            vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
+        }
+
+        vkDestroyRenderPass(device.device(), render_pass, nullptr);
+
+        for (auto semaphore : render_finished_semaphores) {
+            vkDestroySemaphore(device.device(), semaphore, nullptr);
+        }
+        for (size_t i = 0; i < in_flight_fences.size(); i++) {
+            vkDestroySemaphore(device.device(), image_available_semaphores[i], nullptr);
+            vkDestroyFence(device.device(), in_flight_fences[i], nullptr);
+        }
+    }
+
+    VkResult SwapChain::acquire_next_image(uint32_t *image_index) {
+        PIXEL_PROFILE_ZONE("acquire image");
+        vkWaitForFences(
+                device.device(),
+                1,
+                &in_flight_fences[current_frame],
+                VK_TRUE,
+                std::numeric_limits<uint64_t>::max()
+                );
+        // whatever that frame was the last to use can go now
+        if (frame_serials[current_frame] != 0) {
+            device.deletion_queue().frame_completed(frame_serials[current_frame]);
+        }
+
+        // once every frame slot has been waited on again, nothing submitted against the old
+        // swap chain is running any more and its extent dependent resources can go
+        if (old_swap_chain && --frames_until_old_retired == 0) {
+            old_swap_chain.reset();
+        }
+
+        return vkAcquireNextImageKHR(
+                device.device(),
+                swap_chain,
+                std::numeric_limits<uint64_t>::max(),
+                image_available_semaphores[current_frame],  // must be a not signaled semaphore
+                VK_NULL_HANDLE,
+                image_index
+                );
+    }
+
+    VkResult SwapChain::submit_command_buffers(const VkCommandBuffer *buffers, uint32_t *image_index, const std::vector<Sync_Wait> &waits) {
+        PIXEL_PROFILE_ZONE("submit and present");
+        // the image may still be used by an older frame slot when acquire returned it out of order
+        if (images_in_flight[*image_index] != VK_NULL_HANDLE) {
+            vkWaitForFences(device.device(), 1, &images_in_flight[*image_index], VK_TRUE, UINT64_MAX);
+        }
+        images_in_flight[*image_index] = in_flight_fences[current_frame];
+
+        Queue_Submit_Info submit_info{};
+        submit_info.command_buffers = {buffers[0]};
+        submit_info.waits = waits;
+        submit_info.wait_semaphores = {image_available_semaphores[current_frame]};
+        submit_info.wait_stages = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+
+        VkSemaphore signal_semaphores[] = {render_finished_semaphores[*image_index]};
+        submit_info.signal_semaphores = {signal_semaphores[0]};
+        submit_info.fence = in_flight_fences[current_frame];
+
+        vkResetFences(device.device(), 1, &in_flight_fences[current_frame]);
+        last_submit = device.sync().submit(Queue_Type::graphics, submit_info);
+        frame_serials[current_frame] = device.deletion_queue().end_frame();
+
+        VkPresentInfoKHR present_info{};
+        present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+
+        present_info.waitSemaphoreCount = 1;
+        present_info.pWaitSemaphores = signal_semaphores;
+
+        VkSwapchainKHR swap_chains[] = {swap_chain};
+        present_info.swapchainCount = 1;
+        present_info.pSwapchains = swap_chains;
+
+        present_info.pImageIndices = image_index;
+
+        auto result = device.sync().present(present_info);
+
+        current_frame = (current_frame + 1) % config.frames_in_flight;
+
+        return result;
+    }
+
+    void SwapChain::create_swap_chain() {
+        Swap_Chain_Support_Details swap_chain_support = device.get_Swap_Chain_Support();
+
+        VkSurfaceFormatKHR surface_format = choose_swap_surface_format(swap_chain_support.formats);
+        present_mode = choose_swap_present_mode(swap_chain_support.presentModes);
+        VkExtent2D extent = choose_swap_extent(swap_chain_support.capabilities);
+
+        // one more than the minimum so acquire does not wait on the driver, and enough for every frame in flight
+        uint32_t image_count = std::max(swap_chain_support.capabilities.minImageCount + 1, config.frames_in_flight);
+        if (swap_chain_support.capabilities.maxImageCount > 0 &&
+            image_count > swap_chain_support.capabilities.maxImageCount) {
+            image_count = swap_chain_support.capabilities.maxImageCount;
+        }
+
+        VkSwapchainCreateInfoKHR create_info = {};
+        create_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+        create_info.surface = device.surface();
+
+        create_info.minImageCount = image_count;
+        create_info.imageFormat = surface_format.format;
+        create_info.imageColorSpace = surface_format.colorSpace;
+        create_info.imageExtent = extent;
+        create_info.imageArrayLayers = 1;
+        create_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+
+        Queue_Family_Indices indices = device.find_physical_queue_families();
+        uint32_t queue_family_indices[] = {indices.graphics_Family, indices.present_Family};
+
+        if (indices.graphics_Family != indices.present_Family) {
+            create_info.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
+            create_info.queueFamilyIndexCount = 2;
+            create_info.pQueueFamilyIndices = queue_family_indices;
+        } else {
+            create_info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            create_info.queueFamilyIndexCount = 0;
+            create_info.pQueueFamilyIndices = nullptr;
+        }
+
+        create_info.preTransform = swap_chain_support.capabilities.currentTransform;
+        create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+
+        create_info.presentMode = present_mode;
+        create_info.clipped = VK_TRUE;
+
+        // lets the presentation engine hand images over instead of tearing everything down
+        create_info.oldSwapchain = old_swap_chain ? old_swap_chain->swap_chain : VK_NULL_HANDLE;
+
+        if (vkCreateSwapchainKHR(device.device(), &create_info, nullptr, &swap_chain) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create swap chain.");
+        }
+
+        // only the minimum number of images is specified, the implementation may create more
+        vkGetSwapchainImagesKHR(device.device(), swap_chain, &image_count, nullptr);
+        swap_chain_images.resize(image_count);
+        vkGetSwapchainImagesKHR(device.device(), swap_chain, &image_count, swap_chain_images.data());
+
+        swap_chain_image_format = surface_format.format;
+        swap_chain_extent = extent;
+    }
+
+    void SwapChain::create_image_views() {
+        swap_chain_image_views.resize(swap_chain_images.size());
+        for (size_t i = 0; i < swap_chain_images.size(); i++) {
+            VkImageViewCreateInfo view_info{};
+            view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            view_info.image = swap_chain_images[i];
+            view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            view_info.format = swap_chain_image_format;
+            view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            view_info.subresourceRange.baseMipLevel = 0;
+            view_info.subresourceRange.levelCount = 1;
+            view_info.subresourceRange.baseArrayLayer = 0;
+            view_info.subresourceRange.layerCount = 1;
+
+            if (vkCreateImageView(device.device(), &view_info, nullptr, &swap_chain_image_views[i]) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create texture image view.");
+            }
+        }
+    }
+
+    void SwapChain::create_render_pass() {
+        VkAttachmentDescription depth_attachment{};
+        depth_attachment.format = find_depth_format();
+        depth_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        depth_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depth_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        depth_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depth_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        depth_attachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        VkAttachmentReference depth_attachment_ref{};
+        depth_attachment_ref.attachment = 1;
+        depth_attachment_ref.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        VkAttachmentDescription color_attachment = {};
+        color_attachment.format = get_swap_chain_image_format();
+        color_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        color_attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+        VkAttachmentReference color_attachment_ref = {};
+        color_attachment_ref.attachment = 0;
+        color_attachment_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+        VkSubpassDescription subpass = {};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 1;
+        subpass.pColorAttachments = &color_attachment_ref;
+        subpass.pDepthStencilAttachment = &depth_attachment_ref;
+
+        VkSubpassDependency dependency = {};
+        dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependency.srcAccessMask = 0;
+        dependency.srcStageMask =
+                VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        dependency.dstSubpass = 0;
+        dependency.dstStageMask =
+                VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        dependency.dstAccessMask =
+                VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+        std::array<VkAttachmentDescription, 2> attachments = {color_attachment, depth_attachment};
+        VkRenderPassCreateInfo render_pass_info = {};
+        render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        render_pass_info.attachmentCount = static_cast<uint32_t>(attachments.size());
+        render_pass_info.pAttachments = attachments.data();
+        render_pass_info.subpassCount = 1;
+        render_pass_info.pSubpasses = &subpass;
+        render_pass_info.dependencyCount = 1;
+        render_pass_info.pDependencies = &dependency;
+
+        if (vkCreateRenderPass(device.device(), &render_pass_info, nullptr, &render_pass) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create render pass.");
+        }
+    }
+
+    void SwapChain::create_depth_resources() {
+        swap_chain_depth_format = find_depth_format();
+
+        depth_images.resize(image_count());
+        depth_image_memories.resize(image_count());
+        depth_image_views.resize(image_count());
+
+        for (size_t i = 0; i < depth_images.size(); i++) {
+            VkImageCreateInfo image_info{};
+            image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            image_info.imageType = VK_IMAGE_TYPE_2D;
+            image_info.extent.width = swap_chain_extent.width;
+            image_info.extent.height = swap_chain_extent.height;
+            image_info.extent.depth = 1;
+            image_info.mipLevels = 1;
+            image_info.arrayLayers = 1;
+            image_info.format = swap_chain_depth_format;
+            image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+            image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            image_info.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+            image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+            image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            image_info.flags = 0;
+
+            device.create_image_with_info(
+                    image_info,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                    depth_images[i],
+                    depth_image_memories[i]
+                    );
+
+            VkImageViewCreateInfo view_info{};
+            view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            view_info.image = depth_images[i];
+            view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            view_info.format = swap_chain_depth_format;
+            view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+            view_info.subresourceRange.baseMipLevel = 0;
+            view_info.subresourceRange.levelCount = 1;
+            view_info.subresourceRange.baseArrayLayer = 0;
+            view_info.subresourceRange.layerCount = 1;
+
+            if (vkCreateImageView(device.device(), &view_info, nullptr, &depth_image_views[i]) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create texture image view.");
+            }
+        }
+    }
+
+    void SwapChain::create_framebuffers() {
+        swap_chain_framebuffers.resize(image_count());
+        for (size_t i = 0; i < image_count(); i++) {
+            std::array<VkImageView, 2> attachments = {swap_chain_image_views[i], depth_image_views[i]};
+
+            VkFramebufferCreateInfo framebuffer_info = {};
+            framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            framebuffer_info.renderPass = render_pass;
+            framebuffer_info.attachmentCount = static_cast<uint32_t>(attachments.size());
+            framebuffer_info.pAttachments = attachments.data();
+            framebuffer_info.width = swap_chain_extent.width;
+            framebuffer_info.height = swap_chain_extent.height;
+            framebuffer_info.layers = 1;
+
+            if (vkCreateFramebuffer(device.device(), &framebuffer_info, nullptr, &swap_chain_framebuffers[i]) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create framebuffer.");
+            }
+        }
+    }
+
+    void SwapChain::create_sync_objects() {
+        render_finished_semaphores.resize(image_count());
+        images_in_flight.resize(image_count(), VK_NULL_HANDLE);
+
+        VkSemaphoreCreateInfo semaphore_info = {};
+        semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+        for (size_t i = 0; i < image_count(); i++) {
+            if (vkCreateSemaphore(device.device(), &semaphore_info, nullptr, &render_finished_semaphores[i]) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create synchronization objects for a frame.");
+            }
+        }
+
+        // the frame slots do not depend on the extent, take them over and keep counting where the old one stopped
+        if (old_swap_chain && old_swap_chain->config.frames_in_flight == config.frames_in_flight) {
+            image_available_semaphores = std::move(old_swap_chain->image_available_semaphores);
+            in_flight_fences = std::move(old_swap_chain->in_flight_fences);
+            frame_serials = std::move(old_swap_chain->frame_serials);
+            old_swap_chain->image_available_semaphores.clear();
+            old_swap_chain->in_flight_fences.clear();
+            current_frame = old_swap_chain->current_frame;
+            frames_until_old_retired = config.frames_in_flight + 1;
+            return;
+        }
+        if (old_swap_chain) {
+            // a different frame count cannot reuse the slots, this is the only case that waits
+            old_swap_chain->wait_for_frames();
+            old_swap_chain.reset();
+        }
+
+        image_available_semaphores.resize(config.frames_in_flight);
+        in_flight_fences.resize(config.frames_in_flight);
+        frame_serials.assign(config.frames_in_flight, 0);
+
+        VkFenceCreateInfo fence_info = {};
+        fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        // signaled, the first wait on each frame slot returns right away
+        fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+        for (size_t i = 0; i < config.frames_in_flight; i++) {
+            if (vkCreateSemaphore(device.device(), &semaphore_info, nullptr, &image_available_semaphores[i]) != VK_SUCCESS ||
+                vkCreateFence(device.device(), &fence_info, nullptr, &in_flight_fences[i]) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create synchronization objects for a frame.");
+            }
+        }
+    }
+
+    void SwapChain::wait_for_frames() {
+        if (in_flight_fences.empty()) return;
+        vkWaitForFences(
+                device.device(),
+                static_cast<uint32_t>(in_flight_fences.size()),
+                in_flight_fences.data(),
+                VK_TRUE,
+                std::numeric_limits<uint64_t>::max()
+                );
+    }
+
+    VkSurfaceFormatKHR SwapChain::choose_swap_surface_format(const std::vector<VkSurfaceFormatKHR> &available_formats) {
+        for (const auto &available_format : available_formats) {
+            if (available_format.format == VK_FORMAT_B8G8R8A8_SRGB &&
+                available_format.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
+                return available_format;
+            }
+        }
+
+        return available_formats[0];
+    }
+
+    VkPresentModeKHR SwapChain::choose_swap_present_mode(const std::vector<VkPresentModeKHR> &available_present_modes) {
+        std::vector<VkPresentModeKHR> preference;
+        switch (config.present_policy) {
+            case Present_Policy::low_latency:
+                preference = {VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR};
+                break;
+            case Present_Policy::uncapped:
+                preference = {VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR};
+                break;
+            case Present_Policy::low_power:
+                break;
+        }
+
+        for (VkPresentModeKHR wanted : preference) {
+            if (std::find(available_present_modes.begin(), available_present_modes.end(), wanted) != available_present_modes.end()) {
+                return wanted;
+            }
+        }
+
+        // FIFO is the only mode every implementation has to support
+        return VK_PRESENT_MODE_FIFO_KHR;
+    }
+
+    VkExtent2D SwapChain::choose_swap_extent(const VkSurfaceCapabilitiesKHR &capabilities) {
+        if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
+            return capabilities.currentExtent;
+        }
+
+        VkExtent2D actual_extent = window_extent;
+        actual_extent.width = std::max(
+                capabilities.minImageExtent.width,
+                std::min(capabilities.maxImageExtent.width, actual_extent.width));
+        actual_extent.height = std::max(
+                capabilities.minImageExtent.height,
+                std::min(capabilities.maxImageExtent.height, actual_extent.height));
+
+        return actual_extent;
+    }
+
+    VkFormat SwapChain::find_depth_format() {
+        return device.find_supported_format(
+                {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
+                VK_IMAGE_TILING_OPTIMAL,
+                VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
+                );
+    }
+
+    void SwapChain::print_stats(std::ostream &out) const {
+        out << "Swap chain: " << swap_chain_images.size() << " images "
+            << swap_chain_extent.width << "x" << swap_chain_extent.height
+            << ", present mode " << present_mode_name(present_mode)
+            << ", " << config.frames_in_flight << " frames in flight" << std::endl;
+    }
+
+    Present_Policy SwapChain::present_policy_from_environment(Present_Policy fallback) {
+        const char *value = std::getenv("PIXEL_ENGINE_PRESENT_MODE");
+        if (value == nullptr) return fallback;
+
+        std::string policy{value};
+        if (policy == "latency") return Present_Policy::low_latency;
+        if (policy == "power") return Present_Policy::low_power;
+        if (policy == "uncapped") return Present_Policy::uncapped;
+
+        std::cerr << "Unknown PIXEL_ENGINE_PRESENT_MODE \"" << policy << "\", expected latency, power or uncapped" << std::endl;
+        return fallback;
+    }
+
+    std::string SwapChain::present_mode_name(VkPresentModeKHR mode) {
+        switch (mode) {
+            case VK_PRESENT_MODE_IMMEDIATE_KHR:    return "IMMEDIATE";
+            case VK_PRESENT_MODE_MAILBOX_KHR:      return "MAILBOX";
+            case VK_PRESENT_MODE_FIFO_KHR:         return "FIFO";
+            case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "FIFO_RELAXED";
+            default:                               return "other";
+        }
+    }
+
+} // namespace graph_vulkan
@@ -0,0 +1,151 @@
+/**
+ * library_support/Graphic/vulkan/swap_chain
+ *
+ * Swap chain with its render pass, depth buffers and frames in flight
+ *
+ * The present mode follows a policy instead of being hard coded: lowest
+ * latency prefers MAILBOX, lowest power sticks to FIFO and uncapped prefers
+ * IMMEDIATE. Every frame in flight has its own fence and acquire semaphore so
+ * the CPU records frame N+1 while the GPU still renders frame N.
+ *
+ * On resize the new swap chain is created with the old one as oldSwapchain and
+ * takes over the frame fences and semaphores, which do not depend on the
+ * extent. Only the old images, framebuffers and depth buffers are kept until the
+ * frames still using them have finished, nothing waits for the whole device.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_GRAPHIC_VULKAN_SWAP_CHAIN_H
+#define PIXEL_ENGINE_GRAPHIC_VULKAN_SWAP_CHAIN_H
+
+#pragma once
+
+#include "../device/device.hpp"
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace graph_vulkan{
+    enum class Present_Policy {
+        // MAILBOX, then IMMEDIATE, then FIFO: newest image on every vblank, no tearing when possible
+        low_latency,
+        // FIFO: never renders frames that are not shown
+        low_power,
+        // IMMEDIATE, then MAILBOX, then FIFO: as many frames as the GPU manages, for benchmarking
+        uncapped
+    };
+
+    struct Swap_Chain_Config {
+        Present_Policy present_policy = Present_Policy::low_latency;
+        // 2 lets the CPU run one frame ahead, more adds latency for little throughput
+        uint32_t frames_in_flight = 2;
+    };
+
+    class SwapChain {
+    private:
+        Device &device;
+        VkExtent2D window_extent;
+        Swap_Chain_Config config;
+
+        VkSwapchainKHR swap_chain = VK_NULL_HANDLE;
+        VkFormat swap_chain_image_format;
+        VkFormat swap_chain_depth_format;
+        VkExtent2D swap_chain_extent;
+        VkPresentModeKHR present_mode;
+
+        std::vector<VkImage> swap_chain_images;
+        std::vector<VkImageView> swap_chain_image_views;
+        std::vector<VkImage> depth_images;
+        std::vector<Memory_Allocation> depth_image_memories;
+        std::vector<VkImageView> depth_image_views;
+        std::vector<VkFramebuffer> swap_chain_framebuffers;
+        VkRenderPass render_pass = VK_NULL_HANDLE;
+
+        // per frame in flight
+        std::vector<VkSemaphore> image_available_semaphores;
+        std::vector<VkFence> in_flight_fences;
+        // deletion queue serial of the frame last submitted in the slot, 0 before the first
+        std::vector<uint64_t> frame_serials;
+        // per swap chain image, a present may still be waiting on it when the frame slot comes around
+        std::vector<VkSemaphore> render_finished_semaphores;
+        std::vector<VkFence> images_in_flight;
+        uint32_t current_frame = 0;
+        Sync_Point last_submit{};
+
+        // kept alive until every frame submitted against it has finished, an older one it
+        // still holds goes with it since the frame slots are shared along the chain
+        std::shared_ptr<SwapChain> old_swap_chain;
+        uint32_t frames_until_old_retired = 0;
+
+        void init();
+        // blocks until every frame slot is idle, only when the slots cannot be handed over
+        void wait_for_frames();
+        void create_swap_chain();
+        void create_image_views();
+        void create_render_pass();
+        void create_depth_resources();
+        void create_framebuffers();
+        void create_sync_objects();
+
+        // helper functions
+        VkSurfaceFormatKHR choose_swap_surface_format(const std::vector<VkSurfaceFormatKHR> &available_formats);
+        VkPresentModeKHR choose_swap_present_mode(const std::vector<VkPresentModeKHR> &available_present_modes);
+        VkExtent2D choose_swap_extent(const VkSurfaceCapabilitiesKHR &capabilities);
+        VkFormat find_depth_format();
+
+    public:
+        SwapChain(Device &device, VkExtent2D window_extent, const Swap_Chain_Config &config = Swap_Chain_Config{});
+        // recreation, previous hands over its swap chain and frame synchronization
+        SwapChain(
+                Device &device,
+                VkExtent2D window_extent,
+                std::shared_ptr<SwapChain> previous,
+                const Swap_Chain_Config &config = Swap_Chain_Config{}
+                );
+        ~SwapChain();
+
+        SwapChain(const SwapChain &) = delete;
+        SwapChain &operator = (const SwapChain &) = delete;
+
+        VkFramebuffer get_frame_buffer(uint32_t index) { return swap_chain_framebuffers[index]; }
+        VkRenderPass get_render_pass() { return render_pass; }
+        VkImageView get_image_view(uint32_t index) { return swap_chain_image_views[index]; }
+        size_t image_count() { return swap_chain_images.size(); }
+        VkFormat get_swap_chain_image_format() { return swap_chain_image_format; }
+        VkExtent2D get_swap_chain_extent() { return swap_chain_extent; }
+        uint32_t width() { return swap_chain_extent.width; }
+        uint32_t height() { return swap_chain_extent.height; }
+        float extent_aspect_ratio() {
+            return static_cast<float>(swap_chain_extent.width) / static_cast<float>(swap_chain_extent.height);
+        }
+        VkPresentModeKHR get_present_mode() { return present_mode; }
+        // pipelines built against the other render pass still work when this holds
+        bool compare_swap_formats(const SwapChain &other) const {
+            return other.swap_chain_image_format == swap_chain_image_format &&
+                   other.swap_chain_depth_format == swap_chain_depth_format;
+        }
+        uint32_t frames_in_flight() { return config.frames_in_flight; }
+        // index of the frame in flight the next acquire belongs to, for per frame resources
+        uint32_t current_frame_index() { return current_frame; }
+
+        // waits for the frame slot's fence, then acquires an image
+        VkResult acquire_next_image(uint32_t *image_index);
+        // waits holds sync points of other queues the frame needs, like the upload of a texture it samples
+        VkResult submit_command_buffers(const VkCommandBuffer *buffers, uint32_t *image_index, const std::vector<Sync_Wait> &waits = {});
+        // graphics queue point of the last submitted frame
+        Sync_Point get_last_submit() { return last_submit; }
+
+        // image count, extent, present mode and frames in flight
+        void print_stats(std::ostream &out) const;
+
+        // reads PIXEL_ENGINE_PRESENT_MODE (latency, power or uncapped), fallback when unset
+        static Present_Policy present_policy_from_environment(Present_Policy fallback);
+        static std::string present_mode_name(VkPresentModeKHR mode);
+    };
+
+} // namespace graph_vulkan
+
+
+#endif // PIXEL_ENGINE_GRAPHIC_VULKAN_SWAP_CHAIN_H
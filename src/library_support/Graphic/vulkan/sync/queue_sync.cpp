@@ -0,0 +1,251 @@
+/**
+ * library_support/Graphic/vulkan/sync
+ *
+ **/
+
+// match hpp file
+#include "queue_sync.hpp"
+#include "../../../Profiling/profiler/profiler.hpp"
+//standard libraries
+#include <algorithm>
+#include <stdexcept>
+
+namespace graph_vulkan{
+    QueueSync::QueueSync(
+            VkDevice device,
+            bool timeline_semaphores,
+            VkQueue graphics_queue,
+            VkQueue transfer_queue,
+            VkQueue compute_queue,
+            VkQueue present_queue
+            ) : device{device}, timeline_semaphores{timeline_semaphores}, present_queue{present_queue} {
+        timeline(Queue_Type::graphics).queue = graphics_queue;
+        timeline(Queue_Type::transfer).queue = transfer_queue;
+        timeline(Queue_Type::compute).queue = compute_queue;
+        for (auto &queue_timeline : timelines) {
+            queue_timeline.queue_mutex = &mutex_for(queue_timeline.queue);
+        }
+        if (present_queue != VK_NULL_HANDLE) mutex_for(present_queue);
+
+        if (timeline_semaphores) {
+            // looked up instead of linked, so a 1.0 loader can still start the engine
+            wait_semaphores = reinterpret_cast<PFN_vkWaitSemaphores>(
+                    vkGetDeviceProcAddr(device, "vkWaitSemaphores"));
+            get_semaphore_counter_value = reinterpret_cast<PFN_vkGetSemaphoreCounterValue>(
+                    vkGetDeviceProcAddr(device, "vkGetSemaphoreCounterValue"));
+            this->timeline_semaphores = wait_semaphores && get_semaphore_counter_value;
+        }
+        if (!this->timeline_semaphores) return;
+
+        VkSemaphoreTypeCreateInfo type_info{};
+        type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        type_info.initialValue = 0;
+        VkSemaphoreCreateInfo semaphore_info{};
+        semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphore_info.pNext = &type_info;
+        for (auto &queue_timeline : timelines) {
+            if (vkCreateSemaphore(device, &semaphore_info, nullptr, &queue_timeline.semaphore) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create timeline semaphore.");
+            }
+        }
+    }
+
+    QueueSync::~QueueSync() {
+        for (auto &queue_timeline : timelines) {
+            if (queue_timeline.semaphore != VK_NULL_HANDLE) {
+                vkDestroySemaphore(device, queue_timeline.semaphore, nullptr);
+            }
+            for (auto &fence_submit : queue_timeline.fence_submits) {
+                vkDestroyFence(device, fence_submit.fence, nullptr);
+            }
+            for (VkFence fence : queue_timeline.free_fences) {
+                vkDestroyFence(device, fence, nullptr);
+            }
+        }
+    }
+
+    std::mutex &QueueSync::mutex_for(VkQueue queue) {
+        // only filled by the constructor, so the lookups later need no lock
+        auto &mutex = queue_mutexes[queue];
+        if (!mutex) mutex = std::make_unique<std::mutex>();
+        return *mutex;
+    }
+
+    VkFence QueueSync::acquire_fence(Queue_Timeline &queue_timeline) {
+        std::lock_guard<std::mutex> lock{queue_timeline.fence_mutex};
+        poll_fences(queue_timeline);
+        if (!queue_timeline.free_fences.empty()) {
+            VkFence fence = queue_timeline.free_fences.back();
+            queue_timeline.free_fences.pop_back();
+            return fence;
+        }
+
+        VkFenceCreateInfo fence_info{};
+        fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        VkFence fence;
+        if (vkCreateFence(device, &fence_info, nullptr, &fence) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create submit fence.");
+        }
+        return fence;
+    }
+
+    void QueueSync::poll_fences(Queue_Timeline &queue_timeline) {
+        // a queue finishes its submits in order, stop at the first one still running
+        while (!queue_timeline.fence_submits.empty() &&
+               vkGetFenceStatus(device, queue_timeline.fence_submits.front().fence) == VK_SUCCESS) {
+            Fence_Submit &fence_submit = queue_timeline.fence_submits.front();
+            queue_timeline.completed_value.store(fence_submit.value, std::memory_order_release);
+            vkResetFences(device, 1, &fence_submit.fence);
+            queue_timeline.free_fences.push_back(fence_submit.fence);
+            queue_timeline.fence_submits.pop_front();
+        }
+    }
+
+    bool QueueSync::wait_fences(Queue_Timeline &queue_timeline, uint64_t value, uint64_t timeout) {
+        std::lock_guard<std::mutex> lock{queue_timeline.fence_mutex};
+        poll_fences(queue_timeline);
+        for (const auto &fence_submit : queue_timeline.fence_submits) {
+            if (fence_submit.value < value) continue;
+            // held on to the lock, nobody may recycle the fence while we wait on it
+            if (vkWaitForFences(device, 1, &fence_submit.fence, VK_TRUE, timeout) == VK_TIMEOUT) return false;
+            break;
+        }
+        poll_fences(queue_timeline);
+        return queue_timeline.completed_value.load(std::memory_order_acquire) >= value;
+    }
+
+    Sync_Point QueueSync::submit(Queue_Type queue, const Queue_Submit_Info &submit_info) {
+        Queue_Timeline &target = timeline(queue);
+
+        // one wait per timeline is enough, the highest value covers the lower ones
+        uint64_t wait_values[QUEUE_TYPE_COUNT] = {};
+        VkPipelineStageFlags wait_stage_masks[QUEUE_TYPE_COUNT] = {};
+        for (const auto &wait : submit_info.waits) {
+            if (!wait.point.is_valid()) continue;
+            uint32_t index = static_cast<uint32_t>(wait.point.queue);
+            wait_values[index] = std::max(wait_values[index], wait.point.value);
+            wait_stage_masks[index] |= wait.stage_mask;
+        }
+
+        std::vector<VkSemaphore> semaphores = submit_info.wait_semaphores;
+        std::vector<VkPipelineStageFlags> stages = submit_info.wait_stages;
+        std::vector<uint64_t> wait_semaphore_values(semaphores.size(), 0);
+        for (uint32_t i = 0; i < QUEUE_TYPE_COUNT; i++) {
+            if (wait_values[i] == 0) continue;
+            if (timelines[i].completed_value.load(std::memory_order_acquire) >= wait_values[i]) continue;
+            if (timeline_semaphores) {
+                semaphores.push_back(timelines[i].semaphore);
+                stages.push_back(wait_stage_masks[i]);
+                wait_semaphore_values.push_back(wait_values[i]);
+            } else {
+                // binary semaphores cannot be waited on by whoever comes along, the CPU waits instead
+                PIXEL_PROFILE_ZONE("cross queue fence wait");
+                wait(Sync_Point{static_cast<Queue_Type>(i), wait_values[i]});
+            }
+        }
+
+        std::vector<VkSemaphore> signal_semaphores = submit_info.signal_semaphores;
+        std::vector<uint64_t> signal_semaphore_values(signal_semaphores.size(), 0);
+
+        std::lock_guard<std::mutex> lock{*target.queue_mutex};
+        uint64_t value = target.submitted_value.load(std::memory_order_relaxed) + 1;
+
+        VkSubmitInfo vk_submit_info{};
+        vk_submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        VkTimelineSemaphoreSubmitInfo timeline_info{};
+        if (timeline_semaphores) {
+            signal_semaphores.push_back(target.semaphore);
+            signal_semaphore_values.push_back(value);
+
+            timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+            timeline_info.waitSemaphoreValueCount = static_cast<uint32_t>(wait_semaphore_values.size());
+            timeline_info.pWaitSemaphoreValues = wait_semaphore_values.data();
+            timeline_info.signalSemaphoreValueCount = static_cast<uint32_t>(signal_semaphore_values.size());
+            timeline_info.pSignalSemaphoreValues = signal_semaphore_values.data();
+            vk_submit_info.pNext = &timeline_info;
+        }
+        vk_submit_info.waitSemaphoreCount = static_cast<uint32_t>(semaphores.size());
+        vk_submit_info.pWaitSemaphores = semaphores.data();
+        vk_submit_info.pWaitDstStageMask = stages.data();
+        vk_submit_info.commandBufferCount = static_cast<uint32_t>(submit_info.command_buffers.size());
+        vk_submit_info.pCommandBuffers = submit_info.command_buffers.data();
+        vk_submit_info.signalSemaphoreCount = static_cast<uint32_t>(signal_semaphores.size());
+        vk_submit_info.pSignalSemaphores = signal_semaphores.data();
+
+        VkFence tracking_fence = timeline_semaphores ? VK_NULL_HANDLE : acquire_fence(target);
+        VkFence fence = submit_info.fence != VK_NULL_HANDLE ? submit_info.fence : tracking_fence;
+        if (vkQueueSubmit(target.queue, 1, &vk_submit_info, fence) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to submit to queue.");
+        }
+        if (!timeline_semaphores) {
+            // an empty submit signals its fence once everything before it on the queue is done
+            if (fence != tracking_fence && vkQueueSubmit(target.queue, 0, nullptr, tracking_fence) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to submit to queue.");
+            }
+            std::lock_guard<std::mutex> fence_lock{target.fence_mutex};
+            target.fence_submits.push_back({value, tracking_fence});
+        }
+        target.submitted_value.store(value, std::memory_order_release);
+        return Sync_Point{queue, value};
+    }
+
+    VkResult QueueSync::present(const VkPresentInfoKHR &present_info) {
+        std::lock_guard<std::mutex> lock{*queue_mutexes.at(present_queue)};
+        return vkQueuePresentKHR(present_queue, &present_info);
+    }
+
+    bool QueueSync::is_complete(Sync_Point point) {
+        if (!point.is_valid()) return true;
+        Queue_Timeline &queue_timeline = timeline(point.queue);
+        if (queue_timeline.completed_value.load(std::memory_order_acquire) >= point.value) return true;
+
+        if (timeline_semaphores) {
+            uint64_t value = 0;
+            get_semaphore_counter_value(device, queue_timeline.semaphore, &value);
+            uint64_t completed = queue_timeline.completed_value.load(std::memory_order_relaxed);
+            while (completed < value &&
+                   !queue_timeline.completed_value.compare_exchange_weak(completed, value, std::memory_order_acq_rel)) {}
+            return value >= point.value;
+        }
+
+        std::lock_guard<std::mutex> lock{queue_timeline.fence_mutex};
+        poll_fences(queue_timeline);
+        return queue_timeline.completed_value.load(std::memory_order_acquire) >= point.value;
+    }
+
+    bool QueueSync::wait(Sync_Point point, uint64_t timeout) {
+        if (is_complete(point)) return true;
+        Queue_Timeline &queue_timeline = timeline(point.queue);
+        if (point.value > queue_timeline.submitted_value.load(std::memory_order_acquire)) {
+            throw std::runtime_error("Waiting on a sync point that was never submitted.");
+        }
+
+        PIXEL_PROFILE_ZONE("wait for sync point");
+        if (!timeline_semaphores) return wait_fences(queue_timeline, point.value, timeout);
+
+        VkSemaphoreWaitInfo wait_info{};
+        wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        wait_info.semaphoreCount = 1;
+        wait_info.pSemaphores = &queue_timeline.semaphore;
+        wait_info.pValues = &point.value;
+        if (wait_semaphores(device, &wait_info, timeout) == VK_TIMEOUT) return false;
+        return is_complete(point);
+    }
+
+    void QueueSync::wait_idle() {
+        for (uint32_t i = 0; i < QUEUE_TYPE_COUNT; i++) {
+            wait(get_last_submitted(static_cast<Queue_Type>(i)));
+        }
+    }
+
+    Sync_Point QueueSync::get_last_submitted(Queue_Type queue) {
+        return Sync_Point{queue, timeline(queue).submitted_value.load(std::memory_order_acquire)};
+    }
+
+    uint64_t QueueSync::get_completed_value(Queue_Type queue) {
+        is_complete(Sync_Point{queue, UINT64_MAX});
+        return timeline(queue).completed_value.load(std::memory_order_acquire);
+    }
+
+} // namespace graph_vulkan
@@ -0,0 +1,137 @@
+/**
+ * library_support/Graphic/vulkan/sync
+ *
+ * Submission and synchronization of the graphics, transfer and compute queues
+ *
+ * Every queue has its own timeline, a counter that goes up by one with every
+ * submit. A submit returns the Sync_Point it signals, other submits wait on it
+ * on the GPU, the CPU polls or waits on it, so a texture upload on the transfer
+ * queue and the frame that samples it overlap without anybody calling
+ * vkQueueWaitIdle.
+ *
+ * With Vulkan 1.2 every timeline is a timeline semaphore. On 1.0 devices each
+ * submit gets a fence instead: the CPU side works the same, a GPU wait on
+ * another queue turns into a CPU wait on that fence before the submit.
+ *
+ * Every vkQueueSubmit and vkQueuePresentKHR goes through here, the queue
+ * mutexes cover queues that are shared between the timelines.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_GRAPHIC_VULKAN_QUEUE_SYNC_H
+#define PIXEL_ENGINE_GRAPHIC_VULKAN_QUEUE_SYNC_H
+
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace graph_vulkan{
+    enum class Queue_Type : uint32_t {graphics, transfer, compute};
+    constexpr uint32_t QUEUE_TYPE_COUNT = 3;
+
+    // value 0 is never signaled by a submit, it stands for nothing to wait on
+    struct Sync_Point {
+        Queue_Type queue = Queue_Type::graphics;
+        uint64_t value = 0;
+
+        bool is_valid() const { return value != 0; }
+    };
+
+    struct Sync_Wait {
+        Sync_Point point;
+        // the stages of this submit that have to wait
+        VkPipelineStageFlags stage_mask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    };
+
+    struct Queue_Submit_Info {
+        std::vector<VkCommandBuffer> command_buffers;
+        std::vector<Sync_Wait> waits;
+        // binary semaphores outside of the timelines, like the swap chain's acquire and present
+        std::vector<VkSemaphore> wait_semaphores;
+        std::vector<VkPipelineStageFlags> wait_stages;
+        std::vector<VkSemaphore> signal_semaphores;
+        // signaled as well when set, for code that still waits on a fence
+        VkFence fence = VK_NULL_HANDLE;
+    };
+
+    class QueueSync {
+    private:
+        struct Fence_Submit {
+            uint64_t value;
+            VkFence fence;
+        };
+
+        struct Queue_Timeline {
+            VkQueue queue = VK_NULL_HANDLE;
+            // shared with every timeline on the same VkQueue
+            std::mutex *queue_mutex = nullptr;
+
+            VkSemaphore semaphore = VK_NULL_HANDLE;
+            // only moved on under queue_mutex
+            std::atomic<uint64_t> submitted_value{0};
+            std::atomic<uint64_t> completed_value{0};
+
+            // fence fallback, guarded by fence_mutex
+            std::mutex fence_mutex;
+            std::deque<Fence_Submit> fence_submits;
+            std::vector<VkFence> free_fences;
+        };
+
+        VkDevice device;
+        bool timeline_semaphores;
+        PFN_vkWaitSemaphores wait_semaphores = nullptr;
+        PFN_vkGetSemaphoreCounterValue get_semaphore_counter_value = nullptr;
+
+        Queue_Timeline timelines[QUEUE_TYPE_COUNT];
+        std::map<VkQueue, std::unique_ptr<std::mutex>> queue_mutexes;
+        VkQueue present_queue;
+
+        Queue_Timeline &timeline(Queue_Type queue) { return timelines[static_cast<uint32_t>(queue)]; }
+        std::mutex &mutex_for(VkQueue queue);
+        VkFence acquire_fence(Queue_Timeline &timeline);
+        // fence fallback, retires the finished fences from the front
+        void poll_fences(Queue_Timeline &timeline);
+        bool wait_fences(Queue_Timeline &timeline, uint64_t value, uint64_t timeout);
+
+    public:
+        QueueSync(
+                VkDevice device,
+                bool timeline_semaphores,
+                VkQueue graphics_queue,
+                VkQueue transfer_queue,
+                VkQueue compute_queue,
+                VkQueue present_queue
+                );
+        // the queues have to be idle
+        ~QueueSync();
+
+        QueueSync(const QueueSync &) = delete;
+        QueueSync &operator = (const QueueSync &) = delete;
+
+        bool has_timeline_semaphores() const { return timeline_semaphores; }
+
+        // safe from any thread, returns the point signaled once the command buffers finished
+        Sync_Point submit(Queue_Type queue, const Queue_Submit_Info &submit_info);
+        VkResult present(const VkPresentInfoKHR &present_info);
+
+        bool is_complete(Sync_Point point);
+        // false when timeout nanoseconds passed first
+        bool wait(Sync_Point point, uint64_t timeout = UINT64_MAX);
+        void wait_idle();
+
+        Sync_Point get_last_submitted(Queue_Type queue);
+        uint64_t get_completed_value(Queue_Type queue);
+    };
+
+} // namespace graph_vulkan
+
+
+#endif // PIXEL_ENGINE_GRAPHIC_VULKAN_QUEUE_SYNC_H
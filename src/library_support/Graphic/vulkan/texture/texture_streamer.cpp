@@ -0,0 +1,525 @@
+/**
+ * library_support/Graphic/vulkan/texture
+ *
+ **/
+
+// match hpp file
+#include "texture_streamer.hpp"
+#include "../../../Profiling/profiler/profiler.hpp"
+//standard libraries
+#include <algorithm>
+#include <iomanip>
+#include <stdexcept>
+
+namespace graph_vulkan{
+    namespace {
+        uint32_t level_extent(uint32_t size, uint32_t level) {
+            return std::max(1u, size >> level);
+        }
+    } // namespace
+
+    TextureStreamer::TextureStreamer(
+            Device &device,
+            UploadService &upload_service,
+            BindlessDescriptors *bindless,
+            const Texture_Streaming_Config &config
+            ) : device{device}, upload_service{upload_service}, bindless{bindless}, config{config} {
+        VkCommandPoolCreateInfo pool_info = {};
+        pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        pool_info.queueFamilyIndex = device.find_physical_queue_families().graphics_Family;
+        pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        if (vkCreateCommandPool(device.device(), &pool_info, nullptr, &mip_command_pool) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create mip generation command pool.");
+        }
+    }
+
+    TextureStreamer::~TextureStreamer() {
+        for (auto &texture : textures) {
+            if (texture == nullptr) continue;
+            wait_pending(*texture);
+            release_image(texture->pending);
+            release_image(texture->resident);
+            if (bindless != nullptr && texture->bindless_index != INVALID_BINDLESS_INDEX) {
+                bindless->remove(Bindless_Type::sampled_image, texture->bindless_index);
+            }
+        }
+        for (const auto &mip_command_buffer : mip_command_buffers) {
+            device.sync().wait(mip_command_buffer.sync_point);
+        }
+        vkDestroyCommandPool(device.device(), mip_command_pool, nullptr);
+    }
+
+    VkFormat TextureStreamer::vk_format_of(file_io::Texture_Format format, bool srgb) {
+        switch (format) {
+            case file_io::Texture_Format::rgba8:
+                return srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+            case file_io::Texture_Format::bc1_rgb:
+                return srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+            case file_io::Texture_Format::bc1_rgba:
+                return srgb ? VK_FORMAT_BC1_RGBA_SRGB_BLOCK : VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+            case file_io::Texture_Format::bc2:
+                return srgb ? VK_FORMAT_BC2_SRGB_BLOCK : VK_FORMAT_BC2_UNORM_BLOCK;
+            case file_io::Texture_Format::bc3:
+                return srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+            case file_io::Texture_Format::bc4_unorm:
+                return VK_FORMAT_BC4_UNORM_BLOCK;
+            case file_io::Texture_Format::bc4_snorm:
+                return VK_FORMAT_BC4_SNORM_BLOCK;
+            case file_io::Texture_Format::bc5_unorm:
+                return VK_FORMAT_BC5_UNORM_BLOCK;
+            case file_io::Texture_Format::bc5_snorm:
+                return VK_FORMAT_BC5_SNORM_BLOCK;
+            case file_io::Texture_Format::bc6h_ufloat:
+                return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+            case file_io::Texture_Format::bc6h_sfloat:
+                return VK_FORMAT_BC6H_SFLOAT_BLOCK;
+            case file_io::Texture_Format::bc7:
+                return srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+        }
+        return VK_FORMAT_UNDEFINED;
+    }
+
+    VkFormat TextureStreamer::choose_format(const file_io::TextureFile &file) {
+        // BC formats are optional, mobile GPUs usually lack them
+        try {
+            return device.find_supported_format(
+                    {vk_format_of(file.format(), file.is_srgb())},
+                    VK_IMAGE_TILING_OPTIMAL,
+                    VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT
+                    );
+        } catch (const std::runtime_error &) {
+            throw std::runtime_error("Texture format of " + file.name() + " is not supported by the device.");
+        }
+    }
+
+    bool TextureStreamer::can_generate_mips(VkFormat format) {
+        try {
+            device.find_supported_format(
+                    {format},
+                    VK_IMAGE_TILING_OPTIMAL,
+                    VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_BLIT_SRC_BIT |
+                    VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT
+                    );
+            return true;
+        } catch (const std::runtime_error &) {
+            return false;
+        }
+    }
+
+    Texture_Handle TextureStreamer::load(const std::string &path) {
+        PIXEL_PROFILE_ZONE("load texture");
+        return add_texture(std::make_unique<file_io::TextureFile>(path));
+    }
+
+    Texture_Handle TextureStreamer::load(const file_io::AssetArchive &archive, const std::string &name) {
+        PIXEL_PROFILE_ZONE("load texture");
+        const file_io::Archive_Entry *entry = archive.find(name);
+        if (entry == nullptr) throw std::runtime_error("Asset not found in " + archive.path() + ": " + name);
+        if (entry->compression == file_io::Archive_Compression::none) {
+            file_io::Asset_View contents = archive.view(*entry);
+            return add_texture(std::make_unique<file_io::TextureFile>(contents.data, contents.size, archive.path() + ":" + name));
+        }
+        return add_texture(std::make_unique<file_io::TextureFile>(archive.read(*entry), archive.path() + ":" + name));
+    }
+
+    Texture_Handle TextureStreamer::add_texture(std::unique_ptr<file_io::TextureFile> file) {
+        auto texture = std::make_unique<Streamed_Texture>();
+        texture->load_time = std::chrono::steady_clock::now();
+        texture->format = choose_format(*file);
+        texture->generate_mips = file->level_count() == 1 && !file_io::is_block_compressed(file->format()) &&
+                                 can_generate_mips(texture->format);
+        texture->level_count = texture->generate_mips
+                ? file_io::TextureFile::full_level_count(file->width(), file->height())
+                : file->level_count();
+        texture->file = std::move(file);
+
+        // a generated chain is whole from the start, it has no file levels to stream from
+        texture->base_level = texture->level_count - 1;
+        if (texture->generate_mips) {
+            texture->base_level = 0;
+        } else {
+            for (uint32_t level = 0; level < texture->level_count; level++) {
+                if (texture->file->level(level).width <= config.resident_size &&
+                    texture->file->level(level).height <= config.resident_size) {
+                    texture->base_level = level;
+                    break;
+                }
+            }
+        }
+        texture->wanted_level = texture->base_level;
+        texture->last_request = update_count;
+        start_transition(*texture, texture->base_level);
+
+        stats.texture_count++;
+        stats.full_bytes += level_bytes(*texture, 0);
+        if (texture->generate_mips) stats.generated_mip_chains++;
+
+        Texture_Handle handle;
+        if (!free_handles.empty()) {
+            handle = free_handles.back();
+            free_handles.pop_back();
+            textures[handle] = std::move(texture);
+        } else {
+            handle = static_cast<Texture_Handle>(textures.size());
+            textures.push_back(std::move(texture));
+        }
+        return handle;
+    }
+
+    void TextureStreamer::unload(Texture_Handle handle) {
+        Streamed_Texture &texture = *textures[handle];
+        // the transfer queue may still be writing the pending image
+        wait_pending(texture);
+        release_image(texture.pending);
+        release_image(texture.resident);
+        if (bindless != nullptr && texture.bindless_index != INVALID_BINDLESS_INDEX) {
+            bindless->remove(Bindless_Type::sampled_image, texture.bindless_index);
+        }
+
+        stats.texture_count--;
+        stats.full_bytes -= level_bytes(texture, 0);
+        if (texture.generate_mips) stats.generated_mip_chains--;
+        textures[handle].reset();
+        free_handles.push_back(handle);
+    }
+
+    void TextureStreamer::start_transition(Streamed_Texture &texture, uint32_t first_level) {
+        const file_io::TextureFile &file = *texture.file;
+        const uint32_t width = level_extent(file.width(), first_level);
+        const uint32_t height = level_extent(file.height(), first_level);
+        const uint32_t level_count = texture.level_count - first_level;
+
+        VkImageCreateInfo image_info{};
+        image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        image_info.imageType = VK_IMAGE_TYPE_2D;
+        image_info.extent = {width, height, 1};
+        image_info.mipLevels = level_count;
+        image_info.arrayLayers = 1;
+        image_info.format = texture.format;
+        image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        image_info.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        if (texture.generate_mips) image_info.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+        image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        Texture_Image &image = texture.pending;
+        device.create_image_with_info(image_info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image.image, image.memory);
+        image.first_level = first_level;
+
+        VkImageViewCreateInfo view_info{};
+        view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        view_info.image = image.image;
+        view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        view_info.format = texture.format;
+        view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        view_info.subresourceRange.levelCount = level_count;
+        view_info.subresourceRange.layerCount = 1;
+        if (vkCreateImageView(device.device(), &view_info, nullptr, &image.view) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create texture image view for " + file.name() + ".");
+        }
+
+        const VkDeviceSize alignment = file_io::texture_block_bytes(file.format());
+        if (texture.generate_mips) {
+            // level 0 stays a blit source until the chain is done
+            const file_io::Texture_Level &level = file.level(0);
+            texture.pending_upload = upload_service.upload_image(
+                    image.image, file.level_data(0), level.size, level.width, level.height, 1, 0,
+                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, alignment);
+            texture.pending_mips = generate_mips(image, width, height, level_count, texture.pending_upload);
+            stats.uploaded_bytes += level.size;
+        } else {
+            for (uint32_t level_index = first_level; level_index < texture.level_count; level_index++) {
+                const file_io::Texture_Level &level = file.level(level_index);
+                texture.pending_upload = upload_service.upload_image(
+                        image.image, file.level_data(level_index), level.size, level.width, level.height, 1,
+                        level_index - first_level, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, alignment);
+                stats.uploaded_bytes += level.size;
+            }
+        }
+    }
+
+    Sync_Point TextureStreamer::generate_mips(
+            const Texture_Image &image,
+            uint32_t width,
+            uint32_t height,
+            uint32_t level_count,
+            Upload_Ticket upload ){
+        VkCommandBuffer command_buffer;
+        if (!mip_command_buffers.empty() && device.sync().is_complete(mip_command_buffers.front().sync_point)) {
+            command_buffer = mip_command_buffers.front().command_buffer;
+            mip_command_buffers.pop_front();
+            vkResetCommandBuffer(command_buffer, 0);
+        } else {
+            VkCommandBufferAllocateInfo allocate_info{};
+            allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocate_info.commandPool = mip_command_pool;
+            allocate_info.commandBufferCount = 1;
+            if (vkAllocateCommandBuffers(device.device(), &allocate_info, &command_buffer) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to allocate mip generation command buffer.");
+            }
+        }
+
+        VkCommandBufferBeginInfo begin_info{};
+        begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(command_buffer, &begin_info);
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image.image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.layerCount = 1;
+
+        // every level below the first becomes a blit destination
+        barrier.subresourceRange.baseMipLevel = 1;
+        barrier.subresourceRange.levelCount = level_count - 1;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(
+                command_buffer,
+                VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                0, nullptr, 0, nullptr, 1, &barrier
+                );
+
+        // each level is filtered down from the one above, which turns into a blit source right after
+        barrier.subresourceRange.levelCount = 1;
+        for (uint32_t level = 1; level < level_count; level++) {
+            VkImageBlit blit{};
+            blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            blit.srcSubresource.mipLevel = level - 1;
+            blit.srcSubresource.layerCount = 1;
+            blit.srcOffsets[1] = {
+                    static_cast<int32_t>(level_extent(width, level - 1)),
+                    static_cast<int32_t>(level_extent(height, level - 1)),
+                    1};
+            blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            blit.dstSubresource.mipLevel = level;
+            blit.dstSubresource.layerCount = 1;
+            blit.dstOffsets[1] = {
+                    static_cast<int32_t>(level_extent(width, level)),
+                    static_cast<int32_t>(level_extent(height, level)),
+                    1};
+            vkCmdBlitImage(
+                    command_buffer,
+                    image.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                    image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    1, &blit, VK_FILTER_LINEAR
+                    );
+
+            barrier.subresourceRange.baseMipLevel = level;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            vkCmdPipelineBarrier(
+                    command_buffer,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                    0, nullptr, 0, nullptr, 1, &barrier
+                    );
+        }
+
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = level_count;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(
+                command_buffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+                0, nullptr, 0, nullptr, 1, &barrier
+                );
+        vkEndCommandBuffer(command_buffer);
+
+        // blits need a graphics queue, the upload ran on the transfer queue
+        Queue_Submit_Info submit_info{};
+        submit_info.command_buffers = {command_buffer};
+        Sync_Point upload_point = upload_service.get_sync_point(upload);
+        if (upload_point.is_valid()) submit_info.waits.push_back(Sync_Wait{upload_point, VK_PIPELINE_STAGE_TRANSFER_BIT});
+        Sync_Point sync_point = device.sync().submit(Queue_Type::graphics, submit_info);
+        mip_command_buffers.push_back(Mip_Command_Buffer{command_buffer, sync_point});
+        return sync_point;
+    }
+
+    bool TextureStreamer::is_transition_complete(const Streamed_Texture &texture) {
+        if (texture.pending.image == VK_NULL_HANDLE) return false;
+        if (texture.pending_mips.is_valid()) return device.sync().is_complete(texture.pending_mips);
+        return upload_service.is_complete(texture.pending_upload);
+    }
+
+    void TextureStreamer::wait_pending(Streamed_Texture &texture) {
+        if (texture.pending_mips.is_valid()) {
+            device.sync().wait(texture.pending_mips);
+        } else if (texture.pending.image != VK_NULL_HANDLE) {
+            upload_service.wait(texture.pending_upload);
+        }
+    }
+
+    void TextureStreamer::release_image(Texture_Image &image) {
+        // frames in flight may still sample it
+        if (image.view != VK_NULL_HANDLE) device.deletion_queue().push_image_view(image.view);
+        if (image.image != VK_NULL_HANDLE) device.deletion_queue().push_image(image.image, image.memory);
+        image = Texture_Image{};
+    }
+
+    void TextureStreamer::retire_transitions() {
+        for (auto &texture : textures) {
+            if (texture == nullptr || !is_transition_complete(*texture)) continue;
+
+            const bool first_upload = texture->resident.image == VK_NULL_HANDLE;
+            release_image(texture->resident);
+            texture->resident = texture->pending;
+            texture->pending = Texture_Image{};
+            texture->pending_mips = Sync_Point{};
+
+            if (bindless != nullptr) {
+                // frames in flight may still sample the old slot, the new view gets its own and the old one is
+                // handed out again after those frames
+                texture->bindless_index = bindless->replace_texture(texture->bindless_index, texture->resident.view);
+            }
+            if (first_upload) {
+                stats.ready_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - texture->load_time).count();
+                stats.ready_count++;
+            }
+        }
+    }
+
+    VkDeviceSize TextureStreamer::level_bytes(const Streamed_Texture &texture, uint32_t first_level) const {
+        VkDeviceSize bytes = 0;
+        for (uint32_t level = first_level; level < texture.level_count; level++) {
+            bytes += file_io::texture_level_size(
+                    texture.file->format(),
+                    level_extent(texture.file->width(), level),
+                    level_extent(texture.file->height(), level));
+        }
+        return bytes;
+    }
+
+    VkDeviceSize TextureStreamer::committed_bytes(const Streamed_Texture &texture) const {
+        VkDeviceSize bytes = texture.pending.memory.size;
+        const bool demoting = texture.pending.image != VK_NULL_HANDLE && texture.pending.first_level > texture.resident.first_level;
+        if (!demoting) bytes += texture.resident.memory.size;
+        return bytes;
+    }
+
+    VkDeviceSize TextureStreamer::committed_bytes() const {
+        VkDeviceSize bytes = 0;
+        for (const auto &texture : textures) {
+            if (texture != nullptr) bytes += committed_bytes(*texture);
+        }
+        return bytes;
+    }
+
+    bool TextureStreamer::demote_stale_texture() {
+        Streamed_Texture *stalest = nullptr;
+        for (auto &texture : textures) {
+            if (texture == nullptr || texture->resident.image == VK_NULL_HANDLE || texture->pending.image != VK_NULL_HANDLE) continue;
+            if (texture->resident.first_level >= texture->base_level) continue;
+            if (texture->last_request + config.idle_updates >= update_count) continue;
+            if (stalest == nullptr || texture->last_request < stalest->last_request) stalest = texture.get();
+        }
+        if (stalest == nullptr) return false;
+
+        // back to the coarse levels, they are small enough to upload again; until it is requested again it
+        // does not want more
+        stalest->wanted_level = stalest->base_level;
+        start_transition(*stalest, stalest->base_level);
+        stats.demotions++;
+        return true;
+    }
+
+    void TextureStreamer::request(Texture_Handle handle, uint32_t level) {
+        Streamed_Texture &texture = *textures[handle];
+        texture.wanted_level = std::min(level, texture.base_level);
+        texture.last_request = update_count;
+    }
+
+    void TextureStreamer::update() {
+        PIXEL_PROFILE_ZONE("texture streaming");
+        update_count++;
+        retire_transitions();
+
+        std::vector<Streamed_Texture *> candidates;
+        for (auto &texture : textures) {
+            // a stale request is not worth promoting, it would be the first to be demoted again
+            if (texture != nullptr && texture->resident.image != VK_NULL_HANDLE && texture->pending.image == VK_NULL_HANDLE &&
+                texture->wanted_level < texture->resident.first_level &&
+                texture->last_request + config.idle_updates >= update_count) {
+                candidates.push_back(texture.get());
+            }
+        }
+        // what was asked for most recently first, then whatever is missing the most detail
+        std::sort(candidates.begin(), candidates.end(), [](const Streamed_Texture *a, const Streamed_Texture *b) {
+            if (a->last_request != b->last_request) return a->last_request > b->last_request;
+            return a->resident.first_level - a->wanted_level > b->resident.first_level - b->wanted_level;
+        });
+
+        VkDeviceSize started = 0;
+        VkDeviceSize committed = committed_bytes();
+        for (Streamed_Texture *texture : candidates) {
+            if (started >= config.max_upload_per_update) break;
+
+            // make room from textures nobody looks at, then settle for fewer levels if that is not enough
+            uint32_t target = texture->wanted_level;
+            while (committed + level_bytes(*texture, target) > config.memory_budget && demote_stale_texture()) {
+                committed = committed_bytes();
+            }
+            if (texture->pending.image != VK_NULL_HANDLE) continue;
+            while (target < texture->resident.first_level && committed + level_bytes(*texture, target) > config.memory_budget) {
+                target++;
+            }
+            if (target == texture->resident.first_level) continue;
+
+            start_transition(*texture, target);
+            stats.promotions++;
+            started += level_bytes(*texture, target);
+            committed = committed_bytes();
+        }
+
+        // loads and transitions of this frame go to the transfer queue together
+        upload_service.flush();
+
+        stats.resident_bytes = 0;
+        for (const auto &texture : textures) {
+            if (texture != nullptr) stats.resident_bytes += texture->resident.memory.size + texture->pending.memory.size;
+        }
+    }
+
+    bool TextureStreamer::is_ready(Texture_Handle handle) const {
+        return textures[handle]->resident.image != VK_NULL_HANDLE;
+    }
+
+    VkImageView TextureStreamer::view(Texture_Handle handle) const {
+        return textures[handle]->resident.view;
+    }
+
+    Bindless_Index TextureStreamer::bindless_index(Texture_Handle handle) const {
+        return textures[handle]->bindless_index;
+    }
+
+    uint32_t TextureStreamer::resident_level(Texture_Handle handle) const {
+        const Streamed_Texture &texture = *textures[handle];
+        return texture.resident.image != VK_NULL_HANDLE ? texture.resident.first_level : texture.level_count;
+    }
+
+    void TextureStreamer::print_stats(std::ostream &out) const {
+        constexpr double megabyte = 1024.0 * 1024.0;
+        out << std::fixed << std::setprecision(2)
+            << "Textures: " << stats.texture_count << " textures, "
+            << static_cast<double>(stats.resident_bytes) / megabyte << " MB resident of "
+            << static_cast<double>(stats.full_bytes) / megabyte << " MB with every level (budget "
+            << static_cast<double>(config.memory_budget) / megabyte << " MB)" << std::endl;
+        out << "    " << static_cast<double>(stats.uploaded_bytes) / megabyte << " MB uploaded, "
+            << stats.promotions << " promotions, " << stats.demotions << " demotions, "
+            << stats.generated_mip_chains << " generated mip chains, ready after "
+            << (stats.ready_count > 0 ? stats.ready_seconds * 1000.0 / stats.ready_count : 0.0)
+            << " ms on average" << std::defaultfloat << std::endl;
+    }
+
+} // namespace graph_vulkan
@@ -0,0 +1,187 @@
+/**
+ * library_support/Graphic/vulkan/texture
+ *
+ * Block compressed textures with progressive mip streaming under a budget
+ *
+ * KTX2 and DDS files are mapped and their levels go through the UploadService
+ * straight from the mapping. A texture starts with its coarse levels only (the
+ * ones no larger than resident_size), request() asks for finer ones and
+ * update() streams them in, most recently requested first, while the device
+ * memory of all textures stays under the budget; textures nobody asked for in
+ * a while give their fine levels back when the budget runs short.
+ *
+ * Changing the resident levels builds a new image with the wanted levels from
+ * the file and swaps it in once the upload finished, the old one goes to the
+ * deletion queue. The view (and the bindless slot, when there is one) changes
+ * with it, so look them up every frame instead of keeping them.
+ *
+ * Files without mips get theirs generated on the graphics queue with
+ * vkCmdBlitImage. Blits cannot write block compressed formats, those stay at
+ * the levels the file has.
+ *
+ * Not thread safe, load, request and update from the frame loop's thread.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_GRAPHIC_VULKAN_TEXTURE_STREAMER_H
+#define PIXEL_ENGINE_GRAPHIC_VULKAN_TEXTURE_STREAMER_H
+
+#pragma once
+
+#include "../device/device.hpp"
+#include "../descriptor/bindless_descriptors.hpp"
+#include "../upload/upload_service.hpp"
+#include "../../../File/archive/asset_archive.hpp"
+#include "../../../File/texture/texture_file.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace graph_vulkan{
+    using Texture_Handle = uint32_t;
+    constexpr Texture_Handle INVALID_TEXTURE = UINT32_MAX;
+
+    struct Texture_Streaming_Config {
+        // device memory of every texture together, the coarse levels stay resident even above it
+        VkDeviceSize memory_budget = 256ull * 1024 * 1024;
+        // levels up to this width and height are loaded with the texture, finer ones on request
+        uint32_t resident_size = 64;
+        // uploads started by one update(), so a burst of requests does not stall a frame
+        VkDeviceSize max_upload_per_update = 32ull * 1024 * 1024;
+        // updates without a request after which a texture may lose its fine levels
+        uint64_t idle_updates = 120;
+    };
+
+    struct Texture_Streaming_Stats {
+        uint32_t texture_count = 0;
+        // images in use and images being built
+        VkDeviceSize resident_bytes = 0;
+        // every level of every texture, what loading them whole would take
+        VkDeviceSize full_bytes = 0;
+        VkDeviceSize uploaded_bytes = 0;
+        uint32_t promotions = 0;
+        uint32_t demotions = 0;
+        uint32_t generated_mip_chains = 0;
+        // load() until the coarse levels could be sampled, summed over the textures
+        double ready_seconds = 0.0;
+        uint32_t ready_count = 0;
+    };
+
+    class TextureStreamer {
+    private:
+        struct Texture_Image {
+            VkImage image = VK_NULL_HANDLE;
+            Memory_Allocation memory{};
+            VkImageView view = VK_NULL_HANDLE;
+            // the file level in the image's level 0
+            uint32_t first_level = 0;
+        };
+
+        struct Streamed_Texture {
+            std::unique_ptr<file_io::TextureFile> file;
+            VkFormat format = VK_FORMAT_UNDEFINED;
+            // of the full chain, more than the file has when the mips are generated
+            uint32_t level_count = 1;
+            bool generate_mips = false;
+            // the finest level that is always resident
+            uint32_t base_level = 0;
+            uint32_t wanted_level = 0;
+            uint64_t last_request = 0;
+
+            Texture_Image resident;
+            Texture_Image pending;
+            Upload_Ticket pending_upload{};
+            // mip generation on the graphics queue, after the upload
+            Sync_Point pending_mips{};
+            std::chrono::steady_clock::time_point load_time;
+
+            Bindless_Index bindless_index = INVALID_BINDLESS_INDEX;
+        };
+
+        struct Mip_Command_Buffer {
+            VkCommandBuffer command_buffer;
+            Sync_Point sync_point;
+        };
+
+        Device &device;
+        UploadService &upload_service;
+        // may be null
+        BindlessDescriptors *bindless;
+        Texture_Streaming_Config config;
+        Texture_Streaming_Stats stats;
+
+        // null entries are free handles
+        std::vector<std::unique_ptr<Streamed_Texture>> textures;
+        std::vector<Texture_Handle> free_handles;
+        uint64_t update_count = 0;
+
+        VkCommandPool mip_command_pool = VK_NULL_HANDLE;
+        std::deque<Mip_Command_Buffer> mip_command_buffers;
+
+        VkFormat choose_format(const file_io::TextureFile &file);
+        bool can_generate_mips(VkFormat format);
+        Texture_Handle add_texture(std::unique_ptr<file_io::TextureFile> file);
+
+        // builds the image holding first_level and everything coarser, swapped in by retire_transitions()
+        void start_transition(Streamed_Texture &texture, uint32_t first_level);
+        Sync_Point generate_mips(const Texture_Image &image, uint32_t width, uint32_t height, uint32_t level_count, Upload_Ticket upload);
+        bool is_transition_complete(const Streamed_Texture &texture);
+        void retire_transitions();
+        void release_image(Texture_Image &image);
+        void wait_pending(Streamed_Texture &texture);
+
+        // device memory of the levels, an estimate until the image exists
+        VkDeviceSize level_bytes(const Streamed_Texture &texture, uint32_t first_level) const;
+        // what the texture will hold once its transition is done, the old image is going away
+        VkDeviceSize committed_bytes(const Streamed_Texture &texture) const;
+        VkDeviceSize committed_bytes() const;
+        // frees one stale texture's fine levels, false when there is none
+        bool demote_stale_texture();
+
+    public:
+        // bindless, when given, has to outlive the streamer
+        TextureStreamer(
+                Device &device,
+                UploadService &upload_service,
+                BindlessDescriptors *bindless = nullptr,
+                const Texture_Streaming_Config &config = {}
+                );
+        ~TextureStreamer();
+
+        TextureStreamer(const TextureStreamer &) = delete;
+        TextureStreamer &operator = (const TextureStreamer &) = delete;
+
+        // a .ktx2 or .dds file, throws when the file or its format is not supported by the device
+        Texture_Handle load(const std::string &path);
+        // from an archive that outlives the streamer, stored assets are not copied
+        Texture_Handle load(const file_io::AssetArchive &archive, const std::string &name);
+        void unload(Texture_Handle handle);
+
+        // the finest level this texture should have, 0 is the full size; called every frame it is visible
+        void request(Texture_Handle handle, uint32_t level = 0);
+        // once per frame: swaps in finished levels, then starts new uploads and demotions within the budget
+        void update();
+
+        // false until the coarse levels are uploaded, there is nothing to sample before that
+        bool is_ready(Texture_Handle handle) const;
+        VkImageView view(Texture_Handle handle) const;
+        // INVALID_BINDLESS_INDEX until ready or without bindless descriptors
+        Bindless_Index bindless_index(Texture_Handle handle) const;
+        // file level of the finest resident level
+        uint32_t resident_level(Texture_Handle handle) const;
+
+        const Texture_Streaming_Stats &get_stats() const { return stats; }
+        void print_stats(std::ostream &out) const;
+
+        static VkFormat vk_format_of(file_io::Texture_Format format, bool srgb);
+    };
+
+} // namespace graph_vulkan
+
+
+#endif // PIXEL_ENGINE_GRAPHIC_VULKAN_TEXTURE_STREAMER_H
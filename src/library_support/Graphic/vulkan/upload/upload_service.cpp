@@ -0,0 +1,437 @@
+/**
+ * library_support/Graphic/vulkan/upload
+ *
+ **/
+
+// match hpp file
+#include "upload_service.hpp"
+//standard libraries
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <tuple>
+
+namespace graph_vulkan{
+    static VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment){
+        return alignment <= 1 ? value : (value + alignment - 1) / alignment * alignment;
+    }
+
+    UploadService::UploadService(Device &device, VkDeviceSize ring_size) : device{device}, ring_size{ring_size} {
+        create_command_pool();
+
+        device.create_buffer(
+                ring_size,
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                ring_buffer,
+                ring_memory
+                );
+
+        recording_batch.serial = next_serial++;
+    }
+
+    UploadService::~UploadService() {
+        wait_idle();
+
+        vkDestroyCommandPool(device.device(), command_pool, nullptr);
+        device.destroy_buffer(ring_buffer, ring_memory);
+    }
+
+    void UploadService::create_command_pool() {
+        VkCommandPoolCreateInfo pool_info = {};
+        pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        pool_info.queueFamilyIndex = device.find_physical_queue_families().transfer_Family;
+        pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+        if (vkCreateCommandPool(device.device(), &pool_info, nullptr, &command_pool) != VK_SUCCESS){
+            throw std::runtime_error("Failed to create upload command pool. ");
+        }
+    }
+
+    bool UploadService::try_allocate_staging(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset) {
+        if (ring_in_use == 0) {
+            ring_head = ring_tail = 0;
+        }
+
+        VkDeviceSize aligned = align_up(ring_head, alignment);
+        VkDeviceSize consumed;
+        if (ring_head >= ring_tail && !(ring_in_use > 0 && ring_head == ring_tail)) {
+            // free space is [head, size) followed by [0, tail)
+            if (aligned + size <= ring_size) {
+                offset = aligned;
+                consumed = aligned + size - ring_head;
+            } else if (size <= ring_tail) {
+                offset = 0;
+                consumed = (ring_size - ring_head) + size;
+            } else {
+                return false;
+            }
+        } else {
+            // ring is wrapped, free space is [head, tail)
+            if (aligned + size > ring_tail) return false;
+            offset = aligned;
+            consumed = aligned + size - ring_head;
+        }
+
+        ring_head = offset + size;
+        ring_in_use += consumed;
+        recording_batch.ring_end = ring_head;
+        recording_batch.ring_consumed += consumed;
+        return true;
+    }
+
+    VkDeviceSize UploadService::allocate_staging(VkDeviceSize size, VkDeviceSize alignment) {
+        VkDeviceSize offset = 0;
+        if (try_allocate_staging(size, alignment, offset)) return offset;
+
+        // the ring is full, hand what we have to the GPU and recycle finished batches
+        submit_batch();
+        retire_batches(false);
+        while (!try_allocate_staging(size, alignment, offset)) {
+            if (in_flight_batches.empty()) {
+                throw std::runtime_error("Upload does not fit into the staging ring.");
+            }
+            retire_batches(true);
+        }
+        return offset;
+    }
+
+    void UploadService::record_batch(Batch &batch) {
+        VkCommandBufferBeginInfo begin_info{};
+        begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(batch.command_buffer, &begin_info);
+
+        // copies run in the order they were recorded, a run of copies between the same buffers shares one
+        // vkCmdCopyBuffer; touching a range an earlier copy wrote needs a barrier first
+        std::map<VkBuffer, std::map<VkDeviceSize, VkDeviceSize>> written;
+        auto overlaps_written = [&written](VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size) {
+            auto ranges = written.find(buffer);
+            if (ranges == written.end()) return false;
+            // the written ranges never overlap each other, only the neighbours of offset can
+            auto next = ranges->second.lower_bound(offset);
+            if (next != ranges->second.end() && next->first < offset + size) return true;
+            return next != ranges->second.begin() && std::prev(next)->second > offset;
+        };
+
+        std::vector<VkBufferCopy> regions;
+        VkBuffer regions_src = VK_NULL_HANDLE;
+        VkBuffer regions_dst = VK_NULL_HANDLE;
+        auto record_regions = [&]() {
+            if (regions.empty()) return;
+            vkCmdCopyBuffer(
+                    batch.command_buffer,
+                    regions_src,
+                    regions_dst,
+                    static_cast<uint32_t>(regions.size()),
+                    regions.data()
+                    );
+            regions.clear();
+        };
+
+        for (const auto &copy : batch.buffer_copies) {
+            if (overlaps_written(copy.src, copy.region.srcOffset, copy.region.size) ||
+                overlaps_written(copy.dst, copy.region.dstOffset, copy.region.size)) {
+                record_regions();
+                VkMemoryBarrier barrier{};
+                barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+                vkCmdPipelineBarrier(
+                        batch.command_buffer,
+                        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                        1, &barrier, 0, nullptr, 0, nullptr
+                        );
+                written.clear();
+            }
+            if (copy.src != regions_src || copy.dst != regions_dst) {
+                record_regions();
+                regions_src = copy.src;
+                regions_dst = copy.dst;
+            }
+            regions.push_back(copy.region);
+            written[copy.dst].emplace(copy.region.dstOffset, copy.region.dstOffset + copy.region.size);
+        }
+        record_regions();
+
+        if (!batch.image_copies.empty()) {
+            std::vector<VkImageMemoryBarrier> to_transfer;
+            std::vector<VkImageMemoryBarrier> to_final;
+            std::set<std::tuple<VkImage, uint32_t, uint32_t>> transitioned;
+
+            for (const auto &copy : batch.image_copies) {
+                const VkImageSubresourceLayers &layers = copy.region.imageSubresource;
+                if (!transitioned.emplace(copy.image, layers.mipLevel, layers.layerCount).second) continue;
+
+                VkImageMemoryBarrier barrier{};
+                barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.image = copy.image;
+                barrier.subresourceRange.aspectMask = layers.aspectMask;
+                barrier.subresourceRange.baseMipLevel = layers.mipLevel;
+                barrier.subresourceRange.levelCount = 1;
+                barrier.subresourceRange.baseArrayLayer = layers.baseArrayLayer;
+                barrier.subresourceRange.layerCount = layers.layerCount;
+
+                barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+                barrier.srcAccessMask = 0;
+                barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                to_transfer.push_back(barrier);
+
+                barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+                barrier.newLayout = copy.final_layout;
+                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+                to_final.push_back(barrier);
+            }
+
+            vkCmdPipelineBarrier(
+                    batch.command_buffer,
+                    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                    0, nullptr, 0, nullptr,
+                    static_cast<uint32_t>(to_transfer.size()), to_transfer.data()
+                    );
+            for (const auto &copy : batch.image_copies) {
+                vkCmdCopyBufferToImage(
+                        batch.command_buffer,
+                        copy.src,
+                        copy.image,
+                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                        1,
+                        &copy.region
+                        );
+            }
+            vkCmdPipelineBarrier(
+                    batch.command_buffer,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+                    0, nullptr, 0, nullptr,
+                    static_cast<uint32_t>(to_final.size()), to_final.data()
+                    );
+        }
+
+        // make the buffer writes visible to everything submitted after this batch
+        VkMemoryBarrier memory_barrier{};
+        memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        memory_barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        vkCmdPipelineBarrier(
+                batch.command_buffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+                1, &memory_barrier, 0, nullptr, 0, nullptr
+                );
+
+        vkEndCommandBuffer(batch.command_buffer);
+    }
+
+    void UploadService::submit_batch() {
+        if (recording_batch.empty()) return;
+
+        Batch &batch = recording_batch;
+        if (!free_batches.empty()) {
+            batch.command_buffer = free_batches.back().command_buffer;
+            free_batches.pop_back();
+        } else {
+            VkCommandBufferAllocateInfo allocate_info{};
+            allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocate_info.commandPool = command_pool;
+            allocate_info.commandBufferCount = 1;
+            if (vkAllocateCommandBuffers(device.device(), &allocate_info, &batch.command_buffer) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to allocate upload command buffer.");
+            }
+        }
+
+        record_batch(batch);
+
+        Queue_Submit_Info submit_info{};
+        submit_info.command_buffers = {batch.command_buffer};
+        batch.sync_point = device.sync().submit(Queue_Type::transfer, submit_info);
+
+        // freed as soon as the transfer queue passed the batch, not with the next frame
+        for (auto &temporary : batch.temporary_buffers) {
+            device.deletion_queue().push_buffer(temporary.first, temporary.second, batch.sync_point);
+        }
+        batch.temporary_buffers.clear();
+
+        in_flight_batches.push_back(std::move(batch));
+        recording_batch = Batch{};
+        recording_batch.serial = next_serial++;
+    }
+
+    void UploadService::retire_batches(bool wait_oldest) {
+        if (wait_oldest && !in_flight_batches.empty()) {
+            device.sync().wait(in_flight_batches.front().sync_point);
+        }
+
+        // batches finish in submission order, stop at the first one still running
+        bool retired = false;
+        while (!in_flight_batches.empty() &&
+               device.sync().is_complete(in_flight_batches.front().sync_point)) {
+            Batch &batch = in_flight_batches.front();
+
+            if (batch.ring_consumed > 0) {
+                ring_tail = batch.ring_end;
+                ring_in_use -= batch.ring_consumed;
+            }
+            completed_serial = batch.serial;
+
+            vkResetCommandBuffer(batch.command_buffer, 0);
+
+            Batch recycled{};
+            recycled.command_buffer = batch.command_buffer;
+            free_batches.push_back(std::move(recycled));
+            in_flight_batches.pop_front();
+            retired = true;
+        }
+        // their oversized staging buffers went to the deletion queue keyed on the batch
+        if (retired) device.deletion_queue().collect();
+    }
+
+    Upload_Ticket UploadService::upload_buffer(
+            VkBuffer dst_buffer,
+            VkDeviceSize dst_offset,
+            const void *data,
+            VkDeviceSize size ){
+        std::lock_guard<std::mutex> lock{mutex};
+
+        // large uploads are streamed through the ring in pieces
+        const VkDeviceSize chunk_size = ring_size / 4;
+        for (VkDeviceSize done = 0; done < size;) {
+            VkDeviceSize chunk = std::min(size - done, chunk_size);
+            VkDeviceSize offset = allocate_staging(chunk, 4);
+            std::memcpy(static_cast<char *>(ring_memory.mapped) + offset, static_cast<const char *>(data) + done, chunk);
+
+            recording_batch.buffer_copies.push_back({ring_buffer, dst_buffer, {offset, dst_offset + done, chunk}});
+            done += chunk;
+        }
+
+        Upload_Ticket ticket{recording_batch.serial};
+        if (recording_batch.buffer_copies.size() + recording_batch.image_copies.size() >= MAX_COPIES_PER_BATCH) {
+            submit_batch();
+        }
+        return ticket;
+    }
+
+    Upload_Ticket UploadService::copy_buffer(
+            VkBuffer src_buffer,
+            VkBuffer dst_buffer,
+            VkDeviceSize size,
+            VkDeviceSize src_offset,
+            VkDeviceSize dst_offset ){
+        std::lock_guard<std::mutex> lock{mutex};
+
+        recording_batch.buffer_copies.push_back({src_buffer, dst_buffer, {src_offset, dst_offset, size}});
+
+        Upload_Ticket ticket{recording_batch.serial};
+        if (recording_batch.buffer_copies.size() + recording_batch.image_copies.size() >= MAX_COPIES_PER_BATCH) {
+            submit_batch();
+        }
+        return ticket;
+    }
+
+    Upload_Ticket UploadService::upload_image(
+            VkImage image,
+            const void *data,
+            VkDeviceSize size,
+            uint32_t width,
+            uint32_t height,
+            uint32_t layer_count,
+            uint32_t mip_level,
+            VkImageLayout final_layout,
+            VkDeviceSize texel_alignment ){
+        std::lock_guard<std::mutex> lock{mutex};
+
+        Image_Copy copy{};
+        copy.image = image;
+        copy.final_layout = final_layout;
+        copy.region.bufferRowLength = 0;
+        copy.region.bufferImageHeight = 0;
+        copy.region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        copy.region.imageSubresource.mipLevel = mip_level;
+        copy.region.imageSubresource.baseArrayLayer = 0;
+        copy.region.imageSubresource.layerCount = layer_count;
+        copy.region.imageOffset = {0, 0, 0};
+        copy.region.imageExtent = {width, height, 1};
+
+        if (size <= ring_size / 2) {
+            VkDeviceSize offset = allocate_staging(size, std::max<VkDeviceSize>(texel_alignment, 4));
+            std::memcpy(static_cast<char *>(ring_memory.mapped) + offset, data, size);
+            copy.src = ring_buffer;
+            copy.region.bufferOffset = offset;
+        } else {
+            // an image bigger than half the ring gets a one-off staging buffer
+            VkBuffer staging_buffer;
+            Memory_Allocation staging_memory;
+            device.create_buffer(
+                    size,
+                    VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                    staging_buffer,
+                    staging_memory
+                    );
+            std::memcpy(staging_memory.mapped, data, size);
+            recording_batch.temporary_buffers.emplace_back(staging_buffer, staging_memory);
+            copy.src = staging_buffer;
+            copy.region.bufferOffset = 0;
+        }
+        recording_batch.image_copies.push_back(copy);
+
+        Upload_Ticket ticket{recording_batch.serial};
+        if (recording_batch.buffer_copies.size() + recording_batch.image_copies.size() >= MAX_COPIES_PER_BATCH) {
+            submit_batch();
+        }
+        return ticket;
+    }
+
+    Upload_Ticket UploadService::flush() {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        if (recording_batch.empty()) return Upload_Ticket{recording_batch.serial - 1};
+        Upload_Ticket ticket{recording_batch.serial};
+        submit_batch();
+        retire_batches(false);
+        return ticket;
+    }
+
+    bool UploadService::is_complete(Upload_Ticket ticket) {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        retire_batches(false);
+        return ticket.batch <= completed_serial;
+    }
+
+    Sync_Point UploadService::get_sync_point(Upload_Ticket ticket) {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        if (ticket.batch <= completed_serial) return Sync_Point{};
+        if (ticket.batch >= recording_batch.serial) submit_batch();
+        for (const auto &batch : in_flight_batches) {
+            if (batch.serial >= ticket.batch) return batch.sync_point;
+        }
+        return Sync_Point{};
+    }
+
+    void UploadService::wait(Upload_Ticket ticket) {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        if (ticket.batch >= recording_batch.serial) submit_batch();
+        while (completed_serial < ticket.batch && !in_flight_batches.empty()) {
+            retire_batches(true);
+        }
+    }
+
+    void UploadService::wait_idle() {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        submit_batch();
+        while (!in_flight_batches.empty()) {
+            retire_batches(true);
+        }
+    }
+
+} // namespace graph_vulkan
@@ -0,0 +1,147 @@
+/**
+ * library_support/Graphic/vulkan/upload
+ *
+ * Asynchronous staging uploads for buffers and images
+ *
+ * Data is written into a persistently mapped staging ring, copies are collected
+ * into one batch and submitted together, every batch signals its own point on
+ * the transfer queue's timeline.
+ * Callers get an Upload_Ticket back and poll or wait on it instead of stalling
+ * the queue for every single copy.
+ *
+ * Batches run on the transfer queue of the device, which is a dedicated DMA
+ * queue when the hardware has one, so a resource must only be used by other
+ * queues once its ticket is complete, or by a submit that waits on the
+ * ticket's sync point.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_GRAPHIC_VULKAN_UPLOAD_SERVICE_H
+#define PIXEL_ENGINE_GRAPHIC_VULKAN_UPLOAD_SERVICE_H
+
+#pragma once
+
+#include "../device/device.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace graph_vulkan{
+    // identifies the batch an upload was recorded into, 0 means nothing to wait for
+    struct Upload_Ticket {
+        uint64_t batch = 0;
+    };
+
+    class UploadService {
+    private:
+        struct Buffer_Copy {
+            VkBuffer src;
+            VkBuffer dst;
+            VkBufferCopy region;
+        };
+
+        struct Image_Copy {
+            VkBuffer src;
+            VkImage image;
+            VkBufferImageCopy region;
+            VkImageLayout final_layout;
+        };
+
+        struct Batch {
+            uint64_t serial = 0;
+            VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+            // transfer queue point the batch signals, set once submitted
+            Sync_Point sync_point{};
+
+            // staging ring bytes owned by this batch, released when the batch finished
+            VkDeviceSize ring_end = 0;
+            VkDeviceSize ring_consumed = 0;
+
+            std::vector<Buffer_Copy> buffer_copies;
+            std::vector<Image_Copy> image_copies;
+            // oversized uploads which did not fit into the ring, handed to the deletion queue on submit
+            std::vector<std::pair<VkBuffer, Memory_Allocation>> temporary_buffers;
+
+            bool empty() const {
+                return buffer_copies.empty() && image_copies.empty();
+            }
+        };
+
+        Device &device;
+        VkCommandPool command_pool = VK_NULL_HANDLE;
+
+        VkBuffer ring_buffer = VK_NULL_HANDLE;
+        Memory_Allocation ring_memory{};
+        VkDeviceSize ring_size;
+        VkDeviceSize ring_head = 0;
+        VkDeviceSize ring_tail = 0;
+        VkDeviceSize ring_in_use = 0;
+
+        Batch recording_batch;
+        std::deque<Batch> in_flight_batches;
+        std::vector<Batch> free_batches;
+        uint64_t next_serial = 1;
+        uint64_t completed_serial = 0;
+
+        std::mutex mutex;
+
+        void create_command_pool();
+        void submit_batch();
+        void retire_batches(bool wait_oldest);
+        bool try_allocate_staging(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize &offset);
+        VkDeviceSize allocate_staging(VkDeviceSize size, VkDeviceSize alignment);
+        void record_batch(Batch &batch);
+
+    public:
+        static constexpr VkDeviceSize DEFAULT_RING_SIZE = 32ull * 1024 * 1024;
+        // a batch is submitted on its own once it collects this many copies
+        static constexpr size_t MAX_COPIES_PER_BATCH = 4096;
+
+        explicit UploadService(Device &device, VkDeviceSize ring_size = DEFAULT_RING_SIZE);
+        ~UploadService();
+
+        UploadService(const UploadService &) = delete;
+        UploadService &operator = (const UploadService &) = delete;
+
+        Upload_Ticket upload_buffer(
+                VkBuffer dst_buffer,
+                VkDeviceSize dst_offset,
+                const void *data,
+                VkDeviceSize size
+                );
+        Upload_Ticket copy_buffer(
+                VkBuffer src_buffer,
+                VkBuffer dst_buffer,
+                VkDeviceSize size,
+                VkDeviceSize src_offset = 0,
+                VkDeviceSize dst_offset = 0
+                );
+        // the touched subresource is transitioned from undefined to final_layout
+        Upload_Ticket upload_image(
+                VkImage image,
+                const void *data,
+                VkDeviceSize size,
+                uint32_t width,
+                uint32_t height,
+                uint32_t layer_count,
+                uint32_t mip_level = 0,
+                VkImageLayout final_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                VkDeviceSize texel_alignment = 16
+                );
+
+        // submit everything recorded so far, returns the ticket of that batch
+        Upload_Ticket flush();
+        bool is_complete(Upload_Ticket ticket);
+        // for a submit on another queue that uses the upload, submits the ticket's batch if it was still recording;
+        // invalid once the batch has finished
+        Sync_Point get_sync_point(Upload_Ticket ticket);
+        void wait(Upload_Ticket ticket);
+        void wait_idle();
+    };
+
+} // namespace graph_vulkan
+
+
+#endif // PIXEL_ENGINE_GRAPHIC_VULKAN_UPLOAD_SERVICE_H
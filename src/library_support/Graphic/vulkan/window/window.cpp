@@ -1,6 +1,8 @@
 
 #include "window.hpp"
 
+#include <stdexcept>
+
 namespace graph_vulkan{
 
     Window::Window(
@@ -15,16 +17,35 @@ namespace graph_vulkan{
         glfwTerminate();
     }
 
+    void Window::init_library() {
+        // does nothing when already initialized
+        if (glfwInit() != GLFW_TRUE){
+            throw std::runtime_error("Failed to initialize GLFW.");
+        }
+    }
+
     void Window::initWindow() {
-        glfwInit(); // initialize glfw library
+        init_library(); // initialize glfw library
         glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-        glfwWindowHint(GLFW_RESIZABLE,GLFW_FALSE);
+        glfwWindowHint(GLFW_RESIZABLE,GLFW_TRUE);
 
         window = glfwCreateWindow(
                 width, height,
                 name.c_str(),
                 nullptr, nullptr
                 );
+        glfwSetWindowUserPointer(window, this);
+        glfwSetFramebufferSizeCallback(window, framebuffer_resize_callback);
+
+        // on high DPI displays the framebuffer is larger than the window size we asked for
+        glfwGetFramebufferSize(window, &width, &height);
+    }
+
+    void Window::framebuffer_resize_callback(GLFWwindow *glfw_window, int new_width, int new_height) {
+        auto owner = reinterpret_cast<Window *>(glfwGetWindowUserPointer(glfw_window));
+        owner->framebuffer_resized = true;
+        owner->width = new_width;
+        owner->height = new_height;
     }
 
     bool Window::should_close() {
@@ -24,11 +24,13 @@ namespace graph_vulkan {
             GLFWwindow *window{};
             // measures of window
             std::string name;
-            const int width;
-            const int height;
+            int width;
+            int height;
+            bool framebuffer_resized = false;
 
             // create instance
             void initWindow();
+            static void framebuffer_resize_callback(GLFWwindow *glfw_window, int new_width, int new_height);
 
         public:
             // Initial function
@@ -39,8 +41,15 @@ namespace graph_vulkan {
             Window(const Window &) = delete;
             Window &operator = (const Window &) = delete;
 
+            // main thread only, lets the instance be created before the first window exists
+            static void init_library();
+
             // Listener to determine if the instance has been closed
             bool should_close();
+            // size of the framebuffer in pixels, 0 x 0 while minimized
+            VkExtent2D get_extent() { return {static_cast<uint32_t>(width), static_cast<uint32_t>(height)}; }
+            bool was_window_resized() { return framebuffer_resized; }
+            void reset_window_resized_flag() { framebuffer_resized = false; }
 
             void create_window_surface(VkInstance instance, VkSurfaceKHR *surface);
 
@@ -0,0 +1,244 @@
+/**
+ * library_support/Profiling/profiler
+ *
+ **/
+
+// match hpp file
+#include "profiler.hpp"
+//standard libraries
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+namespace profiling{
+    namespace {
+        void write_json_string(std::ostream &out, const std::string &text) {
+            out << '"';
+            for (char character : text) {
+                if (character == '"' || character == '\\') out << '\\';
+                if (static_cast<unsigned char>(character) < 0x20) {
+                    out << ' ';
+                    continue;
+                }
+                out << character;
+            }
+            out << '"';
+        }
+
+        // microseconds, which is what the trace format counts in
+        void write_event(std::ostream &out, bool &first, const char *name, uint32_t thread_id,
+                         int64_t start_ns, int64_t end_ns) {
+            out << (first ? "\n" : ",\n") << "{\"name\":";
+            write_json_string(out, name ? name : "?");
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread_id
+                << ",\"ts\":" << start_ns / 1000.0
+                << ",\"dur\":" << std::max<int64_t>(end_ns - start_ns, 0) / 1000.0 << "}";
+            first = false;
+        }
+
+        void write_thread_name(std::ostream &out, bool &first, uint32_t thread_id, const std::string &name) {
+            out << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread_id
+                << ",\"args\":{\"name\":";
+            write_json_string(out, name);
+            out << "}}";
+            first = false;
+        }
+
+        // nearest rank on sorted values
+        double percentile(const std::vector<double> &sorted, double fraction) {
+            if (sorted.empty()) return 0.0;
+            size_t rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+            return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+        }
+
+        constexpr uint32_t GPU_TRACK_ID = 1000000;
+    } // namespace
+
+    void Profiler::Frame_History::add(double ms) {
+        if (frame_ms.size() < FRAME_HISTORY) {
+            frame_ms.push_back(ms);
+        } else {
+            frame_ms[next] = ms;
+        }
+        next = (next + 1) % FRAME_HISTORY;
+    }
+
+    Frame_Stats Profiler::Frame_History::stats() const {
+        Frame_Stats stats{};
+        if (frame_ms.empty()) return stats;
+
+        std::vector<double> sorted = frame_ms;
+        std::sort(sorted.begin(), sorted.end());
+        double total_ms = 0.0;
+        for (double ms : sorted) total_ms += ms;
+
+        stats.frame_count = static_cast<uint32_t>(sorted.size());
+        stats.mean_ms = total_ms / static_cast<double>(sorted.size());
+        stats.p50_ms = percentile(sorted, 0.50);
+        stats.p95_ms = percentile(sorted, 0.95);
+        stats.p99_ms = percentile(sorted, 0.99);
+        stats.max_ms = sorted.back();
+        return stats;
+    }
+
+    Profiler::Profiler() : epoch{std::chrono::steady_clock::now()} {
+        gpu_track.id = GPU_TRACK_ID;
+        gpu_track.name = "GPU";
+    }
+
+    Profiler &Profiler::instance() {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    Profiler::Thread_Track &Profiler::current_track() {
+        thread_local Thread_Track *track = nullptr;
+        if (track) return *track;
+
+        std::lock_guard<std::mutex> lock{tracks_mutex};
+        tracks.push_back(std::make_unique<Thread_Track>());
+        track = tracks.back().get();
+        track->id = static_cast<uint32_t>(tracks.size());
+        track->name = "thread " + std::to_string(track->id);
+        return *track;
+    }
+
+    void Profiler::start_capture() {
+        {
+            std::lock_guard<std::mutex> lock{tracks_mutex};
+            for (auto &track : tracks) {
+                std::lock_guard<std::mutex> track_lock{track->mutex};
+                track->events.clear();
+            }
+            std::lock_guard<std::mutex> gpu_lock{gpu_track.mutex};
+            gpu_track.events.clear();
+        }
+        dropped_events.store(0, std::memory_order_relaxed);
+        capturing.store(true, std::memory_order_relaxed);
+    }
+
+    void Profiler::stop_capture() {
+        capturing.store(false, std::memory_order_relaxed);
+    }
+
+    void Profiler::set_thread_name(const std::string &name) {
+        Thread_Track &track = current_track();
+        std::lock_guard<std::mutex> lock{track.mutex};
+        track.name = name;
+    }
+
+    uint32_t Profiler::enter_zone() {
+        // the depth is only touched by the owning thread
+        return current_track().depth++;
+    }
+
+    void Profiler::leave_zone(const char *name, int64_t start_ns, int64_t end_ns, uint32_t depth) {
+        Thread_Track &track = current_track();
+        track.depth = depth;
+
+        std::lock_guard<std::mutex> lock{track.mutex};
+        if (track.events.size() >= MAX_EVENTS_PER_TRACK) {
+            dropped_events.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        track.events.push_back(Zone_Event{name, start_ns, end_ns, depth});
+    }
+
+    void Profiler::add_gpu_zone(const char *name, int64_t start_ns, int64_t end_ns) {
+        if (!is_capturing()) return;
+
+        std::lock_guard<std::mutex> lock{gpu_track.mutex};
+        if (gpu_track.events.size() >= MAX_EVENTS_PER_TRACK) {
+            dropped_events.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        gpu_track.events.push_back(Zone_Event{name, start_ns, end_ns, 0});
+    }
+
+    void Profiler::end_frame() {
+        int64_t now = now_ns();
+        {
+            std::lock_guard<std::mutex> lock{frame_mutex};
+            if (last_frame_end_ns >= 0) {
+                cpu_frames.add(static_cast<double>(now - last_frame_end_ns) / 1.0e6);
+            }
+            last_frame_end_ns = now;
+        }
+        if (is_capturing()) {
+            // frame boundaries show up as markers on the frame thread's track
+            Thread_Track &track = current_track();
+            std::lock_guard<std::mutex> lock{track.mutex};
+            if (track.events.size() < MAX_EVENTS_PER_TRACK) {
+                track.events.push_back(Zone_Event{"frame end", now, now, track.depth});
+            }
+        }
+    }
+
+    void Profiler::add_gpu_frame_time(double frame_ms) {
+        std::lock_guard<std::mutex> lock{frame_mutex};
+        gpu_frames.add(frame_ms);
+    }
+
+    Frame_Stats Profiler::cpu_frame_stats() {
+        std::lock_guard<std::mutex> lock{frame_mutex};
+        return cpu_frames.stats();
+    }
+
+    Frame_Stats Profiler::gpu_frame_stats() {
+        std::lock_guard<std::mutex> lock{frame_mutex};
+        return gpu_frames.stats();
+    }
+
+    void Profiler::write_chrome_trace(const std::string &path) {
+        std::ofstream file{path, std::ios::trunc};
+        if (!file) {
+            throw std::runtime_error("Failed to open trace file: " + path);
+        }
+        file << std::fixed << std::setprecision(3);
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+        bool first = true;
+        uint64_t event_count = 0;
+        std::lock_guard<std::mutex> lock{tracks_mutex};
+        for (auto &track : tracks) {
+            std::lock_guard<std::mutex> track_lock{track->mutex};
+            write_thread_name(file, first, track->id, track->name);
+            for (const auto &event : track->events) {
+                write_event(file, first, event.name, track->id, event.start_ns, event.end_ns);
+            }
+            event_count += track->events.size();
+        }
+        {
+            std::lock_guard<std::mutex> gpu_lock{gpu_track.mutex};
+            write_thread_name(file, first, gpu_track.id, gpu_track.name);
+            for (const auto &event : gpu_track.events) {
+                write_event(file, first, event.name, gpu_track.id, event.start_ns, event.end_ns);
+            }
+            event_count += gpu_track.events.size();
+        }
+        file << "\n]}\n";
+
+        if (!file) {
+            throw std::runtime_error("Failed to write trace file: " + path);
+        }
+        std::cout << "Profiler: wrote " << event_count << " zones to " << path;
+        uint64_t dropped = dropped_events.load(std::memory_order_relaxed);
+        if (dropped > 0) std::cout << " (" << dropped << " dropped)";
+        std::cout << std::endl;
+    }
+
+    void Profiler::print_frame_stats(std::ostream &out) {
+        auto print = [&out](const char *label, const Frame_Stats &stats) {
+            if (stats.frame_count == 0) return;
+            out << label << " frame time over " << stats.frame_count << " frames: mean " << stats.mean_ms
+                << " ms, p50 " << stats.p50_ms << ", p95 " << stats.p95_ms
+                << ", p99 " << stats.p99_ms << ", max " << stats.max_ms << std::endl;
+        };
+        print("CPU", cpu_frame_stats());
+        print("GPU", gpu_frame_stats());
+    }
+
+} // namespace profiling
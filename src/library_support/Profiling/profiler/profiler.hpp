@@ -0,0 +1,169 @@
+/**
+ * library_support/Profiling/profiler
+ *
+ * CPU zone profiler, rolling frame time statistics and Chrome trace export
+ *
+ * Zones are recorded into a per thread buffer, so threads never contend with
+ * each other, and only while a capture is running. The PIXEL_PROFILE_* macros
+ * compile to nothing unless PIXEL_ENGINE_PROFILING is defined. Frame times are
+ * always kept for the last FRAME_HISTORY frames, they cost one clock read per
+ * frame. GPU timelines are fed in by graph_vulkan::GpuProfiler.
+ *
+ * The capture is written as Chrome trace JSON, open it in chrome://tracing or
+ * https://ui.perfetto.dev.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_PROFILING_PROFILER_H
+#define PIXEL_ENGINE_PROFILING_PROFILER_H
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace profiling{
+#ifdef PIXEL_ENGINE_PROFILING
+    inline constexpr bool compiled_in = true;
+#else
+    inline constexpr bool compiled_in = false;
+#endif
+
+    struct Zone_Event {
+        // string literals only, the pointer is kept until the trace is written
+        const char *name = nullptr;
+        // nanoseconds since the profiler was created
+        int64_t start_ns = 0;
+        int64_t end_ns = 0;
+        uint32_t depth = 0;
+    };
+
+    struct Frame_Stats {
+        uint32_t frame_count = 0;
+        double mean_ms = 0.0;
+        double p50_ms = 0.0;
+        double p95_ms = 0.0;
+        double p99_ms = 0.0;
+        double max_ms = 0.0;
+    };
+
+    class Profiler {
+    private:
+        struct Thread_Track {
+            uint32_t id = 0;
+            std::string name;
+            // only contended while a trace is written
+            std::mutex mutex;
+            std::vector<Zone_Event> events;
+            uint32_t depth = 0;
+        };
+
+        struct Frame_History {
+            std::vector<double> frame_ms;
+            size_t next = 0;
+
+            void add(double ms);
+            Frame_Stats stats() const;
+        };
+
+        const std::chrono::steady_clock::time_point epoch;
+        std::atomic<bool> capturing{false};
+        std::atomic<uint64_t> dropped_events{0};
+
+        std::mutex tracks_mutex;
+        // never shrinks, threads that have exited keep their zones until the next capture
+        std::vector<std::unique_ptr<Thread_Track>> tracks;
+        Thread_Track gpu_track;
+
+        std::mutex frame_mutex;
+        Frame_History cpu_frames;
+        Frame_History gpu_frames;
+        int64_t last_frame_end_ns = -1;
+
+        Profiler();
+        Thread_Track &current_track();
+
+    public:
+        static constexpr size_t FRAME_HISTORY = 1024;
+        // per thread, a long capture keeps the first zones and drops the rest
+        static constexpr size_t MAX_EVENTS_PER_TRACK = 1u << 20;
+
+        static Profiler &instance();
+
+        Profiler(const Profiler &) = delete;
+        Profiler &operator = (const Profiler &) = delete;
+
+        // clears the zones of the previous capture
+        void start_capture();
+        void stop_capture();
+        bool is_capturing() const { return capturing.load(std::memory_order_relaxed); }
+
+        int64_t now_ns() const {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+        }
+
+        // shown as the track name in the trace
+        void set_thread_name(const std::string &name);
+        // depth bookkeeping for Cpu_Zone
+        uint32_t enter_zone();
+        void leave_zone(const char *name, int64_t start_ns, int64_t end_ns, uint32_t depth);
+        // start and end already translated to the CPU clock
+        void add_gpu_zone(const char *name, int64_t start_ns, int64_t end_ns);
+
+        // call once per frame on the thread that drives the frame loop
+        void end_frame();
+        void add_gpu_frame_time(double frame_ms);
+        Frame_Stats cpu_frame_stats();
+        Frame_Stats gpu_frame_stats();
+
+        // throws std::runtime_error when the file cannot be written
+        void write_chrome_trace(const std::string &path);
+        void print_frame_stats(std::ostream &out);
+    };
+
+    class Cpu_Zone {
+    private:
+        const char *name;
+        int64_t start_ns = 0;
+        uint32_t depth = 0;
+        bool active;
+
+    public:
+        explicit Cpu_Zone(const char *name) : name{name}, active{Profiler::instance().is_capturing()} {
+            if (!active) return;
+            Profiler &profiler = Profiler::instance();
+            depth = profiler.enter_zone();
+            start_ns = profiler.now_ns();
+        }
+        ~Cpu_Zone() {
+            if (!active) return;
+            Profiler &profiler = Profiler::instance();
+            profiler.leave_zone(name, start_ns, profiler.now_ns(), depth);
+        }
+
+        Cpu_Zone(const Cpu_Zone &) = delete;
+        Cpu_Zone &operator = (const Cpu_Zone &) = delete;
+    };
+
+} // namespace profiling
+
+#define PIXEL_PROFILE_CONCAT_INNER(a, b) a##b
+#define PIXEL_PROFILE_CONCAT(a, b) PIXEL_PROFILE_CONCAT_INNER(a, b)
+
+#ifdef PIXEL_ENGINE_PROFILING
+// times the enclosing scope, name must be a string literal
+#define PIXEL_PROFILE_ZONE(name) ::profiling::Cpu_Zone PIXEL_PROFILE_CONCAT(profile_zone_, __LINE__){name}
+#define PIXEL_PROFILE_THREAD(name) ::profiling::Profiler::instance().set_thread_name(name)
+#else
+#define PIXEL_PROFILE_ZONE(name) ((void)0)
+#define PIXEL_PROFILE_THREAD(name) ((void)0)
+#endif
+
+
+#endif // PIXEL_ENGINE_PROFILING_PROFILER_H
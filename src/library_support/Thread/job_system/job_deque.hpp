@@ -0,0 +1,98 @@
+/**
+ * library_support/Thread/job_system
+ *
+ * Lock free work stealing deque (Chase-Lev) of fixed capacity
+ *
+ * The owning thread pushes and pops at the bottom, last in first out, which
+ * keeps the jobs it just spawned hot in its cache. Any other thread steals
+ * from the top, taking the oldest and usually largest piece of work. Only a
+ * pop of the very last job races with thieves, everything else is a plain
+ * load and store.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_THREAD_JOB_DEQUE_H
+#define PIXEL_ENGINE_THREAD_JOB_DEQUE_H
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace jobs{
+    struct Job;
+
+    class JobDeque {
+    public:
+        // power of two, a full deque makes push fail instead of growing
+        static constexpr int64_t CAPACITY = 4096;
+
+    private:
+        static constexpr int64_t MASK = CAPACITY - 1;
+
+        // own cache lines, thieves hammer top while the owner works on bottom
+        alignas(64) std::atomic<int64_t> top{0};
+        alignas(64) std::atomic<int64_t> bottom{0};
+        alignas(64) std::array<std::atomic<Job *>, CAPACITY> slots{};
+
+    public:
+        JobDeque() = default;
+
+        JobDeque(const JobDeque &) = delete;
+        JobDeque &operator = (const JobDeque &) = delete;
+
+        // owner only, false when the deque is full
+        bool push(Job *job) {
+            int64_t b = bottom.load(std::memory_order_relaxed);
+            int64_t t = top.load(std::memory_order_acquire);
+            if (b - t >= CAPACITY) return false;
+            slots[b & MASK].store(job, std::memory_order_relaxed);
+            // publishes the slot to thieves that acquire bottom
+            bottom.store(b + 1, std::memory_order_release);
+            return true;
+        }
+
+        // owner only, nullptr when empty
+        Job *pop() {
+            int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+            bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t t = top.load(std::memory_order_relaxed);
+            if (t > b) {
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            Job *job = slots[b & MASK].load(std::memory_order_relaxed);
+            if (t == b) {
+                // last job, whoever moves top first gets it
+                if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    job = nullptr;
+                }
+                bottom.store(b + 1, std::memory_order_relaxed);
+            }
+            return job;
+        }
+
+        // any thread, nullptr when empty or when another thread won the race
+        Job *steal() {
+            int64_t t = top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t b = bottom.load(std::memory_order_acquire);
+            if (t >= b) return nullptr;
+            Job *job = slots[t & MASK].load(std::memory_order_relaxed);
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return nullptr;
+            }
+            return job;
+        }
+
+        bool empty() const {
+            return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+        }
+    };
+
+} // namespace jobs
+
+
+#endif // PIXEL_ENGINE_THREAD_JOB_DEQUE_H
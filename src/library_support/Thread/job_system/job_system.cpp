@@ -0,0 +1,266 @@
+/**
+ * library_support/Thread/job_system
+ *
+ **/
+
+// match hpp file
+#include "job_system.hpp"
+#include "../../Profiling/profiler/profiler.hpp"
+//standard libraries
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace jobs{
+    namespace {
+        // set on worker threads only, the main thread is recognised by its id
+        struct Worker_Identity {
+            const JobSystem *system = nullptr;
+            uint32_t index = JobSystem::NOT_A_JOB_THREAD;
+        };
+        thread_local Worker_Identity current_worker;
+
+        // rounds of looking for work before a worker goes to sleep
+        constexpr uint32_t IDLE_SPINS = 64;
+    } // namespace
+
+    uint32_t JobSystem::default_worker_count() {
+        uint32_t hardware_threads = std::thread::hardware_concurrency();
+        return hardware_threads > 1 ? hardware_threads - 1 : 0;
+    }
+
+    JobSystem::JobSystem(uint32_t worker_count) : main_thread_id{std::this_thread::get_id()} {
+        deques.reserve(worker_count + 1);
+        for (uint32_t i = 0; i <= worker_count; i++) {
+            deques.push_back(std::make_unique<JobDeque>());
+        }
+
+        workers.reserve(worker_count);
+        for (uint32_t i = 1; i <= worker_count; i++) {
+            workers.emplace_back(&JobSystem::worker_loop, this, i);
+        }
+    }
+
+    JobSystem::~JobSystem() {
+        {
+            std::lock_guard<std::mutex> lock{sleep_mutex};
+            stopping.store(true);
+        }
+        wake.notify_all();
+        for (auto &worker : workers) {
+            worker.join();
+        }
+
+        // nobody is left to run these
+        for (auto &deque : deques) {
+            while (Job *job = deque->steal()) delete job;
+        }
+        for (Job *job : injected_jobs) delete job;
+        for (Job *job : main_jobs) delete job;
+    }
+
+    uint32_t JobSystem::thread_index() const {
+        if (is_main_thread()) return 0;
+        if (current_worker.system == this) return current_worker.index;
+        return NOT_A_JOB_THREAD;
+    }
+
+    void JobSystem::schedule(Job_Function function, Job_Counter *counter) {
+        if (counter) counter->value.fetch_add(1, std::memory_order_relaxed);
+        push(new Job{std::move(function), counter, false});
+    }
+
+    void JobSystem::schedule_after(Job_Counter &dependency, Job_Function function, Job_Counter *counter) {
+        if (counter) counter->value.fetch_add(1, std::memory_order_relaxed);
+        Job *job = new Job{std::move(function), counter, false};
+        {
+            // the job that brings dependency to zero takes the same lock before it releases the continuations
+            std::lock_guard<std::mutex> lock{dependency.mutex};
+            if (dependency.value.load(std::memory_order_acquire) > 0) {
+                dependency.continuations.push_back(job);
+                return;
+            }
+        }
+        push(job);
+    }
+
+    void JobSystem::schedule_on_main(Job_Function function, Job_Counter *counter) {
+        if (counter) counter->value.fetch_add(1, std::memory_order_relaxed);
+        push(new Job{std::move(function), counter, true});
+    }
+
+    void JobSystem::push(Job *job) {
+        if (job->main_thread) {
+            std::lock_guard<std::mutex> lock{main_mutex};
+            main_jobs.push_back(job);
+            main_count.fetch_add(1, std::memory_order_release);
+            return;
+        }
+
+        uint32_t index = thread_index();
+        if (index == NOT_A_JOB_THREAD || !deques[index]->push(job)) {
+            std::lock_guard<std::mutex> lock{injection_mutex};
+            injected_jobs.push_back(job);
+            injected_count.fetch_add(1, std::memory_order_release);
+        }
+        notify_workers();
+    }
+
+    void JobSystem::notify_workers() {
+        work_epoch.fetch_add(1);
+        if (sleeping_workers.load() == 0) return;
+        // a worker between checking the epoch and sleeping holds the lock, so the wakeup cannot get lost
+        std::lock_guard<std::mutex> lock{sleep_mutex};
+        wake.notify_one();
+    }
+
+    Job *JobSystem::pop_main_job() {
+        if (main_count.load(std::memory_order_acquire) == 0) return nullptr;
+        std::lock_guard<std::mutex> lock{main_mutex};
+        if (main_jobs.empty()) return nullptr;
+        Job *job = main_jobs.front();
+        main_jobs.pop_front();
+        main_count.fetch_sub(1, std::memory_order_relaxed);
+        return job;
+    }
+
+    Job *JobSystem::find_job(uint32_t thread_index) {
+        if (thread_index == 0) {
+            if (Job *job = pop_main_job()) return job;
+        }
+        if (Job *job = deques[thread_index]->pop()) return job;
+
+        if (injected_count.load(std::memory_order_acquire) > 0) {
+            std::lock_guard<std::mutex> lock{injection_mutex};
+            if (!injected_jobs.empty()) {
+                Job *job = injected_jobs.front();
+                injected_jobs.pop_front();
+                injected_count.fetch_sub(1, std::memory_order_relaxed);
+                return job;
+            }
+        }
+
+        // start next to ourselves so the thieves spread over the victims
+        uint32_t count = thread_count();
+        for (uint32_t offset = 1; offset < count; offset++) {
+            if (Job *job = deques[(thread_index + offset) % count]->steal()) return job;
+        }
+        return nullptr;
+    }
+
+    void JobSystem::execute(Job *job) {
+        try {
+            job->function();
+        } catch (...) {
+            if (job->counter) {
+                std::lock_guard<std::mutex> lock{job->counter->mutex};
+                if (!job->counter->error) job->counter->error = std::current_exception();
+            } else {
+                std::cerr << "Job without a counter threw an exception, it is dropped." << std::endl;
+            }
+        }
+        Job_Counter *counter = job->counter;
+        delete job;
+        finish(counter);
+    }
+
+    void JobSystem::finish(Job_Counter *counter) {
+        if (!counter) return;
+
+        std::vector<Job *> released;
+        {
+            std::lock_guard<std::mutex> lock{counter->mutex};
+            if (counter->value.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+            released.swap(counter->continuations);
+        }
+        // counter may already be gone here
+        for (Job *job : released) push(job);
+    }
+
+    void JobSystem::wait(Job_Counter &counter) {
+        uint32_t index = thread_index();
+        while (counter.value.load(std::memory_order_acquire) > 0) {
+            Job *job = index != NOT_A_JOB_THREAD ? find_job(index) : nullptr;
+            if (job) {
+                execute(job);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+
+        std::exception_ptr error;
+        {
+            // the job that finished last is out of finish() once it let go of the lock
+            std::lock_guard<std::mutex> lock{counter.mutex};
+            error = counter.error;
+            counter.error = nullptr;
+        }
+        if (error) std::rethrow_exception(error);
+    }
+
+    void JobSystem::run_main_thread_jobs() {
+        if (!is_main_thread()) {
+            throw std::runtime_error("Main thread jobs run on the main thread only.");
+        }
+        // only the jobs queued so far, a job that schedules another one on main does not keep us here
+        uint32_t pending = main_count.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < pending; i++) {
+            Job *job = pop_main_job();
+            if (!job) break;
+            execute(job);
+        }
+    }
+
+    void JobSystem::parallel_for(
+            uint32_t begin,
+            uint32_t end,
+            uint32_t grain,
+            const std::function<void(uint32_t first, uint32_t last)> &body
+            ) {
+        if (end <= begin) return;
+        uint32_t count = end - begin;
+        if (grain == 0) grain = std::max(1u, count / (thread_count() * 4));
+
+        // a single chunk is not worth a job
+        if (count <= grain) {
+            body(begin, end);
+            return;
+        }
+
+        PIXEL_PROFILE_ZONE("parallel for");
+        Job_Counter counter;
+        for (uint32_t first = begin; first < end;) {
+            uint32_t last = first + std::min(grain, end - first);
+            schedule([&body, first, last]{ body(first, last); }, &counter);
+            first = last;
+        }
+        wait(counter);
+    }
+
+    void JobSystem::worker_loop(uint32_t thread_index) {
+        current_worker = Worker_Identity{this, thread_index};
+        PIXEL_PROFILE_THREAD("job worker " + std::to_string(thread_index));
+
+        uint32_t idle_rounds = 0;
+        while (!stopping.load(std::memory_order_relaxed)) {
+            uint64_t epoch = work_epoch.load();
+            if (Job *job = find_job(thread_index)) {
+                execute(job);
+                idle_rounds = 0;
+                continue;
+            }
+            if (++idle_rounds < IDLE_SPINS) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock{sleep_mutex};
+            sleeping_workers.fetch_add(1);
+            wake.wait(lock, [&]{ return stopping.load() || work_epoch.load() != epoch; });
+            sleeping_workers.fetch_sub(1);
+            idle_rounds = 0;
+        }
+    }
+
+} // namespace jobs
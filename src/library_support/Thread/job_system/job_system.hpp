@@ -0,0 +1,144 @@
+/**
+ * library_support/Thread/job_system
+ *
+ * Work stealing job scheduler
+ *
+ * Every worker thread owns a JobDeque. Jobs scheduled from a worker go onto
+ * its own deque, idle workers steal from the others, so a job that spawns more
+ * jobs keeps them local until somebody runs out of work. The thread that
+ * created the JobSystem is the main thread: it owns a deque as well, runs jobs
+ * while it waits and is the only thread that runs jobs scheduled with
+ * schedule_on_main, which is where GLFW and other main thread only calls go.
+ * Other threads may schedule jobs, they go through a locked injection queue.
+ *
+ * Completion is tracked with Job_Counter: scheduling a job against a counter
+ * increments it, finishing the job decrements it. wait() runs other jobs until
+ * the counter drops to zero, schedule_after() defers a job until then.
+ *
+ * Jobs should be small and must not block on anything but wait(), a blocked
+ * worker is a worker less for everybody else.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_THREAD_JOB_SYSTEM_H
+#define PIXEL_ENGINE_THREAD_JOB_SYSTEM_H
+
+#pragma once
+
+#include "job_deque.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace jobs{
+    using Job_Function = std::function<void()>;
+
+    // must outlive every job scheduled against or after it, wait() on it before it goes away
+    class Job_Counter {
+    private:
+        friend class JobSystem;
+
+        std::atomic<int32_t> value{0};
+        // taken by the job that brings value to zero, so wait() knows when it is done with the counter
+        std::mutex mutex;
+        std::vector<Job *> continuations;
+        // first exception a job of this counter threw, rethrown by wait()
+        std::exception_ptr error;
+
+    public:
+        Job_Counter() = default;
+
+        Job_Counter(const Job_Counter &) = delete;
+        Job_Counter &operator = (const Job_Counter &) = delete;
+
+        bool is_done() const { return value.load(std::memory_order_acquire) == 0; }
+    };
+
+    struct Job {
+        Job_Function function;
+        // decremented once the job ran, may be null
+        Job_Counter *counter = nullptr;
+        bool main_thread = false;
+    };
+
+    class JobSystem {
+    public:
+        static constexpr uint32_t NOT_A_JOB_THREAD = UINT32_MAX;
+
+    private:
+        std::thread::id main_thread_id;
+        // index 0 is the main thread's, then one per worker
+        std::vector<std::unique_ptr<JobDeque>> deques;
+        std::vector<std::thread> workers;
+
+        // jobs from threads without a deque and jobs that did not fit into one
+        std::mutex injection_mutex;
+        std::deque<Job *> injected_jobs;
+        std::atomic<uint32_t> injected_count{0};
+
+        std::mutex main_mutex;
+        std::deque<Job *> main_jobs;
+        std::atomic<uint32_t> main_count{0};
+
+        // workers without work sleep until the epoch moves
+        std::mutex sleep_mutex;
+        std::condition_variable wake;
+        std::atomic<uint64_t> work_epoch{0};
+        std::atomic<uint32_t> sleeping_workers{0};
+        std::atomic<bool> stopping{false};
+
+        void push(Job *job);
+        Job *find_job(uint32_t thread_index);
+        Job *pop_main_job();
+        void execute(Job *job);
+        void finish(Job_Counter *counter);
+        void notify_workers();
+        void worker_loop(uint32_t thread_index);
+
+    public:
+        // every hardware thread but one, the main thread being the other
+        static uint32_t default_worker_count();
+
+        // 0 workers is valid, jobs then run on whoever waits for them
+        explicit JobSystem(uint32_t worker_count = default_worker_count());
+        // jobs still queued are dropped without running
+        ~JobSystem();
+
+        JobSystem(const JobSystem &) = delete;
+        JobSystem &operator = (const JobSystem &) = delete;
+
+        // main thread and workers, the range of thread_index()
+        uint32_t thread_count() const { return static_cast<uint32_t>(deques.size()); }
+        // 0 on the main thread, 1 to thread_count() - 1 on workers, NOT_A_JOB_THREAD anywhere else
+        uint32_t thread_index() const;
+        bool is_main_thread() const { return std::this_thread::get_id() == main_thread_id; }
+
+        void schedule(Job_Function function, Job_Counter *counter = nullptr);
+        // runs once dependency dropped to zero, right away if it already has
+        void schedule_after(Job_Counter &dependency, Job_Function function, Job_Counter *counter = nullptr);
+        // runs on the main thread, from run_main_thread_jobs() or while it waits
+        void schedule_on_main(Job_Function function, Job_Counter *counter = nullptr);
+
+        // runs jobs until counter drops to zero, then rethrows the first exception one of them threw;
+        // a thread that is not a job thread only sleeps
+        void wait(Job_Counter &counter);
+        // main thread only, runs the main thread jobs queued so far, call it once per frame
+        void run_main_thread_jobs();
+
+        // body(first, last) over [begin, end) in chunks of grain, 0 picks a grain that gives every thread a few chunks;
+        // returns once every chunk ran
+        void parallel_for(uint32_t begin, uint32_t end, uint32_t grain, const std::function<void(uint32_t first, uint32_t last)> &body);
+    };
+
+} // namespace jobs
+
+
+#endif // PIXEL_ENGINE_THREAD_JOB_SYSTEM_H
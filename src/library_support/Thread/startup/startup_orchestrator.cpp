@@ -0,0 +1,171 @@
+/**
+ * library_support/Thread/startup
+ *
+ **/
+
+// match hpp file
+#include "startup_orchestrator.hpp"
+#include "../../Profiling/profiler/profiler.hpp"
+//standard libraries
+#include <algorithm>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+
+namespace jobs{
+    StartupOrchestrator::StartupOrchestrator(JobSystem &job_system) : job_system{job_system} {}
+
+    Phase_Id StartupOrchestrator::add_phase(
+            const char *name,
+            Job_Function function,
+            const std::vector<Phase_Id> &after,
+            bool main_thread
+            ) {
+        if (has_run) {
+            throw std::runtime_error("Startup phases cannot be added once the startup ran.");
+        }
+        Phase_Id id = static_cast<Phase_Id>(phases.size());
+        for (Phase_Id dependency : after) {
+            // only earlier phases, so the graph cannot have cycles
+            if (dependency >= id) {
+                throw std::runtime_error(std::string("Startup phase ") + name + " comes after a phase added later.");
+            }
+            phases[dependency]->dependents.push_back(id);
+        }
+
+        auto phase = std::make_unique<Phase>();
+        phase->name = name;
+        phase->function = std::move(function);
+        phase->main_thread = main_thread;
+        phase->after = after;
+        phase->waiting_for.store(static_cast<uint32_t>(after.size()), std::memory_order_relaxed);
+        phase->timing.name = name;
+        phases.push_back(std::move(phase));
+        return id;
+    }
+
+    void StartupOrchestrator::schedule_phase(Phase_Id id, Job_Counter &counter) {
+        auto job = [this, id, &counter]{ run_phase(id, counter); };
+        if (phases[id]->main_thread) {
+            job_system.schedule_on_main(job, &counter);
+        } else {
+            job_system.schedule(job, &counter);
+        }
+    }
+
+    void StartupOrchestrator::run_phase(Phase_Id id, Job_Counter &counter) {
+        Phase &phase = *phases[id];
+        profiling::Profiler &profiler = profiling::Profiler::instance();
+
+        std::exception_ptr error;
+        if (failed.load(std::memory_order_acquire)) {
+            phase.timing.skipped = true;
+        } else {
+#ifdef PIXEL_ENGINE_PROFILING
+            profiling::Cpu_Zone zone{phase.name};
+#endif
+            phase.timing.thread_index = job_system.thread_index();
+            phase.timing.start_ms = static_cast<double>(profiler.now_ns() - start_ns) / 1e6;
+            try {
+                phase.function();
+            } catch (...) {
+                error = std::current_exception();
+                failed.store(true, std::memory_order_release);
+            }
+            phase.timing.end_ms = static_cast<double>(profiler.now_ns() - start_ns) / 1e6;
+        }
+
+        // scheduled before this job finishes, so the counter cannot reach zero in between
+        for (Phase_Id dependent : phase.dependents) {
+            if (phases[dependent]->waiting_for.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                schedule_phase(dependent, counter);
+            }
+        }
+        if (error) std::rethrow_exception(error);
+    }
+
+    void StartupOrchestrator::run() {
+        if (!job_system.is_main_thread()) {
+            throw std::runtime_error("Startup has to run on the job system's main thread.");
+        }
+        if (has_run) {
+            throw std::runtime_error("Startup already ran.");
+        }
+        has_run = true;
+
+        PIXEL_PROFILE_ZONE("startup");
+        start_ns = profiling::Profiler::instance().now_ns();
+        Job_Counter counter;
+        for (Phase_Id id = 0; id < phases.size(); id++) {
+            if (phases[id]->after.empty()) schedule_phase(id, counter);
+        }
+        // the main thread runs its own phases from in here
+        std::exception_ptr error;
+        try {
+            job_system.wait(counter);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        total_ms = static_cast<double>(profiling::Profiler::instance().now_ns() - start_ns) / 1e6;
+        if (error) std::rethrow_exception(error);
+    }
+
+    std::vector<Startup_Phase_Timing> StartupOrchestrator::get_timings() const {
+        std::vector<Startup_Phase_Timing> timings;
+        timings.reserve(phases.size());
+        for (const auto &phase : phases) {
+            timings.push_back(phase->timing);
+        }
+        return timings;
+    }
+
+    void StartupOrchestrator::print_report(std::ostream &out) const {
+        double busy_ms = 0.0;
+        Phase_Id last = 0;
+        for (Phase_Id id = 0; id < phases.size(); id++) {
+            const Startup_Phase_Timing &timing = phases[id]->timing;
+            if (timing.skipped) continue;
+            busy_ms += timing.end_ms - timing.start_ms;
+            if (timing.end_ms > phases[last]->timing.end_ms) last = id;
+        }
+
+        out << "Startup: " << std::fixed << std::setprecision(1) << total_ms << " ms, "
+            << busy_ms << " ms of work on " << job_system.thread_count() << " threads" << std::endl;
+        out << "    " << std::left << std::setw(28) << "phase" << std::right
+            << std::setw(10) << "start ms" << std::setw(10) << "time ms" << std::setw(9) << "thread" << std::endl;
+        for (const auto &phase : phases) {
+            const Startup_Phase_Timing &timing = phase->timing;
+            out << "    " << std::left << std::setw(28) << timing.name << std::right;
+            if (timing.skipped) {
+                out << std::setw(29) << "skipped" << std::endl;
+                continue;
+            }
+            out << std::setw(10) << timing.start_ms << std::setw(10) << timing.end_ms - timing.start_ms;
+            if (timing.thread_index == 0) {
+                out << std::setw(9) << "main";
+            } else {
+                out << std::setw(9) << timing.thread_index;
+            }
+            out << std::endl;
+        }
+
+        // walk back from the phase that finished last through whichever dependency finished last
+        if (phases.empty()) return;
+        std::vector<const char *> critical_path;
+        Phase_Id current = last;
+        while (true) {
+            critical_path.push_back(phases[current]->name);
+            const std::vector<Phase_Id> &after = phases[current]->after;
+            if (after.empty()) break;
+            current = *std::max_element(after.begin(), after.end(), [this](Phase_Id a, Phase_Id b) {
+                return phases[a]->timing.end_ms < phases[b]->timing.end_ms;
+            });
+        }
+        out << "    critical path: ";
+        for (size_t i = critical_path.size(); i-- > 0;) {
+            out << critical_path[i] << (i > 0 ? " -> " : "");
+        }
+        out << std::defaultfloat << std::endl;
+    }
+
+} // namespace jobs
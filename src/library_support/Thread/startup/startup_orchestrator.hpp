@@ -0,0 +1,88 @@
+/**
+ * library_support/Thread/startup
+ *
+ * Runs the engine's startup as a graph of phases on the job system
+ *
+ * A phase starts as soon as every phase it comes after has finished, so work
+ * that does not depend on each other overlaps: the window is created on the
+ * main thread while a worker brings up the Vulkan instance, files are read
+ * while the device is being created. Phases marked main_thread only run on the
+ * thread that calls run(), GLFW wants its windows created there.
+ *
+ * Every phase is timed, print_report() lists them on a common time line
+ * together with the critical path, the chain of phases that decided how long
+ * startup took.
+ *
+ **/
+
+#ifndef PIXEL_ENGINE_THREAD_STARTUP_ORCHESTRATOR_H
+#define PIXEL_ENGINE_THREAD_STARTUP_ORCHESTRATOR_H
+
+#pragma once
+
+#include "../job_system/job_system.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+namespace jobs{
+    using Phase_Id = uint32_t;
+
+    struct Startup_Phase_Timing {
+        // string literal given to add_phase
+        const char *name = nullptr;
+        // milliseconds since run() started
+        double start_ms = 0.0;
+        double end_ms = 0.0;
+        uint32_t thread_index = 0;
+        // a phase it comes after failed, it never ran
+        bool skipped = false;
+    };
+
+    class StartupOrchestrator {
+    private:
+        struct Phase {
+            const char *name;
+            Job_Function function;
+            bool main_thread;
+            std::vector<Phase_Id> after;
+            std::vector<Phase_Id> dependents;
+            std::atomic<uint32_t> waiting_for{0};
+            Startup_Phase_Timing timing;
+        };
+
+        JobSystem &job_system;
+        std::vector<std::unique_ptr<Phase>> phases;
+        std::atomic<bool> failed{false};
+        int64_t start_ns = 0;
+        double total_ms = 0.0;
+        bool has_run = false;
+
+        void schedule_phase(Phase_Id id, Job_Counter &counter);
+        void run_phase(Phase_Id id, Job_Counter &counter);
+
+    public:
+        explicit StartupOrchestrator(JobSystem &job_system);
+
+        StartupOrchestrator(const StartupOrchestrator &) = delete;
+        StartupOrchestrator &operator = (const StartupOrchestrator &) = delete;
+
+        // name must be a string literal, after only names phases added before this one
+        Phase_Id add_phase(const char *name, Job_Function function, const std::vector<Phase_Id> &after = {}, bool main_thread = false);
+
+        // main thread of the job system only, returns once every phase ran or was skipped and
+        // rethrows the first exception a phase threw, the phases after it are skipped
+        void run();
+
+        double get_total_ms() const { return total_ms; }
+        std::vector<Startup_Phase_Timing> get_timings() const;
+        void print_report(std::ostream &out) const;
+    };
+
+} // namespace jobs
+
+
+#endif // PIXEL_ENGINE_THREAD_STARTUP_ORCHESTRATOR_H
@@ -6,20 +6,70 @@
 
 
 #include "./test/vulkan_API_test.hpp"
+#include "./test/vulkan_headless_test.hpp"
+#include "./test/render_graph_test.hpp"
+#include "./library_support/Profiling/profiler/profiler.hpp"
 
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
 
-int main(){
-    graph_vulkan::vulkan_window_test test_instance{};
-
+int main(int argc, char **argv){
     try{
-        test_instance.run();
+        // --headless [frames] renders offscreen without a window, for render servers and CI
+        // --output raw:<file>|png:<directory>|pipe:<command> also writes every headless frame out
+        // --trace <file> captures CPU and GPU zones into a Chrome trace written at exit
+        // --test-render-graph runs the render graph checks on a headless device, for ctest
+        bool headless = false;
+        bool test_render_graph = false;
+        uint32_t headless_frames = 600;
+        std::string output;
+        std::string trace_path;
+        for (int i = 1; i < argc; i++) {
+            if (std::strcmp(argv[i], "--headless") == 0) {
+                headless = true;
+                if (i + 1 < argc && argv[i + 1][0] != '-') {
+                    headless_frames = static_cast<uint32_t>(std::stoul(argv[++i]));
+                }
+            } else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+                output = argv[++i];
+            } else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+                trace_path = argv[++i];
+            } else if (std::strcmp(argv[i], "--test-render-graph") == 0) {
+                test_render_graph = true;
+            }
+        }
+
+        PIXEL_PROFILE_THREAD("main");
+        if (!trace_path.empty()) {
+            if (!profiling::compiled_in) {
+                std::cerr << "Built without PIXEL_ENGINE_PROFILING, the trace will be empty" << std::endl;
+            }
+            profiling::Profiler::instance().start_capture();
+        }
+
+        // the device and pipelines are created here, failures there are reported like run time ones
+        if (test_render_graph) {
+            graph_vulkan::render_graph_test test_instance{};
+            test_instance.run();
+        } else if (headless) {
+            graph_vulkan::vulkan_headless_test test_instance{output};
+            test_instance.run(headless_frames);
+        } else {
+            graph_vulkan::vulkan_window_test test_instance{};
+            test_instance.run();
+        }
+
+        if (!trace_path.empty()) {
+            profiling::Profiler::instance().stop_capture();
+            profiling::Profiler::instance().write_chrome_trace(trace_path);
+        }
     }catch(const std::exception &Exception){
         std::cerr << Exception.what() << "\n";
         return EXIT_FAILURE;
     }
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
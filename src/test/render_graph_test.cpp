@@ -0,0 +1,73 @@
+
+#include "render_graph_test.hpp"
+
+#include <iostream>
+#include <stdexcept>
+
+
+namespace graph_vulkan{
+    void render_graph_test::run() {
+        compute_produced_transient();
+        read_before_write();
+        std::cout << "Render graph test: " << check_count << " checks passed" << std::endl;
+    }
+
+    void render_graph_test::check(bool condition, const std::string &message) {
+        if (!condition) {
+            throw std::runtime_error("Render graph test failed: " + message);
+        }
+        check_count++;
+    }
+
+    void render_graph_test::compute_produced_transient() {
+        const Graph_Image_Info info{VK_FORMAT_R8G8B8A8_UNORM, {64, 64}};
+        Pass_Execute dispatch = [](const Pass_Context &) {};
+
+        RenderGraph graph{device};
+        Graph_Resource generated = graph.create_image("generated", info);
+        Graph_Resource filtered = graph.create_image("filtered", info);
+        graph.add_pass("generate", Pass_Type::compute, [&](Pass_Builder &builder) {
+            builder.write_storage(generated);
+        }, dispatch);
+        graph.add_pass("filter", Pass_Type::compute, [&](Pass_Builder &builder) {
+            builder.sample(generated);
+            builder.write_storage(filtered);
+            builder.set_side_effect();
+        }, dispatch);
+        graph.compile();
+
+        check(!graph.is_culled("generate"), "the pass producing a sampled transient was culled");
+        check(graph.get_stats().transient_image_count == 2, "expected two transient images");
+
+        // submitted once, the validation layers see the barriers in debug builds
+        VkCommandBuffer command_buffer = device.begin_single_time_commands();
+        graph.execute(command_buffer);
+        device.end_single_time_commands(command_buffer);
+
+        // generated undefined to general, general to shader read, filtered undefined to general
+        const Render_Graph_Stats &stats = graph.get_stats();
+        check(stats.layout_transitions == 3, "expected 3 layout transitions, got " + std::to_string(stats.layout_transitions));
+        check(stats.barrier_batches == 2, "expected one barrier batch per pass, got " + std::to_string(stats.barrier_batches));
+    }
+
+    void render_graph_test::read_before_write() {
+        const Graph_Image_Info info{VK_FORMAT_R8G8B8A8_UNORM, {64, 64}};
+
+        RenderGraph graph{device};
+        Graph_Resource never_written = graph.create_image("never_written", info);
+        Graph_Resource result = graph.create_image("result", info);
+        graph.add_pass("consume", Pass_Type::compute, [&](Pass_Builder &builder) {
+            builder.sample(never_written);
+            builder.write_storage(result);
+            builder.set_side_effect();
+        }, [](const Pass_Context &) {});
+
+        bool threw = false;
+        try {
+            graph.compile();
+        } catch (const std::runtime_error &) {
+            threw = true;
+        }
+        check(threw, "compile() accepted a transient that is sampled before anything writes it");
+    }
+}
@@ -0,0 +1,36 @@
+//
+// Compiles and executes small render graphs on a headless device, what
+// ctest runs through Pixel_Engine --test-render-graph
+//
+
+#ifndef PIXEL_ENGINE_RENDER_GRAPH_TEST_H
+#define PIXEL_ENGINE_RENDER_GRAPH_TEST_H
+
+#pragma once
+
+#include "../library_support/Graphic/vulkan/device/device.hpp"
+#include "../library_support/Graphic/vulkan/render_graph/render_graph.hpp"
+
+#include <string>
+
+
+namespace graph_vulkan{
+    class render_graph_test{
+    public:
+        // throws on the first check that fails
+        void run();
+
+    private:
+        // a transient written by a compute pass first and sampled after
+        void compute_produced_transient();
+        // sampling a transient nothing wrote has to be rejected by compile()
+        void read_before_write();
+        void check(bool condition, const std::string &message);
+
+        Device device{"Render Graph Test", {0, 0, 1}};
+        uint32_t check_count = 0;
+    };
+} // namespace graph_vulkan
+
+
+#endif //PIXEL_ENGINE_RENDER_GRAPH_TEST_H
@@ -1,11 +1,254 @@
 
 #include "vulkan_API_test.hpp"
+#include "../library_support/Thread/startup/startup_orchestrator.hpp"
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <stdexcept>
+#include <tuple>
 
 
 namespace graph_vulkan{
+    vulkan_window_test::vulkan_window_test() {
+        startup();
+    }
+
+    vulkan_window_test::~vulkan_window_test() {
+        vkFreeCommandBuffers(
+                device->device(),
+                device->get_command_pool(),
+                static_cast<uint32_t>(command_buffers.size()),
+                command_buffers.data()
+                );
+        gpu_profiler.reset();
+        pipeline_library.reset();
+        vkDestroyPipelineLayout(device->device(), pipeline_layout, nullptr);
+        swap_chain.reset();
+    }
+
     void vulkan_window_test::run() {
-        while (!window_test.shouldClose()){
+        bool reported = false;
+        last_report_time = std::chrono::steady_clock::now();
+
+        while (!window_test->should_close()){
              glfwPollEvents();
+             draw_frame();
+
+             // the pipeline compiles in the background, frames are presented meanwhile
+             if (!reported && pipeline.is_ready()) {
+                 pipeline_library->print_stats(std::cout);
+                 device->shader_modules().print_stats(std::cout);
+                 reported = true;
+             }
+             report_frame_times();
+        }
+
+        vkDeviceWaitIdle(device->device());
+    }
+
+    void vulkan_window_test::startup() {
+        jobs::StartupOrchestrator orchestrator{job_system};
+        jobs::Phase_Id glfw = orchestrator.add_phase("glfw init", []{
+            Window::init_library();
+        }, {}, true);
+        jobs::Phase_Id window = orchestrator.add_phase("window", [this]{
+            window_test = std::make_unique<Window>(WIDTH_WINDOW, HEIGHT_WINDOW, "Vulkan Window Test");
+        }, {glfw}, true);
+        // the instance only needs GLFW's extension list, not the window
+        jobs::Phase_Id instance = orchestrator.add_phase("instance", [this]{
+            device = std::make_unique<Device>(Deferred_Window{}, "Vulkan Window Test", std::make_tuple(0, 0, 1));
+        }, {glfw});
+        // the surface touches the window's view, which Cocoa only allows on the main thread
+        jobs::Phase_Id logical_device = orchestrator.add_phase("device", [this]{
+            device->attach_window(*window_test);
+        }, {window, instance}, true);
+
+        jobs::Phase_Id swap = orchestrator.add_phase("swap chain", [this]{
+            swap_chain_config.present_policy = SwapChain::present_policy_from_environment(Present_Policy::low_latency);
+            swap_chain = std::make_shared<SwapChain>(*device, window_test->get_extent(), swap_chain_config);
+        }, {logical_device});
+        jobs::Phase_Id layout = orchestrator.add_phase("pipeline layout", [this]{
+            create_pipeline_layout();
+        }, {logical_device});
+        jobs::Phase_Id library = orchestrator.add_phase("pipeline library", [this]{
+            pipeline_library = std::make_unique<PipelineLibrary>(*device, job_system);
+        }, {logical_device});
+        // compiles as a job, the first frames are drawn without it
+        orchestrator.add_phase("pipeline request", [this]{
+            create_pipeline();
+        }, {swap, layout, library});
+        orchestrator.add_phase("command buffers", [this]{
+            create_command_buffers();
+        }, {swap});
+        orchestrator.add_phase("gpu profiler", [this]{
+            gpu_profiler = std::make_unique<GpuProfiler>(*device, swap_chain->frames_in_flight());
+        }, {swap});
+
+        orchestrator.run();
+        orchestrator.print_report(std::cout);
+        device->print_device_report(std::cout);
+        swap_chain->print_stats(std::cout);
+    }
+
+    void vulkan_window_test::create_pipeline_layout() {
+        VkPipelineLayoutCreateInfo pipeline_layout_info{};
+        pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipeline_layout_info.setLayoutCount = 0;
+        pipeline_layout_info.pSetLayouts = nullptr;
+        pipeline_layout_info.pushConstantRangeCount = 0;
+        pipeline_layout_info.pPushConstantRanges = nullptr;
+        if (vkCreatePipelineLayout(device->device(), &pipeline_layout_info, nullptr, &pipeline_layout) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create pipeline layout.");
+        }
+    }
+
+    void vulkan_window_test::create_pipeline() {
+        Pipeline_Config_Info pipeline_config{};
+        Pipeline::default_pipeline_config_info(pipeline_config);
+        pipeline_config.pipeline_layout = pipeline_layout;
+        pipeline_config.render_pass = swap_chain->get_render_pass();
+        Pipeline_Desc pipeline_desc{};
+        pipeline_desc.vert_code = embedded_shaders::default_vert;
+        pipeline_desc.frag_code = embedded_shaders::default_frag;
+        pipeline_desc.config_info = pipeline_config;
+        pipeline = pipeline_library->request(pipeline_desc);
+    }
+
+    void vulkan_window_test::create_command_buffers() {
+        command_buffers.resize(swap_chain->frames_in_flight());
+
+        VkCommandBufferAllocateInfo allocate_info{};
+        allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocate_info.commandPool = device->get_command_pool();
+        allocate_info.commandBufferCount = static_cast<uint32_t>(command_buffers.size());
+
+        if (vkAllocateCommandBuffers(device->device(), &allocate_info, command_buffers.data()) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate command buffers.");
+        }
+    }
+
+    void vulkan_window_test::recreate_swap_chain() {
+        auto extent = window_test->get_extent();
+        // a minimized window has no surface to present to
+        while (extent.width == 0 || extent.height == 0) {
+            extent = window_test->get_extent();
+            glfwWaitEvents();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::shared_ptr<SwapChain> old_swap_chain = std::move(swap_chain);
+        // no vkDeviceWaitIdle, the new swap chain keeps the old one until its frames are done
+        swap_chain = std::make_shared<SwapChain>(*device, extent, old_swap_chain, swap_chain_config);
+        // the old render pass goes with the old swap chain, a handle we still hold keeps its pipeline
+        pipeline_library->evict_render_pass(old_swap_chain->get_render_pass());
+
+        if (!old_swap_chain->compare_swap_formats(*swap_chain)) {
+            // an incompatible render pass needs a new pipeline, it compiles in the background meanwhile
+            create_pipeline();
+        }
+        auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Swap chain recreated in " << elapsed << " ms" << std::endl;
+    }
+
+    void vulkan_window_test::record_command_buffer(VkCommandBuffer command_buffer, uint32_t image_index) {
+        VkCommandBufferBeginInfo begin_info{};
+        begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to begin recording command buffer.");
+        }
+        gpu_profiler->begin_frame(command_buffer, swap_chain->current_frame_index());
+        {
+            // everything up to the end of the render pass
+            PIXEL_PROFILE_GPU_ZONE(*gpu_profiler, command_buffer, "main pass");
+
+            VkRenderPassBeginInfo render_pass_info{};
+            render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            render_pass_info.renderPass = swap_chain->get_render_pass();
+            render_pass_info.framebuffer = swap_chain->get_frame_buffer(image_index);
+            render_pass_info.renderArea.offset = {0, 0};
+            render_pass_info.renderArea.extent = swap_chain->get_swap_chain_extent();
+
+            std::array<VkClearValue, 2> clear_values{};
+            clear_values[0].color = {{0.1f, 0.1f, 0.1f, 1.0f}};
+            clear_values[1].depthStencil = {1.0f, 0};
+            render_pass_info.clearValueCount = static_cast<uint32_t>(clear_values.size());
+            render_pass_info.pClearValues = clear_values.data();
+
+            vkCmdBeginRenderPass(command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+
+            VkViewport viewport{};
+            viewport.x = 0.0f;
+            viewport.y = 0.0f;
+            viewport.width = static_cast<float>(swap_chain->width());
+            viewport.height = static_cast<float>(swap_chain->height());
+            viewport.minDepth = 0.0f;
+            viewport.maxDepth = 1.0f;
+            VkRect2D scissor{{0, 0}, swap_chain->get_swap_chain_extent()};
+            vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+            vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+
+            // skip the triangle until the pipeline is compiled instead of waiting for it
+            if (pipeline.bind(command_buffer)) {
+                vkCmdDraw(command_buffer, 3, 1, 0, 0);
+            } else {
+                skipped_draws++;
+            }
+
+            vkCmdEndRenderPass(command_buffer);
         }
+        if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to record command buffer.");
+        }
+    }
+
+    void vulkan_window_test::draw_frame() {
+        PIXEL_PROFILE_ZONE("draw frame");
+        VkCommandBuffer command_buffer = command_buffers[swap_chain->current_frame_index()];
+
+        uint32_t image_index;
+        auto result = swap_chain->acquire_next_image(&image_index);
+        if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+            recreate_swap_chain();
+            return;
+        }
+        if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+            throw std::runtime_error("Failed to acquire swap chain image.");
+        }
+
+        record_command_buffer(command_buffer, image_index);
+        result = swap_chain->submit_command_buffers(&command_buffer, &image_index);
+        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || window_test->was_window_resized()) {
+            window_test->reset_window_resized_flag();
+            recreate_swap_chain();
+        } else if (result != VK_SUCCESS) {
+            throw std::runtime_error("Failed to present swap chain image.");
+        }
+
+        profiling::Profiler::instance().end_frame();
+        frames_since_report++;
+    }
+
+    void vulkan_window_test::report_frame_times() {
+        auto now = std::chrono::steady_clock::now();
+        double elapsed_s = std::chrono::duration<double>(now - last_report_time).count();
+        if (elapsed_s < 1.0 || frames_since_report == 0) return;
+
+        // percentiles over the profiler's rolling window, not just the last second
+        profiling::Frame_Stats cpu_stats = profiling::Profiler::instance().cpu_frame_stats();
+        profiling::Frame_Stats gpu_stats = profiling::Profiler::instance().gpu_frame_stats();
+        std::cout << SwapChain::present_mode_name(swap_chain->get_present_mode()) << ": "
+                  << frames_since_report / elapsed_s << " fps, frame time p50 "
+                  << cpu_stats.p50_ms << " ms, p95 " << cpu_stats.p95_ms << ", p99 " << cpu_stats.p99_ms;
+        if (gpu_stats.frame_count > 0) std::cout << ", GPU p50 " << gpu_stats.p50_ms << " ms";
+        if (skipped_draws > 0) std::cout << ", " << skipped_draws << " draws skipped";
+        std::cout << std::endl;
+
+        frames_since_report = 0;
+        skipped_draws = 0;
+        last_report_time = now;
     }
-}
\ No newline at end of file
+}
@@ -8,7 +8,16 @@
 #pragma once
 
 #include "../library_support/Graphic/vulkan/window/window.hpp"
-#include "../library_support/Graphic/vulkan/pipeline/pipeline.hpp"
+#include "../library_support/Graphic/vulkan/device/device.hpp"
+#include "../library_support/Graphic/vulkan/swap_chain/swap_chain.hpp"
+#include "../library_support/Graphic/vulkan/pipeline/pipeline_library.hpp"
+#include "../library_support/Graphic/vulkan/profiler/gpu_profiler.hpp"
+#include "../library_support/Graphic/vulkan/shader/embedded_shaders.hpp"
+#include "../library_support/Thread/job_system/job_system.hpp"
+
+#include <chrono>
+#include <memory>
+#include <vector>
 
 
 namespace graph_vulkan{
@@ -17,16 +26,41 @@ namespace graph_vulkan{
         static constexpr int WIDTH_WINDOW = 1600;
         static constexpr int HEIGHT_WINDOW = 900;
 
+        vulkan_window_test();
+        ~vulkan_window_test();
+
+        vulkan_window_test(const vulkan_window_test &) = delete;
+        vulkan_window_test &operator = (const vulkan_window_test &) = delete;
+
         void run();
 
     private:
-        Window window_test{WIDTH_WINDOW,HEIGHT_WINDOW,"Vulkan Window Test"};
+        // window, device and pipelines come up in overlapping phases, prints how long each took
+        void startup();
+        void create_pipeline_layout();
+        void create_pipeline();
+        void recreate_swap_chain();
+        void create_command_buffers();
+        void record_command_buffer(VkCommandBuffer command_buffer, uint32_t image_index);
+        void draw_frame();
+        void report_frame_times();
+
+        jobs::JobSystem job_system;
+        std::unique_ptr<Window> window_test;
+        std::unique_ptr<Device> device;
+        Swap_Chain_Config swap_chain_config{};
+        std::shared_ptr<SwapChain> swap_chain;
+
+        VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
+        std::unique_ptr<PipelineLibrary> pipeline_library;
+        Pipeline_Handle pipeline;
+        // one per frame in flight
+        std::vector<VkCommandBuffer> command_buffers;
+        std::unique_ptr<GpuProfiler> gpu_profiler;
 
-        const std:: string path_to_shader_spv = "src/library_support/Graphic/vulkan/shaders/build/";
-        Pipeline pipeline{
-            path_to_shader_spv + "shader_v0_0_0.vert.spv",
-            path_to_shader_spv + "shader_v0_0_0.frag.spv"
-        };
+        std::chrono::steady_clock::time_point last_report_time;
+        uint32_t frames_since_report = 0;
+        uint32_t skipped_draws = 0;
     };
 } // namespace graph_vulkan
 
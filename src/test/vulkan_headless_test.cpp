@@ -0,0 +1,160 @@
+
+#include "vulkan_headless_test.hpp"
+
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+
+namespace graph_vulkan{
+    vulkan_headless_test::vulkan_headless_test(const std::string &output) {
+        device.print_device_report(std::cout);
+        Offscreen_Target_Config target_config{};
+        target_config.extent = {WIDTH_IMAGE, HEIGHT_IMAGE};
+        target = std::make_unique<OffscreenTarget>(device, target_config);
+        if (!output.empty()) {
+            Frame_Readback_Config readback_config{};
+            readback_config.ring_size = target->frames_in_flight() + 2;
+            readback = std::make_unique<FrameReadback>(device, target->get_extent(), target->get_color_format(), readback_config);
+            readback->add_sink(create_frame_sink(output));
+        }
+
+        create_pipeline_layout();
+        pipeline_library = std::make_unique<PipelineLibrary>(device, job_system);
+        create_pipeline();
+        create_command_buffers();
+        gpu_profiler = std::make_unique<GpuProfiler>(device, target->frames_in_flight());
+    }
+
+    vulkan_headless_test::~vulkan_headless_test() {
+        target->wait_idle();
+        vkFreeCommandBuffers(
+                device.device(),
+                device.get_command_pool(),
+                static_cast<uint32_t>(command_buffers.size()),
+                command_buffers.data()
+                );
+        readback.reset();
+        gpu_profiler.reset();
+        pipeline_library.reset();
+        vkDestroyPipelineLayout(device.device(), pipeline_layout, nullptr);
+        target.reset();
+    }
+
+    void vulkan_headless_test::run(uint32_t frame_count) {
+        // nobody is looking, there is no point in rendering frames without the triangle
+        pipeline.wait();
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t frame = 0; frame < frame_count; frame++) {
+            PIXEL_PROFILE_ZONE("frame");
+            VkCommandBuffer command_buffer = command_buffers[target->current_frame_index()];
+
+            uint32_t image_index;
+            target->acquire_next_image(&image_index);
+            // the frame slot's fence was just waited for, it is reset by the submit below
+            if (readback) readback->poll();
+            uint32_t readback_slot = record_command_buffer(command_buffer, image_index, frame);
+            target->submit_command_buffers(&command_buffer, &image_index);
+            if (readback) readback->submitted(readback_slot, target->get_frame_fence(image_index));
+            profiling::Profiler::instance().end_frame();
+        }
+        target->wait_idle();
+        if (readback) readback->flush();
+
+        double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Headless: " << frame_count << " frames " << target->width() << "x" << target->height()
+                  << " in " << elapsed_ms << " ms, "
+                  << (frame_count > 0 ? elapsed_ms / frame_count : 0.0) << " ms per frame, "
+                  << (elapsed_ms > 0.0 ? frame_count * 1000.0 / elapsed_ms : 0.0) << " fps" << std::endl;
+        profiling::Profiler::instance().print_frame_stats(std::cout);
+        if (readback) readback->print_stats(std::cout);
+        pipeline_library->print_stats(std::cout);
+    }
+
+    void vulkan_headless_test::create_pipeline_layout() {
+        VkPipelineLayoutCreateInfo pipeline_layout_info{};
+        pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        if (vkCreatePipelineLayout(device.device(), &pipeline_layout_info, nullptr, &pipeline_layout) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create pipeline layout.");
+        }
+    }
+
+    void vulkan_headless_test::create_pipeline() {
+        Pipeline_Config_Info pipeline_config{};
+        Pipeline::default_pipeline_config_info(pipeline_config);
+        pipeline_config.pipeline_layout = pipeline_layout;
+        pipeline_config.render_pass = target->get_render_pass();
+        Pipeline_Desc pipeline_desc{};
+        pipeline_desc.vert_code = embedded_shaders::default_vert;
+        pipeline_desc.frag_code = embedded_shaders::default_frag;
+        pipeline_desc.config_info = pipeline_config;
+        pipeline = pipeline_library->request(pipeline_desc);
+    }
+
+    void vulkan_headless_test::create_command_buffers() {
+        command_buffers.resize(target->frames_in_flight());
+
+        VkCommandBufferAllocateInfo allocate_info{};
+        allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocate_info.commandPool = device.get_command_pool();
+        allocate_info.commandBufferCount = static_cast<uint32_t>(command_buffers.size());
+
+        if (vkAllocateCommandBuffers(device.device(), &allocate_info, command_buffers.data()) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate command buffers.");
+        }
+    }
+
+    uint32_t vulkan_headless_test::record_command_buffer(VkCommandBuffer command_buffer, uint32_t image_index, uint64_t frame_number) {
+        VkCommandBufferBeginInfo begin_info{};
+        begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to begin recording command buffer.");
+        }
+        gpu_profiler->begin_frame(command_buffer, image_index);
+        uint32_t main_pass_zone = gpu_profiler->begin_zone(command_buffer, "main pass");
+
+        VkRenderPassBeginInfo render_pass_info{};
+        render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        render_pass_info.renderPass = target->get_render_pass();
+        render_pass_info.framebuffer = target->get_frame_buffer(image_index);
+        render_pass_info.renderArea.offset = {0, 0};
+        render_pass_info.renderArea.extent = target->get_extent();
+
+        std::array<VkClearValue, 2> clear_values{};
+        clear_values[0].color = {{0.1f, 0.1f, 0.1f, 1.0f}};
+        clear_values[1].depthStencil = {1.0f, 0};
+        render_pass_info.clearValueCount = static_cast<uint32_t>(clear_values.size());
+        render_pass_info.pClearValues = clear_values.data();
+
+        vkCmdBeginRenderPass(command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+
+        VkViewport viewport{0.0f, 0.0f, static_cast<float>(target->width()), static_cast<float>(target->height()), 0.0f, 1.0f};
+        VkRect2D scissor{{0, 0}, target->get_extent()};
+        vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+        vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+
+        if (pipeline.bind(command_buffer)) {
+            vkCmdDraw(command_buffer, 3, 1, 0, 0);
+        }
+
+        vkCmdEndRenderPass(command_buffer);
+        gpu_profiler->end_zone(command_buffer, main_pass_zone);
+
+        // the render pass left the color image in TRANSFER_SRC_OPTIMAL
+        uint32_t readback_slot = 0;
+        if (readback) {
+            PIXEL_PROFILE_GPU_ZONE(*gpu_profiler, command_buffer, "readback copy");
+            readback_slot = readback->record_copy(command_buffer, target->get_color_image(image_index), frame_number);
+        }
+
+        if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to record command buffer.");
+        }
+        return readback_slot;
+    }
+}
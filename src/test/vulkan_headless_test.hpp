@@ -0,0 +1,60 @@
+//
+// Renders the test triangle without a window, for render servers and CI,
+// optionally streaming every frame out through the readback sinks
+//
+
+#ifndef PIXEL_ENGINE_VULKAN_HEADLESS_TEST_H
+#define PIXEL_ENGINE_VULKAN_HEADLESS_TEST_H
+
+#pragma once
+
+#include "../library_support/Graphic/vulkan/device/device.hpp"
+#include "../library_support/Graphic/vulkan/offscreen/offscreen_target.hpp"
+#include "../library_support/Graphic/vulkan/pipeline/pipeline_library.hpp"
+#include "../library_support/Graphic/vulkan/profiler/gpu_profiler.hpp"
+#include "../library_support/Graphic/vulkan/readback/frame_readback.hpp"
+#include "../library_support/Graphic/vulkan/shader/embedded_shaders.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace graph_vulkan{
+    class vulkan_headless_test{
+    public:
+        static constexpr uint32_t WIDTH_IMAGE = 1600;
+        static constexpr uint32_t HEIGHT_IMAGE = 900;
+
+        // output is a frame sink spec (raw:<file>, png:<directory>, pipe:<command>), empty renders only
+        explicit vulkan_headless_test(const std::string &output = "");
+        ~vulkan_headless_test();
+
+        vulkan_headless_test(const vulkan_headless_test &) = delete;
+        vulkan_headless_test &operator = (const vulkan_headless_test &) = delete;
+
+        void run(uint32_t frame_count);
+
+    private:
+        void create_pipeline_layout();
+        void create_pipeline();
+        void create_command_buffers();
+        // returns the readback slot of the frame's copy, when reading back
+        uint32_t record_command_buffer(VkCommandBuffer command_buffer, uint32_t image_index, uint64_t frame_number);
+
+        // pipeline compiles
+        jobs::JobSystem job_system;
+        Device device{"Vulkan Headless Test", {0, 0, 1}};
+        std::unique_ptr<OffscreenTarget> target;
+        std::unique_ptr<FrameReadback> readback;
+
+        VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
+        std::unique_ptr<PipelineLibrary> pipeline_library;
+        Pipeline_Handle pipeline;
+        std::vector<VkCommandBuffer> command_buffers;
+        std::unique_ptr<GpuProfiler> gpu_profiler;
+    };
+} // namespace graph_vulkan
+
+
+#endif //PIXEL_ENGINE_VULKAN_HEADLESS_TEST_H
@@ -0,0 +1,68 @@
+/**
+ *
+ * Pixel_Engine_pack, packs a directory of assets into one archive the engine maps at startup
+ *
+ **/
+
+
+#include "../library_support/File/archive/asset_archive.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+int main(int argc, char **argv){
+    try{
+        // <archive> <directory> [--compress] packs every file below directory, named by its relative path
+        // --verify <archive> checks every asset against its checksum
+        if (argc == 3 && std::strcmp(argv[1], "--verify") == 0) {
+            file_io::AssetArchive archive{argv[2]};
+            size_t bad_count = 0;
+            for (size_t i = 0; i < archive.entry_count(); i++) {
+                const file_io::Archive_Entry &entry = archive.entry(i);
+                if (!archive.verify(entry)) {
+                    std::cerr << "Checksum mismatch: " << archive.entry_name(entry) << "\n";
+                    bad_count++;
+                }
+            }
+            std::cout << archive.entry_count() << " assets, " << bad_count << " damaged" << std::endl;
+            return bad_count == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
+        if (argc < 3) {
+            throw std::runtime_error("Usage: Pixel_Engine_pack <archive> <directory> [--compress] | --verify <archive>");
+        }
+        const std::string archive_path = argv[1];
+        const std::filesystem::path directory = argv[2];
+        bool compress = false;
+        for (int i = 3; i < argc; i++) {
+            if (std::strcmp(argv[i], "--compress") == 0) {
+                compress = true;
+            } else {
+                throw std::runtime_error(std::string("Unknown argument: ") + argv[i]);
+            }
+        }
+
+        // forward slashes on every platform, the names are what the engine looks assets up by
+        file_io::AssetArchiveWriter writer;
+        size_t input_bytes = 0;
+        for (const auto &file : std::filesystem::recursive_directory_iterator(directory)) {
+            if (!file.is_regular_file()) continue;
+            std::string name = std::filesystem::relative(file.path(), directory).generic_string();
+            writer.add_file(name, file.path().string(), compress);
+            input_bytes += static_cast<size_t>(file.file_size());
+        }
+        size_t archive_size = writer.write(archive_path);
+        std::cout << "Packed " << writer.asset_count() << " assets (" << input_bytes << " bytes) into "
+                  << archive_path << " (" << archive_size << " bytes)" << std::endl;
+    }catch(const std::exception &Exception){
+        std::cerr << Exception.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}